@@ -0,0 +1,781 @@
+#include "BenchmarkSuite.h"
+#include "../../Source/Controller/BackupScheduler.h"
+#include "../../Source/Controller/LoopbackMidiTransport.h"
+#include "../../Source/Controller/MidiBlockDriver.h"
+#include "../../Source/Controller/MidiManager.h"
+#include "../../Source/Controller/MidiTelemetry.h"
+#include "../../Source/Controller/PatchManager.h"
+#include "../../Source/Controller/PatchSimilarityIndex.h"
+#include "../../Source/Controller/PersistenceManager.h"
+#include "../../Source/Controller/SimulatedSynthTransport.h"
+#include "../../Source/Model/FactoryTemplates.h"
+#include "../../Source/Model/PatchBank.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr double SAMPLE_RATE = 48000.0;
+    constexpr int BLOCK_SIZE = 256;
+    
+    /** Collects timings and reports their distribution. */
+    class Samples
+    {
+    public:
+        void add(double value) { values.add(value); }
+        
+        double getPercentile(double fraction) const
+        {
+            if (values.isEmpty())
+                return 0.0;
+            
+            auto sorted = values;
+            std::sort(sorted.begin(), sorted.end());
+            const int index = (int)std::ceil(fraction * sorted.size()) - 1;
+            return sorted[juce::jlimit(0, sorted.size() - 1, index)];
+        }
+        
+        juce::var toVar() const
+        {
+            juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+            obj->setProperty("count", values.size());
+            
+            if (!values.isEmpty())
+            {
+                double sum = 0.0;
+                for (double value : values)
+                    sum += value;
+                
+                obj->setProperty("mean", sum / values.size());
+                obj->setProperty("min", getPercentile(0.0));
+                obj->setProperty("p50", getPercentile(0.5));
+                obj->setProperty("p90", getPercentile(0.9));
+                obj->setProperty("p99", getPercentile(0.99));
+                obj->setProperty("max", getPercentile(1.0));
+            }
+            
+            return juce::var(obj.get());
+        }
+    
+    private:
+        juce::Array<double> values;
+    };
+    
+    double microsecondsSince(juce::int64 startTicks) noexcept
+    {
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6;
+    }
+    
+    juce::Result enqueue(MidiManager& midiManager, MidiManager::Priority priority, int index)
+    {
+        // Non-commercial manufacturer ID and a 30-byte body: a typical short parameter dump
+        static const juce::uint8 sysEx[32] = { 0x7d, 0x01 };
+        
+        switch (priority)
+        {
+            case MidiManager::Priority::realtime:
+                return midiManager.sendProgramChange(index % 128, priority);
+            case MidiManager::Priority::interactive:
+                return midiManager.sendControlChange(index % 120, index % 128, priority);
+            case MidiManager::Priority::bulk:
+            default:
+                return midiManager.sendSysEx(sysEx, (int)sizeof(sysEx), priority);
+        }
+    }
+    
+    PatchData createSyntheticPatch(int index, juce::Random& random)
+    {
+        static const char* adjectives[] = { "Warm", "Bright", "Dark", "Soft", "Fat", "Thin", "Glassy", "Dusty", "Analog", "Digital" };
+        static const char* nouns[] = { "Pad", "Bass", "Lead", "Strings", "Keys", "Brass", "Pluck", "Bell", "Choir", "Organ" };
+        static const char* tags[] = { "bass", "lead", "pad", "fx", "keys", "ambient", "arp", "vintage" };
+        
+        PatchData patch(index % PatchBank::BANK_SIZE,
+                        juce::String(adjectives[random.nextInt(10)]) + " " + nouns[random.nextInt(10)]
+                            + " " + juce::String(index % 1000).paddedLeft('0', 3),
+                        "generic");
+        
+        for (int t = random.nextInt(4); --t >= 0;)
+            patch.addTag(tags[random.nextInt(8)]);
+        
+        patch.setFavorite(random.nextInt(10) == 0);
+        return patch;
+    }
+    
+    LoopbackMidiTransport::Options sinkOptions()
+    {
+        // Counts what reaches the port and sends nothing back
+        LoopbackMidiTransport::Options sink;
+        sink.echo = false;
+        return sink;
+    }
+    
+    bool allLanesEmpty(const MidiManager& midiManager) noexcept
+    {
+        for (auto priority : { MidiManager::Priority::realtime, MidiManager::Priority::interactive,
+                               MidiManager::Priority::bulk })
+            if (midiManager.getLaneStatistics(priority).numQueued > 0)
+                return false;
+        
+        return true;
+    }
+    
+    /**
+     * Plays a virtual-device scenario as fast as the CPU allows and reports
+     * both clocks: simulated seconds (what a real synth would take) and wall
+     * time. queueRequests() fills the lanes before every repetition; each
+     * repetition gets a fresh synth, so all of them simulate the same run.
+     */
+    juce::var runVirtualDeviceScenario(const DeviceTemplate& device, const SimulatedSynthTransport::Config& config,
+                                       double wireBaudRate, int repetitions,
+                                       const std::function<void(MidiManager&)>& queueRequests)
+    {
+        Samples wallTimes;
+        SimulatedSynthTransport::Statistics statistics;
+        double simulatedSeconds = 0.0;
+        bool finished = false;
+        
+        for (int n = 0; n < repetitions; ++n)
+        {
+            MidiManager midiManager;
+            SimulatedSynthTransport synth(device, config);
+            midiManager.setTransport(&synth);
+            midiManager.setWireBaudRate(wireBaudRate);
+            
+            MidiBlockDriver::Options driverOptions;
+            driverOptions.sampleRate = SAMPLE_RATE;
+            driverOptions.blockSize = BLOCK_SIZE;
+            driverOptions.speed = 0.0;
+            MidiBlockDriver driver(midiManager, driverOptions);
+            
+            queueRequests(midiManager);
+            
+            const auto start = juce::Time::getHighResolutionTicks();
+            finished = driver.processUntil([&] { return allLanesEmpty(midiManager) && synth.isIdle(); }, 600.0);
+            wallTimes.add(microsecondsSince(start));
+            
+            simulatedSeconds = driver.getElapsedSeconds();
+            statistics = synth.getStatistics();
+            midiManager.setTransport(nullptr);
+        }
+        
+        juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+        obj->setProperty("device", device.getDeviceName());
+        obj->setProperty("finished", finished);
+        obj->setProperty("simulatedSeconds", simulatedSeconds);
+        obj->setProperty("wallTime", wallTimes.toVar());
+        obj->setProperty("synth", statistics.toVar());
+        return juce::var(obj.get());
+    }
+    
+    struct Entry
+    {
+        const char* name;
+        juce::var (*function)(const BenchmarkSuite::Options&);
+    };
+    
+    const Entry benchmarks[] =
+    {
+        { "outputDrain", &BenchmarkSuite::benchmarkOutputDrain },
+        { "programChangeThroughput", &BenchmarkSuite::benchmarkProgramChangeThroughput },
+        { "search", &BenchmarkSuite::benchmarkSearch },
+        { "similarity", &BenchmarkSuite::benchmarkSimilarity },
+        { "persistence", &BenchmarkSuite::benchmarkPersistence },
+        { "telemetry", &BenchmarkSuite::benchmarkTelemetry },
+        { "startup", &BenchmarkSuite::benchmarkStartup },
+        { "virtualDevice", &BenchmarkSuite::benchmarkVirtualDevice },
+        { "backup", &BenchmarkSuite::benchmarkBackup }
+    };
+}
+
+juce::StringArray BenchmarkSuite::getBenchmarkNames()
+{
+    juce::StringArray names;
+    for (const auto& entry : benchmarks)
+        names.add(entry.name);
+    return names;
+}
+
+juce::var BenchmarkSuite::run(const Options& options)
+{
+    juce::DynamicObject::Ptr machine = new juce::DynamicObject();
+    machine->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    machine->setProperty("cpu", juce::SystemStats::getCpuModel());
+    machine->setProperty("numCpus", juce::SystemStats::getNumCpus());
+    machine->setProperty("juce", juce::SystemStats::getJUCEVersion());
+   #if JUCE_DEBUG
+    machine->setProperty("build", "debug");
+   #else
+    machine->setProperty("build", "release");
+   #endif
+   
+    juce::DynamicObject::Ptr results = new juce::DynamicObject();
+    for (const auto& entry : benchmarks)
+        if (options.only.isEmpty() || options.only.contains(entry.name))
+            results->setProperty(entry.name, entry.function(options));
+    
+    juce::DynamicObject::Ptr report = new juce::DynamicObject();
+    report->setProperty("schemaVersion", 1);
+    report->setProperty("timestamp", juce::Time::getCurrentTime().toISO8601(true));
+    report->setProperty("machine", juce::var(machine.get()));
+    report->setProperty("results", juce::var(results.get()));
+    return juce::var(report.get());
+}
+
+juce::var BenchmarkSuite::benchmarkOutputDrain(const Options& options)
+{
+    struct Case
+    {
+        MidiManager::Priority priority;
+        int depth;
+    };
+    
+    // Depths up to each lane's capacity (realtime 64, interactive 256, bulk 1024)
+    static const Case cases[] =
+    {
+        { MidiManager::Priority::realtime, 1 },
+        { MidiManager::Priority::realtime, 16 },
+        { MidiManager::Priority::realtime, 64 },
+        { MidiManager::Priority::interactive, 1 },
+        { MidiManager::Priority::interactive, 32 },
+        { MidiManager::Priority::interactive, 256 },
+        { MidiManager::Priority::bulk, 1 },
+        { MidiManager::Priority::bulk, 128 },
+        { MidiManager::Priority::bulk, 1024 }
+    };
+    
+    MidiManager midiManager;
+    LoopbackMidiTransport sink(sinkOptions());
+    midiManager.setTransport(&sink);
+    midiManager.prepareToPlay(SAMPLE_RATE);
+    midiManager.setWireBaudRate(0.0); // Unlimited: measure the queue, not the cable
+    
+    juce::MidiBuffer buffer;
+    buffer.ensureSize(128 * 1024);
+    
+    juce::Array<juce::var> results;
+    
+    for (const auto& c : cases)
+    {
+        Samples blockTimes;
+        int messagesPerBlock = 0;
+        
+        for (int n = 0; n < options.iterations; ++n)
+        {
+            for (int i = 0; i < c.depth; ++i)
+                enqueue(midiManager, c.priority, i);
+            
+            buffer.clear();
+            const auto start = juce::Time::getHighResolutionTicks();
+            midiManager.processAudioThread(buffer, BLOCK_SIZE);
+            blockTimes.add(microsecondsSince(start));
+            messagesPerBlock = buffer.getNumEvents();
+            
+            // Lanes with a per-block cap keep the rest; start every sample from the same depth
+            while (midiManager.getLaneStatistics(c.priority).numQueued > 0)
+            {
+                buffer.clear();
+                midiManager.processAudioThread(buffer, BLOCK_SIZE);
+            }
+        }
+        
+        juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+        obj->setProperty("lane", MidiManager::getPriorityName(c.priority));
+        obj->setProperty("queueDepth", c.depth);
+        obj->setProperty("blockSize", BLOCK_SIZE);
+        obj->setProperty("messagesPerBlock", messagesPerBlock);
+        obj->setProperty("blockTime", blockTimes.toVar());
+        results.add(juce::var(obj.get()));
+    }
+    
+    midiManager.setTransport(nullptr);
+    return results;
+}
+
+juce::var BenchmarkSuite::benchmarkProgramChangeThroughput(const Options& options)
+{
+    juce::Array<juce::var> results;
+    
+    for (int numThreads = 1; numThreads <= juce::jmax(1, options.maxThreads); numThreads *= 2)
+    {
+        MidiManager midiManager;
+        LoopbackMidiTransport sink(sinkOptions());
+        midiManager.setTransport(&sink);
+        midiManager.prepareToPlay(SAMPLE_RATE);
+        midiManager.setWireBaudRate(0.0);
+        
+        std::atomic<bool> running { true };
+        std::atomic<juce::int64> totalQueued { 0 };
+        std::atomic<juce::int64> totalRejected { 0 };
+        
+        // Stands in for the audio thread, draining as fast as it can
+        std::thread drainer([&]
+        {
+            juce::MidiBuffer buffer;
+            buffer.ensureSize(16 * 1024);
+            
+            while (running.load(std::memory_order_relaxed))
+            {
+                buffer.clear();
+                midiManager.processAudioThread(buffer, BLOCK_SIZE);
+            }
+        });
+        
+        std::vector<std::thread> senders;
+        const auto start = juce::Time::getHighResolutionTicks();
+        
+        for (int t = 0; t < numThreads; ++t)
+        {
+            senders.emplace_back([&, t]
+            {
+                juce::int64 queued = 0, rejected = 0;
+                
+                for (int program = t; running.load(std::memory_order_relaxed); ++program)
+                {
+                    if (midiManager.sendProgramChange(program & 127).wasOk())
+                        ++queued;
+                    else
+                        ++rejected; // Lane full
+                }
+                
+                totalQueued += queued;
+                totalRejected += rejected;
+            });
+        }
+        
+        juce::Thread::sleep(juce::roundToInt(options.throughputSeconds * 1000.0));
+        running = false;
+        
+        for (auto& sender : senders)
+            sender.join();
+        drainer.join();
+        
+        const double seconds = microsecondsSince(start) / 1.0e6;
+        const auto calls = totalQueued.load() + totalRejected.load();
+        
+        juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+        obj->setProperty("threads", numThreads);
+        obj->setProperty("seconds", seconds);
+        obj->setProperty("callsPerSecond", (double)calls / seconds);
+        obj->setProperty("queuedPerSecond", (double)totalQueued.load() / seconds);
+        obj->setProperty("rejected", totalRejected.load());
+        obj->setProperty("delivered", (juce::int64)sink.getNumMessagesReceived());
+        results.add(juce::var(obj.get()));
+        
+        midiManager.setTransport(nullptr);
+    }
+    
+    return results;
+}
+
+juce::var BenchmarkSuite::benchmarkSearch(const Options& options)
+{
+    static const char* queries[] = { "pad", "dusty", "042", "ambient", "no such patch" };
+    
+    juce::Array<juce::var> results;
+    juce::Random random(0x5eed);
+    
+    for (int size = PatchBank::BANK_SIZE; size <= options.maxLibrarySize; size = size < 1000 ? 1000 : size * 10)
+    {
+        juce::Array<PatchData> library;
+        library.ensureStorageAllocated(size);
+        for (int i = 0; i < size; ++i)
+            library.add(createSyntheticPatch(i, random));
+        
+        // Keep each size to a few million patch visits
+        const int repetitions = juce::jlimit(1, options.iterations, 4000000 / size);
+        
+        juce::Array<int> visible;
+        visible.ensureStorageAllocated(size);
+        
+        for (const char* query : queries)
+        {
+            Samples matchTimes, filterTimes, favoritesTimes;
+            int numMatches = 0;
+            
+            for (int n = 0; n < repetitions; ++n)
+            {
+                auto start = juce::Time::getHighResolutionTicks();
+                numMatches = 0;
+                for (const auto& patch : library)
+                    numMatches += patch.matchesSearchQuery(query) ? 1 : 0;
+                matchTimes.add(microsecondsSince(start));
+                
+                // The patch list's filter: search text, optionally favorites only
+                for (int favoritesOnly = 0; favoritesOnly < 2; ++favoritesOnly)
+                {
+                    start = juce::Time::getHighResolutionTicks();
+                    visible.clearQuick();
+                    for (int i = 0; i < library.size(); ++i)
+                    {
+                        const auto& patch = library.getReference(i);
+                        if ((favoritesOnly == 0 || patch.isFavorite()) && patch.matchesSearchQuery(query))
+                            visible.add(i);
+                    }
+                    (favoritesOnly != 0 ? favoritesTimes : filterTimes).add(microsecondsSince(start));
+                }
+            }
+            
+            juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+            obj->setProperty("librarySize", size);
+            obj->setProperty("query", query);
+            obj->setProperty("matches", numMatches);
+            obj->setProperty("nsPerPatch", matchTimes.getPercentile(0.5) * 1000.0 / size);
+            obj->setProperty("matchAll", matchTimes.toVar());
+            obj->setProperty("filter", filterTimes.toVar());
+            obj->setProperty("filterFavorites", favoritesTimes.toVar());
+            results.add(juce::var(obj.get()));
+        }
+    }
+    
+    return results;
+}
+
+juce::var BenchmarkSuite::benchmarkSimilarity(const Options& options)
+{
+    // The scalar walk takes tens of milliseconds per query at this size
+    return PatchSimilarityIndex::benchmark(juce::jmin(100000, options.maxLibrarySize), 64, 10,
+                                           juce::jmax(1, options.iterations / 10));
+}
+
+juce::var BenchmarkSuite::benchmarkPersistence(const Options& options)
+{
+    enum class Content
+    {
+        names,
+        parameters,
+        dumps
+    };
+    
+    static const std::pair<Content, const char*> variants[] =
+    {
+        { Content::names, "names" },
+        { Content::parameters, "parameters" },
+        { Content::dumps, "dumps" }
+    };
+    
+    auto directory = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                         .getNonexistentChildFile("MidiLibrarianBenchmark", {});
+    PersistenceManager persistence(directory);
+    
+    const int repetitions = juce::jmax(1, options.iterations / 4);
+    juce::Array<juce::var> results;
+    juce::Random random(0x5eed);
+    
+    for (const auto& variant : variants)
+    {
+        PatchBank bank;
+        
+        {
+            const PatchBank::ScopedTransaction transaction(bank);
+            
+            for (int slot = 0; slot < PatchBank::BANK_SIZE; ++slot)
+            {
+                auto patch = createSyntheticPatch(slot, random);
+                
+                if (variant.first == Content::parameters)
+                {
+                    for (int p = 0; p < 64; ++p)
+                        patch.setParameterValue("p" + juce::String(p), random.nextInt(128));
+                }
+                else if (variant.first == Content::dumps)
+                {
+                    juce::MemoryBlock dump(256);
+                    random.fillBitsRandomly(dump.getData(), dump.getSize());
+                    patch.setPatchDump(dump);
+                }
+                
+                bank.setPatch(slot, patch);
+            }
+        }
+        
+        Samples saveTimes, loadTimes;
+        for (int n = 0; n < repetitions; ++n)
+        {
+            auto start = juce::Time::getHighResolutionTicks();
+            const bool saved = persistence.savePatchBank(bank);
+            saveTimes.add(microsecondsSince(start));
+            
+            PatchBank loaded;
+            start = juce::Time::getHighResolutionTicks();
+            const bool ok = persistence.loadPatchBank(loaded);
+            loadTimes.add(microsecondsSince(start));
+            
+            jassert(saved && ok);
+            juce::ignoreUnused(saved, ok);
+        }
+        
+        juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+        obj->setProperty("content", variant.second);
+        obj->setProperty("fileBytes", persistence.getPatchesFile().getSize());
+        obj->setProperty("save", saveTimes.toVar());
+        obj->setProperty("load", loadTimes.toVar());
+        results.add(juce::var(obj.get()));
+    }
+    
+    directory.deleteRecursively();
+    return results;
+}
+
+juce::var BenchmarkSuite::benchmarkTelemetry(const Options& options)
+{
+    // Cost per event of what the pipeline records: a timestamp plus one histogram update.
+    // Each sample is the mean over a batch, since a single event is below the timer's resolution.
+    constexpr int EVENTS_PER_SAMPLE = 10000;
+    MidiTelemetry telemetry;
+    Samples recordOnly, timestampAndRecord;
+    
+    for (int i = 0; i < options.iterations; ++i)
+    {
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        for (int e = 0; e < EVENTS_PER_SAMPLE; ++e)
+            telemetry.recordEnqueueLatency(startTicks - (e & 4095) * 1000, startTicks);
+        recordOnly.add(microsecondsSince(startTicks) * 1000.0 / EVENTS_PER_SAMPLE);
+        
+        startTicks = juce::Time::getHighResolutionTicks();
+        for (int e = 0; e < EVENTS_PER_SAMPLE; ++e)
+            telemetry.recordEnqueueLatency(startTicks, juce::Time::getHighResolutionTicks());
+        timestampAndRecord.add(microsecondsSince(startTicks) * 1000.0 / EVENTS_PER_SAMPLE);
+    }
+    
+    juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+    obj->setProperty("unit", "ns per event");
+    obj->setProperty("record", recordOnly.toVar());
+    obj->setProperty("timestampAndRecord", timestampAndRecord.toVar());
+    return juce::var(obj.get());
+}
+
+juce::var BenchmarkSuite::benchmarkStartup(const Options& options)
+{
+    constexpr int NUM_USER_TEMPLATES = 20;
+    
+    auto directory = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                         .getNonexistentChildFile("MidiLibrarianStartup", {});
+    juce::Random random(0x5eed);
+    
+    // A library as a long-time user would have it: dumps in every slot, a folder of templates
+    {
+        PersistenceManager persistence(directory);
+        PatchBank bank;
+        
+        {
+            const PatchBank::ScopedTransaction transaction(bank);
+            
+            for (int slot = 0; slot < PatchBank::BANK_SIZE; ++slot)
+            {
+                auto patch = createSyntheticPatch(slot, random);
+                juce::MemoryBlock dump(256);
+                random.fillBitsRandomly(dump.getData(), dump.getSize());
+                patch.setPatchDump(dump);
+                bank.setPatch(slot, patch);
+            }
+        }
+        
+        persistence.savePatchBank(bank);
+        
+        auto templates = directory.getChildFile("templates");
+        templates.createDirectory();
+        
+        for (int i = 0; i < NUM_USER_TEMPLATES; ++i)
+        {
+            auto template_ = DeviceTemplate::createGeneric();
+            template_.setDeviceID("bench" + juce::String(i));
+            template_.setDeviceName("Bench Synth " + juce::String(i));
+            template_.setManufacturer("Benchmark");
+            templates.getChildFile("bench" + juce::String(i) + ".json")
+                .replaceWithText(juce::JSON::toString(template_.toVar(), true));
+        }
+    }
+    
+    PersistenceManager::setDefaultDataDirectory(directory);
+    
+    // Each PatchManager is the only instance, so every iteration loads the shared library from disk
+    Samples construction, toReady;
+    const int repetitions = juce::jmax(1, options.iterations / 4);
+    
+    for (int n = 0; n < repetitions; ++n)
+    {
+        auto start = juce::Time::getHighResolutionTicks();
+        auto patchManager = std::make_unique<PatchManager>();
+        construction.add(microsecondsSince(start));
+        
+        start = juce::Time::getHighResolutionTicks();
+        patchManager->beginStartup();
+        patchManager->waitUntilReady();
+        toReady.add(microsecondsSince(start));
+    }
+    
+    PersistenceManager::setDefaultDataDirectory({});
+    directory.deleteRecursively();
+    
+    juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+    obj->setProperty("construction", construction.toVar());
+    obj->setProperty("beginStartupToReady", toReady.toVar());
+    return juce::var(obj.get());
+}
+
+juce::var BenchmarkSuite::benchmarkVirtualDevice(const Options& options)
+{
+    const int repetitions = juce::jmax(1, options.iterations / 20);
+    juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+    
+    // JV-1080 name readback over DIN: every slot's name requested, as syncPatchNamesFromDevice() does
+    {
+        const auto device = FactoryTemplates::materialize(FactoryTemplates::indexOf("roland_jv1080"));
+        const auto protocol = device->getSysExProtocol();
+        const auto* requestFormat = protocol->getFormat(SysExProtocol::DATA_REQUEST);
+        const auto nameMap = *protocol->getAddressMap(SysExProtocol::PATCH_NAME);
+        
+        obj->setProperty("nameReadback", runVirtualDeviceScenario(*device, {}, MidiWireModel::DIN_BAUD_RATE,
+                                                                  repetitions, [&](MidiManager& midiManager)
+        {
+            for (int slot = device->getMinPatchNumber(); slot <= device->getMaxPatchNumber(); ++slot)
+            {
+                SysExMessageFormat::Fields fields;
+                fields.deviceId = protocol->getDefaultDeviceId();
+                fields.address = nameMap.getAddress(slot);
+                fields.size = (juce::uint32)nameMap.length;
+                
+                const auto request = requestFormat->encode(fields);
+                midiManager.sendSysEx(static_cast<const juce::uint8*>(request.getData()), (int)request.getSize(),
+                                      MidiManager::Priority::interactive);
+            }
+        }));
+    }
+    
+    // DX7 bank writes then a read back: over DIN the synth keeps up, over USB
+    // each 4 KB dump lands at once and overflows its input buffer
+    {
+        const auto device = FactoryTemplates::materialize(FactoryTemplates::indexOf("yamaha_dx7"));
+        const auto protocol = device->getSysExProtocol();
+        constexpr int NUM_BANKS = 4;
+        
+        juce::MemoryBlock voices(4096);
+        juce::Random random(0x5eed);
+        for (size_t i = 0; i < voices.getSize(); ++i)
+            voices[i] = (char)random.nextInt(128);
+        
+        SysExMessageFormat::Fields fields;
+        fields.deviceId = protocol->getDefaultDeviceId();
+        const auto bankDump = protocol->getFormat("bankDump")->encode(fields, static_cast<const juce::uint8*>(voices.getData()),
+                                                                      (int)voices.getSize());
+        const auto bankRequest = protocol->getFormat("bankDumpRequest")->encode(fields);
+        
+        const auto queueBankWrites = [&](MidiManager& midiManager)
+        {
+            for (int bank = 0; bank < NUM_BANKS; ++bank)
+                midiManager.sendSysEx(static_cast<const juce::uint8*>(bankDump.getData()), (int)bankDump.getSize());
+            
+            midiManager.sendSysEx(static_cast<const juce::uint8*>(bankRequest.getData()), (int)bankRequest.getSize());
+        };
+        
+        obj->setProperty("bankWriteDin", runVirtualDeviceScenario(*device, {}, MidiWireModel::DIN_BAUD_RATE,
+                                                                  repetitions, queueBankWrites));
+        
+        SimulatedSynthTransport::Config usb;
+        usb.inputBaudRate = 0.0;
+        usb.replyBaudRate = 0.0;
+        obj->setProperty("bankWriteUsb", runVirtualDeviceScenario(*device, usb, 0.0, repetitions, queueBankWrites));
+    }
+    
+    // Loopback: program changes out and back with one block of latency, at full speed
+    {
+        LoopbackMidiTransport::Options loopbackOptions;
+        loopbackOptions.latencySamples = BLOCK_SIZE;
+        
+        MidiManager midiManager;
+        LoopbackMidiTransport loopback(loopbackOptions);
+        midiManager.setTransport(&loopback);
+        midiManager.setWireBaudRate(0.0);
+        
+        MidiBlockDriver::Options driverOptions;
+        driverOptions.sampleRate = SAMPLE_RATE;
+        driverOptions.blockSize = BLOCK_SIZE;
+        driverOptions.speed = 0.0;
+        MidiBlockDriver driver(midiManager, driverOptions);
+        
+        constexpr int PER_BLOCK = 64; // The realtime lane's capacity
+        const int numBlocks = juce::jmax(1, options.iterations) * 10;
+        const auto start = juce::Time::getHighResolutionTicks();
+        
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int i = 0; i < PER_BLOCK; ++i)
+                midiManager.sendProgramChange(i);
+            
+            driver.processBlocks(1);
+        }
+        
+        driver.processBlocks(2); // Let the last block's messages come back
+        const double seconds = microsecondsSince(start) / 1.0e6;
+        midiManager.setTransport(nullptr);
+        
+        juce::DynamicObject::Ptr loop = new juce::DynamicObject();
+        loop->setProperty("messagesSent", (juce::int64)loopback.getNumMessagesReceived());
+        loop->setProperty("messagesEchoed", (juce::int64)loopback.getNumMessagesEchoed());
+        loop->setProperty("simulatedSeconds", driver.getElapsedSeconds());
+        loop->setProperty("wallSeconds", seconds);
+        loop->setProperty("messagesPerSecond", (double)loopback.getNumMessagesEchoed() / seconds);
+        obj->setProperty("loopback", juce::var(loop.get()));
+    }
+    
+    return juce::var(obj.get());
+}
+
+juce::var BenchmarkSuite::benchmarkBackup(const Options& options)
+{
+    auto directory = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                         .getNonexistentChildFile("MidiLibrarianBackupBenchmark", {});
+    
+    // A four-synth rack, simulated: every device on its own DIN port, then the two JV-1080s chained on one
+    const auto makeDevice = [](const char* templateId, const juce::String& name, const juce::String& port, int deviceId)
+    {
+        DeviceSession::Settings settings;
+        settings.device = *FactoryTemplates::materialize(FactoryTemplates::indexOf(templateId));
+        settings.name = name;
+        settings.deviceId = deviceId;
+        settings.outputName = port;
+        settings.inputName = port;
+        settings.simulate = true;
+        return settings;
+    };
+    
+    juce::Array<DeviceSession::Settings> independent;
+    independent.add(makeDevice("roland_jv1080", "JV-1080 A", "DIN 1", 16));
+    independent.add(makeDevice("roland_jv1080", "JV-1080 B", "DIN 2", 17));
+    independent.add(makeDevice("yamaha_dx7", "DX7", "DIN 3", -1));
+    independent.add(makeDevice("korg_m1", "M1", "DIN 4", -1));
+    
+    auto chained = independent;
+    chained.getReference(1).outputName = "DIN 1";
+    chained.getReference(1).inputName = "DIN 1";
+    
+    BackupScheduler::Options backupOptions;
+    backupOptions.outputDirectory = directory;
+    backupOptions.lastSlot = options.iterations >= 200 ? PatchBank::BANK_SIZE - 1 : 31;
+    
+    const auto runRack = [&](const juce::Array<DeviceSession::Settings>& rack)
+    {
+        BackupScheduler scheduler(backupOptions);
+        const auto report = scheduler.run(rack);
+        
+        juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+        obj->setProperty("links", (int)report.links.size());
+        obj->setProperty("workers", report.numWorkers);
+        obj->setProperty("patchesRead", report.patchesRead);
+        obj->setProperty("numFailed", report.numFailed);
+        obj->setProperty("modeledSeconds", report.modeledSeconds);
+        obj->setProperty("slowestDeviceSeconds", report.slowestDeviceSeconds);
+        obj->setProperty("serialSeconds", report.serialSeconds);
+        obj->setProperty("wallSeconds", report.wallSeconds);
+        return juce::var(obj.get());
+    };
+    
+    juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+    obj->setProperty("slots", backupOptions.lastSlot + 1);
+    obj->setProperty("independentLinks", runRack(independent));
+    obj->setProperty("sharedChain", runRack(chained));
+    
+    directory.deleteRecursively();
+    return juce::var(obj.get());
+}
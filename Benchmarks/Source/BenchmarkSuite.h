@@ -0,0 +1,67 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Headless benchmarks for the Model and Controller code.
+ * 
+ * Each benchmark returns a JSON-ready var; run() collects them with some
+ * machine information into one report, so results can be stored and
+ * compared between builds to catch regressions:
+ * 
+ * - outputDrain: MidiManager::processAudioThread() time per block with a
+ *   given number of messages waiting in each priority lane
+ * - programChangeThroughput: sendProgramChange() calls per second from
+ *   several threads while another thread drains as the audio thread would
+ * - search: PatchData::matchesSearchQuery() and the patch list's filter
+ *   over synthetic libraries of 128 patches up to Options::maxLibrarySize
+ * - similarity: PatchSimilarityIndex queries over 100k patches (fewer if
+ *   Options::maxLibrarySize is smaller), the scalar var walk against the
+ *   SIMD matrix, with the top-k mismatches between them (expect 0)
+ * - persistence: PersistenceManager::savePatchBank()/loadPatchBank() latency
+ *   for banks with names only, with parameters and with patch dumps
+ * - telemetry: MidiTelemetry's cost per recorded event, with and without
+ *   taking the timestamp (budget: 50 ns)
+ * - startup: PatchManager construction (what a scanning host pays) and
+ *   beginStartup() to ready, with a full library and user templates on disk
+ * - virtualDevice: scenarios against SimulatedSynthTransport at full speed
+ *   (JV-1080 name readback, DX7 bank writes over DIN and over USB) with
+ *   simulated and wall-clock time, and LoopbackMidiTransport round trips
+ * - backup: BackupScheduler over a simulated four-synth rack, each synth on
+ *   its own port and then two sharing a DIN chain, with the modeled backup
+ *   time next to the slowest device's and the one-after-another total
+ * 
+ * outputDrain and programChangeThroughput send into a LoopbackMidiTransport
+ * sink, so messages are queued and drained as they would be to an open port.
+ * 
+ * Times are in microseconds unless a key says otherwise. The persistence and
+ * startup benchmarks write to a scratch folder in the temp directory, never
+ * to the user's library.
+ */
+class BenchmarkSuite
+{
+public:
+    struct Options
+    {
+        int iterations = 200;               // Samples per measurement (search scales this down for big libraries)
+        int maxLibrarySize = 1000000;       // Largest synthetic library for the search benchmark
+        int maxThreads = 8;                 // Largest sender count for the throughput benchmark
+        double throughputSeconds = 0.5;     // Duration of each throughput run
+        juce::StringArray only;             // Benchmark names to run (empty = all)
+    };
+    
+    BenchmarkSuite() = delete;
+    
+    static juce::var run(const Options& options);
+    static juce::StringArray getBenchmarkNames();
+    
+    static juce::var benchmarkOutputDrain(const Options& options);
+    static juce::var benchmarkProgramChangeThroughput(const Options& options);
+    static juce::var benchmarkSearch(const Options& options);
+    static juce::var benchmarkSimilarity(const Options& options);
+    static juce::var benchmarkPersistence(const Options& options);
+    static juce::var benchmarkTelemetry(const Options& options);
+    static juce::var benchmarkStartup(const Options& options);
+    static juce::var benchmarkVirtualDevice(const Options& options);
+    static juce::var benchmarkBackup(const Options& options);
+};
@@ -0,0 +1,72 @@
+#include <JuceHeader.h>
+#include "BenchmarkSuite.h"
+#include "../../Source/Model/PatchBank.h"
+#include <iostream>
+
+/**
+ * Console entry point for the benchmarks.
+ * 
+ * Usage: LibrarianBenchmarks [--quick] [--only=name,name] [--max-patches=N]
+ *                            [--threads=N] [--output=file.json]
+ * 
+ * Prints the JSON report to stdout unless --output is given.
+ */
+int main(int argc, char* argv[])
+{
+    // ChangeBroadcaster and AsyncUpdater need a message manager, even without a running loop
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    
+    juce::ArgumentList args(argc, argv);
+    BenchmarkSuite::Options options;
+    
+    if (args.containsOption("--help|-h"))
+    {
+        std::cout << "Usage: " << args.executableName << " [--quick] [--only=name,name] [--max-patches=N]"
+                  << " [--threads=N] [--output=file.json]" << std::endl
+                  << "Benchmarks: " << BenchmarkSuite::getBenchmarkNames().joinIntoString(", ") << std::endl;
+        return 0;
+    }
+    
+    if (args.containsOption("--quick"))
+    {
+        options.iterations = 20;
+        options.maxLibrarySize = 100000;
+        options.throughputSeconds = 0.1;
+    }
+    
+    if (args.containsOption("--only"))
+        options.only.addTokens(args.getValueForOption("--only"), ",", {});
+    
+    if (args.containsOption("--max-patches"))
+        options.maxLibrarySize = juce::jmax(PatchBank::BANK_SIZE, args.getValueForOption("--max-patches").getIntValue());
+    
+    if (args.containsOption("--threads"))
+        options.maxThreads = juce::jmax(1, args.getValueForOption("--threads").getIntValue());
+    
+    for (const auto& name : options.only)
+    {
+        if (!BenchmarkSuite::getBenchmarkNames().contains(name))
+        {
+            std::cerr << "Unknown benchmark: " << name << std::endl;
+            return 1;
+        }
+    }
+    
+    const auto json = juce::JSON::toString(BenchmarkSuite::run(options));
+    
+    if (args.containsOption("--output"))
+    {
+        const auto file = args.getFileForOption("--output");
+        if (!file.replaceWithText(json))
+        {
+            std::cerr << "Couldn't write " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << json << std::endl;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,632 @@
+#include "LibrarianCommandLine.h"
+#include "../../Source/Controller/BackupScheduler.h"
+#include "../../Source/Controller/MidiDeviceWatcher.h"
+#include "../../Source/Controller/PatchManager.h"
+#include "../../Source/Controller/PersistenceManager.h"
+#include "../../Source/Controller/SharedLibrary.h"
+#include "../../Source/Controller/TraceRecorder.h"
+#include <iostream>
+
+namespace
+{
+    int fail(const juce::String& message, int exitCode)
+    {
+        std::cerr << message << std::endl;
+        return exitCode;
+    }
+    
+    /** "5" or "1-32", 1-based as the editor shows slots; stored 0-based. */
+    bool parseSlots(const juce::String& text, int& firstSlot, int& lastSlot)
+    {
+        if (text.isEmpty())
+        {
+            firstSlot = 0;
+            lastSlot = PatchBank::BANK_SIZE - 1;
+            return true;
+        }
+        
+        const auto first = text.upToFirstOccurrenceOf("-", false, false).trim();
+        const auto last = text.containsChar('-') ? text.fromFirstOccurrenceOf("-", false, false).trim() : first;
+        
+        if (!first.containsOnly("0123456789") || !last.containsOnly("0123456789") || first.isEmpty() || last.isEmpty())
+            return false;
+        
+        firstSlot = first.getIntValue() - 1;
+        lastSlot = last.getIntValue() - 1;
+        return firstSlot >= 0 && firstSlot <= lastSlot && lastSlot < PatchBank::BANK_SIZE;
+    }
+    
+    bool parseFormat(const juce::String& text, PersistenceManager::FileFormat& format)
+    {
+        if (text.isEmpty() || text == "json")
+            format = PersistenceManager::FileFormat::json;
+        else if (text == "bin" || text == "binary")
+            format = PersistenceManager::FileFormat::binary;
+        else if (text == "syx" || text == "sysex")
+            format = PersistenceManager::FileFormat::sysEx;
+        else
+            return false;
+        
+        return true;
+    }
+    
+    juce::String describePatch(const PatchData& patch)
+    {
+        auto line = juce::String(patch.getSlotIndex() + 1).paddedLeft(' ', 4) + "  " + patch.getPatchName();
+        
+        if (!patch.getTags().isEmpty())
+            line << "  [" << patch.getTags().joinIntoString(", ") << "]";
+        
+        if (patch.isFavorite())
+            line << "  *";
+        
+        return line;
+    }
+    
+    juce::String formatThroughput(const DeviceSession::Statistics& statistics)
+    {
+        const int numPatches = statistics.patchesRead + statistics.patchesWritten;
+        const double seconds = juce::jmax(1.0e-6, statistics.seconds);
+        
+        return juce::String(numPatches) + " patches in " + juce::String(statistics.seconds, 2) + " s ("
+             + juce::String(numPatches / seconds, 1) + " patches/s, "
+             + juce::String((double)(statistics.bytesSent + statistics.bytesReceived) / seconds / 1024.0, 2) + " KB/s)";
+    }
+}
+
+struct LibrarianCommandLine::Context
+{
+    explicit Context(const juce::ArgumentList& arguments) : args(arguments)
+    {
+        templates.indexNow();
+        templates.setWatchingDirectory(false);
+    }
+    
+    juce::String get(const char* option) const
+    {
+        return args.containsOption(option) ? args.getValueForOption(option) : juce::String();
+    }
+    
+    juce::File getFile(const char* option) const
+    {
+        return args.containsOption(option) ? args.getFileForOption(option) : juce::File();
+    }
+    
+    /** The rack's devices, or those named by --devices (or --device). */
+    juce::Result loadDevices(juce::Array<DeviceSession::Settings>& devices)
+    {
+        const auto rackFile = getFile("--rack");
+        if (rackFile == juce::File())
+            return juce::Result::fail("No rack file (--rack=file.json)");
+        
+        auto result = loadRack(rackFile, templates, args.containsOption("--simulate"), devices);
+        if (result.failed())
+            return result;
+        
+        juce::StringArray wanted;
+        wanted.addTokens(get("--devices").isNotEmpty() ? get("--devices") : get("--device"), ",", "\"");
+        wanted.trim();
+        wanted.removeEmptyStrings();
+        
+        if (wanted.isEmpty())
+            return juce::Result::ok();
+        
+        juce::Array<DeviceSession::Settings> selected;
+        
+        for (const auto& name : wanted)
+        {
+            const auto* match = std::find_if(devices.begin(), devices.end(),
+                                             [&name](const DeviceSession::Settings& d) { return d.name == name; });
+            if (match == devices.end())
+                return juce::Result::fail("No device named \"" + name + "\" in " + rackFile.getFileName());
+            
+            selected.add(*match);
+        }
+        
+        devices.swapWith(selected);
+        return juce::Result::ok();
+    }
+    
+    /** Codec for --template, or nullptr if none was given. */
+    std::unique_ptr<PatchSysExCodec> getTemplateCodec() const
+    {
+        const auto id = get("--template");
+        if (id.isEmpty() || !templates.hasTemplate(id))
+            return nullptr;
+        
+        return std::make_unique<PatchSysExCodec>(templates.getTemplate(id));
+    }
+    
+    void writeReport(const juce::String& command) const
+    {
+        report->setProperty("command", command);
+        report->setProperty("timestamp", juce::Time::getCurrentTime().toISO8601(true));
+        
+        if (args.containsOption("--report"))
+        {
+            const auto file = args.getFileForOption("--report");
+            if (!file.replaceWithText(juce::JSON::toString(juce::var(report.get()))))
+                std::cerr << "Couldn't write " << file.getFullPathName() << std::endl;
+        }
+    }
+    
+    const juce::ArgumentList& args;
+    DeviceTemplateManager templates { PersistenceManager::getDefaultDataDirectory().getChildFile("templates") };
+    juce::DynamicObject::Ptr report = new juce::DynamicObject();
+};
+
+juce::String LibrarianCommandLine::getUsage(const juce::String& executableName)
+{
+    return "Usage: " + executableName + " <command> [options]\n"
+           "\n"
+           "  recall   --rack=FILE --device=NAME --slot=N\n"
+           "  dump     --rack=FILE [--devices=A,B] [--output=DIR] [--format=json|bin|syx] [--slots=1-128]\n"
+           "           [--workers=N] [--chunk=N] [--retries=N] [--link-limit=N]\n"
+           "  restore  --rack=FILE --device=NAME --input=FILE [--slots=1-128]\n"
+           "  import   --input=FILE [--template=ID]\n"
+           "  export   --output=FILE [--template=ID]\n"
+           "  convert  --input=FILE --output=FILE [--template=ID]\n"
+           "  search   --query=TEXT [--input=FILE] [--template=ID]\n"
+           "           --like=SLOT [--count=N] [--input=FILE --template=ID]\n"
+           "  ports\n"
+           "\n"
+           "  --data=DIR      Library folder instead of the plugin's\n"
+           "  --simulate      Simulated synths instead of the rack's MIDI ports\n"
+           "  --report=FILE   Write the JSON report\n"
+           "  --trace=FILE    Record the command as a Chrome trace (builds with MIDI_LIBRARIAN_TRACING=1)\n"
+           "\n"
+           "Bank files: .json, .bin (binary) or .syx (needs the device template)\n";
+}
+
+int LibrarianCommandLine::run(const juce::ArgumentList& args)
+{
+    if (args.size() == 0 || args.containsOption("--help|-h"))
+    {
+        std::cout << getUsage(args.executableName);
+        return args.size() == 0 ? usageError : success;
+    }
+    
+    // Before anything opens the library
+    if (args.containsOption("--data"))
+        PersistenceManager::setDefaultDataDirectory(args.getFileForOption("--data"));
+    
+    const auto traceFile = args.containsOption("--trace") ? args.getFileForOption("--trace") : juce::File();
+    if (traceFile != juce::File() && !TraceRecorder::isCompiledIn())
+        return fail("--trace needs a build with MIDI_LIBRARIAN_TRACING=1", usageError);
+    
+    using Command = int (*)(Context&);
+    
+    static const std::pair<const char*, Command> commands[] =
+    {
+        { "recall", &LibrarianCommandLine::recall },
+        { "dump", &LibrarianCommandLine::dump },
+        { "restore", &LibrarianCommandLine::restore },
+        { "import", &LibrarianCommandLine::importBank },
+        { "export", &LibrarianCommandLine::exportBank },
+        { "convert", &LibrarianCommandLine::convert },
+        { "search", &LibrarianCommandLine::search },
+        { "ports", &LibrarianCommandLine::listPorts }
+    };
+    
+    const auto name = args[0].text;
+    
+    for (const auto& command : commands)
+    {
+        if (name == command.first)
+        {
+            Context context(args);
+            TraceRecorder::setEnabled(traceFile != juce::File());
+            const int exitCode = command.second(context);
+            
+            if (traceFile != juce::File())
+            {
+                TraceRecorder::setEnabled(false);
+                if (!TraceRecorder::writeChromeTrace(traceFile))
+                    std::cerr << "Couldn't write " << traceFile.getFullPathName() << std::endl;
+            }
+            
+            context.report->setProperty("exitCode", exitCode);
+            context.writeReport(name);
+            return exitCode;
+        }
+    }
+    
+    return fail("Unknown command: " + name + "\n\n" + getUsage(args.executableName), usageError);
+}
+
+juce::Result LibrarianCommandLine::loadRack(const juce::File& file, DeviceTemplateManager& templates, bool simulateAll,
+                                            juce::Array<DeviceSession::Settings>& devices)
+{
+    if (!file.existsAsFile())
+        return juce::Result::fail("No such rack file: " + file.getFullPathName());
+    
+    const auto rack = juce::JSON::parse(file);
+    const auto* list = rack["devices"].getArray();
+    
+    if (list == nullptr)
+        return juce::Result::fail(file.getFileName() + " has no \"devices\" list");
+    
+    devices.clearQuick();
+    
+    for (const auto& entry : *list)
+    {
+        const auto templateId = entry["template"].toString();
+        
+        if (templateId.isEmpty() || !templates.hasTemplate(templateId))
+            return juce::Result::fail(file.getFileName() + ": unknown template \"" + templateId + "\"");
+        
+        DeviceSession::Settings settings;
+        settings.device = templates.getTemplate(templateId);
+        settings.name = entry.getProperty("name", settings.device.getDeviceName()).toString();
+        settings.midiChannel = juce::jlimit(1, 16, (int)entry.getProperty("channel", settings.device.getDefaultChannel()));
+        settings.deviceId = entry.getProperty("deviceId", -1);
+        settings.outputName = entry["output"].toString();
+        settings.outputIdentifier = entry["outputId"].toString();
+        settings.inputName = entry["input"].toString();
+        settings.inputIdentifier = entry["inputId"].toString();
+        settings.link = entry["link"].toString();
+        settings.wireBaudRate = entry.getProperty("baudRate", MidiWireModel::DIN_BAUD_RATE);
+        settings.timeoutMs = entry.getProperty("timeoutMs", settings.timeoutMs);
+        settings.maxRetries = entry.getProperty("retries", settings.maxRetries);
+        settings.maxInFlight = entry.getProperty("inFlight", settings.maxInFlight);
+        settings.writeGapMs = entry.getProperty("writeGapMs", settings.writeGapMs);
+        settings.simulate = simulateAll || (bool)entry.getProperty("simulate", false);
+        
+        for (const auto& other : devices)
+            if (other.name == settings.name)
+                return juce::Result::fail(file.getFileName() + ": two devices named \"" + settings.name + "\"");
+        
+        if (!settings.simulate && settings.outputName.isEmpty() && settings.outputIdentifier.isEmpty())
+            return juce::Result::fail(file.getFileName() + ": \"" + settings.name + "\" has no output port");
+        
+        devices.add(settings);
+    }
+    
+    return juce::Result::ok();
+}
+
+juce::Result LibrarianCommandLine::loadLinkLimits(const juce::File& file, std::map<juce::String, int>& limits)
+{
+    const auto rack = juce::JSON::parse(file);
+    const auto* links = rack["links"].getDynamicObject();
+    
+    if (links == nullptr)
+        return juce::Result::ok();
+    
+    for (const auto& link : links->getProperties())
+    {
+        if (!(link.value.isInt() || link.value.isInt64()) || (int)link.value < 1)
+            return juce::Result::fail(file.getFileName() + ": link \"" + link.name.toString() + "\" needs a limit of 1 or more");
+        
+        limits[link.name.toString()] = link.value;
+    }
+    
+    return juce::Result::ok();
+}
+
+int LibrarianCommandLine::recall(Context& context)
+{
+    juce::Array<DeviceSession::Settings> devices;
+    auto result = context.loadDevices(devices);
+    if (result.failed())
+        return fail(result.getErrorMessage(), usageError);
+    
+    int slot = 0, lastSlot = 0;
+    if (devices.size() != 1 || !parseSlots(context.get("--slot"), slot, lastSlot) || slot != lastSlot)
+        return fail("recall needs one --device and one --slot", usageError);
+    
+    DeviceSession session(devices.getReference(0));
+    result = session.open();
+    
+    if (result.wasOk())
+        result = session.recall(slot);
+    
+    context.report->setProperty("device", session.getName());
+    context.report->setProperty("slot", slot + 1);
+    
+    if (result.failed())
+        return fail(result.getErrorMessage(), deviceError);
+    
+    std::cout << session.getName() << ": recalled slot " << slot + 1 << std::endl;
+    return success;
+}
+
+int LibrarianCommandLine::dump(Context& context)
+{
+    juce::Array<DeviceSession::Settings> devices;
+    auto result = context.loadDevices(devices);
+    if (result.failed())
+        return fail(result.getErrorMessage(), usageError);
+    
+    BackupScheduler::Options options;
+    
+    if (!parseFormat(context.get("--format"), options.format))
+        return fail("Unknown format: " + context.get("--format"), usageError);
+    
+    if (!parseSlots(context.get("--slots"), options.firstSlot, options.lastSlot))
+        return fail("Bad slot range: " + context.get("--slots"), usageError);
+    
+    result = loadLinkLimits(context.getFile("--rack"), options.linkLimits);
+    if (result.failed())
+        return fail(result.getErrorMessage(), usageError);
+    
+    options.outputDirectory = context.args.containsOption("--output") ? context.getFile("--output")
+                                                                      : juce::File::getCurrentWorkingDirectory();
+    
+    if (context.args.containsOption("--workers"))
+        options.maxWorkers = juce::jmax(1, context.get("--workers").getIntValue());
+    
+    if (context.args.containsOption("--chunk"))
+        options.chunkSize = juce::jlimit(1, PatchBank::BANK_SIZE, context.get("--chunk").getIntValue());
+    
+    if (context.args.containsOption("--retries"))
+        options.maxChunkRetries = juce::jmax(0, context.get("--retries").getIntValue());
+    
+    if (context.args.containsOption("--link-limit"))
+        options.defaultLinkLimit = juce::jmax(1, context.get("--link-limit").getIntValue());
+    
+    if (!options.outputDirectory.isDirectory() && !options.outputDirectory.createDirectory())
+        return fail("Couldn't create " + options.outputDirectory.getFullPathName(), usageError);
+    
+    juce::CriticalSection printLock;
+    BackupScheduler scheduler(options);
+    
+    const auto report = scheduler.run(devices, [&printLock](const BackupScheduler::DeviceResult& device)
+    {
+        const juce::ScopedLock sl(printLock);
+        std::cout << device.name << " [" << device.link << "]: " << formatThroughput(device.statistics)
+                  << (device.namesOnly ? "  NAMES ONLY" : "")
+                  << (device.error.isNotEmpty() ? "  FAILED: " + device.error : juce::String()) << std::endl;
+    });
+    
+    context.report->setProperty("format", PersistenceManager::getFileFormatName(options.format));
+    context.report->setProperty("backup", report.toVar());
+    
+    std::cout << devices.size() << " device(s) on " << (int)report.links.size() << " link(s), "
+              << report.patchesRead << " patches in " << juce::String(report.modeledSeconds, 2) << " s"
+              << " (slowest device " << juce::String(report.slowestDeviceSeconds, 2) << " s, one after another "
+              << juce::String(report.serialSeconds, 2) << " s; wall " << juce::String(report.wallSeconds, 2)
+              << " s with " << report.numWorkers << " worker(s))" << std::endl;
+    
+    if (report.numNamesOnly > 0)
+        std::cerr << report.numNamesOnly << " device(s) backed up names only: their templates have no \"patch\""
+                  << " address map, so the files hold no sounds" << std::endl;
+    
+    return report.numFailed > 0 ? deviceError : success;
+}
+
+int LibrarianCommandLine::restore(Context& context)
+{
+    juce::Array<DeviceSession::Settings> devices;
+    auto result = context.loadDevices(devices);
+    if (result.failed())
+        return fail(result.getErrorMessage(), usageError);
+    
+    int firstSlot = 0, lastSlot = 0;
+    const auto input = context.getFile("--input");
+    
+    if (devices.size() != 1 || input == juce::File())
+        return fail("restore needs one --device and an --input file", usageError);
+    
+    if (!parseSlots(context.get("--slots"), firstSlot, lastSlot))
+        return fail("Bad slot range: " + context.get("--slots"), usageError);
+    
+    DeviceSession session(devices.getReference(0));
+    PatchBank bank;
+    PersistenceManager persistence;
+    
+    result = persistence.importFromFile(bank, input, PersistenceManager::getFileFormat(input), &session.getCodec());
+    if (result.failed())
+        return fail(result.getErrorMessage(), usageError);
+    
+    result = session.open();
+    if (result.wasOk())
+        result = session.restore(bank, firstSlot, lastSlot);
+    
+    context.report->setProperty("device", session.getName());
+    context.report->setProperty("statistics", session.getStatistics().toVar());
+    
+    if (result.failed())
+        return fail(result.getErrorMessage(), deviceError);
+    
+    std::cout << session.getName() << ": " << formatThroughput(session.getStatistics()) << std::endl;
+    return success;
+}
+
+int LibrarianCommandLine::importBank(Context& context)
+{
+    const auto input = context.getFile("--input");
+    if (input == juce::File())
+        return fail("import needs an --input file", usageError);
+    
+    PatchManager patchManager;
+    patchManager.beginStartup();
+    patchManager.waitUntilReady();
+    
+    // .syx is read as the library's device unless --template names another (which then becomes the library's)
+    if (context.get("--template").isNotEmpty())
+    {
+        if (!context.templates.hasTemplate(context.get("--template")))
+            return fail("Unknown template: " + context.get("--template"), usageError);
+        
+        patchManager.setDeviceTemplate(context.templates.getTemplate(context.get("--template")));
+    }
+    
+    auto result = patchManager.importPatches(input);
+    juce::SharedResourcePointer<SharedLibrary>()->flush();
+    
+    if (result.failed())
+        return fail(result.getErrorMessage(), usageError);
+    
+    context.report->setProperty("input", input.getFullPathName());
+    std::cout << "Imported " << input.getFileName() << " into the library" << std::endl;
+    return success;
+}
+
+int LibrarianCommandLine::exportBank(Context& context)
+{
+    const auto output = context.getFile("--output");
+    if (output == juce::File())
+        return fail("export needs an --output file", usageError);
+    
+    PatchManager patchManager;
+    patchManager.beginStartup();
+    patchManager.waitUntilReady();
+    
+    if (context.get("--template").isNotEmpty())
+    {
+        if (!context.templates.hasTemplate(context.get("--template")))
+            return fail("Unknown template: " + context.get("--template"), usageError);
+        
+        patchManager.setDeviceTemplate(context.templates.getTemplate(context.get("--template")));
+    }
+    
+    auto result = patchManager.exportPatches(output);
+    if (result.failed())
+        return fail(result.getErrorMessage(), usageError);
+    
+    context.report->setProperty("output", output.getFullPathName());
+    std::cout << "Exported the library to " << output.getFullPathName() << std::endl;
+    return success;
+}
+
+int LibrarianCommandLine::convert(Context& context)
+{
+    const auto input = context.getFile("--input");
+    const auto output = context.getFile("--output");
+    
+    if (input == juce::File() || output == juce::File())
+        return fail("convert needs --input and --output files", usageError);
+    
+    const auto codec = context.getTemplateCodec();
+    if (context.get("--template").isNotEmpty() && codec == nullptr)
+        return fail("Unknown template: " + context.get("--template"), usageError);
+    
+    PersistenceManager persistence;
+    PatchBank bank;
+    
+    auto result = persistence.importFromFile(bank, input, PersistenceManager::getFileFormat(input), codec.get());
+    if (result.wasOk())
+        result = persistence.exportToFile(bank, output, PersistenceManager::getFileFormat(output), codec.get());
+    
+    if (result.failed())
+        return fail(result.getErrorMessage(), usageError);
+    
+    context.report->setProperty("input", input.getFullPathName());
+    context.report->setProperty("output", output.getFullPathName());
+    std::cout << "Converted " << input.getFileName() << " to " << output.getFileName() << std::endl;
+    return success;
+}
+
+int LibrarianCommandLine::search(Context& context)
+{
+    const auto query = context.get("--query");
+    const auto input = context.getFile("--input");
+    PatchBank bank;
+    
+    // --like: the patches nearest one slot's parameters, closest first (see PatchSimilarityIndex)
+    int likeSlot = -1, lastSlot = -1;
+    const auto like = context.get("--like");
+    if (like.isNotEmpty() && (!parseSlots(like, likeSlot, lastSlot) || likeSlot != lastSlot))
+        return fail("Bad slot: " + like, usageError);
+    
+    const int count = context.get("--count").isNotEmpty() ? juce::jmax(1, context.get("--count").getIntValue()) : 10;
+    juce::Array<PatchSimilarityIndex::Match> similar;
+    
+    if (input != juce::File())
+    {
+        const auto codec = context.getTemplateCodec();
+        PersistenceManager persistence;
+        
+        auto result = persistence.importFromFile(bank, input, PersistenceManager::getFileFormat(input), codec.get());
+        if (result.failed())
+            return fail(result.getErrorMessage(), usageError);
+        
+        if (likeSlot >= 0)
+        {
+            // A bank file doesn't say which device it's for; the template's parameter map does
+            if (codec == nullptr)
+                return fail("search --like with an --input file needs its --template", usageError);
+            
+            PatchSimilarityIndex index;
+            index.rebuild(context.templates.getTemplate(context.get("--template")).getParameterMap(), bank.getPatches());
+            similar = index.findSimilar(likeSlot, count);
+        }
+    }
+    else
+    {
+        PatchManager patchManager;
+        patchManager.beginStartup();
+        patchManager.waitUntilReady();
+        bank.setPatches(patchManager.getPatchBank().getPatches());
+        
+        if (likeSlot >= 0)
+            similar = patchManager.findSimilarPatches(likeSlot, count);
+    }
+    
+    juce::Array<juce::var> matches;
+    
+    const auto addMatch = [&](const PatchData& patch, const juce::var& distance)
+    {
+        if (query.isNotEmpty() && !patch.matchesSearchQuery(query))
+            return;
+        
+        auto match = patch.toVar();
+        auto line = describePatch(patch);
+        
+        if (!distance.isVoid())
+        {
+            match.getDynamicObject()->setProperty("distance", distance);
+            line << "  (" << juce::String((double)distance, 3) << ")";
+        }
+        
+        std::cout << line << std::endl;
+        matches.add(match);
+    };
+    
+    if (likeSlot >= 0)
+    {
+        for (const auto& similarPatch : similar)
+            addMatch(bank.getPatches().getReference(similarPatch.patchIndex), similarPatch.distance);
+        
+        context.report->setProperty("like", likeSlot + 1);
+    }
+    else
+    {
+        for (const auto& patch : bank.getPatches())
+            addMatch(patch, {});
+    }
+    
+    context.report->setProperty("query", query);
+    context.report->setProperty("matches", matches);
+    std::cout << matches.size() << " match(es)" << std::endl;
+    return success;
+}
+
+int LibrarianCommandLine::listPorts(Context& context)
+{
+    juce::SharedResourcePointer<MidiDeviceWatcher> watcher;
+    const auto devices = watcher->getDeviceList(true);
+    
+    const auto list = [](const char* heading, const juce::Array<juce::MidiDeviceInfo>& ports)
+    {
+        juce::Array<juce::var> result;
+        std::cout << heading << ":" << std::endl;
+        
+        for (const auto& port : ports)
+        {
+            std::cout << "  " << port.name << "  (" << port.identifier << ")" << std::endl;
+            
+            juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+            obj->setProperty("name", port.name);
+            obj->setProperty("identifier", port.identifier);
+            result.add(juce::var(obj.get()));
+        }
+        
+        return result;
+    };
+    
+    context.report->setProperty("outputs", list("Outputs", devices->outputs));
+    context.report->setProperty("inputs", list("Inputs", devices->inputs));
+    return success;
+}
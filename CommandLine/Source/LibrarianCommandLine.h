@@ -0,0 +1,81 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/Controller/DeviceSession.h"
+#include "../../Source/Controller/DeviceTemplateManager.h"
+#include <map>
+
+/**
+ * The librarian without a DAW, for scripts and scheduled backups.
+ * 
+ * Commands:
+ * - recall: send a slot's program change to a rack device
+ * - dump: back up every listed rack device into bank files through a
+ *   BackupScheduler: devices on separate links at once, in chunks of slots
+ *   (--chunk) retried when they fail (--retries), files saved as they arrive.
+ *   A device whose template reads names only is flagged NAMES ONLY
+ * - restore: write a bank file's dumps to a rack device
+ * - import / export: move a bank file into or out of the library, through
+ *   PatchManager as the editor does
+ * - convert: between JSON, binary (.bin) and SysEx (.syx) bank files
+ * - search: list the patches of the library or a bank file matching a query
+ * - ports: list the MIDI ports, with the identifiers a rack file can use
+ * 
+ * The rack file describes the devices (see loadRack()). Every device can
+ * be simulated (--simulate, or "simulate" per device) to try a rack file or
+ * a script without hardware. The library folder is the plugin's unless
+ * --data names another.
+ * 
+ * Each command prints a summary; --report writes the JSON report and --trace
+ * a Chrome trace of the command (in tracing builds). The exit
+ * code is 0 on success, 1 for usage and file errors, 2 if a device failed.
+ */
+class LibrarianCommandLine
+{
+public:
+    LibrarianCommandLine() = delete;
+    
+    /** Runs the command named by the first argument; call on the message thread. */
+    static int run(const juce::ArgumentList& args);
+    static juce::String getUsage(const juce::String& executableName);
+    
+    /**
+     * Reads a rack file:
+     * {
+     *     "devices": [
+     *         { "name": "JV rack", "template": "roland_jv1080", "channel": 1,
+     *           "output": "USB MIDI 1", "outputId": "...", "input": "USB MIDI 1", "inputId": "...",
+     *           "deviceId": 16, "baudRate": 31250, "timeoutMs": 400, "retries": 2,
+     *           "inFlight": 4, "writeGapMs": 20, "link": "DIN chain A", "simulate": false }
+     *     ],
+     *     "links": { "DIN chain A": 1 }
+     * }
+     * Only "template" is required; names must be unique. "link" names a DIN
+     * chain or merger the device shares with others; without one, devices
+     * sharing a port are on one link (see BackupScheduler).
+     */
+    static juce::Result loadRack(const juce::File& file, DeviceTemplateManager& templates, bool simulateAll,
+                                 juce::Array<DeviceSession::Settings>& devices);
+    
+    /** The rack file's "links": how many chunks each link may run at once (default 1, or --link-limit). */
+    static juce::Result loadLinkLimits(const juce::File& file, std::map<juce::String, int>& limits);
+    
+private:
+    enum ExitCode
+    {
+        success = 0,
+        usageError = 1,
+        deviceError = 2
+    };
+    
+    struct Context;
+    
+    static int recall(Context& context);
+    static int dump(Context& context);
+    static int restore(Context& context);
+    static int importBank(Context& context);
+    static int exportBank(Context& context);
+    static int convert(Context& context);
+    static int search(Context& context);
+    static int listPorts(Context& context);
+};
@@ -0,0 +1,17 @@
+#include <JuceHeader.h>
+#include "LibrarianCommandLine.h"
+
+/**
+ * Console entry point for the command-line librarian.
+ * 
+ * Usage: LibrarianCli <command> [options]; --help lists the commands.
+ * Exits with 0 on success, 1 for usage and file errors and 2 if a device
+ * failed, so a scheduled backup can alert on it.
+ */
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    
+    juce::ArgumentList args(argc, argv);
+    return LibrarianCommandLine::run(args);
+}
@@ -0,0 +1,388 @@
+#include "BackupScheduler.h"
+#include "TraceRecorder.h"
+
+namespace
+{
+    /** Splits ascending slots into contiguous [first, last] runs, as DeviceSession::dump() reads them. */
+    std::vector<std::pair<int, int>> getRuns(const juce::Array<int>& slots)
+    {
+        std::vector<std::pair<int, int>> runs;
+        
+        for (int slot : slots)
+        {
+            if (!runs.empty() && runs.back().second == slot - 1)
+                runs.back().second = slot;
+            else
+                runs.emplace_back(slot, slot);
+        }
+        
+        return runs;
+    }
+    
+    juce::String getPortKey(const char* direction, const juce::String& identifier, const juce::String& name)
+    {
+        if (identifier.isNotEmpty())
+            return juce::String(direction) + ":" + identifier;
+        
+        return name.isNotEmpty() ? juce::String(direction) + ":" + name : juce::String();
+    }
+}
+
+juce::var BackupScheduler::DeviceResult::toVar() const
+{
+    juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+    obj->setProperty("name", name);
+    obj->setProperty("link", link);
+    obj->setProperty("file", file.getFullPathName());
+    obj->setProperty("chunks", chunks);
+    obj->setProperty("chunkRetries", chunkRetries);
+    obj->setProperty("patchesMissing", patchesMissing);
+    obj->setProperty("namesOnly", namesOnly);
+    obj->setProperty("seconds", seconds);
+    obj->setProperty("modeledEndSeconds", modeledEndSeconds);
+    obj->setProperty("statistics", statistics.toVar());
+    
+    if (error.isNotEmpty())
+        obj->setProperty("error", error);
+    
+    return juce::var(obj.get());
+}
+
+juce::var BackupScheduler::Report::toVar() const
+{
+    juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+    obj->setProperty("numWorkers", numWorkers);
+    obj->setProperty("numFailed", numFailed);
+    obj->setProperty("numNamesOnly", numNamesOnly);
+    obj->setProperty("patchesRead", patchesRead);
+    obj->setProperty("wallSeconds", wallSeconds);
+    obj->setProperty("modeledSeconds", modeledSeconds);
+    obj->setProperty("slowestDeviceSeconds", slowestDeviceSeconds);
+    obj->setProperty("serialSeconds", serialSeconds);
+    
+    juce::DynamicObject::Ptr linkObj = new juce::DynamicObject();
+    for (const auto& link : links)
+        linkObj->setProperty(link.first, link.second);
+    obj->setProperty("links", juce::var(linkObj.get()));
+    
+    juce::Array<juce::var> deviceList;
+    for (const auto& device : devices)
+        deviceList.add(device.toVar());
+    obj->setProperty("devices", deviceList);
+    
+    return juce::var(obj.get());
+}
+
+BackupScheduler::BackupScheduler(const Options& options_)
+    : options(options_)
+{
+    jassert(options.chunkSize > 0 && options.firstSlot <= options.lastSlot);
+}
+
+juce::StringArray BackupScheduler::assignLinks(const juce::Array<DeviceSession::Settings>& devices)
+{
+    // Union-find over port keys: two devices sharing any port end up with one root
+    std::map<juce::String, juce::String> parent;
+    
+    const std::function<juce::String(const juce::String&)> find = [&](const juce::String& key)
+    {
+        auto& up = parent[key];
+        if (up.isEmpty() || up == key)
+            return up = key;
+        
+        return up = find(up);
+    };
+    
+    std::vector<juce::StringArray> portsByDevice;
+    
+    for (const auto& device : devices)
+    {
+        juce::StringArray ports;
+        
+        if (device.link.isEmpty())
+        {
+            ports.add(getPortKey("out", device.outputIdentifier, device.outputName));
+            ports.add(getPortKey("in", device.inputIdentifier, device.inputName));
+            ports.removeEmptyStrings();
+            
+            for (int i = 1; i < ports.size(); ++i)
+            {
+                const auto a = find(ports[0]), b = find(ports[i]);
+                if (a != b)
+                    parent[b] = a;
+            }
+        }
+        
+        portsByDevice.push_back(ports);
+    }
+    
+    juce::StringArray result;
+    
+    for (int i = 0; i < devices.size(); ++i)
+    {
+        const auto& device = devices.getReference(i);
+        const auto& ports = portsByDevice[(size_t)i];
+        
+        if (device.link.isNotEmpty())
+            result.add(device.link);
+        else if (!ports.isEmpty())
+            result.add(find(ports[0]));
+        else
+            result.add("device:" + (device.name.isNotEmpty() ? device.name : juce::String(i + 1)));
+    }
+    
+    return result;
+}
+
+juce::String BackupScheduler::getFileExtension(PersistenceManager::FileFormat format)
+{
+    switch (format)
+    {
+        case PersistenceManager::FileFormat::binary:    return ".bin";
+        case PersistenceManager::FileFormat::sysEx:     return ".syx";
+        case PersistenceManager::FileFormat::json:
+        default:                                        return ".json";
+    }
+}
+
+BackupScheduler::Report BackupScheduler::run(const juce::Array<DeviceSession::Settings>& devices,
+                                             const DeviceCallback& onDeviceFinished)
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("BackupScheduler::run");
+    
+    const auto linkNames = assignLinks(devices);
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    Report report;
+    
+    {
+        const juce::ScopedLock sl(lock);
+        states.clear();
+        links.clear();
+        
+        for (int i = 0; i < devices.size(); ++i)
+        {
+            auto state = std::make_unique<DeviceState>();
+            state->settings = devices.getReference(i);
+            state->result.name = state->settings.name.isNotEmpty() ? state->settings.name
+                                                                   : state->settings.device.getDeviceName();
+            state->result.link = linkNames[i];
+            state->result.namesOnly = PatchSysExCodec(state->settings.device, state->settings.deviceId).readsNamesOnly();
+            
+            const int first = juce::jmax(options.firstSlot, state->settings.device.getMinPatchNumber());
+            const int last = juce::jmin(options.lastSlot, state->settings.device.getMaxPatchNumber(),
+                                        PatchBank::BANK_SIZE - 1);
+            
+            for (int slot = first; slot <= last; slot += options.chunkSize)
+            {
+                Chunk chunk;
+                for (int s = slot; s <= juce::jmin(last, slot + options.chunkSize - 1); ++s)
+                    chunk.slots.add(s);
+                
+                state->chunks.push_back(chunk);
+                state->slotsLeft += chunk.slots.size();
+            }
+            
+            auto& link = links[linkNames[i]];
+            const auto limit = options.linkLimits.find(linkNames[i]);
+            link.limit = juce::jmax(1, limit != options.linkLimits.end() ? limit->second : options.defaultLinkLimit);
+            link.freeAtSeconds.assign((size_t)link.limit, 0.0);
+            
+            report.links[linkNames[i]].add(state->result.name);
+            
+            state->finished = state->chunks.empty();
+            if (state->finished)
+                state->result.error = "No slots to read in the range";
+            
+            states.push_back(std::move(state));
+        }
+        
+        numUnfinished = 0;
+        int maxConcurrency = 0;
+        
+        for (const auto& state : states)
+            numUnfinished += state->finished ? 0 : 1;
+        
+        for (const auto& link : links)
+            maxConcurrency += link.second.limit;
+        
+        report.numWorkers = juce::jlimit(1, juce::jmax(1, options.maxWorkers), maxConcurrency);
+    }
+    
+    {
+        juce::ThreadPool pool(report.numWorkers);
+        
+        for (;;)
+        {
+            {
+                const juce::ScopedLock sl(lock);
+                if (numUnfinished == 0)
+                    break;
+                
+                dispatch(pool, onDeviceFinished);
+            }
+            
+            chunkFinished.wait();
+        }
+    }
+    
+    report.wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    
+    for (const auto& state : states)
+    {
+        const auto& result = state->result;
+        report.devices.add(result);
+        report.numFailed += result.error.isNotEmpty() ? 1 : 0;
+        report.numNamesOnly += result.namesOnly ? 1 : 0;
+        report.patchesRead += result.statistics.patchesRead;
+        report.modeledSeconds = juce::jmax(report.modeledSeconds, result.modeledEndSeconds);
+        report.slowestDeviceSeconds = juce::jmax(report.slowestDeviceSeconds, result.seconds);
+        report.serialSeconds += result.seconds;
+    }
+    
+    states.clear();
+    links.clear();
+    return report;
+}
+
+void BackupScheduler::dispatch(juce::ThreadPool& pool, const DeviceCallback& onDeviceFinished)
+{
+    // Called with the lock held. Longest remaining work first, so the slowest device sets the pace.
+    std::vector<DeviceState*> ready;
+    
+    for (const auto& state : states)
+        if (!state->finished && !state->busy && !state->chunks.empty())
+            ready.push_back(state.get());
+    
+    std::stable_sort(ready.begin(), ready.end(),
+                     [](const DeviceState* a, const DeviceState* b) { return a->slotsLeft > b->slotsLeft; });
+    
+    for (auto* state : ready)
+    {
+        auto& link = links[state->result.link];
+        if (link.active >= link.limit)
+            continue;
+        
+        ++link.active;
+        state->busy = true;
+        
+        auto chunk = std::move(state->chunks.front());
+        state->chunks.pop_front();
+        
+        pool.addJob([this, state, chunk, &onDeviceFinished]
+        {
+            runChunk(*state, chunk, onDeviceFinished);
+            return juce::ThreadPoolJob::jobHasFinished;
+        });
+    }
+}
+
+void BackupScheduler::runChunk(DeviceState& state, Chunk chunk, const DeviceCallback& onDeviceFinished)
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("BackupScheduler::runChunk");
+    
+    // Only this worker touches the session and bank until the chunk is handed back
+    if (state.session == nullptr)
+        state.session = std::make_unique<DeviceSession>(state.settings);
+    
+    auto& session = *state.session;
+    auto result = session.open();
+    const double startClock = session.getClockSeconds();
+    juce::Array<int> received;
+    
+    if (result.wasOk())
+    {
+        for (const auto& run : getRuns(chunk.slots))
+        {
+            auto runResult = session.dump(run.first, run.second, state.bank,
+                                          [&received](int slot, const PatchData&) { received.addIfNotAlreadyThere(slot); });
+            if (runResult.failed() && result.wasOk())
+                result = runResult;
+        }
+    }
+    else
+    {
+        state.session.reset(); // Opened afresh on the retry
+    }
+    
+    const double chunkSeconds = state.session != nullptr ? session.getClockSeconds() - startClock : 0.0;
+    
+    if (!received.isEmpty())
+    {
+        const auto file = options.outputDirectory.getChildFile(juce::File::createLegalFileName(state.result.name)
+                                                               + getFileExtension(options.format));
+        PersistenceManager persistence(options.outputDirectory);
+        auto saved = persistence.exportToFile(state.bank, file, options.format, &state.session->getCodec());
+        
+        if (saved.wasOk())
+            state.result.file = file;
+        else if (result.wasOk())
+            result = saved;
+    }
+    
+    Chunk retry;
+    retry.attempt = chunk.attempt + 1;
+    
+    for (int slot : chunk.slots)
+        if (!received.contains(slot))
+            retry.slots.add(slot);
+    
+    bool finished = false;
+    
+    {
+        const juce::ScopedLock sl(lock);
+        
+        // Replay the chunk on the modeled clock: it starts once the device and a link slot are both free
+        auto& link = links[state.result.link];
+        auto freeSlot = std::min_element(link.freeAtSeconds.begin(), link.freeAtSeconds.end());
+        const double endSeconds = juce::jmax(*freeSlot, state.readySeconds) + chunkSeconds;
+        *freeSlot = endSeconds;
+        state.readySeconds = endSeconds;
+        --link.active;
+        
+        ++state.result.chunks;
+        state.result.seconds += chunkSeconds;
+        state.result.modeledEndSeconds = endSeconds;
+        state.slotsLeft -= received.size();
+        
+        if (!retry.slots.isEmpty())
+        {
+            if (chunk.attempt < options.maxChunkRetries)
+            {
+                ++state.result.chunkRetries;
+                state.chunks.push_back(retry);
+            }
+            else
+            {
+                state.result.patchesMissing += retry.slots.size();
+                state.slotsLeft -= retry.slots.size();
+                state.result.error = result.failed() ? result.getErrorMessage()
+                                                     : juce::String(retry.slots.size()) + " patches not received";
+            }
+        }
+        else if (result.failed())
+        {
+            state.result.error = result.getErrorMessage(); // Everything arrived, but the file wasn't saved
+        }
+        
+        finished = state.chunks.empty();
+        state.busy = false;
+    }
+    
+    if (finished)
+    {
+        if (state.session != nullptr)
+        {
+            state.result.statistics = state.session->getStatistics();
+            state.session->close();
+        }
+        
+        if (onDeviceFinished != nullptr)
+            onDeviceFinished(state.result);
+        
+        const juce::ScopedLock sl(lock);
+        state.finished = true;
+        --numUnfinished;
+    }
+    
+    chunkFinished.signal();
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DeviceSession.h"
+#include "PersistenceManager.h"
+#include <deque>
+#include <map>
+
+/**
+ * Backs up a whole rack at once: every device's bank is read in chunks of
+ * slots by DeviceSessions on a pool of workers, and saved as it arrives.
+ * 
+ * TOPOLOGY:
+ * - Devices are grouped into links: a DIN chain (THRU) or a merger carries
+ *   one conversation at a time, so devices on one link take turns
+ * - A device's link is Settings::link if set; otherwise devices sharing an
+ *   output or an input port are on one link (through any number of shared
+ *   ports), and a device with ports of its own is a link by itself
+ * - Each link runs at most its limit of chunks at once (Options), and a
+ *   device never runs two chunks at once
+ * 
+ * With independent links the backup takes about as long as the slowest
+ * device instead of all of them in turn. Among the chunks that may start,
+ * those of the device with the most slots left go first, so the slowest
+ * device is never kept waiting behind quick ones.
+ * 
+ * Slots that don't arrive go back at the end of their device's queue as a
+ * new chunk, up to Options::maxChunkRetries times; a device that can't be
+ * opened is retried the same way. After every chunk the device's file is
+ * rewritten (atomically) through PersistenceManager, so an interrupted
+ * backup keeps everything read so far.
+ * 
+ * A device whose template can only read names (no "patch" address map, see
+ * PatchSysExCodec) is still backed up, but its result and the report say
+ * namesOnly: its files hold names and no sounds.
+ * 
+ * TIME: each chunk is timed on its session's clock (simulated time for
+ * simulated devices), and the report replays the chunks against the link
+ * limits to give the backup's modeled duration next to the wall time. With
+ * real ports the two agree; simulated, the modeled time is what the rack
+ * would take.
+ * 
+ * THREADING:
+ * - run() blocks the calling thread until every device is done; one run at
+ *   a time per scheduler
+ * - onDeviceFinished is called on a worker
+ */
+class BackupScheduler
+{
+public:
+    struct Options
+    {
+        juce::File outputDirectory;
+        PersistenceManager::FileFormat format = PersistenceManager::FileFormat::json;
+        int firstSlot = 0;
+        int lastSlot = PatchBank::BANK_SIZE - 1;
+        int chunkSize = 16;
+        int maxChunkRetries = 2;
+        int maxWorkers = 8;
+        int defaultLinkLimit = 1;                   // Chunks at once on one link
+        std::map<juce::String, int> linkLimits;     // By link name, overriding the default
+    };
+    
+    struct DeviceResult
+    {
+        juce::String name;
+        juce::String link;
+        juce::File file;                            // Empty if nothing was read
+        juce::String error;                         // Empty on success
+        int chunks = 0;
+        int chunkRetries = 0;
+        int patchesMissing = 0;
+        bool namesOnly = false;                     // The template reads names only; no dumps were saved
+        double seconds = 0.0;                       // Session clock time of its chunks
+        double modeledEndSeconds = 0.0;             // When it finished in the replayed backup
+        DeviceSession::Statistics statistics;
+        
+        juce::var toVar() const;
+    };
+    
+    struct Report
+    {
+        juce::Array<DeviceResult> devices;
+        int numFailed = 0;
+        int numNamesOnly = 0;                       // Devices backed up without their sounds
+        int patchesRead = 0;
+        double wallSeconds = 0.0;
+        double modeledSeconds = 0.0;                // Replayed against the link limits
+        double slowestDeviceSeconds = 0.0;          // The best any schedule could do
+        double serialSeconds = 0.0;                 // One device after another
+        int numWorkers = 0;
+        std::map<juce::String, juce::StringArray> links;
+        
+        juce::var toVar() const;
+    };
+    
+    using DeviceCallback = std::function<void(const DeviceResult& result)>;
+    
+    explicit BackupScheduler(const Options& options);
+    ~BackupScheduler() = default;
+    
+    Report run(const juce::Array<DeviceSession::Settings>& devices, const DeviceCallback& onDeviceFinished = nullptr);
+    
+    /** Each device's link name, in order (see TOPOLOGY). */
+    static juce::StringArray assignLinks(const juce::Array<DeviceSession::Settings>& devices);
+    
+    static juce::String getFileExtension(PersistenceManager::FileFormat format);
+    
+private:
+    struct Chunk
+    {
+        juce::Array<int> slots;                     // Ascending
+        int attempt = 0;
+    };
+    
+    struct DeviceState
+    {
+        DeviceSession::Settings settings;
+        std::unique_ptr<DeviceSession> session;     // Used by the worker running its chunk
+        PatchBank bank;
+        std::deque<Chunk> chunks;
+        int slotsLeft = 0;
+        bool busy = false;
+        bool finished = false;
+        double readySeconds = 0.0;                  // Modeled time its last chunk ended
+        DeviceResult result;
+    };
+    
+    struct LinkState
+    {
+        int limit = 1;
+        int active = 0;
+        std::vector<double> freeAtSeconds;          // Modeled time each of its limit slots is free
+    };
+    
+    const Options options;
+    
+    juce::CriticalSection lock;
+    std::vector<std::unique_ptr<DeviceState>> states;
+    std::map<juce::String, LinkState> links;
+    int numUnfinished = 0;
+    juce::WaitableEvent chunkFinished;
+    
+    void dispatch(juce::ThreadPool& pool, const DeviceCallback& onDeviceFinished);
+    void runChunk(DeviceState& state, Chunk chunk, const DeviceCallback& onDeviceFinished);
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BackupScheduler)
+};
@@ -0,0 +1,409 @@
+#include "DeviceSession.h"
+
+juce::var DeviceSession::Statistics::toVar() const
+{
+    juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+    obj->setProperty("patchesRead", patchesRead);
+    obj->setProperty("patchesWritten", patchesWritten);
+    obj->setProperty("patchesFailed", patchesFailed);
+    obj->setProperty("requests", requests);
+    obj->setProperty("retries", retries);
+    obj->setProperty("timeouts", timeouts);
+    obj->setProperty("checksumErrors", checksumErrors);
+    obj->setProperty("bytesSent", (juce::int64)bytesSent);
+    obj->setProperty("bytesReceived", (juce::int64)bytesReceived);
+    obj->setProperty("seconds", seconds);
+    
+    if (seconds > 0.0)
+    {
+        obj->setProperty("patchesPerSecond", (patchesRead + patchesWritten) / seconds);
+        obj->setProperty("bytesPerSecond", (double)(bytesSent + bytesReceived) / seconds);
+    }
+    
+    return juce::var(obj.get());
+}
+
+DeviceSession::DeviceSession(const Settings& settings_)
+    : settings(settings_),
+      codec(settings_.device, settings_.deviceId),
+      requests(midiManager, [this] { return getClockSeconds() * 1000.0; })
+{
+}
+
+DeviceSession::~DeviceSession()
+{
+    close();
+}
+
+juce::Result DeviceSession::open()
+{
+    if (isOpen())
+        return juce::Result::ok();
+    
+    MidiBlockDriver::Options driverOptions;
+    
+    if (settings.simulate)
+    {
+        auto config = settings.simulation;
+        config.deviceId = codec.getDeviceId();
+        if (config.name.isEmpty())
+            config.name = "Simulated " + getName();
+        
+        synth = std::make_unique<SimulatedSynthTransport>(settings.device, config);
+        midiManager.setTransport(synth.get());
+        driverOptions.speed = 0.0; // Only runs while a caller waits, as fast as it can
+    }
+    else
+    {
+        hardware = std::make_unique<HardwareMidiTransport>();
+        auto result = hardware->open(settings.outputName, settings.outputIdentifier,
+                                     settings.inputName, settings.inputIdentifier);
+        if (result.failed())
+        {
+            hardware.reset();
+            return juce::Result::fail(getName() + ": " + result.getErrorMessage());
+        }
+        
+        midiManager.setTransport(hardware.get());
+    }
+    
+    midiManager.setMidiChannel(settings.midiChannel);
+    midiManager.setWireBaudRate(settings.wireBaudRate);
+    midiManager.addInputListener(this);
+    
+    driver = std::make_unique<MidiBlockDriver>(midiManager, driverOptions);
+    if (hardware != nullptr)
+        driver->start();
+    
+    openedAtMs = juce::Time::getMillisecondCounterHiRes();
+    return juce::Result::ok();
+}
+
+void DeviceSession::close()
+{
+    if (!isOpen())
+        return;
+    
+    driver->stop();
+    midiManager.removeInputListener(this);
+    midiManager.setTransport(nullptr);
+    driver.reset();
+    hardware.reset();
+    
+    // The synth is kept so its statistics can still be read
+}
+
+juce::String DeviceSession::getName() const
+{
+    return settings.name.isNotEmpty() ? settings.name : settings.device.getDeviceName();
+}
+
+double DeviceSession::getClockSeconds() const
+{
+    if (settings.simulate)
+        return driver != nullptr ? driver->getElapsedSeconds() : 0.0;
+    
+    return (juce::Time::getMillisecondCounterHiRes() - openedAtMs) / 1000.0;
+}
+
+DeviceSession::Statistics DeviceSession::getStatistics() const
+{
+    auto result = statistics;
+    const auto& requestStatistics = requests.getStatistics();
+    result.requests = requestStatistics.requestsSent;
+    result.retries = requestStatistics.retries;
+    result.timeouts = requestStatistics.timeouts;
+    result.checksumErrors = requestStatistics.checksumErrors;
+    return result;
+}
+
+juce::Result DeviceSession::recall(int slot)
+{
+    if (!isOpen())
+        return juce::Result::fail(getName() + ": not open");
+    
+    auto result = sendProgramChange(slot);
+    if (result.failed())
+        return result;
+    
+    return waitUntilSent(1.0) ? juce::Result::ok() : juce::Result::fail(getName() + ": program change not sent");
+}
+
+juce::Result DeviceSession::dump(int firstSlot, int lastSlot, PatchBank& bank, const PatchCallback& onPatch)
+{
+    if (!isOpen())
+        return juce::Result::fail(getName() + ": not open");
+    
+    if (!codec.canRead())
+        return juce::Result::fail("Patch dumps are not supported for " + settings.device.getDeviceName());
+    
+    const auto deviceKey = getName();
+    SysExRequestManager::DeviceConfig config;
+    config.maxInFlight = codec.needsProgramChange() ? 1 : settings.maxInFlight;
+    config.timeoutMs = settings.timeoutMs;
+    config.maxRetries = settings.maxRetries;
+    config.matchInOrder = codec.needsProgramChange();
+    config.parser = [this](const juce::uint8* data, int size, SysExRequestManager::ParsedReply& parsed)
+    {
+        // Per-program replies carry no slot; the manager gives them to the one request in flight
+        PatchSysExCodec::Reply reply;
+        if (!codec.parseReply(data, size, settings.device.getMinPatchNumber(), reply))
+            return false;
+        
+        parsed.address = codec.getReplyAddress(reply.slot, reply.block);
+        parsed.payload = std::move(reply.payload);
+        parsed.checksumValid = reply.checksumValid;
+        return true;
+    };
+    
+    requests.configureDevice(deviceKey, config);
+    
+    const int first = juce::jmax(firstSlot, settings.device.getMinPatchNumber());
+    const int last = juce::jmin(lastSlot, settings.device.getMaxPatchNumber(), PatchBank::BANK_SIZE - 1);
+    const int numRequested = juce::jmax(0, last - first + 1);
+    const double startSeconds = getClockSeconds();
+    int numFailed = 0;
+    
+    // Each block is a request of its own; a patch is stored once all of them are in
+    struct PendingPatch
+    {
+        juce::MemoryBlock dump;
+        int blocksLeft = 0;
+        bool failed = false;
+    };
+    
+    const int numBlocks = codec.getNumBlocks();
+    std::vector<PendingPatch> pending((size_t)numRequested);
+    
+    for (int slot = first; slot <= last; ++slot)
+    {
+        auto& patchState = pending[(size_t)(slot - first)];
+        patchState.blocksLeft = numBlocks;
+        
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            SysExRequestManager::Request request;
+            request.address = codec.getReplyAddress(slot, block);
+            request.message = codec.createRequest(slot, block);
+            
+            if (codec.needsProgramChange())
+                request.beforeSend = [this, slot] { return sendProgramChange(slot); };
+            
+            request.onComplete = [this, slot, block, &patchState, &bank, &onPatch, &numFailed](
+                const juce::Result& result, const juce::MemoryBlock& payload)
+            {
+                --patchState.blocksLeft;
+                
+                if (result.failed())
+                {
+                    // One lost block loses the patch; count it once
+                    if (!patchState.failed)
+                    {
+                        ++numFailed;
+                        ++statistics.patchesFailed;
+                    }
+                    
+                    patchState.failed = true;
+                    return;
+                }
+                
+                codec.storeBlock(patchState.dump, block, payload);
+                
+                if (patchState.blocksLeft > 0 || patchState.failed)
+                    return;
+                
+                auto patch = bank.getPatch(slot);
+                codec.applyReply(patch, patchState.dump);
+                bank.setPatch(slot, patch);
+                ++statistics.patchesRead;
+                
+                if (onPatch != nullptr)
+                    onPatch(slot, patch);
+            };
+            
+            requests.submit(deviceKey, std::move(request));
+        }
+    }
+    
+    while (!requests.isIdle())
+    {
+        juce::MidiMessage message;
+        while (takeInput(message))
+            requests.handleIncomingSysEx(message);
+        
+        requests.pump();
+        
+        if (!requests.isIdle() && !hasInput())
+            waitForInput(juce::jmax(0.001, requests.getNextDeadlineMs() / 1000.0 - getClockSeconds()));
+    }
+    
+    statistics.seconds += getClockSeconds() - startSeconds;
+    statistics.bytesSent = midiManager.getOutputStatistics().getTotalBytes();
+    statistics.bytesReceived = midiManager.getInputStatistics().getTotalBytes();
+    
+    if (numFailed > 0)
+        return juce::Result::fail(getName() + ": " + juce::String(numFailed) + " of "
+                                  + juce::String(numRequested) + " patches not received");
+    
+    return juce::Result::ok();
+}
+
+juce::Result DeviceSession::restore(const PatchBank& bank, int firstSlot, int lastSlot)
+{
+    if (!isOpen())
+        return juce::Result::fail(getName() + ": not open");
+    
+    if (codec.readsNamesOnly())
+        return juce::Result::fail("Writing patches is not supported for " + settings.device.getDeviceName()
+                                  + ": its template has no \"patch\" address map, so only names can be read");
+    
+    if (!codec.canWrite())
+        return juce::Result::fail("Writing patches is not supported for " + settings.device.getDeviceName());
+    
+    const double startSeconds = getClockSeconds();
+    int numWritten = 0;
+    juce::Result result = juce::Result::ok();
+    
+    for (int slot = juce::jmax(firstSlot, settings.device.getMinPatchNumber());
+         slot <= juce::jmin(lastSlot, settings.device.getMaxPatchNumber(), PatchBank::BANK_SIZE - 1); ++slot)
+    {
+        const auto& patch = bank.getPatch(slot);
+        const auto writes = patch.hasPatchDump() ? codec.createWrites(slot, patch.getPatchDump())
+                                                 : juce::Array<juce::MemoryBlock>();
+        
+        if (writes.isEmpty())
+            continue; // No dump, or one for another device
+        
+        // One write at a time: a program change must not overtake the dump before it
+        if (codec.needsProgramChange())
+            result = sendProgramChange(slot);
+        
+        for (const auto& body : writes)
+        {
+            if (result.wasOk())
+                result = send(body, MidiManager::Priority::bulk);
+            
+            const double wireSeconds = midiManager.estimateWireDelayMs(MidiManager::Priority::bulk) / 1000.0;
+            
+            if (result.wasOk() && !waitUntilSent(wireSeconds + 1.0))
+                result = juce::Result::fail(getName() + ": timed out sending slot " + juce::String(slot + 1));
+            
+            if (result.failed())
+                break;
+            
+            pause(settings.writeGapMs / 1000.0);
+        }
+        
+        if (result.failed())
+            break;
+        
+        ++numWritten;
+        ++statistics.patchesWritten;
+    }
+    
+    statistics.seconds += getClockSeconds() - startSeconds;
+    statistics.bytesSent = midiManager.getOutputStatistics().getTotalBytes();
+    statistics.bytesReceived = midiManager.getInputStatistics().getTotalBytes();
+    
+    if (result.wasOk() && numWritten == 0)
+        return juce::Result::fail(getName() + ": no " + settings.device.getDeviceName() + " dumps in the bank");
+    
+    return result;
+}
+
+void DeviceSession::midiInputReceived(const juce::MidiMessage& message)
+{
+    // Only replies matter here; clock and sensing bytes would just wake the waiter
+    if (!message.isSysEx())
+        return;
+    
+    {
+        const juce::ScopedLock sl(inputLock);
+        received.push_back(message);
+    }
+    
+    inputArrived.signal();
+}
+
+bool DeviceSession::takeInput(juce::MidiMessage& message)
+{
+    const juce::ScopedLock sl(inputLock);
+    
+    if (received.empty())
+        return false;
+    
+    message = std::move(received.front());
+    received.pop_front();
+    return true;
+}
+
+bool DeviceSession::hasInput()
+{
+    const juce::ScopedLock sl(inputLock);
+    return !received.empty();
+}
+
+juce::Result DeviceSession::send(const juce::MemoryBlock& body, MidiManager::Priority priority)
+{
+    if (body.isEmpty())
+        return juce::Result::fail(getName() + ": nothing to send");
+    
+    auto result = midiManager.sendSysEx(static_cast<const juce::uint8*>(body.getData()), (int)body.getSize(), priority);
+    return result.wasOk() ? result : juce::Result::fail(getName() + ": " + result.getErrorMessage());
+}
+
+juce::Result DeviceSession::sendProgramChange(int slot)
+{
+    if (!settings.device.isValidPatchNumber(slot))
+        return juce::Result::fail(getName() + ": no slot " + juce::String(slot + 1));
+    
+    auto result = midiManager.sendProgramChange(slot, MidiManager::Priority::realtime);
+    return result.wasOk() ? result : juce::Result::fail(getName() + ": " + result.getErrorMessage());
+}
+
+void DeviceSession::waitForInput(double seconds)
+{
+    if (settings.simulate)
+        driver->processUntil([this] { return hasInput(); }, seconds);
+    else
+        inputArrived.wait(juce::jmax(1, juce::roundToInt(seconds * 1000.0)));
+}
+
+bool DeviceSession::waitUntilSent(double maxSeconds)
+{
+    if (settings.simulate)
+        return driver->processUntil([this] { return allLanesEmpty(); }, maxSeconds);
+    
+    const double endMs = juce::Time::getMillisecondCounterHiRes() + maxSeconds * 1000.0;
+    
+    while (!allLanesEmpty())
+    {
+        if (juce::Time::getMillisecondCounterHiRes() >= endMs)
+            return false;
+        
+        juce::Thread::sleep(1);
+    }
+    
+    return true;
+}
+
+void DeviceSession::pause(double seconds)
+{
+    if (seconds <= 0.0)
+        return;
+    
+    if (settings.simulate)
+        driver->processUntil([] { return false; }, seconds);
+    else
+        juce::Thread::sleep(juce::roundToInt(seconds * 1000.0));
+}
+
+bool DeviceSession::allLanesEmpty() const noexcept
+{
+    for (auto priority : { MidiManager::Priority::realtime, MidiManager::Priority::interactive,
+                           MidiManager::Priority::bulk })
+        if (midiManager.getLaneStatistics(priority).numQueued > 0)
+            return false;
+    
+    return true;
+}
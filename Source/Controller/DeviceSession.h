@@ -0,0 +1,136 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MidiManager.h"
+#include "MidiBlockDriver.h"
+#include "HardwareMidiTransport.h"
+#include "SimulatedSynthTransport.h"
+#include "PatchSysExCodec.h"
+#include "SysExRequestManager.h"
+#include <deque>
+
+/**
+ * One device driven without a host: its own MidiManager, ports (or a
+ * simulated synth) and block driver, and blocking patch transfers.
+ * 
+ * Sessions are what the command-line librarian runs on its workers: each
+ * owns everything it sends and receives through, so any number of them can
+ * run at once on different threads.
+ * 
+ * TIME:
+ * - With real ports a MidiBlockDriver thread paces blocks to the wall
+ *   clock, and timeouts are in wall time
+ * - Simulated, blocks are run on the calling thread only while it waits,
+ *   and all times (timeouts, reported seconds) are simulated: a session
+ *   takes the same simulated time however loaded the machine is
+ * 
+ * Requests go through the same SysExRequestManager the plugin reads names
+ * with, driven on the session clock instead of a message-thread timer:
+ * pipelined up to Settings::maxInFlight (one at a time for per-program
+ * protocols, which need a program change first), retried on timeout or a
+ * bad checksum, and sent through the interactive lane. Writes are sent one at a time through the bulk lane with
+ * Settings::writeGapMs between them, so the device can store each one.
+ * 
+ * THREADING:
+ * - A session is used by one thread at a time, any thread; the message
+ *   manager must exist (MidiManager broadcasts changes)
+ */
+class DeviceSession : private MidiManager::InputListener
+{
+public:
+    struct Settings
+    {
+        juce::String name;                      // For reports; empty: the template's device name
+        DeviceTemplate device;
+        int midiChannel = 1;
+        int deviceId = -1;                      // -1: the protocol's default
+        
+        // Ports, by identifier then name (ignored when simulated)
+        juce::String outputName, outputIdentifier;
+        juce::String inputName, inputIdentifier;
+        double wireBaudRate = MidiWireModel::DIN_BAUD_RATE;   // 0 for USB
+        juce::String link;                      // Shared DIN chain or merger (see BackupScheduler); empty: by ports
+        
+        bool simulate = false;
+        SimulatedSynthTransport::Config simulation;
+        
+        int maxInFlight = 4;
+        int timeoutMs = 400;                    // Per attempt, after the request reaches the wire
+        int maxRetries = 2;
+        int writeGapMs = 20;
+    };
+    
+    struct Statistics
+    {
+        int patchesRead = 0;
+        int patchesWritten = 0;
+        int patchesFailed = 0;
+        int requests = 0;
+        int retries = 0;
+        int timeouts = 0;
+        int checksumErrors = 0;
+        juce::uint64 bytesSent = 0;
+        juce::uint64 bytesReceived = 0;
+        double seconds = 0.0;                   // Session clock time spent transferring
+        
+        juce::var toVar() const;
+    };
+    
+    explicit DeviceSession(const Settings& settings);
+    ~DeviceSession() override;
+    
+    juce::Result open();
+    void close();
+    bool isOpen() const noexcept { return driver != nullptr; }
+    
+    juce::String getName() const;
+    const Settings& getSettings() const noexcept { return settings; }
+    const PatchSysExCodec& getCodec() const noexcept { return codec; }
+    SimulatedSynthTransport* getSimulatedSynth() noexcept { return synth.get(); }
+    double getClockSeconds() const;
+    Statistics getStatistics() const;
+    
+    /** Sends the slot's program change and waits until it is on the wire. */
+    juce::Result recall(int slot);
+    
+    /**
+     * Reads slots [firstSlot, lastSlot] (clipped to the device's range) into
+     * the bank, calling onPatch for each as it arrives. Slots that fail after
+     * all retries are left as they were and make the result fail.
+     */
+    using PatchCallback = std::function<void(int slot, const PatchData& patch)>;
+    juce::Result dump(int firstSlot, int lastSlot, PatchBank& bank, const PatchCallback& onPatch = nullptr);
+    
+    /** Writes every slot in the range that holds a dump for this device. */
+    juce::Result restore(const PatchBank& bank, int firstSlot, int lastSlot);
+    
+private:
+    const Settings settings;
+    const PatchSysExCodec codec;
+    
+    MidiManager midiManager;
+    SysExRequestManager requests;
+    std::unique_ptr<SimulatedSynthTransport> synth;
+    std::unique_ptr<HardwareMidiTransport> hardware;
+    std::unique_ptr<MidiBlockDriver> driver;
+    double openedAtMs = 0.0;
+    
+    juce::CriticalSection inputLock;
+    std::deque<juce::MidiMessage> received;
+    juce::WaitableEvent inputArrived;
+    
+    Statistics statistics;
+    
+    void midiInputReceived(const juce::MidiMessage& message) override; // Transport or MIDI thread
+    bool takeInput(juce::MidiMessage& message);
+    bool hasInput();
+    
+    juce::Result send(const juce::MemoryBlock& body, MidiManager::Priority priority);
+    juce::Result sendProgramChange(int slot);
+    void waitForInput(double seconds);
+    bool waitUntilSent(double maxSeconds);
+    void pause(double seconds);
+    bool allLanesEmpty() const noexcept;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeviceSession)
+};
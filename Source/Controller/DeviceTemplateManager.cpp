@@ -1,56 +1,49 @@
 #include "DeviceTemplateManager.h"
-#include "PersistenceManager.h"
+#include "../Model/FactoryTemplates.h"
 
-DeviceTemplateManager::DeviceTemplateManager()
+DeviceTemplateManager::DeviceTemplateManager(const juce::File& directory)
+    : templatesDirectory(directory)
 {
-    // Get templates directory
-    auto dataDir = PersistenceManager().getDataDirectory();
-    templatesDirectory = dataDir.getChildFile("templates");
-    ensureTemplatesDirectoryExists();
-    
-    // Initialize factory templates
-    initializeFactoryTemplates();
-    
-    // Load custom templates from disk
-    loadAllTemplates();
+    // Factory templates only; the folder is indexed by readIndex()/applyIndex()
+    rebuildIndex();
 }
 
-juce::Array<DeviceTemplate> DeviceTemplateManager::getAvailableTemplates() const
+DeviceTemplateManager::~DeviceTemplateManager()
 {
-    return templates;
+    stopTimer();
 }
 
 DeviceTemplate DeviceTemplateManager::getTemplate(const juce::Identifier& deviceID) const
 {
-    for (const auto& t : templates)
-    {
-        if (t.getDeviceID() == deviceID)
-            return t;
-    }
+    auto it = index.find(deviceID);
     
     // Return generic template if not found
-    return DeviceTemplate::createGeneric();
-}
-
-bool DeviceTemplateManager::hasTemplate(const juce::Identifier& deviceID) const
-{
-    for (const auto& t : templates)
+    if (it == index.end())
+        return DeviceTemplate::createGeneric();
+    
+    const auto& entry = it->second;
+    if (entry.loaded == nullptr && entry.info.isFactory())
     {
-        if (t.getDeviceID() == deviceID)
-            return true;
+        entry.loaded = FactoryTemplates::materialize(FactoryTemplates::indexOf(deviceID));
     }
-    return false;
+    else if (entry.loaded == nullptr)
+    {
+        DeviceTemplate template_;
+        if (!parseTemplateFile(entry.info.file, template_))
+        {
+            juce::Logger::writeToLog("Failed to load template: " + entry.info.file.getFullPathName());
+            return DeviceTemplate::createGeneric();
+        }
+        
+        entry.loaded = std::make_shared<const DeviceTemplate>(template_);
+    }
+    
+    return *entry.loaded;
 }
 
-void DeviceTemplateManager::initializeFactoryTemplates()
+bool DeviceTemplateManager::hasTemplate(const juce::Identifier& deviceID) const
 {
-    templates.clear();
-    
-    // Add factory templates
-    templates.add(DeviceTemplate::createGeneric());
-    templates.add(DeviceTemplate::createRolandJV1080());
-    templates.add(DeviceTemplate::createYamahaDX7());
-    templates.add(DeviceTemplate::createKorgM1());
+    return index.find(deviceID) != index.end();
 }
 
 bool DeviceTemplateManager::saveTemplate(const DeviceTemplate& template_)
@@ -69,74 +62,136 @@ bool DeviceTemplateManager::saveTemplate(const DeviceTemplate& template_)
     
     stream->writeString(jsonString);
     stream->flush();
+    stream.reset();
     
-    bool success = tempFile.overwriteTargetFileWithTemporary();
+    if (!tempFile.overwriteTargetFileWithTemporary())
+        return false;
     
-    if (success)
-    {
-        // Reload templates
-        loadAllTemplates();
-    }
+    // Update just this entry; the recorded size and time keep the watcher from re-reading it
+    TemplateInfo info;
+    info.deviceID = template_.getDeviceID();
+    info.deviceName = template_.getDeviceName();
+    info.manufacturer = template_.getManufacturer();
+    info.file = file;
+    info.lastModified = file.getLastModificationTime().toMilliseconds();
+    info.fileSize = file.getSize();
+    filesByPath[file.getFullPathName()] = info;
+    
+    auto& entry = index[info.deviceID];
+    entry.info = info;
+    entry.loaded = std::make_shared<const DeviceTemplate>(template_);
+    updateOrder();
+    
+    writeManifest();
     
-    return success;
+    lastChanged.clearQuick();
+    lastChanged.add(info.deviceID);
+    sendChangeMessage();
+    return true;
 }
 
-bool DeviceTemplateManager::loadTemplate(const juce::Identifier& deviceID, DeviceTemplate& template_)
+bool DeviceTemplateManager::loadTemplate(const juce::Identifier& deviceID, DeviceTemplate& template_) const
 {
-    auto file = templatesDirectory.getChildFile(deviceID.toString() + ".json");
+    auto it = index.find(deviceID);
     
-    if (!file.existsAsFile())
+    if (it == index.end() || it->second.info.isFactory())
         return false;
     
-    juce::String jsonString = file.loadFileAsString();
-    auto var = juce::JSON::parse(jsonString);
+    return parseTemplateFile(it->second.info.file, template_);
+}
+
+DeviceTemplateManager::IndexScan DeviceTemplateManager::readIndex() const
+{
+    if (!templatesDirectory.exists())
+        templatesDirectory.createDirectory();
     
-    if (var.isUndefined())
-        return false;
+    // Index custom templates from the manifest; only new or changed files are opened
+    IndexScan scan;
+    auto manifest = readManifest();
+    scan.files = scanDirectory(manifest);
     
-    template_ = DeviceTemplate::fromVar(var);
-    return true;
+    scan.manifestCurrent = std::equal(scan.files.begin(), scan.files.end(),
+                                      manifest.begin(), manifest.end(),
+                                      [](const auto& a, const auto& b)
+                                      {
+                                          return a.first == b.first
+                                              && a.second.lastModified == b.second.lastModified
+                                              && a.second.fileSize == b.second.fileSize;
+                                      });
+    return scan;
 }
 
-juce::Array<DeviceTemplate> DeviceTemplateManager::loadAllTemplates()
+void DeviceTemplateManager::applyIndex(IndexScan scan)
 {
-    juce::Array<DeviceTemplate> loadedTemplates;
+    filesByPath = std::move(scan.files);
+    rebuildIndex();
     
-    if (!templatesDirectory.exists())
-        return loadedTemplates;
+    if (!scan.manifestCurrent)
+        writeManifest();
+    
+    // Every user template is new to anyone who looked before the index was ready
+    lastChanged.clearQuick();
+    for (const auto& [path, info] : filesByPath)
+        if (!info.deviceID.isNull())
+            lastChanged.addIfNotAlreadyThere(info.deviceID);
     
-    auto files = templatesDirectory.findChildFiles(juce::File::findFiles, false, "*.json");
+    indexed = true;
+    setWatchingDirectory(true);
     
-    for (const auto& file : files)
+    if (!lastChanged.isEmpty())
+        sendChangeMessage();
+}
+
+bool DeviceTemplateManager::rescan()
+{
+    auto scanned = scanDirectory(filesByPath);
+    juce::Array<juce::Identifier> changed;
+    bool anyFileChanged = false;
+    
+    for (const auto& [path, info] : scanned)
     {
-        juce::String jsonString = file.loadFileAsString();
-        auto var = juce::JSON::parse(jsonString);
-        
-        if (!var.isUndefined())
+        auto it = filesByPath.find(path);
+        if (it == filesByPath.end())
         {
-            auto template_ = DeviceTemplate::fromVar(var);
-            loadedTemplates.add(template_);
-            
-            // Add to main templates array if not already present
-            bool found = false;
-            for (auto& t : templates)
-            {
-                if (t.getDeviceID() == template_.getDeviceID())
-                {
-                    t = template_; // Update existing
-                    found = true;
-                    break;
-                }
-            }
-            
-            if (!found)
-            {
-                templates.add(template_);
-            }
+            changed.addIfNotAlreadyThere(info.deviceID);
+            anyFileChanged = true;
+        }
+        else if (it->second.lastModified != info.lastModified || it->second.fileSize != info.fileSize)
+        {
+            changed.addIfNotAlreadyThere(it->second.deviceID);
+            changed.addIfNotAlreadyThere(info.deviceID);
+            anyFileChanged = true;
         }
     }
     
-    return loadedTemplates;
+    for (const auto& [path, info] : filesByPath)
+    {
+        if (scanned.find(path) == scanned.end())
+        {
+            changed.addIfNotAlreadyThere(info.deviceID);
+            anyFileChanged = true;
+        }
+    }
+    
+    if (!anyFileChanged)
+        return false;
+    
+    filesByPath = std::move(scanned);
+    rebuildIndex();
+    writeManifest();
+    
+    // Invalid files have null IDs; they change the manifest but not the template list
+    changed.removeAllInstancesOf(juce::Identifier());
+    lastChanged = changed;
+    return !changed.isEmpty();
+}
+
+void DeviceTemplateManager::setWatchingDirectory(bool shouldWatch)
+{
+    if (shouldWatch)
+        startTimer(WATCH_INTERVAL_MS);
+    else
+        stopTimer();
 }
 
 juce::File DeviceTemplateManager::getTemplatesDirectory() const
@@ -144,6 +199,12 @@ juce::File DeviceTemplateManager::getTemplatesDirectory() const
     return templatesDirectory;
 }
 
+juce::File DeviceTemplateManager::getManifestFile() const
+{
+    // Not *.json, so the scan never mistakes it for a template
+    return templatesDirectory.getChildFile("manifest.cache");
+}
+
 void DeviceTemplateManager::ensureTemplatesDirectoryExists()
 {
     if (!templatesDirectory.exists())
@@ -152,3 +213,194 @@ void DeviceTemplateManager::ensureTemplatesDirectoryExists()
     }
 }
 
+std::map<juce::String, DeviceTemplateManager::TemplateInfo>
+DeviceTemplateManager::scanDirectory(const std::map<juce::String, TemplateInfo>& known) const
+{
+    std::map<juce::String, TemplateInfo> result;
+    
+    if (!templatesDirectory.isDirectory())
+        return result;
+    
+    // Size and time come with the directory listing, so unchanged files are never opened
+    for (const auto& dirEntry : juce::RangedDirectoryIterator(templatesDirectory, false, "*.json",
+                                                              juce::File::findFiles))
+    {
+        TemplateInfo info;
+        info.file = dirEntry.getFile();
+        info.lastModified = dirEntry.getModificationTime().toMilliseconds();
+        info.fileSize = dirEntry.getFileSize();
+        
+        const auto path = info.file.getFullPathName();
+        auto it = known.find(path);
+        
+        if (it != known.end() && it->second.lastModified == info.lastModified && it->second.fileSize == info.fileSize)
+        {
+            result[path] = it->second;
+            continue;
+        }
+        
+        // Unreadable files are kept with a null ID so they aren't re-read until they change
+        if (!readTemplateInfo(info.file, info))
+            juce::Logger::writeToLog("Skipping invalid template: " + path);
+        
+        result[path] = info;
+    }
+    
+    return result;
+}
+
+void DeviceTemplateManager::rebuildIndex()
+{
+    std::unordered_map<juce::Identifier, Entry, IdentifierHasher> newIndex;
+    newIndex.reserve((size_t)FactoryTemplates::getNumDevices() + filesByPath.size());
+    
+    // Built-in devices are listed from the constexpr table; materialized on first getTemplate()
+    for (int i = 0; i < FactoryTemplates::getNumDevices(); ++i)
+    {
+        const auto& device = FactoryTemplates::getDevice(i);
+        auto& entry = newIndex[device.deviceID];
+        entry.info.deviceID = device.deviceID;
+        entry.info.deviceName = device.deviceName;
+        entry.info.manufacturer = device.manufacturer;
+    }
+    
+    // User files override factory templates; later paths win on duplicate IDs
+    for (const auto& [path, info] : filesByPath)
+    {
+        if (info.deviceID.isNull())
+            continue;
+        
+        auto& entry = newIndex[info.deviceID];
+        entry.info = info;
+        entry.loaded = nullptr;
+        
+        // Keep an already-parsed template if its file hasn't changed
+        auto old = index.find(info.deviceID);
+        if (old != index.end() && old->second.info.file == info.file
+            && old->second.info.lastModified == info.lastModified && old->second.info.fileSize == info.fileSize)
+            entry.loaded = old->second.loaded;
+    }
+    
+    index = std::move(newIndex);
+    updateOrder();
+}
+
+void DeviceTemplateManager::updateOrder()
+{
+    // Factory order first, then user-only devices by name
+    orderedTemplates.clearQuick();
+    juce::Array<juce::Identifier> factoryIds;
+    
+    for (int i = 0; i < FactoryTemplates::getNumDevices(); ++i)
+    {
+        const juce::Identifier id(FactoryTemplates::getDevice(i).deviceID);
+        factoryIds.add(id);
+        orderedTemplates.add(index.at(id).info);
+    }
+    
+    juce::Array<TemplateInfo> userTemplates;
+    for (const auto& [id, entry] : index)
+        if (!factoryIds.contains(id))
+            userTemplates.add(entry.info);
+    
+    std::sort(userTemplates.begin(), userTemplates.end(), [](const TemplateInfo& a, const TemplateInfo& b)
+    {
+        return a.getDisplayName().compareIgnoreCase(b.getDisplayName()) < 0;
+    });
+    
+    orderedTemplates.addArray(userTemplates);
+}
+
+std::map<juce::String, DeviceTemplateManager::TemplateInfo> DeviceTemplateManager::readManifest() const
+{
+    std::map<juce::String, TemplateInfo> manifest;
+    
+    auto file = getManifestFile();
+    if (!file.existsAsFile())
+        return manifest;
+    
+    auto var = juce::JSON::parse(file.loadFileAsString());
+    if (auto* entries = var.getProperty("templates", juce::var()).getArray())
+    {
+        for (const auto& v : *entries)
+        {
+            TemplateInfo info;
+            info.file = templatesDirectory.getChildFile(v.getProperty("file", "").toString());
+            info.lastModified = (juce::int64)v.getProperty("modified", 0);
+            info.fileSize = (juce::int64)v.getProperty("size", 0);
+            info.deviceName = v.getProperty("deviceName", "").toString();
+            info.manufacturer = v.getProperty("manufacturer", "").toString();
+            
+            auto id = v.getProperty("deviceID", "").toString();
+            if (id.isNotEmpty())
+                info.deviceID = id;
+            
+            manifest[info.file.getFullPathName()] = info;
+        }
+    }
+    
+    return manifest;
+}
+
+void DeviceTemplateManager::writeManifest() const
+{
+    juce::Array<juce::var> entries;
+    
+    for (const auto& [path, info] : filesByPath)
+    {
+        juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+        obj->setProperty("file", info.file.getFileName());
+        obj->setProperty("modified", info.lastModified);
+        obj->setProperty("size", info.fileSize);
+        obj->setProperty("deviceID", info.deviceID.toString());
+        obj->setProperty("deviceName", info.deviceName);
+        obj->setProperty("manufacturer", info.manufacturer);
+        entries.add(juce::var(obj.get()));
+    }
+    
+    juce::DynamicObject::Ptr root = new juce::DynamicObject();
+    root->setProperty("version", 1);
+    root->setProperty("templates", entries);
+    
+    auto file = getManifestFile();
+    juce::TemporaryFile tempFile(file);
+    
+    if (tempFile.getFile().replaceWithText(juce::JSON::toString(juce::var(root.get()), true)))
+        tempFile.overwriteTargetFileWithTemporary();
+}
+
+bool DeviceTemplateManager::readTemplateInfo(const juce::File& file, TemplateInfo& info)
+{
+    auto var = juce::JSON::parse(file.loadFileAsString());
+    auto id = var.getProperty("deviceID", "").toString();
+    
+    if (id.isEmpty())
+        return false;
+    
+    // Header fields only: SysEx and parameter compilation wait for getTemplate()
+    info.deviceID = id;
+    info.deviceName = var.getProperty("deviceName", "").toString();
+    info.manufacturer = var.getProperty("manufacturer", "").toString();
+    return true;
+}
+
+bool DeviceTemplateManager::parseTemplateFile(const juce::File& file, DeviceTemplate& template_)
+{
+    if (!file.existsAsFile())
+        return false;
+    
+    juce::String jsonString = file.loadFileAsString();
+    auto var = juce::JSON::parse(jsonString);
+    
+    if (var.isUndefined())
+        return false;
+    
+    template_ = DeviceTemplate::fromVar(var);
+    return true;
+}
+
+void DeviceTemplateManager::timerCallback()
+{
+    if (rescan())
+        sendChangeMessage();
+}
@@ -2,41 +2,138 @@
 
 #include <JuceHeader.h>
 #include "../Model/DeviceTemplate.h"
+#include <map>
+#include <memory>
+#include <unordered_map>
 
 /**
  * Manages available device templates.
  * 
- * Loads templates from disk and provides factory templates.
- * Templates are stored in ~/Library/Application Support/MidiLibrarian/templates/
+ * Provides the built-in devices (see FactoryTemplates) plus any user
+ * templates found in the templates directory (user files override built-in
+ * devices with the same ID).
+ * 
+ * Templates are indexed by device ID in a hash map and parsed lazily: the
+ * index only reads the manifest (templates/manifest.cache), which records
+ * each file's size, modification time, ID and display name. Files whose size
+ * and time still match are not opened at all; changed files have just their
+ * header fields read. The full template (including SysEx and parameter
+ * compilation) is built on the first getTemplate() for that ID and cached.
+ * 
+ * A new manager lists only the factory templates. The user templates are
+ * indexed in two steps so the file I/O can run on a worker thread during
+ * startup: readIndex() (any thread) and applyIndex() (message thread).
+ * 
+ * Once indexed, a timer polls the directory every WATCH_INTERVAL_MS and applies added,
+ * edited and deleted files, broadcasting a change message when anything
+ * changed (see getLastChangedTemplates()).
+ * 
+ * THREADING:
+ * - Message thread only, except readIndex()
  */
-class DeviceTemplateManager
+class DeviceTemplateManager : public juce::ChangeBroadcaster,
+                              private juce::Timer
 {
 public:
-    DeviceTemplateManager();
-    ~DeviceTemplateManager() = default;
+    /** Manifest entry: what the template list needs without parsing the template. */
+    struct TemplateInfo
+    {
+        juce::Identifier deviceID;
+        juce::String deviceName;
+        juce::String manufacturer;
+        juce::File file;                // Default File() for factory templates
+        juce::int64 lastModified = 0;   // Milliseconds since epoch
+        juce::int64 fileSize = 0;
+        
+        bool isFactory() const noexcept { return file == juce::File(); }
+        juce::String getDisplayName() const { return manufacturer + " " + deviceName; }
+    };
     
-    // Template access
-    juce::Array<DeviceTemplate> getAvailableTemplates() const;
-    DeviceTemplate getTemplate(const juce::Identifier& deviceID) const;
-    bool hasTemplate(const juce::Identifier& deviceID) const;
+    /** Result of readIndex(): the template files found, with their header fields. */
+    struct IndexScan
+    {
+        std::map<juce::String, TemplateInfo> files;
+        bool manifestCurrent = false;   // The manifest already matches the files
+    };
     
-    // Factory templates
-    void initializeFactoryTemplates();
+    static constexpr int WATCH_INTERVAL_MS = 2000;
+    
+    explicit DeviceTemplateManager(const juce::File& templatesDirectory);
+    ~DeviceTemplateManager() override;
+    
+    /**
+     * Startup indexing. readIndex() reads the manifest and lists the folder,
+     * opening only new or changed files; it touches no member state, so it
+     * may run on any thread. applyIndex() installs the result, rewrites a
+     * stale manifest, starts the directory watcher and broadcasts a change
+     * listing the user templates (see getLastChangedTemplates()).
+     */
+    IndexScan readIndex() const;
+    void applyIndex(IndexScan scan);
+    bool isIndexed() const noexcept { return indexed; }
+    void indexNow() { applyIndex(readIndex()); } // Both steps on the message thread
+    
+    // Template access: factory templates first, then user templates by name
+    const juce::Array<TemplateInfo>& getAvailableTemplates() const noexcept { return orderedTemplates; }
+    DeviceTemplate getTemplate(const juce::Identifier& deviceID) const; // Generic if unknown
+    bool hasTemplate(const juce::Identifier& deviceID) const;
     
     // Load/Save templates
     bool saveTemplate(const DeviceTemplate& template_);
-    bool loadTemplate(const juce::Identifier& deviceID, DeviceTemplate& template_);
-    juce::Array<DeviceTemplate> loadAllTemplates();
+    bool loadTemplate(const juce::Identifier& deviceID, DeviceTemplate& template_) const;
+    
+    /**
+     * Re-stats the templates directory and applies added, changed and removed
+     * files to the index. Called by the directory watcher.
+     * 
+     * @return True if any template changed
+     */
+    bool rescan();
+    void setWatchingDirectory(bool shouldWatch);
+    
+    // IDs added, changed or removed by the last rescan() or saveTemplate()
+    const juce::Array<juce::Identifier>& getLastChangedTemplates() const noexcept { return lastChanged; }
     
     // Template directory
     juce::File getTemplatesDirectory() const;
+    juce::File getManifestFile() const;
     
 private:
-    juce::Array<DeviceTemplate> templates;
+    // Identifiers are pooled, so the string pointer is a stable, unique key
+    struct IdentifierHasher
+    {
+        size_t operator()(const juce::Identifier& id) const noexcept
+        {
+            return std::hash<const void*>()(id.getCharPointer().getAddress());
+        }
+    };
+    
+    struct Entry
+    {
+        TemplateInfo info;
+        mutable std::shared_ptr<const DeviceTemplate> loaded; // Parsed on first use
+    };
+    
     juce::File templatesDirectory;
+    std::map<juce::String, TemplateInfo> filesByPath;   // Sorted, so duplicate IDs resolve deterministically
+    std::unordered_map<juce::Identifier, Entry, IdentifierHasher> index;
+    juce::Array<TemplateInfo> orderedTemplates;
+    juce::Array<juce::Identifier> lastChanged;
+    bool indexed = false;
     
     void ensureTemplatesDirectoryExists();
     
+    std::map<juce::String, TemplateInfo> scanDirectory(const std::map<juce::String, TemplateInfo>& known) const;
+    void rebuildIndex();
+    void updateOrder();
+    
+    std::map<juce::String, TemplateInfo> readManifest() const;
+    void writeManifest() const;
+    
+    static bool readTemplateInfo(const juce::File& file, TemplateInfo& info);
+    static bool parseTemplateFile(const juce::File& file, DeviceTemplate& template_);
+    
+    void timerCallback() override;
+    
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeviceTemplateManager)
 };
-
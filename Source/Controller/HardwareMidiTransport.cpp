@@ -0,0 +1,61 @@
+#include "HardwareMidiTransport.h"
+
+HardwareMidiTransport::~HardwareMidiTransport()
+{
+    close();
+}
+
+juce::Result HardwareMidiTransport::open(const juce::String& outputName, const juce::String& outputIdentifier,
+                                         const juce::String& inputName, const juce::String& inputIdentifier)
+{
+    close();
+    
+    auto result = connectionPool->open(MidiConnectionPool::Direction::output, outputIdentifier, outputName,
+                                       *this, outputConnection);
+    if (result.failed())
+        return result;
+    
+    if (inputName.isNotEmpty() || inputIdentifier.isNotEmpty())
+    {
+        result = connectionPool->open(MidiConnectionPool::Direction::input, inputIdentifier, inputName,
+                                      *this, inputConnection);
+        if (result.failed())
+        {
+            close();
+            return result;
+        }
+    }
+    
+    return juce::Result::ok();
+}
+
+void HardwareMidiTransport::close()
+{
+    inputConnection.reset();
+    outputConnection.reset();
+}
+
+bool HardwareMidiTransport::isOutputConnected() const
+{
+    return outputConnection != nullptr && outputConnection->getState() == MidiConnectionPool::State::connected;
+}
+
+juce::String HardwareMidiTransport::getName() const
+{
+    return outputConnection != nullptr ? outputConnection->getName() : juce::String();
+}
+
+void HardwareMidiTransport::processBlock(const juce::MidiBuffer& output, double, int)
+{
+    if (output.isEmpty())
+        return;
+    
+    if (outputConnection == nullptr || !outputConnection->sendMessagesNow(output))
+        numMessagesDropped += (juce::uint64)output.getNumEvents();
+}
+
+void HardwareMidiTransport::midiConnectionMessageReceived(const MidiConnectionPool::Connection&,
+                                                          const juce::MidiMessage& message)
+{
+    deliver(message);
+}
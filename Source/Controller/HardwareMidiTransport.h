@@ -0,0 +1,51 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MidiTransport.h"
+#include "MidiConnectionPool.h"
+
+/**
+ * MidiTransport over real MIDI ports, for running without a host.
+ * 
+ * In the plugin, the host carries what processAudioThread() produces to
+ * the device. Headless tools attach this transport instead: each block is
+ * sent to the output port as soon as it is drained (MidiManager's wire
+ * model has already paced it), and the input port's messages are delivered
+ * back to MidiManager. Both ports come from the shared MidiConnectionPool,
+ * so they reconnect like the plugin's.
+ * 
+ * THREADING:
+ * - open() and close() on one thread, while no block is being processed
+ * - processBlock() runs on the block driver's thread and may block briefly
+ *   while the pool reconnects a port, so never attach it in a host
+ */
+class HardwareMidiTransport : public MidiTransport,
+                              private MidiConnectionPool::Client
+{
+public:
+    HardwareMidiTransport() = default;
+    ~HardwareMidiTransport() override;
+    
+    /** Opens the ports by identifier, then name. The input is optional (empty name and identifier). */
+    juce::Result open(const juce::String& outputName, const juce::String& outputIdentifier,
+                      const juce::String& inputName, const juce::String& inputIdentifier);
+    void close();
+    
+    bool isOutputConnected() const;
+    juce::String getName() const override;
+    void processBlock(const juce::MidiBuffer& output, double sampleRate, int numSamples) override;
+    
+    /** Messages drained while the output port was away (thread-safe). */
+    juce::uint64 getNumMessagesDropped() const noexcept { return numMessagesDropped.load(); }
+    
+private:
+    juce::SharedResourcePointer<MidiConnectionPool> connectionPool;
+    std::unique_ptr<MidiConnectionPool::Connection> outputConnection;
+    std::unique_ptr<MidiConnectionPool::Connection> inputConnection;
+    std::atomic<juce::uint64> numMessagesDropped { 0 };
+    
+    void midiConnectionStateChanged(const MidiConnectionPool::Connection&, MidiConnectionPool::State) override {}
+    void midiConnectionMessageReceived(const MidiConnectionPool::Connection&, const juce::MidiMessage& message) override;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HardwareMidiTransport)
+};
@@ -0,0 +1,124 @@
+#include "LogHistogram.h"
+
+namespace
+{
+    constexpr int SUB_BUCKET_BITS = 2; // log2(SUB_BUCKETS)
+    
+    int findHighestSetBit64(juce::uint64 value) noexcept
+    {
+        const auto high = (juce::uint32)(value >> 32);
+        
+        if (high != 0)
+            return 32 + juce::findHighestSetBit(high);
+        
+        return juce::findHighestSetBit((juce::uint32)value);
+    }
+}
+
+LogHistogram::LogHistogram()
+{
+    reset();
+}
+
+void LogHistogram::record(juce::uint64 value) noexcept
+{
+    buckets[getBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+    
+    auto previousMax = maximum.load(std::memory_order_relaxed);
+    while (value > previousMax
+           && !maximum.compare_exchange_weak(previousMax, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+double LogHistogram::getMean() const noexcept
+{
+    const auto numSamples = getCount();
+    return numSamples > 0 ? (double)getSum() / (double)numSamples : 0.0;
+}
+
+juce::uint64 LogHistogram::getPercentile(double fraction) const noexcept
+{
+    const auto numSamples = getCount();
+    if (numSamples == 0)
+        return 0;
+    
+    // Rank of the sample we want (1-based), then the bucket that holds it
+    const auto rank = juce::jmax((juce::uint64)1, (juce::uint64)std::ceil(juce::jlimit(0.0, 1.0, fraction) * (double)numSamples));
+    juce::uint64 seen = 0;
+    
+    for (int i = 0; i < NUM_BUCKETS; ++i)
+    {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+            return juce::jmin(getBucketUpperBound(i), getMax());
+    }
+    
+    return getMax();
+}
+
+juce::var LogHistogram::toVar() const
+{
+    juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+    obj->setProperty("count", (juce::int64)getCount());
+    obj->setProperty("sum", (juce::int64)getSum());
+    obj->setProperty("mean", getMean());
+    obj->setProperty("p50", (juce::int64)getPercentile(0.5));
+    obj->setProperty("p90", (juce::int64)getPercentile(0.9));
+    obj->setProperty("p99", (juce::int64)getPercentile(0.99));
+    obj->setProperty("max", (juce::int64)getMax());
+    
+    juce::Array<juce::var> nonEmptyBuckets;
+    for (int i = 0; i < NUM_BUCKETS; ++i)
+    {
+        const auto bucketCount = buckets[i].load(std::memory_order_relaxed);
+        if (bucketCount > 0)
+            nonEmptyBuckets.add(juce::Array<juce::var> { (juce::int64)getBucketLowerBound(i), (juce::int64)bucketCount });
+    }
+    
+    obj->setProperty("buckets", nonEmptyBuckets);
+    return juce::var(obj.get());
+}
+
+void LogHistogram::reset() noexcept
+{
+    for (auto& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    maximum.store(0, std::memory_order_relaxed);
+}
+
+int LogHistogram::getBucketIndex(juce::uint64 value) noexcept
+{
+    if (value < (juce::uint64)SUB_BUCKETS)
+        return (int)value;
+    
+    // Octave from the highest set bit, sub-bucket from the next SUB_BUCKET_BITS bits
+    const int highestBit = findHighestSetBit64(value);
+    const int subBucket = (int)((value >> (highestBit - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    return (highestBit - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + subBucket;
+}
+
+juce::uint64 LogHistogram::getBucketLowerBound(int bucketIndex) noexcept
+{
+    jassert(bucketIndex >= 0 && bucketIndex < NUM_BUCKETS);
+    
+    if (bucketIndex < SUB_BUCKETS)
+        return (juce::uint64)bucketIndex;
+    
+    const int highestBit = bucketIndex / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    const int subBucket = bucketIndex % SUB_BUCKETS;
+    return (juce::uint64)(SUB_BUCKETS + subBucket) << (highestBit - SUB_BUCKET_BITS);
+}
+
+juce::uint64 LogHistogram::getBucketUpperBound(int bucketIndex) noexcept
+{
+    if (bucketIndex >= NUM_BUCKETS - 1)
+        return std::numeric_limits<juce::uint64>::max();
+    
+    return getBucketLowerBound(bucketIndex + 1) - 1;
+}
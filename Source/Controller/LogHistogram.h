@@ -0,0 +1,56 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Lock-free histogram of non-negative integer samples with log-spaced buckets.
+ * 
+ * Each power of two is split into SUB_BUCKETS buckets, so a bucket covers at
+ * most 25% of its lower bound whatever the magnitude: 3 µs and 3 s are
+ * recorded with the same relative precision in a fixed 2 KB of counters.
+ * 
+ * record() is wait-free apart from a rarely contended max update (a few
+ * relaxed atomic adds, well under 50 ns) and may be called from any thread,
+ * including the audio thread. Readers see a consistent-enough view: counts
+ * recorded while a read is in progress may or may not be included.
+ * 
+ * The unit is up to the owner (MidiTelemetry records microseconds or
+ * nanoseconds and says which in its report).
+ */
+class LogHistogram
+{
+public:
+    static constexpr int SUB_BUCKETS = 4;     // Per power of two
+    static constexpr int NUM_BUCKETS = SUB_BUCKETS + (64 - 2) * SUB_BUCKETS;
+    
+    LogHistogram();
+    ~LogHistogram() = default;
+    
+    // Recording (lock-free, any thread)
+    void record(juce::uint64 value) noexcept;
+    
+    // Reading (thread-safe)
+    juce::uint64 getCount() const noexcept { return count.load(std::memory_order_relaxed); }
+    juce::uint64 getSum() const noexcept { return sum.load(std::memory_order_relaxed); }
+    juce::uint64 getMax() const noexcept { return maximum.load(std::memory_order_relaxed); }
+    double getMean() const noexcept;
+    juce::uint64 getPercentile(double fraction) const noexcept; // Upper bound of the bucket holding it (capped at max)
+    
+    /** count, sum, mean, p50, p90, p99, max and the non-empty buckets as [lowerBound, count] pairs. */
+    juce::var toVar() const;
+    
+    void reset() noexcept;
+    
+    // Bucket layout
+    static int getBucketIndex(juce::uint64 value) noexcept;
+    static juce::uint64 getBucketLowerBound(int bucketIndex) noexcept;
+    static juce::uint64 getBucketUpperBound(int bucketIndex) noexcept;
+    
+private:
+    std::atomic<juce::uint64> buckets[NUM_BUCKETS];
+    std::atomic<juce::uint64> count { 0 };
+    std::atomic<juce::uint64> sum { 0 };
+    std::atomic<juce::uint64> maximum { 0 };
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LogHistogram)
+};
@@ -0,0 +1,34 @@
+#include "LoopbackMidiTransport.h"
+
+LoopbackMidiTransport::LoopbackMidiTransport(const Options& transportOptions)
+    : options(transportOptions)
+{
+}
+
+void LoopbackMidiTransport::processBlock(const juce::MidiBuffer& output, double, int numSamples)
+{
+    const auto blockStart = samplesProcessed.load(std::memory_order_relaxed);
+    
+    for (const auto metadata : output)
+    {
+        numMessagesReceived.fetch_add(1, std::memory_order_relaxed);
+        numBytesReceived.fetch_add((juce::uint64)metadata.numBytes, std::memory_order_relaxed);
+        
+        if (options.echo)
+            pending.add({ blockStart + metadata.samplePosition + options.latencySamples, metadata.getMessage() });
+    }
+    
+    // Messages due by the end of this block come back now, in order
+    const auto blockEnd = blockStart + numSamples;
+    int numDue = 0;
+    
+    while (numDue < pending.size() && pending.getReference(numDue).dueSample < blockEnd)
+    {
+        deliver(pending.getReference(numDue).message);
+        ++numDue;
+    }
+    
+    pending.removeRange(0, numDue);
+    numMessagesEchoed.fetch_add((juce::uint64)numDue, std::memory_order_relaxed);
+    samplesProcessed.store(blockEnd, std::memory_order_relaxed);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MidiTransport.h"
+
+/**
+ * Virtual MIDI port whose output loops back to its input.
+ * 
+ * Every message MidiManager sends is delivered back after latencySamples,
+ * counted in the sample clock of the blocks, so round trips are exact and
+ * repeatable. With echo off the transport is a sink: it only counts what
+ * it receives, and its processBlock() neither locks nor allocates, so it
+ * can sit behind a real-time stress test.
+ */
+class LoopbackMidiTransport : public MidiTransport
+{
+public:
+    struct Options
+    {
+        bool echo = true;
+        int latencySamples = 0;     // Delay before a message comes back
+        juce::String name = "Virtual Loopback";
+    };
+    
+    LoopbackMidiTransport() : LoopbackMidiTransport(Options()) {}
+    explicit LoopbackMidiTransport(const Options& options);
+    ~LoopbackMidiTransport() override = default;
+    
+    juce::String getName() const override { return options.name; }
+    void processBlock(const juce::MidiBuffer& output, double sampleRate, int numSamples) override;
+    
+    // Counters (thread-safe)
+    juce::uint64 getNumMessagesReceived() const noexcept { return numMessagesReceived.load(std::memory_order_relaxed); }
+    juce::uint64 getNumBytesReceived() const noexcept { return numBytesReceived.load(std::memory_order_relaxed); }
+    juce::uint64 getNumMessagesEchoed() const noexcept { return numMessagesEchoed.load(std::memory_order_relaxed); }
+    juce::int64 getSamplesProcessed() const noexcept { return samplesProcessed.load(std::memory_order_relaxed); }
+    
+private:
+    struct PendingEcho
+    {
+        juce::int64 dueSample;
+        juce::MidiMessage message;
+    };
+    
+    const Options options;
+    juce::Array<PendingEcho> pending;   // processBlock() thread only, in due order
+    
+    std::atomic<juce::uint64> numMessagesReceived { 0 };
+    std::atomic<juce::uint64> numBytesReceived { 0 };
+    std::atomic<juce::uint64> numMessagesEchoed { 0 };
+    std::atomic<juce::int64> samplesProcessed { 0 };
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoopbackMidiTransport)
+};
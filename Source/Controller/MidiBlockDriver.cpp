@@ -0,0 +1,82 @@
+#include "MidiBlockDriver.h"
+
+MidiBlockDriver::MidiBlockDriver(MidiManager& manager, const Options& driverOptions)
+    : juce::Thread("MIDI Block Driver"),
+      midiManager(manager),
+      options(driverOptions)
+{
+    jassert(options.sampleRate > 0.0 && options.blockSize > 0);
+    
+    buffer.ensureSize(64 * 1024);
+    midiManager.prepareToPlay(options.sampleRate);
+}
+
+MidiBlockDriver::~MidiBlockDriver()
+{
+    stop();
+}
+
+void MidiBlockDriver::start()
+{
+    startThread(juce::Thread::Priority::high);
+}
+
+void MidiBlockDriver::stop()
+{
+    stopThread(1000);
+}
+
+void MidiBlockDriver::processBlocks(int numBlocks)
+{
+    jassert(!isThreadRunning());
+    
+    for (int i = 0; i < numBlocks; ++i)
+        processBlock();
+}
+
+bool MidiBlockDriver::processUntil(const std::function<bool()>& done, double maxSeconds)
+{
+    jassert(!isThreadRunning());
+    
+    const auto endSample = samplesProcessed.load() + (juce::int64)(maxSeconds * options.sampleRate);
+    
+    while (!done())
+    {
+        if (samplesProcessed.load() >= endSample)
+            return false;
+        
+        processBlock();
+    }
+    
+    return true;
+}
+
+void MidiBlockDriver::run()
+{
+    const double blockMs = 1000.0 * options.blockSize / options.sampleRate;
+    const double startMs = juce::Time::getMillisecondCounterHiRes();
+    const auto startSample = samplesProcessed.load();
+    
+    while (!threadShouldExit())
+    {
+        processBlock();
+        
+        if (options.speed <= 0.0)
+            continue;
+        
+        // Pace against the start, not the previous block, so sleep jitter doesn't add up
+        const auto blocksDone = (samplesProcessed.load() - startSample) / options.blockSize;
+        const double dueMs = startMs + blocksDone * blockMs / options.speed;
+        const double waitMs = dueMs - juce::Time::getMillisecondCounterHiRes();
+        
+        if (waitMs >= 1.0)
+            wait((int)waitMs);
+    }
+}
+
+void MidiBlockDriver::processBlock()
+{
+    buffer.clear();
+    midiManager.processAudioThread(buffer, options.blockSize);
+    samplesProcessed += options.blockSize;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MidiManager.h"
+
+/**
+ * Stands in for the host's audio callback when there is no host.
+ * 
+ * Calls MidiManager::processAudioThread() block after block on its own
+ * thread (or on the caller's, with processBlocks()), which drains the lanes
+ * into the attached MidiTransport. Time is counted in samples, so the wire
+ * model and the transport see the same clock:
+ * - speed 1: blocks are paced to the wall clock, as a real host would
+ * - speed N: N simulated seconds per wall-clock second
+ * - speed 0: blocks run back to back; the fastest way to run a scenario
+ * 
+ * Runs are reproducible whatever the speed, as long as everything queued
+ * goes in before the blocks that should see it.
+ */
+class MidiBlockDriver : private juce::Thread
+{
+public:
+    struct Options
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        double speed = 1.0;
+    };
+    
+    MidiBlockDriver(MidiManager& midiManager, const Options& options);
+    ~MidiBlockDriver() override;
+    
+    void start();
+    void stop();
+    bool isRunning() const { return isThreadRunning(); }
+    
+    /** Runs blocks on the calling thread; only while stopped. */
+    void processBlocks(int numBlocks);
+    
+    /**
+     * Runs blocks on the calling thread until done() returns true or
+     * maxSeconds of simulated time have passed. Returns done()'s last result.
+     */
+    bool processUntil(const std::function<bool()>& done, double maxSeconds);
+    
+    // Simulated time (thread-safe)
+    juce::int64 getSamplesProcessed() const noexcept { return samplesProcessed.load(); }
+    double getElapsedSeconds() const noexcept { return samplesProcessed.load() / options.sampleRate; }
+    
+private:
+    MidiManager& midiManager;
+    const Options options;
+    juce::MidiBuffer buffer;
+    std::atomic<juce::int64> samplesProcessed { 0 };
+    
+    void run() override;
+    void processBlock();
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiBlockDriver)
+};
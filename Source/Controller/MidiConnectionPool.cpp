@@ -0,0 +1,382 @@
+#include "MidiConnectionPool.h"
+#include "TraceRecorder.h"
+
+/** An open (or reopening) device, shared by every Connection to it. */
+struct MidiConnectionPool::Connection::Port : public juce::MidiInputCallback
+{
+    Direction direction = Direction::output;
+    
+    // Written under the pool lock; nameLock lets clients read them without it
+    juce::SpinLock nameLock;
+    juce::String identifier;
+    juce::String name;
+    
+    std::unique_ptr<juce::MidiOutput> output;
+    std::unique_ptr<juce::MidiInput> input;
+    std::atomic<State> state { State::connected };
+    
+    // Reconnect schedule (pool lock)
+    juce::int64 disconnectedAtMs = 0;
+    juce::int64 nextRetryMs = 0;
+    int retryDelayMs = 0;
+    
+    // Written under the pool lock and callbackLock; the MIDI thread reads them under callbackLock
+    juce::Array<Connection*> connections;
+    juce::CriticalSection callbackLock;
+    
+    juce::String getIdentifier() const
+    {
+        const juce::SpinLock::ScopedLockType sl(nameLock);
+        return identifier;
+    }
+    
+    juce::String getName() const
+    {
+        const juce::SpinLock::ScopedLockType sl(nameLock);
+        return name;
+    }
+    
+    void setDevice(const juce::MidiDeviceInfo& device)
+    {
+        const juce::SpinLock::ScopedLockType sl(nameLock);
+        identifier = device.identifier;
+        name = device.name;
+    }
+    
+    void closeDevice()
+    {
+        if (input != nullptr)
+            input->stop();
+        
+        input.reset();
+        output.reset();
+    }
+    
+    void handleIncomingMidiMessage(juce::MidiInput*, const juce::MidiMessage& message) override
+    {
+        const juce::ScopedLock sl(callbackLock);
+        for (auto* connection : connections)
+            connection->client.midiConnectionMessageReceived(*connection, message);
+    }
+};
+
+namespace
+{
+    constexpr juce::int64 noRetry = std::numeric_limits<juce::int64>::max();
+    
+    juce::int64 nowMs() noexcept
+    {
+        return (juce::int64)juce::Time::getMillisecondCounterHiRes();
+    }
+    
+    const char* getDirectionName(MidiConnectionPool::Direction direction) noexcept
+    {
+        return direction == MidiConnectionPool::Direction::output ? "output" : "input";
+    }
+}
+
+MidiConnectionPool::Connection::Connection(MidiConnectionPool& owner, Port& connectedPort, Client& connectionClient)
+    : pool(owner), port(connectedPort), client(connectionClient)
+{
+}
+
+MidiConnectionPool::Connection::~Connection()
+{
+    pool.release(*this);
+}
+
+MidiConnectionPool::Direction MidiConnectionPool::Connection::getDirection() const noexcept
+{
+    return port.direction;
+}
+
+MidiConnectionPool::State MidiConnectionPool::Connection::getState() const noexcept
+{
+    return port.state.load();
+}
+
+juce::String MidiConnectionPool::Connection::getName() const
+{
+    return port.getName();
+}
+
+juce::String MidiConnectionPool::Connection::getIdentifier() const
+{
+    return port.getIdentifier();
+}
+
+bool MidiConnectionPool::Connection::sendMessagesNow(const juce::MidiBuffer& messages)
+{
+    jassert(port.direction == Direction::output);
+    
+    // The pool lock keeps a reconnect from replacing the device mid-send
+    const juce::ScopedLock sl(pool.lock);
+    
+    if (port.output == nullptr || port.state.load() != State::connected)
+        return false;
+    
+    port.output->sendBlockOfMessagesNow(messages);
+    return true;
+}
+
+MidiConnectionPool::MidiConnectionPool()
+    : juce::Thread("MIDI Reconnect")
+{
+    deviceWatcher->addListener(this);
+    startThread();
+}
+
+MidiConnectionPool::~MidiConnectionPool()
+{
+    deviceWatcher->removeListener(this);
+    stopThread(MAX_RETRY_MS);
+    
+    // Every Connection must be released before the last SharedResourcePointer goes
+    jassert(ports.isEmpty());
+}
+
+juce::Result MidiConnectionPool::open(Direction direction, const juce::String& identifier, const juce::String& name,
+                                      Client& client, std::unique_ptr<Connection>& connection)
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("MidiConnectionPool::open");
+    
+    const auto devices = deviceWatcher->getDeviceList(true);
+    const auto& available = direction == Direction::output ? devices->outputs : devices->inputs;
+    const juce::String kind = getDirectionName(direction);
+    
+    const juce::ScopedLock sl(lock);
+    
+    // A port that is already open (or reconnecting) is joined, even if its device is briefly gone
+    auto* port = findPort(direction, identifier);
+    
+    if (port == nullptr)
+    {
+        const int index = MidiDeviceWatcher::findDevice(available, identifier, name);
+        if (index < 0)
+            return juce::Result::fail("MIDI " + kind + " port not found: " + name);
+        
+        const auto device = available[index];
+        port = findPort(direction, device.identifier);
+        
+        if (port == nullptr)
+        {
+            auto newPort = std::make_unique<Port>();
+            newPort->direction = direction;
+            newPort->setDevice(device);
+            
+            if (!reopen(*newPort))
+                return juce::Result::fail("Failed to open MIDI " + kind + " port: " + name);
+            
+            port = ports.add(newPort.release());
+        }
+    }
+    
+    connection.reset(new Connection(*this, *port, client));
+    
+    const juce::ScopedLock cl(port->callbackLock);
+    port->connections.add(connection.get());
+    return juce::Result::ok();
+}
+
+const char* MidiConnectionPool::getStateName(State state) noexcept
+{
+    switch (state)
+    {
+        case State::connected:      return "connected";
+        case State::reconnecting:   return "reconnecting";
+        case State::lost:           break;
+    }
+    
+    return "lost";
+}
+
+MidiConnectionPool::Port* MidiConnectionPool::findPort(Direction direction, const juce::String& identifier) const
+{
+    if (identifier.isEmpty())
+        return nullptr;
+    
+    for (auto* port : ports)
+        if (port->direction == direction && port->getIdentifier() == identifier)
+            return port;
+    
+    return nullptr;
+}
+
+bool MidiConnectionPool::reopen(Port& port)
+{
+    // Open by identifier first: it needs no enumeration, so a retry isn't held up by the device poll
+    const auto identifier = port.getIdentifier();
+    const auto devices = deviceWatcher->getDeviceList(false);
+    const auto& available = port.direction == Direction::output ? devices->outputs : devices->inputs;
+    
+    auto tryOpen = [&port](const juce::String& deviceIdentifier)
+    {
+        if (port.direction == Direction::output)
+        {
+            port.output = juce::MidiOutput::openDevice(deviceIdentifier);
+            return port.output != nullptr;
+        }
+        
+        port.input = juce::MidiInput::openDevice(deviceIdentifier, &port);
+        if (port.input == nullptr)
+            return false;
+        
+        port.input->start();
+        return true;
+    };
+    
+    if (tryOpen(identifier))
+    {
+        // Pick up a rename
+        const int index = MidiDeviceWatcher::findDevice(available, identifier, {});
+        if (index >= 0)
+            port.setDevice(available[index]);
+        
+        return true;
+    }
+    
+    // Some backends hand out a new identifier when a device is replugged
+    const int index = MidiDeviceWatcher::findDevice(available, {}, port.getName());
+    if (index < 0 || available.getReference(index).identifier == identifier)
+        return false;
+    
+    if (findPort(port.direction, available.getReference(index).identifier) != nullptr)
+        return false; // Same name, but another open device
+    
+    if (!tryOpen(available.getReference(index).identifier))
+        return false;
+    
+    port.setDevice(available[index]);
+    return true;
+}
+
+void MidiConnectionPool::setState(Port& port, State newState)
+{
+    if (port.state.exchange(newState) == newState)
+        return;
+    
+    juce::Logger::writeToLog("MIDI " + juce::String(getDirectionName(port.direction)) + " " + port.getName()
+                             + ": " + getStateName(newState));
+    
+    for (auto* connection : port.connections)
+        connection->client.midiConnectionStateChanged(*connection, newState);
+}
+
+void MidiConnectionPool::release(Connection& connection)
+{
+    const juce::ScopedLock sl(lock);
+    auto& port = connection.port;
+    
+    {
+        const juce::ScopedLock cl(port.callbackLock);
+        port.connections.removeFirstMatchingValue(&connection);
+    }
+    
+    if (port.connections.isEmpty())
+    {
+        port.closeDevice();
+        ports.removeObject(&port);
+    }
+}
+
+void MidiConnectionPool::run()
+{
+    while (!threadShouldExit())
+    {
+        const int waitMs = retryDuePorts();
+        wait(waitMs); // -1: until midiDevicesChanged() or the destructor wakes us
+    }
+}
+
+int MidiConnectionPool::retryDuePorts()
+{
+    const juce::ScopedLock sl(lock);
+    const auto now = nowMs();
+    auto nextWakeMs = noRetry;
+    
+    for (auto* port : ports)
+    {
+        if (port->state == State::connected)
+            continue;
+        
+        if (port->nextRetryMs <= now)
+        {
+            MIDI_LIBRARIAN_TRACE_SCOPE("MidiConnectionPool::reopen");
+            
+            if (reopen(*port))
+            {
+                setState(*port, State::connected);
+                continue;
+            }
+            
+            port->retryDelayMs = juce::jmin(port->retryDelayMs * 2, MAX_RETRY_MS);
+            port->nextRetryMs = port->state == State::lost ? noRetry : now + port->retryDelayMs;
+        }
+        
+        if (port->state == State::reconnecting)
+        {
+            const auto windowEndMs = port->disconnectedAtMs + RECONNECT_WINDOW_MS;
+            
+            if (now >= windowEndMs)
+            {
+                // Stop polling the driver; the watcher reports the device if it comes back
+                port->nextRetryMs = noRetry;
+                setState(*port, State::lost);
+                continue;
+            }
+            
+            nextWakeMs = juce::jmin(nextWakeMs, windowEndMs);
+        }
+        
+        nextWakeMs = juce::jmin(nextWakeMs, port->nextRetryMs);
+    }
+    
+    if (nextWakeMs == noRetry)
+        return -1;
+    
+    return (int)juce::jmax((juce::int64)0, nextWakeMs - now);
+}
+
+void MidiConnectionPool::midiDevicesChanged(const MidiDeviceWatcher::Diff& diff)
+{
+    const juce::ScopedLock sl(lock);
+    const auto now = nowMs();
+    bool shouldRetry = false;
+    
+    for (auto* port : ports)
+    {
+        const bool isOutput = port->direction == Direction::output;
+        const auto& added = isOutput ? diff.addedOutputs : diff.addedInputs;
+        const auto& removed = isOutput ? diff.removedOutputs : diff.removedInputs;
+        const auto identifier = port->getIdentifier();
+        
+        if (port->state == State::connected)
+        {
+            if (MidiDeviceWatcher::findDevice(removed, identifier, {}) < 0)
+                continue;
+            
+            // Removed and added under the same identifier: only the name changed
+            const int renamed = MidiDeviceWatcher::findDevice(added, identifier, {});
+            if (renamed >= 0)
+            {
+                port->setDevice(added[renamed]);
+                continue;
+            }
+            
+            port->closeDevice();
+            port->disconnectedAtMs = now;
+            port->retryDelayMs = INITIAL_RETRY_MS;
+            port->nextRetryMs = now + INITIAL_RETRY_MS;
+            setState(*port, State::reconnecting);
+            shouldRetry = true;
+        }
+        else if (MidiDeviceWatcher::findDevice(added, identifier, port->getName()) >= 0)
+        {
+            port->nextRetryMs = now;
+            shouldRetry = true;
+        }
+    }
+    
+    if (shouldRetry)
+        notify();
+}
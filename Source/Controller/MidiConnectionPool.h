@@ -0,0 +1,127 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <memory>
+#include "MidiDeviceWatcher.h"
+
+/**
+ * Process-wide pool of open MIDI ports with automatic reconnect.
+ * 
+ * Each port is opened once however many MidiManagers use it, and is keyed by
+ * MidiDeviceInfo::identifier. The display name is only a fallback, for old
+ * configs without an identifier and backends that hand out new identifiers
+ * when a device is replugged. Clients hold a Connection; the port closes
+ * when the last one is released.
+ * 
+ * RECONNECT:
+ * - When the watcher reports a port's device gone, the port goes to
+ *   `reconnecting` and the pool thread retries opening it, starting after
+ *   INITIAL_RETRY_MS and doubling up to MAX_RETRY_MS
+ * - Retries open by identifier directly, so they don't wait for the next
+ *   device poll; a device the watcher reports back is retried at once
+ * - If the port isn't back within RECONNECT_WINDOW_MS it becomes `lost`:
+ *   timed retries stop, and it reopens only when the watcher sees it again
+ * 
+ * THREADING:
+ * - open() and Connection release may be called from any thread, but not
+ *   from inside a Client callback
+ * - Client::midiConnectionStateChanged() runs on the pool or watcher thread
+ *   with the pool locked; it must not call back into the pool
+ * - Client::midiConnectionMessageReceived() runs on the MIDI input thread
+ * 
+ * Hold it with juce::SharedResourcePointer.
+ */
+class MidiConnectionPool : private juce::Thread,
+                           private MidiDeviceWatcher::Listener
+{
+public:
+    enum class Direction
+    {
+        output,
+        input
+    };
+    
+    enum class State
+    {
+        connected,
+        reconnecting,   // Device gone, retrying within RECONNECT_WINDOW_MS
+        lost            // Device gone for longer; reopens when it comes back
+    };
+    
+    static constexpr int INITIAL_RETRY_MS = 50;
+    static constexpr int MAX_RETRY_MS = 1000;
+    static constexpr int RECONNECT_WINDOW_MS = 3000;
+    
+    class Connection;
+    
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+        virtual void midiConnectionStateChanged(const Connection& connection, State newState) = 0;
+        virtual void midiConnectionMessageReceived(const Connection&, const juce::MidiMessage&) {}
+    };
+    
+    /** One client's hold on a port. */
+    class Connection
+    {
+    public:
+        ~Connection();
+        
+        Direction getDirection() const noexcept;
+        State getState() const noexcept;
+        juce::String getName() const;          // Follows renames on reconnect
+        juce::String getIdentifier() const;
+        
+        /**
+         * Sends straight to an output port, for tools that have no host to
+         * carry MidiManager's blocks (see HardwareMidiTransport). Returns
+         * false if the port isn't connected.
+         */
+        bool sendMessagesNow(const juce::MidiBuffer& messages);
+    
+    private:
+        friend class MidiConnectionPool;
+        struct Port;
+        
+        Connection(MidiConnectionPool& owner, Port& connectedPort, Client& connectionClient);
+        
+        MidiConnectionPool& pool;
+        Port& port;
+        Client& client;
+        
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Connection)
+    };
+    
+    MidiConnectionPool();
+    ~MidiConnectionPool() override;
+    
+    /**
+     * Opens a port, or joins it if it is already open.
+     * 
+     * The device is found by identifier, then by name. Fails if neither
+     * matches a present device or the device can't be opened.
+     */
+    juce::Result open(Direction direction, const juce::String& identifier, const juce::String& name,
+                      Client& client, std::unique_ptr<Connection>& connection);
+    
+    static const char* getStateName(State state) noexcept;
+    
+private:
+    using Port = Connection::Port;
+    
+    juce::SharedResourcePointer<MidiDeviceWatcher> deviceWatcher;
+    juce::CriticalSection lock;
+    juce::OwnedArray<Port> ports;
+    
+    Port* findPort(Direction direction, const juce::String& identifier) const;
+    bool reopen(Port& port); // Caller holds lock
+    void setState(Port& port, State newState);
+    void release(Connection& connection);
+    
+    void run() override;
+    int retryDuePorts(); // Returns ms until the next retry, or -1 for none
+    void midiDevicesChanged(const MidiDeviceWatcher::Diff& diff) override;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiConnectionPool)
+};
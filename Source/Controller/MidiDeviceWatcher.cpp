@@ -0,0 +1,130 @@
+#include "MidiDeviceWatcher.h"
+#include "TraceRecorder.h"
+
+MidiDeviceWatcher::MidiDeviceWatcher()
+    : juce::Thread("MIDI Device Watcher"),
+      current(std::make_shared<DeviceList>())
+{
+}
+
+MidiDeviceWatcher::~MidiDeviceWatcher()
+{
+    stopThread(FIRST_SCAN_TIMEOUT_MS);
+}
+
+MidiDeviceWatcher::DeviceListPtr MidiDeviceWatcher::getDeviceList(bool waitForFirstScan)
+{
+    {
+        const juce::ScopedLock sl(startLock);
+        if (!isThreadRunning())
+            startThread(juce::Thread::Priority::low);
+    }
+    
+    if (waitForFirstScan)
+        firstScanDone.wait(FIRST_SCAN_TIMEOUT_MS);
+    
+    const juce::SpinLock::ScopedLockType lock(listLock);
+    return current;
+}
+
+void MidiDeviceWatcher::rescanNow()
+{
+    notify();
+}
+
+void MidiDeviceWatcher::addListener(Listener* listener)
+{
+    listeners.add(listener);
+}
+
+void MidiDeviceWatcher::removeListener(Listener* listener)
+{
+    listeners.remove(listener);
+}
+
+int MidiDeviceWatcher::findDevice(const juce::Array<juce::MidiDeviceInfo>& devices, const juce::String& identifier,
+                                  const juce::String& name)
+{
+    if (identifier.isNotEmpty())
+    {
+        for (int i = 0; i < devices.size(); ++i)
+            if (devices.getReference(i).identifier == identifier)
+                return i;
+    }
+    
+    // Some backends hand out new identifiers when a device is replugged
+    if (name.isNotEmpty())
+    {
+        for (int i = 0; i < devices.size(); ++i)
+            if (devices.getReference(i).name == name)
+                return i;
+    }
+    
+    return -1;
+}
+
+juce::StringArray MidiDeviceWatcher::getNames(const juce::Array<juce::MidiDeviceInfo>& devices)
+{
+    juce::StringArray names;
+    for (const auto& device : devices)
+        names.add(device.name);
+    return names;
+}
+
+void MidiDeviceWatcher::run()
+{
+    while (!threadShouldExit())
+    {
+        scan();
+        firstScanDone.signal(); // Also when nothing was found
+        wait(POLL_INTERVAL_MS);
+    }
+}
+
+void MidiDeviceWatcher::scan()
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("MidiDeviceWatcher::scan");
+    
+    auto scanned = std::make_shared<DeviceList>();
+    scanned->outputs = juce::MidiOutput::getAvailableDevices();
+    scanned->inputs = juce::MidiInput::getAvailableDevices();
+    
+    DeviceListPtr previous;
+    {
+        const juce::SpinLock::ScopedLockType lock(listLock);
+        previous = current;
+    }
+    
+    // Only this thread publishes, so nothing can change current between here and the swap
+    if (previous->version != 0 && scanned->outputs == previous->outputs && scanned->inputs == previous->inputs)
+        return;
+    
+    Diff diff;
+    diffDevices(previous->outputs, scanned->outputs, diff.addedOutputs, diff.removedOutputs);
+    diffDevices(previous->inputs, scanned->inputs, diff.addedInputs, diff.removedInputs);
+    diff.version = scanned->version = previous->version + 1;
+    
+    {
+        const juce::SpinLock::ScopedLockType lock(listLock);
+        current = scanned;
+    }
+    
+    // Listeners reopening ports read the list; they must not wait for it
+    firstScanDone.signal();
+    listeners.call([&diff](Listener& listener) { listener.midiDevicesChanged(diff); });
+}
+
+void MidiDeviceWatcher::diffDevices(const juce::Array<juce::MidiDeviceInfo>& before,
+                                    const juce::Array<juce::MidiDeviceInfo>& after,
+                                    juce::Array<juce::MidiDeviceInfo>& added,
+                                    juce::Array<juce::MidiDeviceInfo>& removed)
+{
+    // A device that only changed its name counts as removed and added, so name matches see it
+    for (const auto& device : after)
+        if (!before.contains(device))
+            added.add(device);
+    
+    for (const auto& device : before)
+        if (!after.contains(device))
+            removed.add(device);
+}
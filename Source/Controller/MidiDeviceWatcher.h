@@ -0,0 +1,93 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <memory>
+
+/**
+ * Keeps the list of MIDI devices up to date on a background thread.
+ * 
+ * Enumerating devices can take tens of milliseconds (macOS with many virtual
+ * ports), so nothing else calls juce::MidiInput/MidiOutput::getAvailableDevices().
+ * The watcher polls every POLL_INTERVAL_MS and publishes the result as an
+ * immutable, versioned DeviceList; readers on any thread get the latest one
+ * without locking out the scan.
+ * 
+ * Devices are compared by MidiDeviceInfo::identifier, which stays the same
+ * when other ports come and go. When the list changes, listeners receive a
+ * Diff of added and removed devices on the watcher thread, so they can close
+ * and reopen ports there without blocking the message thread.
+ * 
+ * One watcher serves the whole process: hold it with juce::SharedResourcePointer.
+ * The thread starts on the first getDeviceList(), so a host scanning the
+ * plugin never enumerates devices.
+ */
+class MidiDeviceWatcher : private juce::Thread
+{
+public:
+    struct DeviceList
+    {
+        juce::Array<juce::MidiDeviceInfo> outputs;
+        juce::Array<juce::MidiDeviceInfo> inputs;
+        juce::uint64 version = 0;  // 0 until the first scan
+    };
+    
+    using DeviceListPtr = std::shared_ptr<const DeviceList>;
+    
+    /** What changed between two versions of the list. */
+    struct Diff
+    {
+        juce::Array<juce::MidiDeviceInfo> addedOutputs;
+        juce::Array<juce::MidiDeviceInfo> removedOutputs;
+        juce::Array<juce::MidiDeviceInfo> addedInputs;
+        juce::Array<juce::MidiDeviceInfo> removedInputs;
+        juce::uint64 version = 0;  // Version of the new list
+    };
+    
+    /** Called on the watcher thread after each change is published. */
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        virtual void midiDevicesChanged(const Diff& diff) = 0;
+    };
+    
+    static constexpr int POLL_INTERVAL_MS = 1000;
+    static constexpr int FIRST_SCAN_TIMEOUT_MS = 2000;
+    
+    MidiDeviceWatcher();
+    ~MidiDeviceWatcher() override;
+    
+    /**
+     * Latest device list (thread-safe). The first call starts the watcher.
+     * Until its first scan completes the list is empty (version 0), unless
+     * waitForFirstScan is set (waits at most FIRST_SCAN_TIMEOUT_MS).
+     */
+    DeviceListPtr getDeviceList(bool waitForFirstScan);
+    
+    /** Wakes the watcher to scan now instead of at the next poll. */
+    void rescanNow();
+    
+    // Listeners (thread-safe; removeListener() waits for a running callback)
+    void addListener(Listener* listener);
+    void removeListener(Listener* listener);
+    
+    // Lookup helpers: by identifier, falling back to the display name
+    static int findDevice(const juce::Array<juce::MidiDeviceInfo>& devices, const juce::String& identifier,
+                          const juce::String& name);
+    static juce::StringArray getNames(const juce::Array<juce::MidiDeviceInfo>& devices);
+    
+private:
+    mutable juce::SpinLock listLock;
+    DeviceListPtr current;
+    juce::CriticalSection startLock;
+    juce::WaitableEvent firstScanDone { true };
+    juce::ListenerList<Listener, juce::Array<Listener*, juce::CriticalSection>> listeners;
+    
+    void run() override;
+    void scan();
+    
+    static void diffDevices(const juce::Array<juce::MidiDeviceInfo>& before, const juce::Array<juce::MidiDeviceInfo>& after,
+                            juce::Array<juce::MidiDeviceInfo>& added, juce::Array<juce::MidiDeviceInfo>& removed);
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiDeviceWatcher)
+};
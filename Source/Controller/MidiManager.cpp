@@ -1,58 +1,73 @@
 #include "MidiManager.h"
+#include "TraceRecorder.h"
 
 MidiManager::MidiManager()
 {
-    // Initialize MIDI message queue
-    midiMessageQueue.ensureStorageAllocated(MIDI_FIFO_SIZE);
-    midiMessageQueue.resize(MIDI_FIFO_SIZE);
-    
     // Create input callback
     inputCallback = std::make_unique<MidiInputCallback>(*this);
     
-    // Listen for MIDI device changes
-    juce::MidiOutput::getDevices(); // Trigger device list refresh
-    juce::MidiOutput::addChangeListener(this);
-    juce::MidiInput::getDevices(); // Trigger input device list refresh
-    juce::MidiInput::addChangeListener(this);
+    // Hotplug: the shared watcher enumerates devices on its own thread
+    deviceWatcher->addListener(this);
+    
+    startTimer(RATE_INTERVAL_MS);
 }
 
 MidiManager::~MidiManager()
 {
-    juce::MidiOutput::removeChangeListener(this);
-    juce::MidiInput::removeChangeListener(this);
-    closePort();
-    closeInputPort();
+    stopTimer();
+    deviceWatcher->removeListener(this);
+    
+    if (auto* virtualTransport = transport.exchange(nullptr))
+        virtualTransport->setReceiver(nullptr);
+    
+    // Releasing the connections waits for any pool callback into this object
+    disconnect(MidiConnectionPool::Direction::output);
+    disconnect(MidiConnectionPool::Direction::input);
 }
 
 void MidiManager::MidiInputCallback::handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message)
 {
+    // Count on the MIDI thread so the statistics see every event, including filtered ones
+    midiManager.inputStatistics.recordMessage(message);
+    midiManager.inputListeners.call([&message](InputListener& listener) { listener.midiInputReceived(message); });
+    
     // Forward to callback on message thread
     if (midiManager.onMidiInput)
     {
-        juce::MessageManager::callAsync([this, message]()
+        const auto receivedTicks = juce::Time::getHighResolutionTicks();
+        
+        juce::MessageManager::callAsync([this, message, receivedTicks]()
         {
+            // Lets a recall triggered by this message be timed from its arrival
+            midiManager.telemetry.beginInputDispatch(receivedTicks);
             midiManager.onMidiInput(message);
+            midiManager.telemetry.endInputDispatch();
         });
     }
 }
 
-juce::Result MidiManager::setOutputPort(const juce::String& portName)
+juce::Result MidiManager::setOutputPort(const juce::String& portName, const juce::String& identifier)
 {
-    const juce::ScopedLock sl(deviceLock);
+    MIDI_LIBRARIAN_TRACE_SCOPE("MidiManager::setOutputPort");
     
-    if (portName.isEmpty())
+    if (portName.isEmpty() && identifier.isEmpty())
     {
-        closePort();
+        disconnect(MidiConnectionPool::Direction::output);
         sendChangeMessage();
         return juce::Result::ok();
     }
     
-    if (portName == currentPortName && midiOutput != nullptr)
     {
-        return juce::Result::ok(); // Already open
+        const juce::ScopedLock sl(deviceLock);
+        if (outputConnection != nullptr
+            && (identifier.isNotEmpty() ? identifier == outputConnection->getIdentifier()
+                                        : portName == outputConnection->getName()))
+        {
+            return juce::Result::ok(); // Already open (or reconnecting)
+        }
     }
     
-    auto result = openPort(portName);
+    auto result = connect(MidiConnectionPool::Direction::output, portName, identifier);
     if (result.wasOk())
     {
         sendChangeMessage();
@@ -70,31 +85,57 @@ void MidiManager::setMidiChannel(int channel)
 
 juce::StringArray MidiManager::getAvailableOutputPorts() const
 {
-    return juce::MidiOutput::getDevices();
+    return MidiDeviceWatcher::getNames(getAvailableOutputDevices());
 }
 
 juce::StringArray MidiManager::getAvailableInputPorts() const
 {
-    return juce::MidiInput::getDevices();
+    return MidiDeviceWatcher::getNames(getAvailableInputDevices());
 }
 
-juce::Result MidiManager::setInputPort(const juce::String& portName)
+juce::Array<juce::MidiDeviceInfo> MidiManager::getAvailableOutputDevices() const
 {
-    const juce::ScopedLock sl(deviceLock);
+    return getDeviceList()->outputs;
+}
+
+juce::Array<juce::MidiDeviceInfo> MidiManager::getAvailableInputDevices() const
+{
+    return getDeviceList()->inputs;
+}
+
+juce::uint64 MidiManager::getDeviceListVersion() const
+{
+    return getDeviceList()->version;
+}
+
+MidiDeviceWatcher::DeviceListPtr MidiManager::getDeviceList() const
+{
+    // The message thread never waits for enumeration; it refreshes on the change message instead
+    return deviceWatcher->getDeviceList(!juce::MessageManager::existsAndIsCurrentThread());
+}
+
+juce::Result MidiManager::setInputPort(const juce::String& portName, const juce::String& identifier)
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("MidiManager::setInputPort");
     
-    if (portName.isEmpty())
+    if (portName.isEmpty() && identifier.isEmpty())
     {
-        closeInputPort();
+        disconnect(MidiConnectionPool::Direction::input);
         sendChangeMessage();
         return juce::Result::ok();
     }
     
-    if (portName == currentInputPortName && midiInput != nullptr)
     {
-        return juce::Result::ok(); // Already open
+        const juce::ScopedLock sl(deviceLock);
+        if (inputConnection != nullptr
+            && (identifier.isNotEmpty() ? identifier == inputConnection->getIdentifier()
+                                        : portName == inputConnection->getName()))
+        {
+            return juce::Result::ok(); // Already open (or reconnecting)
+        }
     }
     
-    auto result = openInputPort(portName);
+    auto result = connect(MidiConnectionPool::Direction::input, portName, identifier);
     if (result.wasOk())
     {
         sendChangeMessage();
@@ -102,7 +143,7 @@ juce::Result MidiManager::setInputPort(const juce::String& portName)
     return result;
 }
 
-juce::Result MidiManager::sendProgramChange(int programNumber)
+juce::Result MidiManager::sendProgramChange(int programNumber, Priority priority)
 {
     // Validate program number (0-127)
     if (programNumber < 0 || programNumber > 127)
@@ -110,26 +151,6 @@ juce::Result MidiManager::sendProgramChange(int programNumber)
         return juce::Result::fail("Program number must be 0-127");
     }
     
-    // Check if port is open (thread-safe read)
-    {
-        const juce::ScopedLock sl(deviceLock);
-        if (midiOutput == nullptr)
-        {
-            return juce::Result::fail("MIDI output port not open");
-        }
-    }
-    
-    // Queue message to FIFO (thread-safe)
-    const juce::ScopedLock sl(midiQueueLock);
-    
-    int start1, size1, start2, size2;
-    midiFifo.prepareToWrite(1, start1, size1, start2, size2);
-    
-    if (size1 + size2 == 0)
-    {
-        return juce::Result::fail("MIDI output queue full");
-    }
-    
     // Create Program Change message on the specified channel
     int channel;
     {
@@ -137,23 +158,10 @@ juce::Result MidiManager::sendProgramChange(int programNumber)
         channel = midiChannel + 1; // Convert 0-15 to 1-16
     }
     
-    juce::MidiMessage message = juce::MidiMessage::programChange(channel, programNumber);
-    
-    if (size1 > 0)
-    {
-        midiMessageQueue.set(start1, message);
-        midiFifo.finishedWrite(size1);
-    }
-    else if (size2 > 0)
-    {
-        midiMessageQueue.set(start2, message);
-        midiFifo.finishedWrite(size2);
-    }
-    
-    return juce::Result::ok();
+    return enqueueMessage(juce::MidiMessage::programChange(channel, programNumber), priority);
 }
 
-juce::Result MidiManager::sendControlChange(int controller, int value)
+juce::Result MidiManager::sendControlChange(int controller, int value, Priority priority)
 {
     if (controller < 0 || controller > 127)
     {
@@ -165,47 +173,16 @@ juce::Result MidiManager::sendControlChange(int controller, int value)
         return juce::Result::fail("Control value must be 0-127");
     }
     
-    {
-        const juce::ScopedLock sl(deviceLock);
-        if (midiOutput == nullptr)
-        {
-            return juce::Result::fail("MIDI output port not open");
-        }
-    }
-    
-    const juce::ScopedLock sl(midiQueueLock);
-    
-    int start1, size1, start2, size2;
-    midiFifo.prepareToWrite(1, start1, size1, start2, size2);
-    
-    if (size1 + size2 == 0)
-    {
-        return juce::Result::fail("MIDI output queue full");
-    }
-    
     int channel;
     {
         const juce::ScopedLock deviceSl(deviceLock);
         channel = midiChannel + 1;
     }
     
-    juce::MidiMessage message = juce::MidiMessage::controllerEvent(channel, controller, value);
-    
-    if (size1 > 0)
-    {
-        midiMessageQueue.set(start1, message);
-        midiFifo.finishedWrite(size1);
-    }
-    else if (size2 > 0)
-    {
-        midiMessageQueue.set(start2, message);
-        midiFifo.finishedWrite(size2);
-    }
-    
-    return juce::Result::ok();
+    return enqueueMessage(juce::MidiMessage::controllerEvent(channel, controller, value), priority);
 }
 
-juce::Result MidiManager::sendBankSelect(int bankNumber, bool useMSB)
+juce::Result MidiManager::sendBankSelect(int bankNumber, bool useMSB, Priority priority)
 {
     if (bankNumber < 0 || bankNumber > 127)
     {
@@ -214,101 +191,366 @@ juce::Result MidiManager::sendBankSelect(int bankNumber, bool useMSB)
     
     // Send Bank Select MSB (CC#0) or LSB (CC#32)
     int controller = useMSB ? 0 : 32;
-    return sendControlChange(controller, bankNumber);
+    return sendControlChange(controller, bankNumber, priority);
+}
+
+juce::Result MidiManager::sendSysEx(const juce::uint8* data, int dataSize, Priority priority)
+{
+    if (data == nullptr || dataSize <= 0)
+    {
+        return juce::Result::fail("Invalid SysEx data");
+    }
+    
+    return enqueueMessage(juce::MidiMessage::createSysExMessage(data, dataSize), priority);
 }
 
-juce::Result MidiManager::sendSysEx(const juce::uint8* data, int dataSize)
+juce::Result MidiManager::sendSysExDump(const juce::uint8* data, int dataSize)
 {
     if (data == nullptr || dataSize <= 0)
     {
         return juce::Result::fail("Invalid SysEx data");
     }
     
+    // Split the stream into F0..F7 packets. Each packet is queued separately so
+    // short messages can be sent between packets instead of waiting for the whole dump.
+    juce::Array<juce::MidiMessage> packets;
+    int packetStart = -1;
+    
+    for (int i = 0; i < dataSize; ++i)
     {
-        const juce::ScopedLock sl(deviceLock);
-        if (midiOutput == nullptr)
+        if (data[i] == 0xf0)
         {
-            return juce::Result::fail("MIDI output port not open");
+            packetStart = i;
+        }
+        else if (data[i] == 0xf7 && packetStart >= 0)
+        {
+            packets.add(juce::MidiMessage(data + packetStart, i - packetStart + 1));
+            packetStart = -1;
         }
     }
     
-    const juce::ScopedLock sl(midiQueueLock);
-    
-    // SysEx messages can be large, so we need to handle them carefully
-    // For now, we'll queue them like other messages, but they might need special handling
-    int start1, size1, start2, size2;
-    midiFifo.prepareToWrite(1, start1, size1, start2, size2);
-    
-    if (size1 + size2 == 0)
+    if (packets.isEmpty())
     {
-        return juce::Result::fail("MIDI output queue full");
+        return juce::Result::fail("No complete SysEx messages in data");
     }
     
-    juce::MidiMessage message = juce::MidiMessage::createSysExMessage(data, dataSize);
+    // Queued all at once, so a full lane rejects the whole dump rather than half of it
+    return enqueueMessages(packets, Priority::bulk);
+}
+
+juce::Result MidiManager::enqueueMessage(const juce::MidiMessage& message, Priority priority)
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("MidiManager::enqueueMessage");
     
-    if (size1 > 0)
+    // Accepted while reconnecting: the audio thread holds the lanes until the port is back
+    const auto link = outputLink.load();
+    if (link == OutputLink::closed || link == OutputLink::discarding)
     {
-        midiMessageQueue.set(start1, message);
-        midiFifo.finishedWrite(size1);
+        return juce::Result::fail("MIDI output port not open");
     }
-    else if (size2 > 0)
+    
+    auto& lane = getLane(priority);
+    const bool isBulk = priority == Priority::bulk;
+    const auto enqueueTicks = juce::Time::getHighResolutionTicks();
+    
+    // Account the bytes before the audio thread can see the message
+    outputWire.onBytesQueued(message.getRawDataSize(), isBulk);
+    
+    if (!lane.push(message, enqueueTicks))
     {
-        midiMessageQueue.set(start2, message);
-        midiFifo.finishedWrite(size2);
+        outputWire.onBytesDropped(message.getRawDataSize(), isBulk);
+        telemetry.recordQueueFull();
+        return juce::Result::fail("MIDI output queue full (" + lane.getName() + ")");
     }
     
+    // The enqueue tick identifies the message until processAudioThread() drains it
+    MIDI_LIBRARIAN_TRACE_FLOW_BEGIN("MIDI out", enqueueTicks);
+    
+    notifyMessageQueued(message);
     return juce::Result::ok();
 }
 
-void MidiManager::processAudioThread(juce::MidiBuffer& midiBuffer)
+juce::Result MidiManager::enqueueMessages(const juce::Array<juce::MidiMessage>& messages, Priority priority)
 {
-    // This is called from processBlock() on the audio thread
-    // Read queued messages from FIFO and add to the output MIDI buffer
+    MIDI_LIBRARIAN_TRACE_SCOPE("MidiManager::enqueueMessages");
+    
+    const auto link = outputLink.load();
+    if (link == OutputLink::closed || link == OutputLink::discarding)
+    {
+        return juce::Result::fail("MIDI output port not open");
+    }
+    
+    auto& lane = getLane(priority);
+    const bool isBulk = priority == Priority::bulk;
+    const auto enqueueTicks = juce::Time::getHighResolutionTicks();
+    
+    int numBytes = 0;
+    for (const auto& message : messages)
+        numBytes += message.getRawDataSize();
+    
+    outputWire.onBytesQueued(numBytes, isBulk);
+    
+    if (!lane.pushAll(messages, enqueueTicks))
+    {
+        outputWire.onBytesDropped(numBytes, isBulk);
+        telemetry.recordQueueFull();
+        return juce::Result::fail("MIDI output queue full (" + lane.getName() + ")");
+    }
     
-    const juce::ScopedLock sl(midiQueueLock);
+    for (int i = 0; i < messages.size(); ++i)
+    {
+        MIDI_LIBRARIAN_TRACE_FLOW_BEGIN("MIDI out", enqueueTicks + i);
+        notifyMessageQueued(messages.getReference(i));
+    }
     
-    int start1, size1, start2, size2;
-    midiFifo.prepareToRead(midiFifo.getNumReady(), start1, size1, start2, size2);
+    return juce::Result::ok();
+}
+
+MidiOutputLane& MidiManager::getLane(Priority priority) noexcept
+{
+    switch (priority)
+    {
+        case Priority::realtime:    return realtimeLane;
+        case Priority::interactive: return interactiveLane;
+        case Priority::bulk:        break;
+    }
     
-    // Read first block
-    for (int i = 0; i < size1; ++i)
+    return bulkLane;
+}
+
+const MidiOutputLane& MidiManager::getLane(Priority priority) const noexcept
+{
+    return const_cast<MidiManager*>(this)->getLane(priority);
+}
+
+const char* MidiManager::getPriorityName(Priority priority) noexcept
+{
+    switch (priority)
     {
-        const auto& message = midiMessageQueue[start1 + i];
-        midiBuffer.addEvent(message, 0); // Add at sample 0 (start of block)
+        case Priority::realtime:    return "realtime";
+        case Priority::interactive: return "interactive";
+        case Priority::bulk:        break;
     }
     
-    // Read second block (if FIFO wrapped)
-    for (int i = 0; i < size2; ++i)
+    return "bulk";
+}
+
+void MidiManager::prepareToPlay(double sampleRate)
+{
+    audioSampleRate.store(sampleRate);
+}
+
+void MidiManager::processAudioThread(juce::MidiBuffer& midiBuffer, int numSamples)
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("MidiManager::processAudioThread");
+    
+    // This is called from processBlock() on the audio thread
+    // Drain the lanes in priority order, placing as many messages as the wire
+    // model allows into the output MIDI buffer. Lanes are read without locking.
+    
+    const auto blockStartTicks = juce::Time::getHighResolutionTicks();
+    outputWire.beginBlock(audioSampleRate.load(), numSamples);
+    
+    switch (outputLink.load())
+    {
+        case OutputLink::holding:
+            // The port is reconnecting: keep everything queued for when it's back
+            outputWire.endBlock();
+            telemetry.recordDrainTime(blockStartTicks, juce::Time::getHighResolutionTicks());
+            return;
+        
+        case OutputLink::discarding:
+            discardLane(realtimeLane, false);
+            discardLane(interactiveLane, false);
+            discardLane(bulkLane, true);
+            break;
+        
+        case OutputLink::closed:
+        case OutputLink::connected:
+            break;
+    }
+    
+    // Realtime: everything that fits on the wire this block
+    drainLane(realtimeLane, false, std::numeric_limits<int>::max(), midiBuffer, blockStartTicks);
+    
+    // Interactive: capped so a burst of UI edits can't starve a recall arriving next block
+    if (realtimeLane.isEmpty())
+        drainLane(interactiveLane, false, MAX_INTERACTIVE_PER_BLOCK, midiBuffer, blockStartTicks);
+    
+    // Bulk: only when nothing more urgent is waiting for the wire
+    if (realtimeLane.isEmpty() && interactiveLane.isEmpty())
+        drainLane(bulkLane, true, std::numeric_limits<int>::max(), midiBuffer, blockStartTicks);
+    
+    outputWire.endBlock();
+    telemetry.recordDrainTime(blockStartTicks, juce::Time::getHighResolutionTicks());
+    
+    if (auto* virtualTransport = transport.load())
+        virtualTransport->processBlock(midiBuffer, audioSampleRate.load(), numSamples);
+}
+
+int MidiManager::drainLane(MidiOutputLane& lane, bool isBulk, int maxMessages, juce::MidiBuffer& midiBuffer,
+                           juce::int64 blockStartTicks)
+{
+    int numSent = 0;
+    int sampleOffset = 0;
+    
+    while (numSent < maxMessages)
+    {
+        juce::int64 enqueueTicks = 0;
+        const auto* message = lane.peek(&enqueueTicks);
+        if (message == nullptr)
+            break;
+        
+        // Leave the message queued if the wire is busy past the end of this block
+        if (!outputWire.scheduleMessage(message->getRawDataSize(), isBulk, sampleOffset))
+            break;
+        
+        midiBuffer.addEvent(*message, sampleOffset);
+        lane.pop();
+        telemetry.recordEnqueueLatency(enqueueTicks, blockStartTicks);
+        MIDI_LIBRARIAN_TRACE_FLOW_END("MIDI out", enqueueTicks);
+        ++numSent;
+    }
+    
+    return numSent;
+}
+
+void MidiManager::discardLane(MidiOutputLane& lane, bool isBulk) noexcept
+{
+    juce::int64 enqueueTicks = 0;
+    
+    while (const auto* message = lane.peek(&enqueueTicks))
     {
-        const auto& message = midiMessageQueue[start2 + i];
-        midiBuffer.addEvent(message, 0);
+        outputWire.onBytesDropped(message->getRawDataSize(), isBulk);
+        lane.pop();
+        telemetry.recordDisconnectDrop();
+        MIDI_LIBRARIAN_TRACE_FLOW_END("MIDI out", enqueueTicks);
     }
+}
+
+void MidiManager::setWireBaudRate(double bitsPerSecond)
+{
+    outputWire.setBaudRate(bitsPerSecond);
+}
+
+double MidiManager::getQueueDepthMs() const noexcept
+{
+    return outputWire.getQueueDepthMs();
+}
+
+double MidiManager::estimateWireDelayMs(Priority priority) const noexcept
+{
+    return outputWire.estimateWireDelayMs(priority == Priority::bulk);
+}
+
+MidiOutputLane::Statistics MidiManager::getLaneStatistics(Priority priority) const noexcept
+{
+    return getLane(priority).getStatistics();
+}
+
+void MidiManager::resetLaneHighWaterMarks() noexcept
+{
+    realtimeLane.resetHighWaterMark();
+    interactiveLane.resetHighWaterMark();
+    bulkLane.resetHighWaterMark();
+}
+
+juce::var MidiManager::getDiagnostics() const
+{
+    juce::DynamicObject::Ptr lanes = new juce::DynamicObject();
+    
+    for (int i = 0; i < NUM_PRIORITIES; ++i)
+    {
+        const auto priority = static_cast<Priority>(i);
+        const auto stats = getLaneStatistics(priority);
+        
+        juce::DynamicObject::Ptr lane = new juce::DynamicObject();
+        lane->setProperty("capacity", stats.capacity);
+        lane->setProperty("queued", stats.numQueued);
+        lane->setProperty("highWaterMark", stats.highWaterMark);
+        lane->setProperty("enqueued", (juce::int64)stats.numEnqueued);
+        lane->setProperty("dropped", (juce::int64)stats.numDropped);
+        lanes->setProperty(getPriorityName(priority), juce::var(lane.get()));
+    }
+    
+    // Rates are as of the last timerCallback(), at most RATE_INTERVAL_MS ago
+    auto trafficToVar = [](const MidiTrafficStatistics& stats)
+    {
+        juce::DynamicObject::Ptr traffic = new juce::DynamicObject();
+        traffic->setProperty("messages", (juce::int64)stats.getTotalMessages());
+        traffic->setProperty("bytes", (juce::int64)stats.getTotalBytes());
+        traffic->setProperty("messagesPerSecond", stats.getMessagesPerSecond());
+        traffic->setProperty("bytesPerSecond", stats.getBytesPerSecond());
+        return juce::var(traffic.get());
+    };
+    
+    juce::DynamicObject::Ptr report = new juce::DynamicObject();
+    report->setProperty("telemetry", telemetry.toVar());
+    report->setProperty("lanes", juce::var(lanes.get()));
+    report->setProperty("queueDepthMs", getQueueDepthMs());
+    report->setProperty("input", trafficToVar(inputStatistics));
+    report->setProperty("output", trafficToVar(outputStatistics));
+    return juce::var(report.get());
+}
+
+void MidiManager::resetDiagnostics() noexcept
+{
+    telemetry.reset();
+    resetLaneHighWaterMarks();
+}
+
+void MidiManager::notifyMessageQueued(const juce::MidiMessage& message)
+{
+    outputStatistics.recordMessage(message);
     
-    midiFifo.finishedRead(size1 + size2);
+    if (onMidiOutput)
+        onMidiOutput(message);
+    
+    outputListeners.call([&message](OutputListener& listener) { listener.midiOutputQueued(message); });
+}
+
+void MidiManager::timerCallback()
+{
+    const double now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+    inputStatistics.updateRates(now);
+    outputStatistics.updateRates(now);
 }
 
 bool MidiManager::isPortOpen() const noexcept
 {
-    const juce::ScopedLock sl(deviceLock);
-    return midiOutput != nullptr;
+    return outputLink.load() == OutputLink::connected;
+}
+
+bool MidiManager::isPortReconnecting() const noexcept
+{
+    return outputLink.load() == OutputLink::holding;
 }
 
 bool MidiManager::isInputPortOpen() const noexcept
 {
     const juce::ScopedLock sl(deviceLock);
-    return midiInput != nullptr;
+    return inputConnection != nullptr && inputConnection->getState() == MidiConnectionPool::State::connected;
 }
 
 juce::String MidiManager::getCurrentPortName() const noexcept
+{
+    if (auto* virtualTransport = transport.load())
+        return virtualTransport->getName();
+    
+    const juce::ScopedLock sl(deviceLock);
+    return outputConnection != nullptr ? outputConnection->getName() : juce::String();
+}
+
+juce::String MidiManager::getCurrentPortIdentifier() const noexcept
 {
     const juce::ScopedLock sl(deviceLock);
-    return currentPortName;
+    return outputConnection != nullptr ? outputConnection->getIdentifier() : juce::String();
 }
 
 juce::String MidiManager::getCurrentInputPortName() const noexcept
 {
     const juce::ScopedLock sl(deviceLock);
-    return currentInputPortName;
+    return inputConnection != nullptr ? inputConnection->getName() : juce::String();
 }
 
 int MidiManager::getCurrentChannel() const noexcept
@@ -317,100 +559,132 @@ int MidiManager::getCurrentChannel() const noexcept
     return midiChannel + 1; // Return 1-16 for display
 }
 
-void MidiManager::changeListenerCallback(juce::ChangeBroadcaster* source)
+void MidiManager::midiDevicesChanged(const MidiDeviceWatcher::Diff&)
 {
-    // MIDI device list changed - handle hotplug
-    refreshPortList();
+    // Reconnects are the pool's job; this only refreshes port lists in the UI
     sendChangeMessage();
 }
 
-void MidiManager::refreshPortList()
+void MidiManager::midiConnectionStateChanged(const MidiConnectionPool::Connection& connection,
+                                             MidiConnectionPool::State newState)
 {
-    const juce::ScopedLock sl(deviceLock);
-    
-    auto availablePorts = juce::MidiOutput::getDevices();
-    
-    // If current port is no longer available, close it
-    if (!currentPortName.isEmpty() && !availablePorts.contains(currentPortName))
-    {
-        juce::Logger::writeToLog("MIDI device disconnected: " + currentPortName);
-        closePort();
-    }
-    // If port was closed but is now available again, try to reopen
-    else if (midiOutput == nullptr && !currentPortName.isEmpty() && availablePorts.contains(currentPortName))
     {
-        juce::Logger::writeToLog("MIDI device reconnected, attempting to reopen: " + currentPortName);
-        // Note: We don't call openPort() here directly because we're in a callback
-        // The UI should handle reconnection via setOutputPort()
+        const juce::ScopedLock sl(deviceLock);
+        
+        // A connection being swapped out can still report; connect() reads the new one's state itself
+        if (&connection == outputConnection.get())
+            outputLink = getOutputLink(newState);
+        else if (&connection != inputConnection.get())
+            return;
     }
+    
+    sendChangeMessage();
 }
 
-juce::Result MidiManager::openPort(const juce::String& portName)
+void MidiManager::addInputListener(InputListener* listener)
 {
-    if (portName.isEmpty())
-    {
-        closePort();
-        return juce::Result::ok();
-    }
-    
-    auto availablePorts = juce::MidiOutput::getDevices();
-    int portIndex = availablePorts.indexOf(portName);
-    
-    if (portIndex < 0)
+    inputListeners.add(listener);
+}
+
+void MidiManager::removeInputListener(InputListener* listener)
+{
+    inputListeners.remove(listener);
+}
+
+void MidiManager::addOutputListener(OutputListener* listener)
+{
+    outputListeners.add(listener);
+}
+
+void MidiManager::removeOutputListener(OutputListener* listener)
+{
+    outputListeners.remove(listener);
+}
+
+void MidiManager::setTransport(MidiTransport* newTransport)
+{
+    if (newTransport != nullptr)
     {
-        return juce::Result::fail("MIDI output port not found: " + portName);
+        disconnect(MidiConnectionPool::Direction::output);
+        disconnect(MidiConnectionPool::Direction::input);
+        newTransport->setReceiver(this);
     }
     
-    midiOutput = juce::MidiOutput::openDevice(portIndex);
-    if (midiOutput == nullptr)
-    {
-        return juce::Result::fail("Failed to open MIDI output port: " + portName);
-    }
+    if (auto* previous = transport.exchange(newTransport))
+        if (previous != newTransport)
+            previous->setReceiver(nullptr);
     
-    currentPortName = portName;
-    return juce::Result::ok();
+    outputLink = newTransport != nullptr ? OutputLink::connected : OutputLink::closed;
+    sendChangeMessage();
 }
 
-void MidiManager::closePort()
+void MidiManager::midiTransportMessageReceived(const juce::MidiMessage& message)
 {
-    midiOutput.reset();
-    currentPortName = juce::String();
+    inputCallback->handleIncomingMidiMessage(nullptr, message);
 }
 
-juce::Result MidiManager::openInputPort(const juce::String& portName)
+void MidiManager::midiConnectionMessageReceived(const MidiConnectionPool::Connection&, const juce::MidiMessage& message)
 {
-    if (portName.isEmpty())
+    inputCallback->handleIncomingMidiMessage(nullptr, message);
+}
+
+MidiManager::OutputLink MidiManager::getOutputLink(MidiConnectionPool::State state) noexcept
+{
+    switch (state)
     {
-        closeInputPort();
-        return juce::Result::ok();
+        case MidiConnectionPool::State::connected:      return OutputLink::connected;
+        case MidiConnectionPool::State::reconnecting:   return OutputLink::holding;
+        case MidiConnectionPool::State::lost:           break;
     }
     
-    auto availablePorts = juce::MidiInput::getDevices();
-    int portIndex = availablePorts.indexOf(portName);
+    return OutputLink::discarding;
+}
+
+juce::Result MidiManager::connect(MidiConnectionPool::Direction direction, const juce::String& portName,
+                                  const juce::String& identifier)
+{
+    if (transport.load() != nullptr)
+        setTransport(nullptr);
     
-    if (portIndex < 0)
-    {
-        return juce::Result::fail("MIDI input port not found: " + portName);
-    }
+    // Never call into the pool with deviceLock held: pool callbacks take it
+    std::unique_ptr<MidiConnectionPool::Connection> connection;
+    auto result = connectionPool->open(direction, identifier, portName, *this, connection);
+    if (result.failed())
+        return result;
     
-    midiInput = juce::MidiInput::openDevice(portIndex, inputCallback.get());
-    if (midiInput == nullptr)
     {
-        return juce::Result::fail("Failed to open MIDI input port: " + portName);
+        const juce::ScopedLock sl(deviceLock);
+        
+        if (direction == MidiConnectionPool::Direction::output)
+        {
+            std::swap(outputConnection, connection);
+            outputLink = getOutputLink(outputConnection->getState());
+        }
+        else
+        {
+            std::swap(inputConnection, connection);
+        }
     }
     
-    midiInput->start();
-    currentInputPortName = portName;
+    // connection now holds the previous one, released outside the lock
     return juce::Result::ok();
 }
 
-void MidiManager::closeInputPort()
+void MidiManager::disconnect(MidiConnectionPool::Direction direction)
 {
-    if (midiInput != nullptr)
+    std::unique_ptr<MidiConnectionPool::Connection> previous;
+    
     {
-        midiInput->stop();
-        midiInput.reset();
+        const juce::ScopedLock sl(deviceLock);
+        
+        if (direction == MidiConnectionPool::Direction::output)
+        {
+            std::swap(outputConnection, previous);
+            outputLink = OutputLink::closed;
+        }
+        else
+        {
+            std::swap(inputConnection, previous);
+        }
     }
-    currentInputPortName = juce::String();
 }
-
@@ -2,40 +2,138 @@
 
 #include <JuceHeader.h>
 #include "../Model/DeviceModel.h"
+#include "MidiTrafficStatistics.h"
+#include "MidiWireModel.h"
+#include "MidiOutputLane.h"
+#include "MidiTelemetry.h"
+#include "MidiDeviceWatcher.h"
+#include "MidiConnectionPool.h"
+#include "MidiTransport.h"
 
 /**
  * Handles all MIDI I/O operations.
  * 
  * THREADING MODEL:
- * - Device management (port open/close) happens on message thread
+ * - Device management (port open/close) happens on the message thread, plus
+ *   the startup open (a PatchManager worker). Ports are opened through the
+ *   MidiConnectionPool outside deviceLock and swapped in under it, so
+ *   senders never wait for a device to open
  * - MIDI message sending uses a lock-free FIFO for audio thread processing
  * - User-initiated sends (from UI) queue messages to FIFO
  * - processBlock() on audio thread reads FIFO for sample-accurate timing
  * 
  * This ensures proper DAW integration and sample-accurate MIDI timing.
+ * 
+ * WIRE MODEL:
+ * - Every queued byte is accounted in a per-port MidiWireModel (31.25 kbaud by default)
+ * - processAudioThread() paces output so the DAW never receives more than the
+ *   cable can carry; events are placed at the sample where they reach the wire
+ * - Bulk messages (SysEx by default) are overtaken by realtime and interactive
+ *   messages at packet boundaries (a packet already on the wire completes)
+ * 
+ * PRIORITY LANES:
+ * - realtime: performance recall (PC + bank select); drained first, no per-block cap.
+ *   A bank select must go on this lane too, or a later PC would overtake it
+ * - interactive: UI edits (CC, parameter changes); capped per block
+ * - bulk: SysEx dumps and backups; only sent when both other lanes are empty
+ * Each lane has its own capacity, so a full bulk lane never rejects a recall.
+ * 
+ * DEVICES:
+ * - Port lists come from the process-wide MidiDeviceWatcher's cached list;
+ *   nothing here enumerates devices
+ * - Ports are shared through the process-wide MidiConnectionPool, keyed by
+ *   MidiDeviceInfo::identifier (names are the fallback), which reconnects
+ *   a port that disappears with exponential backoff
+ * - While the output port is reconnecting, sends are still accepted and
+ *   processAudioThread() holds the lanes instead of draining them; if it
+ *   isn't back within MidiConnectionPool::RECONNECT_WINDOW_MS the held
+ *   messages are discarded (counted as disconnect drops) and sends fail
+ *   until it returns
+ * 
+ * TRANSPORTS:
+ * - setTransport() replaces the ports with a virtual MidiTransport (loopback,
+ *   simulated synth): drained blocks go to it and what it delivers comes in
+ *   as input, so everything here can run headless (see MidiBlockDriver)
+ * 
+ * TELEMETRY:
+ * - MidiTelemetry times every message from enqueue to drain, every drain and
+ *   every learn-triggered recall, and counts queue-full rejections
+ * - getDiagnostics() reports those with lane depths, high-water marks and
+ *   port traffic as one JSON-ready var
+ * - A timer on the message thread refreshes the port traffic rates every
+ *   RATE_INTERVAL_MS, whether or not a monitor is open
  */
-class MidiManager : public juce::ChangeListener,
-                     public juce::ChangeBroadcaster
+class MidiManager : public juce::ChangeBroadcaster,
+                    private MidiDeviceWatcher::Listener,
+                    private MidiConnectionPool::Client,
+                    private MidiTransport::Receiver,
+                    private juce::Timer
 {
 public:
     MidiManager();
     ~MidiManager() override;
     
-    // Device management (message thread only)
-    juce::Result setOutputPort(const juce::String& portName);
-    juce::Result setInputPort(const juce::String& portName);
+    // Device management (thread-safe; see THREADING MODEL)
+    // The identifier is preferred when given; the name is the fallback (e.g. old configs)
+    juce::Result setOutputPort(const juce::String& portName, const juce::String& identifier = {});
+    juce::Result setInputPort(const juce::String& portName, const juce::String& identifier = {});
     void setMidiChannel(int channel); // 1-16
+    
+    // Cached device lists (thread-safe, no enumeration). Empty on the message thread
+    // until the watcher's first scan, which is announced with a change message.
     juce::StringArray getAvailableOutputPorts() const;
     juce::StringArray getAvailableInputPorts() const;
+    juce::Array<juce::MidiDeviceInfo> getAvailableOutputDevices() const;
+    juce::Array<juce::MidiDeviceInfo> getAvailableInputDevices() const;
+    juce::uint64 getDeviceListVersion() const; // Bumped whenever a device comes or goes
+    
+    /**
+     * Routes output and input through a virtual transport instead of ports
+     * (nullptr goes back to ports; selecting a port also detaches it). The
+     * transport must outlive its use: detach it only while no block is
+     * being processed.
+     */
+    void setTransport(MidiTransport* newTransport);
+    MidiTransport* getTransport() const noexcept { return transport.load(); }
+    
+    enum class Priority
+    {
+        realtime = 0,
+        interactive,
+        bulk
+    };
     
-    // MIDI operations (thread-safe, queues to FIFO)
-    juce::Result sendProgramChange(int programNumber); // 0-127
-    juce::Result sendControlChange(int controller, int value);
-    juce::Result sendBankSelect(int bankNumber, bool useMSB = true); // Bank 0-127, MSB (CC#0) or LSB (CC#32)
-    juce::Result sendSysEx(const juce::uint8* data, int dataSize); // Send SysEx message
+    static constexpr int NUM_PRIORITIES = 3;
+    
+    // MIDI operations (thread-safe, queues to the lane for the given priority)
+    juce::Result sendProgramChange(int programNumber, Priority priority = Priority::realtime); // 0-127
+    juce::Result sendControlChange(int controller, int value, Priority priority = Priority::interactive);
+    juce::Result sendBankSelect(int bankNumber, bool useMSB = true, // Bank 0-127, MSB (CC#0) or LSB (CC#32)
+                                Priority priority = Priority::realtime);  // Same lane as the PC it precedes
+    juce::Result sendSysEx(const juce::uint8* data, int dataSize, // Send SysEx message
+                           Priority priority = Priority::bulk);
+    juce::Result sendSysExDump(const juce::uint8* data, int dataSize); // Raw F0..F7 stream, one packet per message
     
     // Audio thread processing (called from processBlock)
-    void processAudioThread(juce::MidiBuffer& midiBuffer);
+    void prepareToPlay(double sampleRate);
+    void processAudioThread(juce::MidiBuffer& midiBuffer, int numSamples);
+    
+    // Wire model (thread-safe)
+    void setWireBaudRate(double bitsPerSecond); // 0 = unlimited (USB/virtual ports)
+    double getQueueDepthMs() const noexcept;
+    double estimateWireDelayMs(Priority priority) const noexcept;
+    const MidiWireModel& getOutputWireModel() const noexcept { return outputWire; }
+    
+    // Queue statistics per lane (thread-safe)
+    MidiOutputLane::Statistics getLaneStatistics(Priority priority) const noexcept;
+    void resetLaneHighWaterMarks() noexcept;
+    static const char* getPriorityName(Priority priority) noexcept;
+    
+    // Pipeline telemetry (thread-safe)
+    MidiTelemetry& getTelemetry() noexcept { return telemetry; }
+    const MidiTelemetry& getTelemetry() const noexcept { return telemetry; }
+    juce::var getDiagnostics() const; // Telemetry, lanes, wire and traffic counters
+    void resetDiagnostics() noexcept; // Telemetry and high-water marks
     
     // MIDI input callback
     class MidiInputCallback : public juce::MidiInputCallback
@@ -48,40 +146,124 @@ public:
     };
     
     // State (thread-safe reads)
-    bool isPortOpen() const noexcept;
+    bool isPortOpen() const noexcept;           // Connected; false while reconnecting
+    bool isPortReconnecting() const noexcept;   // Device gone, sends held for the reconnect window
     bool isInputPortOpen() const noexcept;
-    juce::String getCurrentPortName() const noexcept;
+    juce::String getCurrentPortName() const noexcept;   // Selected port, even while disconnected
+    juce::String getCurrentPortIdentifier() const noexcept;
     juce::String getCurrentInputPortName() const noexcept;
     int getCurrentChannel() const noexcept; // Returns 1-16
     
     // MIDI input monitoring
     std::function<void(const juce::MidiMessage&)> onMidiInput;
     
-    // JUCE ChangeListener (for MIDI device list changes)
-    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+    /**
+     * Sees input on the thread it arrives on (MIDI input, or the thread
+     * processing a transport's blocks), before onMidiInput. For headless
+     * code that waits for replies without a message loop.
+     */
+    class InputListener
+    {
+    public:
+        virtual ~InputListener() = default;
+        virtual void midiInputReceived(const juce::MidiMessage& message) = 0;
+    };
+    
+    // Thread-safe; removeInputListener() waits for a running callback
+    void addInputListener(InputListener* listener);
+    void removeInputListener(InputListener* listener);
+    
+    // MIDI output monitoring (called on the sending thread after a message is queued)
+    std::function<void(const juce::MidiMessage&)> onMidiOutput;
+    
+    /** Sees every queued message on the sending thread, after onMidiOutput (e.g. the MIDI monitor). */
+    class OutputListener
+    {
+    public:
+        virtual ~OutputListener() = default;
+        virtual void midiOutputQueued(const juce::MidiMessage& message) = 0;
+    };
+    
+    // Thread-safe; removeOutputListener() waits for a running callback
+    void addOutputListener(OutputListener* listener);
+    void removeOutputListener(OutputListener* listener);
+    
+    // Per-port traffic counters (input recorded on the MIDI thread, output on enqueue).
+    // Rates are refreshed on the message thread; read them there.
+    static constexpr int RATE_INTERVAL_MS = 500;
+    MidiTrafficStatistics& getInputStatistics() noexcept { return inputStatistics; }
+    MidiTrafficStatistics& getOutputStatistics() noexcept { return outputStatistics; }
     
 private:
-    void refreshPortList();
-    juce::Result openPort(const juce::String& portName);
-    void closePort();
+    juce::SharedResourcePointer<MidiDeviceWatcher> deviceWatcher;
+    
+    juce::SharedResourcePointer<MidiConnectionPool> connectionPool;
+    std::atomic<MidiTransport*> transport { nullptr };
+    
+    MidiDeviceWatcher::DeviceListPtr getDeviceList() const;
+    void midiDevicesChanged(const MidiDeviceWatcher::Diff& diff) override; // Watcher thread
     
-    // Thread-safe MIDI message queue
-    static constexpr int MIDI_FIFO_SIZE = 512;
-    juce::AbstractFifo midiFifo { MIDI_FIFO_SIZE };
-    juce::Array<juce::MidiMessage> midiMessageQueue;
-    juce::CriticalSection midiQueueLock;
+    // MidiConnectionPool::Client
+    void midiConnectionStateChanged(const MidiConnectionPool::Connection& connection,
+                                    MidiConnectionPool::State newState) override;
+    void midiConnectionMessageReceived(const MidiConnectionPool::Connection& connection,
+                                       const juce::MidiMessage& message) override;
+    
+    /** What the audio thread does with the lanes, given the output connection. */
+    enum class OutputLink
+    {
+        closed,         // No port selected: drain (sends are refused)
+        connected,      // Drain
+        holding,        // Reconnecting: keep everything queued
+        discarding      // Reconnect window over: drop what was held
+    };
+    
+    std::atomic<OutputLink> outputLink { OutputLink::closed };
+    
+    void midiTransportMessageReceived(const juce::MidiMessage& message) override;
+    static OutputLink getOutputLink(MidiConnectionPool::State state) noexcept;
+    
+    // Outgoing MIDI queue: one lane per priority
+    static constexpr int REALTIME_LANE_SIZE = 64;
+    static constexpr int INTERACTIVE_LANE_SIZE = 256;
+    static constexpr int BULK_LANE_SIZE = 1024;
+    static constexpr int MAX_INTERACTIVE_PER_BLOCK = 32;
+    
+    MidiOutputLane realtimeLane { "realtime", REALTIME_LANE_SIZE };
+    MidiOutputLane interactiveLane { "interactive", INTERACTIVE_LANE_SIZE };
+    MidiOutputLane bulkLane { "bulk", BULK_LANE_SIZE };
+    
+    MidiOutputLane& getLane(Priority priority) noexcept;
+    const MidiOutputLane& getLane(Priority priority) const noexcept;
+    juce::Result enqueueMessage(const juce::MidiMessage& message, Priority priority);
+    juce::Result enqueueMessages(const juce::Array<juce::MidiMessage>& messages, Priority priority); // All or none
+    int drainLane(MidiOutputLane& lane, bool isBulk, int maxMessages, juce::MidiBuffer& midiBuffer,
+                  juce::int64 blockStartTicks);
+    void discardLane(MidiOutputLane& lane, bool isBulk) noexcept;
+    
+    MidiWireModel outputWire;
+    MidiTelemetry telemetry;
+    std::atomic<double> audioSampleRate { 0.0 };
     
     // Device state (protected by critical section for port operations)
     juce::CriticalSection deviceLock;
-    juce::String currentPortName;
-    juce::String currentInputPortName;
     int midiChannel = 0; // 0-15 (channel 1-16)
-    std::unique_ptr<juce::MidiOutput> midiOutput;
-    std::unique_ptr<juce::MidiInput> midiInput;
+    std::unique_ptr<MidiConnectionPool::Connection> outputConnection;
+    std::unique_ptr<MidiConnectionPool::Connection> inputConnection;
     std::unique_ptr<MidiInputCallback> inputCallback;
     
-    juce::Result openInputPort(const juce::String& portName);
-    void closeInputPort();
+    // Opens through the pool without deviceLock, then swaps the connection in under it
+    juce::Result connect(MidiConnectionPool::Direction direction, const juce::String& portName,
+                         const juce::String& identifier);
+    void disconnect(MidiConnectionPool::Direction direction);
+    
+    void notifyMessageQueued(const juce::MidiMessage& message);
+    void timerCallback() override; // Traffic rates
+    
+    MidiTrafficStatistics inputStatistics;
+    MidiTrafficStatistics outputStatistics;
+    juce::ListenerList<InputListener, juce::Array<InputListener*, juce::CriticalSection>> inputListeners;
+    juce::ListenerList<OutputListener, juce::Array<OutputListener*, juce::CriticalSection>> outputListeners;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiManager)
 };
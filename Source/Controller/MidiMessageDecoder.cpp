@@ -0,0 +1,253 @@
+#include "MidiMessageDecoder.h"
+#include <cstdio>
+
+namespace
+{
+    using MessageType = MidiMessageDecoder::MessageType;
+    using Formatter = int (*)(const juce::uint8* data, int size, char* dest, int destSize);
+    
+    struct StatusEntry
+    {
+        MessageType type = MessageType::undefined;
+        Formatter formatter = nullptr;
+    };
+    
+    int channelOf(const juce::uint8* data) noexcept
+    {
+        return (data[0] & 0x0f) + 1;
+    }
+    
+    int dataByte(const juce::uint8* data, int size, int index) noexcept
+    {
+        return index < size ? (data[index] & 0x7f) : 0;
+    }
+    
+    int formatNoteOff(const juce::uint8* d, int size, char* dest, int destSize)
+    {
+        return std::snprintf(dest, (size_t)destSize, "NoteOff Ch%d Note%d", channelOf(d), dataByte(d, size, 1));
+    }
+    
+    int formatNoteOn(const juce::uint8* d, int size, char* dest, int destSize)
+    {
+        // Note-on with velocity 0 is a note-off by convention
+        if (dataByte(d, size, 2) == 0)
+            return formatNoteOff(d, size, dest, destSize);
+        
+        return std::snprintf(dest, (size_t)destSize, "NoteOn Ch%d Note%d Vel%d",
+                             channelOf(d), dataByte(d, size, 1), dataByte(d, size, 2));
+    }
+    
+    int formatPolyPressure(const juce::uint8* d, int size, char* dest, int destSize)
+    {
+        return std::snprintf(dest, (size_t)destSize, "PolyAT Ch%d Note%d=%d",
+                             channelOf(d), dataByte(d, size, 1), dataByte(d, size, 2));
+    }
+    
+    int formatController(const juce::uint8* d, int size, char* dest, int destSize)
+    {
+        return std::snprintf(dest, (size_t)destSize, "CC Ch%d #%d=%d",
+                             channelOf(d), dataByte(d, size, 1), dataByte(d, size, 2));
+    }
+    
+    int formatProgramChange(const juce::uint8* d, int size, char* dest, int destSize)
+    {
+        return std::snprintf(dest, (size_t)destSize, "PC Ch%d Prg%d", channelOf(d), dataByte(d, size, 1));
+    }
+    
+    int formatChannelPressure(const juce::uint8* d, int size, char* dest, int destSize)
+    {
+        return std::snprintf(dest, (size_t)destSize, "ChanAT Ch%d =%d", channelOf(d), dataByte(d, size, 1));
+    }
+    
+    int formatPitchBend(const juce::uint8* d, int size, char* dest, int destSize)
+    {
+        const int value = dataByte(d, size, 1) | (dataByte(d, size, 2) << 7);
+        return std::snprintf(dest, (size_t)destSize, "PitchBend Ch%d %+d", channelOf(d), value - 8192);
+    }
+    
+    int formatSysEx(const juce::uint8* d, int size, char* dest, int destSize)
+    {
+        // Manufacturer ID is the first data byte (or 0x00 + two bytes for extended IDs)
+        const int manufacturer = dataByte(d, size, 1);
+        return std::snprintf(dest, (size_t)destSize, "SysEx (%d bytes) Mfr 0x%02X", size, manufacturer);
+    }
+    
+    int formatTimeCode(const juce::uint8* d, int size, char* dest, int destSize)
+    {
+        const int value = dataByte(d, size, 1);
+        return std::snprintf(dest, (size_t)destSize, "MTC Quarter Frame %d:%d", value >> 4, value & 0x0f);
+    }
+    
+    int formatSongPosition(const juce::uint8* d, int size, char* dest, int destSize)
+    {
+        const int beats = dataByte(d, size, 1) | (dataByte(d, size, 2) << 7);
+        return std::snprintf(dest, (size_t)destSize, "Song Position %d", beats);
+    }
+    
+    int formatSongSelect(const juce::uint8* d, int size, char* dest, int destSize)
+    {
+        return std::snprintf(dest, (size_t)destSize, "Song Select %d", dataByte(d, size, 1));
+    }
+    
+    int formatUndefined(const juce::uint8* d, int size, char* dest, int destSize)
+    {
+        int written = std::snprintf(dest, (size_t)destSize, "Other (0x");
+        
+        for (int i = 0; i < size && written + 3 < destSize; ++i)
+            written += std::snprintf(dest + written, (size_t)(destSize - written), "%02X", d[i]);
+        
+        if (written + 1 < destSize)
+            written += std::snprintf(dest + written, (size_t)(destSize - written), ")");
+        
+        return written;
+    }
+    
+    template <MessageType Type>
+    int formatByName(const juce::uint8*, int, char* dest, int destSize)
+    {
+        return std::snprintf(dest, (size_t)destSize, "%s", MidiMessageDecoder::getTypeName(Type));
+    }
+    
+    struct StatusTable
+    {
+        StatusEntry entries[256];
+        
+        StatusTable()
+        {
+            // Data bytes (running status) are never valid as a status byte
+            for (auto& entry : entries)
+                entry = { MessageType::undefined, formatUndefined };
+            
+            const StatusEntry channelEntries[] =
+            {
+                { MessageType::noteOff,         formatNoteOff },
+                { MessageType::noteOn,          formatNoteOn },
+                { MessageType::polyPressure,    formatPolyPressure },
+                { MessageType::controller,      formatController },
+                { MessageType::programChange,   formatProgramChange },
+                { MessageType::channelPressure, formatChannelPressure },
+                { MessageType::pitchBend,       formatPitchBend }
+            };
+            
+            for (int group = 0; group < 7; ++group)
+                for (int channel = 0; channel < 16; ++channel)
+                    entries[0x80 + (group << 4) + channel] = channelEntries[group];
+            
+            entries[0xf0] = { MessageType::sysEx,           formatSysEx };
+            entries[0xf1] = { MessageType::timeCode,        formatTimeCode };
+            entries[0xf2] = { MessageType::songPosition,    formatSongPosition };
+            entries[0xf3] = { MessageType::songSelect,      formatSongSelect };
+            entries[0xf6] = { MessageType::tuneRequest,     formatByName<MessageType::tuneRequest> };
+            entries[0xf8] = { MessageType::clock,           formatByName<MessageType::clock> };
+            entries[0xfa] = { MessageType::start,           formatByName<MessageType::start> };
+            entries[0xfb] = { MessageType::continueMessage, formatByName<MessageType::continueMessage> };
+            entries[0xfc] = { MessageType::stop,            formatByName<MessageType::stop> };
+            entries[0xfe] = { MessageType::activeSensing,   formatByName<MessageType::activeSensing> };
+            entries[0xff] = { MessageType::reset,           formatByName<MessageType::reset> };
+        }
+    };
+    
+    const StatusTable& getStatusTable() noexcept
+    {
+        static const StatusTable table;
+        return table;
+    }
+    
+    const char* const typeNames[MidiMessageDecoder::NUM_TYPES] =
+    {
+        "NoteOff", "NoteOn", "PolyAT", "CC", "PC", "ChanAT", "PitchBend",
+        "SysEx", "MTC", "SongPos", "SongSel", "TuneReq",
+        "Clock", "Start", "Continue", "Stop", "ActiveSensing", "Reset", "Other"
+    };
+}
+
+bool MidiMessageDecoder::Filter::accepts(MessageType type, int channel, bool isOutgoing) const noexcept
+{
+    if (isOutgoing ? !showOutgoing : !showIncoming)
+        return false;
+    
+    if (!isTypeEnabled(type))
+        return false;
+    
+    if (channel > 0 && !isChannelEnabled(channel))
+        return false;
+    
+    return true;
+}
+
+void MidiMessageDecoder::Filter::setTypeEnabled(MessageType type, bool enabled) noexcept
+{
+    const auto bit = 1u << static_cast<int>(type);
+    typeMask = enabled ? (typeMask | bit) : (typeMask & ~bit);
+}
+
+bool MidiMessageDecoder::Filter::isTypeEnabled(MessageType type) const noexcept
+{
+    return (typeMask & (1u << static_cast<int>(type))) != 0;
+}
+
+void MidiMessageDecoder::Filter::setChannelEnabled(int channel, bool enabled) noexcept
+{
+    jassert(channel >= 1 && channel <= 16);
+    const auto bit = (juce::uint16)(1u << (juce::jlimit(1, 16, channel) - 1));
+    channelMask = enabled ? (juce::uint16)(channelMask | bit) : (juce::uint16)(channelMask & ~bit);
+}
+
+bool MidiMessageDecoder::Filter::isChannelEnabled(int channel) const noexcept
+{
+    if (channel < 1 || channel > 16)
+        return true;
+    
+    return (channelMask & (1u << (channel - 1))) != 0;
+}
+
+MidiMessageDecoder::MessageType MidiMessageDecoder::getType(juce::uint8 statusByte) noexcept
+{
+    return getStatusTable().entries[statusByte].type;
+}
+
+MidiMessageDecoder::MessageType MidiMessageDecoder::getType(const juce::MidiMessage& message) noexcept
+{
+    if (message.getRawDataSize() <= 0)
+        return MessageType::undefined;
+    
+    return getType(message.getRawData()[0]);
+}
+
+int MidiMessageDecoder::getChannel(const juce::MidiMessage& message) noexcept
+{
+    if (message.getRawDataSize() <= 0)
+        return 0;
+    
+    const auto status = message.getRawData()[0];
+    return isChannelMessage(getType(status)) ? (status & 0x0f) + 1 : 0;
+}
+
+const char* MidiMessageDecoder::getTypeName(MessageType type) noexcept
+{
+    const int index = static_cast<int>(type);
+    return (index >= 0 && index < NUM_TYPES) ? typeNames[index] : "Other";
+}
+
+bool MidiMessageDecoder::isChannelMessage(MessageType type) noexcept
+{
+    return static_cast<int>(type) <= static_cast<int>(MessageType::pitchBend);
+}
+
+int MidiMessageDecoder::formatDescription(const juce::MidiMessage& message, char* dest, int destSize) noexcept
+{
+    if (dest == nullptr || destSize <= 0)
+        return 0;
+    
+    const auto* data = message.getRawData();
+    const int size = message.getRawDataSize();
+    
+    if (size <= 0)
+    {
+        dest[0] = 0;
+        return 0;
+    }
+    
+    const int written = getStatusTable().entries[data[0]].formatter(data, size, dest, destSize);
+    return juce::jlimit(0, destSize - 1, written);
+}
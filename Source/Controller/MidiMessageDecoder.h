@@ -0,0 +1,84 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Table-driven MIDI message decoder.
+ * 
+ * Every status byte (0x00-0xFF) maps to one entry in a static table that
+ * holds the message type and the formatter for it. Classifying a message is
+ * a single table lookup, so filters and statistics can run on every event
+ * without formatting anything. Text is only produced for events that pass
+ * the filter, and is written into a caller-provided buffer (no allocation).
+ * 
+ * Thread-safe: the table is immutable after static initialisation.
+ */
+class MidiMessageDecoder
+{
+public:
+    enum class MessageType : juce::uint8
+    {
+        noteOff = 0,
+        noteOn,
+        polyPressure,
+        controller,
+        programChange,
+        channelPressure,
+        pitchBend,
+        sysEx,
+        timeCode,
+        songPosition,
+        songSelect,
+        tuneRequest,
+        clock,
+        start,
+        continueMessage,
+        stop,
+        activeSensing,
+        reset,
+        undefined,
+        numTypes
+    };
+    
+    static constexpr int NUM_TYPES = static_cast<int>(MessageType::numTypes);
+    static constexpr int MAX_DESCRIPTION_LENGTH = 96;
+    
+    /**
+     * Filter applied before formatting.
+     * 
+     * Masks are bit sets: bit n of typeMask is MessageType n,
+     * bit n of channelMask is MIDI channel n + 1. System messages
+     * (no channel) are only checked against typeMask.
+     */
+    struct Filter
+    {
+        juce::uint32 typeMask = 0xffffffffu;
+        juce::uint16 channelMask = 0xffffu;
+        bool showIncoming = true;
+        bool showOutgoing = true;
+        
+        bool accepts(MessageType type, int channel, bool isOutgoing) const noexcept;
+        
+        void setTypeEnabled(MessageType type, bool enabled) noexcept;
+        bool isTypeEnabled(MessageType type) const noexcept;
+        void setChannelEnabled(int channel, bool enabled) noexcept; // 1-16
+        bool isChannelEnabled(int channel) const noexcept;          // 1-16
+    };
+    
+    // Classification (O(1), no allocation)
+    static MessageType getType(juce::uint8 statusByte) noexcept;
+    static MessageType getType(const juce::MidiMessage& message) noexcept;
+    static int getChannel(const juce::MidiMessage& message) noexcept; // 1-16, 0 for system messages
+    static const char* getTypeName(MessageType type) noexcept;
+    static bool isChannelMessage(MessageType type) noexcept;
+    
+    /**
+     * Writes a human-readable description of the message into dest.
+     * 
+     * @return Number of characters written (excluding terminator)
+     */
+    static int formatDescription(const juce::MidiMessage& message, char* dest, int destSize) noexcept;
+    
+private:
+    MidiMessageDecoder() = delete;
+};
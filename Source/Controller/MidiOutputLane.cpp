@@ -0,0 +1,96 @@
+#include "MidiOutputLane.h"
+
+MidiOutputLane::MidiOutputLane(const juce::String& laneName, int capacity)
+    : name(laneName)
+    , fifo(capacity + 1) // AbstractFifo keeps one slot free
+{
+    messages.resize(capacity + 1);
+    enqueueTicks.calloc((size_t)capacity + 1);
+}
+
+bool MidiOutputLane::push(const juce::MidiMessage& message, juce::int64 ticks)
+{
+    const juce::ScopedLock sl(writeLock);
+    return write(&message, 1, ticks);
+}
+
+bool MidiOutputLane::pushAll(const juce::Array<juce::MidiMessage>& source, juce::int64 ticks)
+{
+    // The space check and the writes share the lock, so no other writer can take the room in between
+    const juce::ScopedLock sl(writeLock);
+    return write(source.begin(), source.size(), ticks);
+}
+
+bool MidiOutputLane::write(const juce::MidiMessage* source, int numMessages, juce::int64 ticks)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(numMessages, start1, size1, start2, size2);
+    
+    if (size1 + size2 < numMessages)
+    {
+        numDropped.fetch_add((juce::uint64)numMessages, std::memory_order_relaxed);
+        return false;
+    }
+    
+    // Consecutive ticks keep each message's trace flow apart
+    for (int i = 0; i < numMessages; ++i)
+    {
+        const int index = i < size1 ? start1 + i : start2 + (i - size1);
+        messages.getReference(index) = source[i];
+        enqueueTicks[index] = ticks + i;
+    }
+    
+    fifo.finishedWrite(numMessages);
+    
+    numEnqueued.fetch_add((juce::uint64)numMessages, std::memory_order_relaxed);
+    
+    // Only writers raise the mark, and they hold writeLock, so a plain compare is enough
+    const int depth = fifo.getNumReady();
+    if (depth > highWaterMark.load(std::memory_order_relaxed))
+        highWaterMark.store(depth, std::memory_order_relaxed);
+    
+    return true;
+}
+
+bool MidiOutputLane::hasFreeSpace(int numMessages) const noexcept
+{
+    return fifo.getFreeSpace() >= numMessages;
+}
+
+const juce::MidiMessage* MidiOutputLane::peek(juce::int64* enqueueTicksOut) const noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(1, start1, size1, start2, size2);
+    
+    if (size1 + size2 == 0)
+        return nullptr;
+    
+    const int index = size1 > 0 ? start1 : start2;
+    
+    if (enqueueTicksOut != nullptr)
+        *enqueueTicksOut = enqueueTicks[index];
+    
+    return &messages.getReference(index);
+}
+
+void MidiOutputLane::pop() noexcept
+{
+    jassert(!isEmpty());
+    fifo.finishedRead(1);
+}
+
+MidiOutputLane::Statistics MidiOutputLane::getStatistics() const noexcept
+{
+    Statistics stats;
+    stats.capacity = fifo.getTotalSize() - 1;
+    stats.numQueued = fifo.getNumReady();
+    stats.highWaterMark = highWaterMark.load(std::memory_order_relaxed);
+    stats.numEnqueued = numEnqueued.load(std::memory_order_relaxed);
+    stats.numDropped = numDropped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void MidiOutputLane::resetHighWaterMark() noexcept
+{
+    highWaterMark.store(fifo.getNumReady(), std::memory_order_relaxed);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * One priority lane of the outgoing MIDI queue.
+ * 
+ * A fixed-capacity FIFO of MidiMessages with its own statistics.
+ * Writers (any thread) are serialised by a lock so several threads can
+ * queue at once; the single reader (the audio thread) is lock-free and
+ * peeks at the front message so it can leave it queued when the wire is busy.
+ * Each message is stored with the high-resolution tick count at which it
+ * was queued, so the reader can measure how long it waited.
+ * 
+ * Storage is allocated once in the constructor.
+ */
+class MidiOutputLane
+{
+public:
+    struct Statistics
+    {
+        int capacity = 0;
+        int numQueued = 0;
+        int highWaterMark = 0;
+        juce::uint64 numEnqueued = 0;
+        juce::uint64 numDropped = 0;
+    };
+    
+    MidiOutputLane(const juce::String& name, int capacity);
+    ~MidiOutputLane() = default;
+    
+    // Producer side (any thread)
+    bool push(const juce::MidiMessage& message, juce::int64 enqueueTicks);
+    bool pushAll(const juce::Array<juce::MidiMessage>& messages, juce::int64 enqueueTicks); // All or none; i at ticks + i
+    bool hasFreeSpace(int numMessages) const noexcept;
+    
+    // Consumer side (audio thread only)
+    const juce::MidiMessage* peek(juce::int64* enqueueTicks = nullptr) const noexcept;
+    void pop() noexcept;
+    bool isEmpty() const noexcept { return fifo.getNumReady() == 0; }
+    
+    // Statistics (thread-safe)
+    const juce::String& getName() const noexcept { return name; }
+    Statistics getStatistics() const noexcept;
+    void resetHighWaterMark() noexcept;
+    
+private:
+    const juce::String name;
+    juce::AbstractFifo fifo;
+    juce::Array<juce::MidiMessage> messages;
+    juce::HeapBlock<juce::int64> enqueueTicks;  // Parallel to messages
+    juce::CriticalSection writeLock;
+    
+    std::atomic<int> highWaterMark { 0 };
+    std::atomic<juce::uint64> numEnqueued { 0 };
+    std::atomic<juce::uint64> numDropped { 0 };
+    
+    bool write(const juce::MidiMessage* source, int numMessages, juce::int64 ticks); // Caller holds writeLock
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiOutputLane)
+};
@@ -0,0 +1,46 @@
+#include "MidiTelemetry.h"
+
+void MidiTelemetry::recordEnqueueLatency(juce::int64 enqueueTicks, juce::int64 drainTicks) noexcept
+{
+    enqueueLatency.record(ticksToMicroseconds(drainTicks - enqueueTicks));
+}
+
+void MidiTelemetry::recordDrainTime(juce::int64 startTicks, juce::int64 endTicks) noexcept
+{
+    const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::jmax((juce::int64)0, endTicks - startTicks));
+    drainTime.record((juce::uint64)(seconds * 1.0e9));
+}
+
+void MidiTelemetry::recordLearnRecall() noexcept
+{
+    // Recalls not caused by an input message (UI, host) aren't learn recalls
+    if (dispatchReceivedTicks == 0)
+        return;
+    
+    learnRecallLatency.record(ticksToMicroseconds(juce::Time::getHighResolutionTicks() - dispatchReceivedTicks));
+}
+
+juce::var MidiTelemetry::toVar() const
+{
+    juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+    obj->setProperty("enqueueLatencyUs", enqueueLatency.toVar());
+    obj->setProperty("drainTimeNs", drainTime.toVar());
+    obj->setProperty("learnRecallLatencyUs", learnRecallLatency.toVar());
+    obj->setProperty("queueFullFailures", (juce::int64)getQueueFullFailures());
+    obj->setProperty("disconnectDrops", (juce::int64)getDisconnectDrops());
+    return juce::var(obj.get());
+}
+
+void MidiTelemetry::reset() noexcept
+{
+    enqueueLatency.reset();
+    drainTime.reset();
+    learnRecallLatency.reset();
+    queueFullFailures.store(0, std::memory_order_relaxed);
+    disconnectDrops.store(0, std::memory_order_relaxed);
+}
+
+juce::uint64 MidiTelemetry::ticksToMicroseconds(juce::int64 ticks) noexcept
+{
+    return (juce::uint64)(juce::Time::highResolutionTicksToSeconds(juce::jmax((juce::int64)0, ticks)) * 1.0e6);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "LogHistogram.h"
+
+/**
+ * Always-on timing and failure counters for the MIDI pipeline.
+ * 
+ * - enqueue latency: from a message entering an output lane to the
+ *   processBlock() that drains it (µs; excludes wire time)
+ * - drain time: duration of MidiManager::processAudioThread() (ns)
+ * - learn recall latency: from a MIDI input message arriving on the MIDI
+ *   thread to the recall it triggers being queued (µs)
+ * - queue full: sends rejected because an output lane was full
+ * - disconnect drops: messages held while the output port was reconnecting,
+ *   then discarded because it didn't come back in time
+ * 
+ * Recording is lock-free and costs a timestamp plus a LogHistogram::record()
+ * per event. Queue depth, high-water marks and input rates come from the
+ * lanes and MidiTrafficStatistics; MidiManager::getDiagnostics() combines
+ * them with these into one report.
+ */
+class MidiTelemetry
+{
+public:
+    MidiTelemetry() = default;
+    ~MidiTelemetry() = default;
+    
+    // Recording (lock-free, any thread)
+    void recordEnqueueLatency(juce::int64 enqueueTicks, juce::int64 drainTicks) noexcept;
+    void recordDrainTime(juce::int64 startTicks, juce::int64 endTicks) noexcept;
+    void recordQueueFull() noexcept { queueFullFailures.fetch_add(1, std::memory_order_relaxed); }
+    void recordDisconnectDrop() noexcept { disconnectDrops.fetch_add(1, std::memory_order_relaxed); }
+    
+    /**
+     * Learn recall timing (message thread only). MidiManager brackets the
+     * delivery of each input message with begin/endInputDispatch(); a recall
+     * queued in between is timed from when the message arrived.
+     */
+    void beginInputDispatch(juce::int64 receivedTicks) noexcept { dispatchReceivedTicks = receivedTicks; }
+    void endInputDispatch() noexcept { dispatchReceivedTicks = 0; }
+    void recordLearnRecall() noexcept;
+    
+    // Reading (thread-safe)
+    const LogHistogram& getEnqueueLatencyMicroseconds() const noexcept { return enqueueLatency; }
+    const LogHistogram& getDrainTimeNanoseconds() const noexcept { return drainTime; }
+    const LogHistogram& getLearnRecallLatencyMicroseconds() const noexcept { return learnRecallLatency; }
+    juce::uint64 getQueueFullFailures() const noexcept { return queueFullFailures.load(std::memory_order_relaxed); }
+    juce::uint64 getDisconnectDrops() const noexcept { return disconnectDrops.load(std::memory_order_relaxed); }
+    
+    juce::var toVar() const;
+    void reset() noexcept;
+    
+private:
+    LogHistogram enqueueLatency;
+    LogHistogram drainTime;
+    LogHistogram learnRecallLatency;
+    std::atomic<juce::uint64> queueFullFailures { 0 };
+    std::atomic<juce::uint64> disconnectDrops { 0 };
+    
+    juce::int64 dispatchReceivedTicks = 0; // Message thread only
+    
+    static juce::uint64 ticksToMicroseconds(juce::int64 ticks) noexcept;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiTelemetry)
+};
@@ -0,0 +1,119 @@
+#include "MidiTrafficStatistics.h"
+
+namespace
+{
+    // Exponential smoothing for the rate meters (per update)
+    constexpr double RATE_SMOOTHING = 0.5;
+}
+
+MidiTrafficStatistics::MidiTrafficStatistics()
+{
+    reset();
+}
+
+void MidiTrafficStatistics::recordMessage(const juce::MidiMessage& message) noexcept
+{
+    recordMessage(MidiMessageDecoder::getType(message),
+                  MidiMessageDecoder::getChannel(message),
+                  message.getRawDataSize());
+}
+
+void MidiTrafficStatistics::recordMessage(MidiMessageDecoder::MessageType type, int channel, int numBytes) noexcept
+{
+    totalMessages.fetch_add(1, std::memory_order_relaxed);
+    totalBytes.fetch_add((juce::uint64)juce::jmax(0, numBytes), std::memory_order_relaxed);
+    typeCounts[static_cast<int>(type)].fetch_add(1, std::memory_order_relaxed);
+    
+    if (channel >= 1 && channel <= 16)
+        channelCounts[channel - 1].fetch_add(1, std::memory_order_relaxed);
+}
+
+juce::uint64 MidiTrafficStatistics::getTotalMessages() const noexcept
+{
+    return totalMessages.load(std::memory_order_relaxed);
+}
+
+juce::uint64 MidiTrafficStatistics::getTotalBytes() const noexcept
+{
+    return totalBytes.load(std::memory_order_relaxed);
+}
+
+juce::uint64 MidiTrafficStatistics::getTypeCount(MidiMessageDecoder::MessageType type) const noexcept
+{
+    return typeCounts[static_cast<int>(type)].load(std::memory_order_relaxed);
+}
+
+juce::uint64 MidiTrafficStatistics::getChannelCount(int channel) const noexcept
+{
+    if (channel < 1 || channel > 16)
+        return 0;
+    
+    return channelCounts[channel - 1].load(std::memory_order_relaxed);
+}
+
+void MidiTrafficStatistics::updateRates(double nowSeconds)
+{
+    const auto messages = getTotalMessages();
+    const auto bytes = getTotalBytes();
+    
+    if (lastUpdateSeconds <= 0.0 || nowSeconds <= lastUpdateSeconds)
+    {
+        // First sample (or clock went backwards): establish a baseline only
+        lastUpdateSeconds = nowSeconds;
+        lastTotalMessages = messages;
+        lastTotalBytes = bytes;
+        for (int i = 0; i < MidiMessageDecoder::NUM_TYPES; ++i)
+            lastTypeCounts[i] = typeCounts[i].load(std::memory_order_relaxed);
+        return;
+    }
+    
+    const double elapsed = nowSeconds - lastUpdateSeconds;
+    auto smooth = [elapsed](double current, juce::uint64 delta)
+    {
+        const double instant = (double)delta / elapsed;
+        return current + (instant - current) * RATE_SMOOTHING;
+    };
+    
+    bytesPerSecond = smooth(bytesPerSecond, bytes - lastTotalBytes);
+    messagesPerSecond = smooth(messagesPerSecond, messages - lastTotalMessages);
+    
+    for (int i = 0; i < MidiMessageDecoder::NUM_TYPES; ++i)
+    {
+        const auto count = typeCounts[i].load(std::memory_order_relaxed);
+        typeRates[i] = smooth(typeRates[i], count - lastTypeCounts[i]);
+        lastTypeCounts[i] = count;
+    }
+    
+    lastUpdateSeconds = nowSeconds;
+    lastTotalMessages = messages;
+    lastTotalBytes = bytes;
+}
+
+double MidiTrafficStatistics::getTypeRate(MidiMessageDecoder::MessageType type) const noexcept
+{
+    return typeRates[static_cast<int>(type)];
+}
+
+void MidiTrafficStatistics::reset() noexcept
+{
+    totalMessages.store(0, std::memory_order_relaxed);
+    totalBytes.store(0, std::memory_order_relaxed);
+    
+    for (auto& count : typeCounts)
+        count.store(0, std::memory_order_relaxed);
+    
+    for (auto& count : channelCounts)
+        count.store(0, std::memory_order_relaxed);
+    
+    lastUpdateSeconds = 0.0;
+    lastTotalMessages = 0;
+    lastTotalBytes = 0;
+    bytesPerSecond = 0.0;
+    messagesPerSecond = 0.0;
+    
+    for (int i = 0; i < MidiMessageDecoder::NUM_TYPES; ++i)
+    {
+        lastTypeCounts[i] = 0;
+        typeRates[i] = 0.0;
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MidiMessageDecoder.h"
+
+/**
+ * Live message counters and throughput meters for one MIDI port.
+ * 
+ * recordMessage() is lock-free (relaxed atomics only) and may be called from
+ * the MIDI input thread or any sending thread. updateRates() derives
+ * messages/bytes per second from the counters and must be called
+ * periodically from a single thread (MidiManager's timer, on the message
+ * thread).
+ * 
+ * Bus load is reported against the DIN MIDI rate of 31.25 kbaud
+ * (10 bits per byte on the wire = 3125 bytes per second).
+ */
+class MidiTrafficStatistics
+{
+public:
+    static constexpr double DIN_BYTES_PER_SECOND = 31250.0 / 10.0;
+    
+    MidiTrafficStatistics();
+    ~MidiTrafficStatistics() = default;
+    
+    // Recording (lock-free, any thread)
+    void recordMessage(const juce::MidiMessage& message) noexcept;
+    void recordMessage(MidiMessageDecoder::MessageType type, int channel, int numBytes) noexcept;
+    
+    // Cumulative counters (thread-safe reads)
+    juce::uint64 getTotalMessages() const noexcept;
+    juce::uint64 getTotalBytes() const noexcept;
+    juce::uint64 getTypeCount(MidiMessageDecoder::MessageType type) const noexcept;
+    juce::uint64 getChannelCount(int channel) const noexcept; // 1-16
+    
+    // Rate meters (updateRates() and the rate getters from the same thread)
+    void updateRates(double nowSeconds);
+    double getBytesPerSecond() const noexcept { return bytesPerSecond; }
+    double getMessagesPerSecond() const noexcept { return messagesPerSecond; }
+    double getTypeRate(MidiMessageDecoder::MessageType type) const noexcept;
+    double getBusLoad() const noexcept { return bytesPerSecond / DIN_BYTES_PER_SECOND; } // 0-1 (can exceed 1 on USB)
+    
+    void reset() noexcept;
+    
+private:
+    std::atomic<juce::uint64> totalMessages { 0 };
+    std::atomic<juce::uint64> totalBytes { 0 };
+    std::atomic<juce::uint64> typeCounts[MidiMessageDecoder::NUM_TYPES];
+    std::atomic<juce::uint64> channelCounts[16];
+    
+    // Rate state (owned by the updateRates() thread)
+    double lastUpdateSeconds = 0.0;
+    juce::uint64 lastTotalMessages = 0;
+    juce::uint64 lastTotalBytes = 0;
+    juce::uint64 lastTypeCounts[MidiMessageDecoder::NUM_TYPES] = {};
+    double bytesPerSecond = 0.0;
+    double messagesPerSecond = 0.0;
+    double typeRates[MidiMessageDecoder::NUM_TYPES] = {};
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiTrafficStatistics)
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+/**
+ * A virtual MIDI endpoint that can stand in for MidiManager's hardware ports.
+ * 
+ * MidiManager::setTransport() attaches one: sends are accepted as if an
+ * output port were open, every block that processAudioThread() produces is
+ * handed to processBlock(), and whatever the transport delivers comes back
+ * through MidiManager's input path like messages from an input port.
+ * 
+ * Transports see time only as the stream of blocks (sample offsets within a
+ * block, blocks back to back), so a run driven by MidiBlockDriver in virtual
+ * time is reproducible and doesn't depend on the machine's speed.
+ * 
+ * THREADING:
+ * - processBlock() is called on the thread running processAudioThread()
+ * - deliver() may be called from processBlock() or any other thread
+ * - Virtual transports are for headless runs; unless a transport says
+ *   otherwise it may allocate, so don't attach one in a real-time host
+ */
+class MidiTransport
+{
+public:
+    /** Receives what the transport delivers (thread as for deliver()). */
+    class Receiver
+    {
+    public:
+        virtual ~Receiver() = default;
+        virtual void midiTransportMessageReceived(const juce::MidiMessage& message) = 0;
+    };
+    
+    MidiTransport() = default;
+    virtual ~MidiTransport() = default;
+    
+    virtual juce::String getName() const = 0;
+    
+    /** One block of output. Sample offsets are relative to the start of the block. */
+    virtual void processBlock(const juce::MidiBuffer& output, double sampleRate, int numSamples) = 0;
+    
+    void setReceiver(Receiver* newReceiver) noexcept { receiver.store(newReceiver); }
+    
+protected:
+    void deliver(const juce::MidiMessage& message)
+    {
+        if (auto* r = receiver.load())
+            r->midiTransportMessageReceived(message);
+    }
+    
+private:
+    std::atomic<Receiver*> receiver { nullptr };
+    
+    JUCE_DECLARE_NON_COPYABLE(MidiTransport)
+};
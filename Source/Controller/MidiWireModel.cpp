@@ -0,0 +1,113 @@
+#include "MidiWireModel.h"
+
+void MidiWireModel::setBaudRate(double bitsPerSecond) noexcept
+{
+    baudRate.store(juce::jmax(0.0, bitsPerSecond), std::memory_order_relaxed);
+}
+
+void MidiWireModel::reset() noexcept
+{
+    queuedBulkBytes.store(0, std::memory_order_relaxed);
+    queuedPriorityBytes.store(0, std::memory_order_relaxed);
+    backlogSeconds.store(0.0, std::memory_order_relaxed);
+    
+    blockStartSeconds = 0.0;
+    blockEndSeconds = 0.0;
+    wireFreeAtSeconds = 0.0;
+}
+
+double MidiWireModel::getSecondsForBytes(int numBytes) const noexcept
+{
+    return getSecondsForBytes(numBytes, getBaudRate());
+}
+
+double MidiWireModel::getSecondsForBytes(int numBytes, double bitsPerSecond) noexcept
+{
+    if (bitsPerSecond <= 0.0 || numBytes <= 0)
+        return 0.0;
+    
+    return (double)numBytes * BITS_PER_BYTE / bitsPerSecond;
+}
+
+void MidiWireModel::onBytesQueued(int numBytes, bool isBulk) noexcept
+{
+    auto& counter = isBulk ? queuedBulkBytes : queuedPriorityBytes;
+    counter.fetch_add(numBytes, std::memory_order_relaxed);
+}
+
+void MidiWireModel::onBytesDropped(int numBytes, bool isBulk) noexcept
+{
+    auto& counter = isBulk ? queuedBulkBytes : queuedPriorityBytes;
+    counter.fetch_sub(numBytes, std::memory_order_relaxed);
+}
+
+double MidiWireModel::estimateWireDelayMs(bool isBulk) const noexcept
+{
+    // Priority messages overtake queued bulk packets, but not the one already on the wire
+    auto bytesAhead = queuedPriorityBytes.load(std::memory_order_relaxed);
+    if (isBulk)
+        bytesAhead += queuedBulkBytes.load(std::memory_order_relaxed);
+    
+    const double seconds = backlogSeconds.load(std::memory_order_relaxed)
+                         + getSecondsForBytes((int)juce::jmin<juce::int64>(bytesAhead, std::numeric_limits<int>::max()));
+    return seconds * 1000.0;
+}
+
+double MidiWireModel::getQueueDepthMs() const noexcept
+{
+    return estimateWireDelayMs(true);
+}
+
+juce::int64 MidiWireModel::getQueuedBytes() const noexcept
+{
+    return queuedBulkBytes.load(std::memory_order_relaxed)
+         + queuedPriorityBytes.load(std::memory_order_relaxed);
+}
+
+void MidiWireModel::beginBlock(double sampleRate, int numSamples) noexcept
+{
+    currentSampleRate = sampleRate;
+    currentBlockSize = juce::jmax(0, numSamples);
+    
+    blockStartSeconds = blockEndSeconds;
+    blockEndSeconds = sampleRate > 0.0 ? blockStartSeconds + (double)currentBlockSize / sampleRate
+                                       : blockStartSeconds;
+}
+
+bool MidiWireModel::scheduleMessage(int numBytes, bool isBulk, int& sampleOffset) noexcept
+{
+    sampleOffset = 0;
+    
+    const double bitsPerSecond = getBaudRate();
+    
+    // Without a sample rate or a rate limit there is no timeline to model
+    if (currentSampleRate <= 0.0 || bitsPerSecond <= 0.0)
+    {
+        markTransmitted(numBytes, isBulk);
+        return true;
+    }
+    
+    const double startSeconds = juce::jmax(blockStartSeconds, wireFreeAtSeconds);
+    
+    if (startSeconds >= blockEndSeconds)
+        return false;
+    
+    sampleOffset = juce::jlimit(0, juce::jmax(0, currentBlockSize - 1),
+                                (int)((startSeconds - blockStartSeconds) * currentSampleRate));
+    
+    wireFreeAtSeconds = startSeconds + getSecondsForBytes(numBytes, bitsPerSecond);
+    
+    markTransmitted(numBytes, isBulk);
+    return true;
+}
+
+void MidiWireModel::markTransmitted(int numBytes, bool isBulk) noexcept
+{
+    onBytesDropped(numBytes, isBulk);
+    totalBytesTransmitted.fetch_add((juce::uint64)numBytes, std::memory_order_relaxed);
+}
+
+void MidiWireModel::endBlock() noexcept
+{
+    backlogSeconds.store(juce::jmax(0.0, wireFreeAtSeconds - blockEndSeconds), std::memory_order_relaxed);
+}
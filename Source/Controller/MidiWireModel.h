@@ -0,0 +1,91 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Byte accounting and serial-time model for one MIDI output port.
+ * 
+ * A DIN MIDI link runs at 31.25 kbaud with 10 bits per byte on the wire
+ * (start + 8 data + stop), so every byte takes 320 us. A 20 KB SysEx dump
+ * therefore occupies the cable for ~6.5 s, and anything queued behind it
+ * waits that long. This class tracks how many bytes are queued but not yet
+ * transmitted and when the wire will next be free, so MidiManager can pace
+ * output and report realistic queue latency.
+ * 
+ * THREADING:
+ * - onBytesQueued()/estimate*() may be called from any thread (atomics)
+ * - beginBlock()/scheduleMessage()/endBlock() are audio-thread only
+ * 
+ * A baud rate of 0 models an unlimited link (USB/virtual ports): messages
+ * are never delayed and the queue depth only reflects unsent messages.
+ */
+class MidiWireModel
+{
+public:
+    static constexpr double DIN_BAUD_RATE = 31250.0;
+    static constexpr double BITS_PER_BYTE = 10.0;
+    
+    MidiWireModel() = default;
+    ~MidiWireModel() = default;
+    
+    // Configuration
+    void setBaudRate(double bitsPerSecond) noexcept;
+    double getBaudRate() const noexcept { return baudRate.load(std::memory_order_relaxed); }
+    bool isRateLimited() const noexcept { return getBaudRate() > 0.0; }
+    void reset() noexcept;
+    
+    // Serial time for a number of bytes at the current baud rate
+    double getSecondsForBytes(int numBytes) const noexcept;
+    static double getSecondsForBytes(int numBytes, double bitsPerSecond) noexcept;
+    
+    // Producer side (any thread)
+    void onBytesQueued(int numBytes, bool isBulk) noexcept;
+    void onBytesDropped(int numBytes, bool isBulk) noexcept;
+    
+    /**
+     * Estimated time until a message queued now would start on the wire.
+     * 
+     * Non-bulk messages only wait for the packet currently on the wire and
+     * other non-bulk messages; bulk messages wait for the whole backlog.
+     */
+    double estimateWireDelayMs(bool isBulk) const noexcept;
+    
+    // Total queued + in-flight serial time, in milliseconds
+    double getQueueDepthMs() const noexcept;
+    juce::int64 getQueuedBytes() const noexcept;
+    juce::uint64 getTotalBytesTransmitted() const noexcept { return totalBytesTransmitted.load(std::memory_order_relaxed); }
+    
+    // Audio thread: per-block scheduling
+    void beginBlock(double sampleRate, int numSamples) noexcept;
+    
+    /**
+     * Tries to place a message of numBytes on the wire within this block.
+     * 
+     * @param sampleOffset Receives the sample position where transmission starts
+     * @return false if the wire is busy until after the end of this block
+     */
+    bool scheduleMessage(int numBytes, bool isBulk, int& sampleOffset) noexcept;
+    void endBlock() noexcept;
+    
+private:
+    std::atomic<double> baudRate { DIN_BAUD_RATE };
+    
+    // Bytes accepted into the queue but not yet placed on the wire
+    std::atomic<juce::int64> queuedBulkBytes { 0 };
+    std::atomic<juce::int64> queuedPriorityBytes { 0 };
+    
+    // Wire time still owed after the most recent block (audio thread writes)
+    std::atomic<double> backlogSeconds { 0.0 };
+    std::atomic<juce::uint64> totalBytesTransmitted { 0 };
+    
+    // Audio-thread timeline (seconds since reset)
+    double blockStartSeconds = 0.0;
+    double blockEndSeconds = 0.0;
+    double wireFreeAtSeconds = 0.0;
+    double currentSampleRate = 0.0;
+    int currentBlockSize = 0;
+    
+    void markTransmitted(int numBytes, bool isBulk) noexcept;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiWireModel)
+};
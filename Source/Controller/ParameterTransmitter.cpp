@@ -0,0 +1,249 @@
+#include "ParameterTransmitter.h"
+
+namespace
+{
+    constexpr double MIN_BURST_BYTES = 32.0;
+}
+
+ParameterTransmitter::ParameterTransmitter(MidiManager& manager)
+    : midiManager(manager)
+{
+}
+
+ParameterTransmitter::~ParameterTransmitter()
+{
+    stopTimer();
+}
+
+void ParameterTransmitter::setDevice(ParameterMap::Ptr newParameterMap, SysExProtocol::Ptr newProtocol, int newDeviceId)
+{
+    stopTimer();
+    
+    parameterMap = std::move(newParameterMap);
+    protocol = std::move(newProtocol);
+    deviceId = newDeviceId >= 0 ? newDeviceId : (protocol != nullptr ? protocol->getDefaultDeviceId() : 0);
+    
+    const size_t numParameters = parameterMap != nullptr ? (size_t)parameterMap->size() : 0;
+    pendingValues.assign(numParameters, 0);
+    sentValues.assign(numParameters, UNKNOWN_VALUE);
+    isPending.assign(numParameters, false);
+    pendingOrder.clear();
+    pendingOrder.reserve(numParameters);
+}
+
+void ParameterTransmitter::setTransmitWindowMs(int milliseconds)
+{
+    windowMs = juce::jlimit(1, 1000, milliseconds);
+    
+    if (isTimerRunning())
+        startTimer(windowMs);
+}
+
+void ParameterTransmitter::setMaxBytesPerSecond(int bytesPerSecond)
+{
+    maxBytesPerSecond = juce::jmax(0, bytesPerSecond);
+    availableBytes = juce::jmin(availableBytes, getBurstBytes());
+}
+
+void ParameterTransmitter::setParameter(int parameterIndex, int value)
+{
+    if (parameterMap == nullptr || parameterIndex < 0 || parameterIndex >= parameterMap->size())
+    {
+        jassertfalse;
+        return;
+    }
+    
+    const auto index = (size_t)parameterIndex;
+    value = parameterMap->getParameter(parameterIndex).clampValue(value);
+    ++statistics.editsReceived;
+    
+    if (isPending[index])
+    {
+        // Not sent yet: the newer value replaces it
+        ++statistics.editsCoalesced;
+        pendingValues[index] = value;
+        return;
+    }
+    
+    if (value == sentValues[index])
+        return;
+    
+    pendingValues[index] = value;
+    isPending[index] = true;
+    pendingOrder.push_back(parameterIndex);
+    
+    // Leading edge: a quiet transmitter sends at once, then waits a window before the next batch
+    if (!isTimerRunning())
+    {
+        transmitPending();
+        startTimer(windowMs);
+    }
+}
+
+bool ParameterTransmitter::setParameter(const juce::String& parameterId, int value)
+{
+    const int index = parameterMap != nullptr ? parameterMap->indexOf(parameterId) : -1;
+    if (index < 0)
+        return false;
+    
+    setParameter(index, value);
+    return true;
+}
+
+void ParameterTransmitter::invalidateSentValues()
+{
+    std::fill(sentValues.begin(), sentValues.end(), UNKNOWN_VALUE);
+}
+
+int ParameterTransmitter::getMessageBytes(const ParameterMap::Parameter& parameter) const noexcept
+{
+    switch (parameter.transport)
+    {
+        case ParameterMap::Transport::controlChange:
+            return 3;
+        
+        case ParameterMap::Transport::nrpn:
+            // CC 99, 98, 6 (and 38 for 14-bit values), without running status
+            return parameter.maxValue > 127 ? 12 : 9;
+        
+        case ParameterMap::Transport::sysEx:
+            if (protocol != nullptr)
+                if (const auto* format = protocol->getFormat(parameter.sysExMessage))
+                    return format->getEncodedSize(parameter.valueBytes) + 2; // F0/F7
+            return 0;
+    }
+    
+    return 0;
+}
+
+void ParameterTransmitter::timerCallback()
+{
+    if (pendingOrder.empty())
+    {
+        stopTimer();
+        return;
+    }
+    
+    transmitPending();
+}
+
+void ParameterTransmitter::transmitPending()
+{
+    refillBudget();
+    
+    size_t numDone = 0;
+    
+    for (; numDone < pendingOrder.size(); ++numDone)
+    {
+        const int parameterIndex = pendingOrder[numDone];
+        const auto index = (size_t)parameterIndex;
+        const int value = pendingValues[index];
+        
+        // Moved away and back within the window: the device already has this value
+        if (value == sentValues[index])
+        {
+            isPending[index] = false;
+            continue;
+        }
+        
+        const auto& parameter = parameterMap->getParameter(parameterIndex);
+        const int cost = getMessageBytes(parameter);
+        
+        // A message larger than the burst allowance waits for a full bucket, then goes into debt
+        if (maxBytesPerSecond > 0 && availableBytes < juce::jmin((double)cost, getBurstBytes()))
+        {
+            ++statistics.rateLimitedWindows;
+            break;
+        }
+        
+        auto result = transmit(parameter, value);
+        if (result.failed())
+        {
+            // Lane full or no protocol: keep it pending and try again next window
+            ++statistics.sendFailures;
+            juce::Logger::writeToLog("Parameter " + parameter.id + ": " + result.getErrorMessage());
+            break;
+        }
+        
+        if (maxBytesPerSecond > 0)
+            availableBytes -= cost;
+        
+        sentValues[index] = value;
+        isPending[index] = false;
+        ++statistics.messagesSent;
+        statistics.bytesSent += (juce::uint64)cost;
+    }
+    
+    pendingOrder.erase(pendingOrder.begin(), pendingOrder.begin() + (std::ptrdiff_t)numDone);
+}
+
+void ParameterTransmitter::refillBudget()
+{
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    
+    if (lastRefillMs <= 0.0)
+        availableBytes = getBurstBytes();
+    else
+        availableBytes = juce::jmin(getBurstBytes(), availableBytes + (now - lastRefillMs) * maxBytesPerSecond / 1000.0);
+    
+    lastRefillMs = now;
+}
+
+double ParameterTransmitter::getBurstBytes() const noexcept
+{
+    return juce::jmax(MIN_BURST_BYTES, maxBytesPerSecond * windowMs / 1000.0);
+}
+
+juce::Result ParameterTransmitter::transmit(const ParameterMap::Parameter& parameter, int value)
+{
+    constexpr auto priority = MidiManager::Priority::interactive;
+    
+    switch (parameter.transport)
+    {
+        case ParameterMap::Transport::controlChange:
+            return midiManager.sendControlChange(parameter.number, value, priority);
+        
+        case ParameterMap::Transport::nrpn:
+        {
+            const bool is14Bit = parameter.maxValue > 127;
+            const int numMessages = is14Bit ? 4 : 3;
+            
+            // All or nothing: half an NRPN would leave the device pointing at the wrong parameter
+            auto lane = midiManager.getLaneStatistics(priority);
+            if (lane.capacity - lane.numQueued < numMessages)
+                return juce::Result::fail("MIDI output queue full (interactive)");
+            
+            midiManager.sendControlChange(99, (parameter.number >> 7) & 0x7f, priority);
+            midiManager.sendControlChange(98, parameter.number & 0x7f, priority);
+            
+            if (is14Bit)
+            {
+                midiManager.sendControlChange(6, (value >> 7) & 0x7f, priority);
+                return midiManager.sendControlChange(38, value & 0x7f, priority);
+            }
+            
+            return midiManager.sendControlChange(6, value & 0x7f, priority);
+        }
+        
+        case ParameterMap::Transport::sysEx:
+        {
+            const auto* format = protocol != nullptr ? protocol->getFormat(parameter.sysExMessage) : nullptr;
+            if (format == nullptr)
+                return juce::Result::fail("No SysEx message '" + parameter.sysExMessage + "' in the device protocol");
+            
+            juce::uint8 data[4];
+            for (int i = 0; i < parameter.valueBytes; ++i)
+                data[i] = (juce::uint8)((value >> (7 * (parameter.valueBytes - 1 - i))) & 0x7f);
+            
+            SysExMessageFormat::Fields fields;
+            fields.deviceId = deviceId;
+            fields.address = parameter.address;
+            format->encodeInto(sysExScratch, fields, data, parameter.valueBytes);
+            
+            return midiManager.sendSysEx(static_cast<const juce::uint8*>(sysExScratch.getData()),
+                                         (int)sysExScratch.getSize(), priority);
+        }
+    }
+    
+    return juce::Result::fail("Unknown parameter transport");
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "../Model/ParameterMap.h"
+#include "../Model/SysExProtocol.h"
+#include "MidiManager.h"
+#include <vector>
+
+/**
+ * Turns parameter edits into CC, NRPN or SysEx messages without flooding the port.
+ * 
+ * Edits are coalesced: within one transmit window only the latest value of
+ * each parameter is sent, so a fast knob sweep produces one message per
+ * parameter per window rather than one per mouse event. The first edit
+ * after a quiet period goes out immediately.
+ * 
+ * Output is also capped per device with a byte budget (token bucket). When
+ * the budget runs out, remaining parameters stay pending with their latest
+ * value and go out in later windows, in the order they were first edited.
+ * 
+ * THREADING:
+ * - Message thread only; messages go out through MidiManager's interactive lane
+ */
+class ParameterTransmitter : private juce::Timer
+{
+public:
+    struct Statistics
+    {
+        juce::uint64 editsReceived = 0;
+        juce::uint64 editsCoalesced = 0;    // Overwritten before they were sent
+        juce::uint64 messagesSent = 0;
+        juce::uint64 bytesSent = 0;
+        juce::uint64 rateLimitedWindows = 0;
+        juce::uint64 sendFailures = 0;
+    };
+    
+    static constexpr int DEFAULT_WINDOW_MS = 20;
+    static constexpr int DEFAULT_MAX_BYTES_PER_SECOND = 1000; // About a third of a DIN link
+    
+    explicit ParameterTransmitter(MidiManager& midiManager);
+    ~ParameterTransmitter() override;
+    
+    // Device configuration (clears pending edits)
+    void setDevice(ParameterMap::Ptr parameterMap, SysExProtocol::Ptr protocol,
+                   int deviceId = -1); // SysEx device ID; -1: the protocol's default
+    ParameterMap::Ptr getParameterMap() const noexcept { return parameterMap; }
+    
+    void setTransmitWindowMs(int milliseconds);
+    void setMaxBytesPerSecond(int bytesPerSecond); // 0 = no cap
+    int getTransmitWindowMs() const noexcept { return windowMs; }
+    int getMaxBytesPerSecond() const noexcept { return maxBytesPerSecond; }
+    
+    // Edits
+    void setParameter(int parameterIndex, int value);
+    bool setParameter(const juce::String& parameterId, int value);
+    
+    /** Forgets what was last sent, e.g. after a program change loaded new values on the device. */
+    void invalidateSentValues();
+    
+    int getNumPending() const noexcept { return (int)pendingOrder.size(); }
+    const Statistics& getStatistics() const noexcept { return statistics; }
+    
+    // Bytes on the wire for one update of a parameter
+    int getMessageBytes(const ParameterMap::Parameter& parameter) const noexcept;
+    
+private:
+    static constexpr int UNKNOWN_VALUE = -1;
+    
+    MidiManager& midiManager;
+    ParameterMap::Ptr parameterMap;
+    SysExProtocol::Ptr protocol;
+    int deviceId = 0;
+    
+    // Per parameter index
+    std::vector<int> pendingValues;
+    std::vector<int> sentValues;
+    std::vector<bool> isPending;
+    std::vector<int> pendingOrder;
+    
+    juce::MemoryBlock sysExScratch;
+    
+    int windowMs = DEFAULT_WINDOW_MS;
+    int maxBytesPerSecond = DEFAULT_MAX_BYTES_PER_SECOND;
+    double availableBytes = 0.0;
+    double lastRefillMs = 0.0;
+    
+    Statistics statistics;
+    
+    void timerCallback() override;
+    void transmitPending();
+    void refillBudget();
+    double getBurstBytes() const noexcept;
+    juce::Result transmit(const ParameterMap::Parameter& parameter, int value);
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterTransmitter)
+};
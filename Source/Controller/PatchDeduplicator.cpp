@@ -0,0 +1,214 @@
+#include "PatchDeduplicator.h"
+
+PatchDeduplicator::PatchDeduplicator()
+    : slotHashes((size_t)PatchBank::BANK_SIZE)
+    , dirty((size_t)PatchBank::BANK_SIZE, true)
+{
+}
+
+PatchDeduplicator::~PatchDeduplicator()
+{
+    if (threadPool != nullptr)
+        threadPool->removeAllJobs(true, 1000);
+}
+
+void PatchDeduplicator::setNonSoundRanges(const juce::Array<juce::Range<int>>& ranges)
+{
+    if (ranges == nonSoundRanges)
+        return;
+    
+    nonSoundRanges = ranges;
+    markAllDirty();
+}
+
+void PatchDeduplicator::markDirty(int slotIndex)
+{
+    if (slotIndex >= 0 && slotIndex < (int)dirty.size())
+    {
+        dirty[(size_t)slotIndex] = true;
+        anyDirty = true;
+    }
+}
+
+void PatchDeduplicator::markAllDirty()
+{
+    std::fill(dirty.begin(), dirty.end(), true);
+    anyDirty = true;
+}
+
+void PatchDeduplicator::update(const PatchBank& bank)
+{
+    if (!anyDirty)
+        return;
+    
+    juce::Array<int> slots;
+    for (size_t i = 0; i < dirty.size(); ++i)
+        if (dirty[i])
+            slots.add((int)i);
+    
+    std::vector<PatchHash> results((size_t)slots.size());
+    hashSlots(bank, slots, results.data());
+    
+    for (int i = 0; i < slots.size(); ++i)
+    {
+        setSlotHash(slots[i], results[(size_t)i]);
+        dirty[(size_t)slots[i]] = false;
+    }
+    
+    anyDirty = false;
+}
+
+PatchHash PatchDeduplicator::getHash(int slotIndex) const noexcept
+{
+    if (slotIndex < 0 || slotIndex >= (int)slotHashes.size())
+        return {};
+    
+    return slotHashes[(size_t)slotIndex];
+}
+
+juce::Array<PatchDeduplicator::DuplicateGroup> PatchDeduplicator::getDuplicateGroups() const
+{
+    jassert(!anyDirty); // Call update() first
+    
+    juce::Array<DuplicateGroup> groups;
+    
+    for (const auto& entry : index)
+    {
+        if (entry.second.size() < 2)
+            continue;
+        
+        DuplicateGroup group;
+        group.hash = entry.first;
+        group.slots = entry.second;
+        group.slots.sort();
+        groups.add(group);
+    }
+    
+    // Stable report order: by first slot
+    std::sort(groups.begin(), groups.end(), [](const DuplicateGroup& a, const DuplicateGroup& b)
+    {
+        return a.slots.getFirst() < b.slots.getFirst();
+    });
+    
+    return groups;
+}
+
+PatchDeduplicator::MergeReport PatchDeduplicator::planMerge(const PatchBank& bank,
+                                                            const juce::Array<DuplicateGroup>& groups,
+                                                            juce::Array<int>& slots,
+                                                            juce::Array<PatchData>& newPatches)
+{
+    MergeReport report;
+    slots.clear();
+    newPatches.clear();
+    
+    for (const auto& group : groups)
+    {
+        if (group.slots.size() < 2)
+            continue;
+        
+        int keeperSlot = group.slots.getFirst();
+        for (int slot : group.slots)
+        {
+            if (bank.getPatch(slot).isFavorite())
+            {
+                keeperSlot = slot;
+                break;
+            }
+        }
+        
+        auto keeper = bank.getPatch(keeperSlot);
+        
+        for (int slot : group.slots)
+        {
+            if (slot == keeperSlot)
+                continue;
+            
+            const auto& duplicate = bank.getPatch(slot);
+            for (const auto& tag : duplicate.getTags())
+                keeper.addTag(tag);
+            
+            if (duplicate.isFavorite())
+                keeper.setFavorite(true);
+            
+            // Same placeholder clearPatchRange() produces
+            PatchData placeholder(slot, "Patch " + juce::String(slot + 1).paddedLeft('0', 3), duplicate.getDeviceID());
+            report.bytesReclaimed += (juce::int64)duplicate.getPatchDump().getSize();
+            ++report.patchesRemoved;
+            
+            slots.add(slot);
+            newPatches.add(placeholder);
+        }
+        
+        slots.add(keeperSlot);
+        newPatches.add(keeper);
+        ++report.groupsMerged;
+    }
+    
+    return report;
+}
+
+void PatchDeduplicator::hashSlots(const PatchBank& bank, const juce::Array<int>& slots, PatchHash* results)
+{
+    const int numSlots = slots.size();
+    const int numJobs = juce::jmin(juce::SystemStats::getNumCpus(), numSlots / MIN_SLOTS_PER_JOB);
+    
+    if (numJobs <= 1)
+    {
+        juce::MemoryBlock scratch;
+        for (int i = 0; i < numSlots; ++i)
+            results[i] = PatchHasher::hashPatch(bank.getPatch(slots[i]), nonSoundRanges, scratch);
+        return;
+    }
+    
+    if (threadPool == nullptr)
+        threadPool = std::make_unique<juce::ThreadPool>(juce::SystemStats::getNumCpus());
+    
+    // The bank is only read, and this thread waits below, so it can't change under the jobs
+    std::atomic<int> remaining { numJobs };
+    juce::WaitableEvent finished;
+    const int slotsPerJob = (numSlots + numJobs - 1) / numJobs;
+    
+    for (int job = 0; job < numJobs; ++job)
+    {
+        const int begin = job * slotsPerJob;
+        const int end = juce::jmin(numSlots, begin + slotsPerJob);
+        
+        threadPool->addJob([&, begin, end]
+        {
+            juce::MemoryBlock scratch;
+            for (int i = begin; i < end; ++i)
+                results[i] = PatchHasher::hashPatch(bank.getPatch(slots[i]), nonSoundRanges, scratch);
+            
+            if (--remaining == 0)
+                finished.signal();
+            
+            return juce::ThreadPoolJob::jobHasFinished;
+        });
+    }
+    
+    finished.wait();
+}
+
+void PatchDeduplicator::setSlotHash(int slotIndex, const PatchHash& hash)
+{
+    auto& current = slotHashes[(size_t)slotIndex];
+    if (current == hash && !current.isEmpty())
+        return;
+    
+    if (!current.isEmpty())
+    {
+        auto it = index.find(current);
+        if (it != index.end())
+        {
+            it->second.removeFirstMatchingValue(slotIndex);
+            if (it->second.isEmpty())
+                index.erase(it);
+        }
+    }
+    
+    current = hash;
+    
+    if (!hash.isEmpty())
+        index[hash].addIfNotAlreadyThere(slotIndex);
+}
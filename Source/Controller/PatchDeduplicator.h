@@ -0,0 +1,85 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "../Model/PatchBank.h"
+#include "PatchHasher.h"
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Content-addressed duplicate detection across the library.
+ * 
+ * Keeps one PatchHash per slot and an index from hash to the slots that
+ * share it. Slots are re-hashed lazily: callers mark slots dirty when their
+ * sound data may have changed (copy, import, parameter edit, undo) and the
+ * next update() re-hashes only those. Large updates are split across a
+ * ThreadPool with one job per core; each job writes its own result range,
+ * so no locking is needed.
+ * 
+ * Placeholder slots (no dump, no edited parameters) are never duplicates.
+ * 
+ * THREADING:
+ * - Message thread only; update() blocks until the worker jobs finish
+ */
+class PatchDeduplicator
+{
+public:
+    struct DuplicateGroup
+    {
+        PatchHash hash;
+        juce::Array<int> slots; // Ascending
+    };
+    
+    struct MergeReport
+    {
+        int groupsMerged = 0;
+        int patchesRemoved = 0;
+        juce::int64 bytesReclaimed = 0;  // Dump bytes freed in the removed slots
+    };
+    
+    // Fewer dirty slots than this are hashed on the calling thread
+    static constexpr int MIN_SLOTS_PER_JOB = 32;
+    
+    PatchDeduplicator();
+    ~PatchDeduplicator();
+    
+    // Canonical form (from the device template's SysExProtocol)
+    void setNonSoundRanges(const juce::Array<juce::Range<int>>& ranges);
+    
+    // Incremental updates
+    void markDirty(int slotIndex);
+    void markAllDirty();
+    void update(const PatchBank& bank);
+    
+    // Queries (update() first)
+    PatchHash getHash(int slotIndex) const noexcept;
+    juce::Array<DuplicateGroup> getDuplicateGroups() const;
+    
+    /**
+     * Plans merging every duplicate group into one patch.
+     * 
+     * The keeper is the group's first favorite, else its lowest slot. It gets
+     * the union of the group's tags and is a favorite if any member was. The
+     * other members are reset to empty placeholders.
+     * 
+     * @param slots       Receives the slots that change
+     * @param newPatches  Receives their new contents (same order as slots)
+     */
+    static MergeReport planMerge(const PatchBank& bank,
+                                 const juce::Array<DuplicateGroup>& groups,
+                                 juce::Array<int>& slots,
+                                 juce::Array<PatchData>& newPatches);
+    
+private:
+    std::vector<PatchHash> slotHashes;
+    std::vector<bool> dirty;
+    bool anyDirty = true;
+    std::unordered_map<PatchHash, juce::Array<int>, PatchHash::Hasher> index;
+    juce::Array<juce::Range<int>> nonSoundRanges;
+    std::unique_ptr<juce::ThreadPool> threadPool;
+    
+    void hashSlots(const PatchBank& bank, const juce::Array<int>& slots, PatchHash* results);
+    void setSlotHash(int slotIndex, const PatchHash& hash);
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PatchDeduplicator)
+};
@@ -0,0 +1,246 @@
+#include "PatchDelta.h"
+
+namespace
+{
+    // The strings themselves are shared with the patch; only the array is the delta's own
+    juce::StringArray trimmed(const juce::StringArray& strings)
+    {
+        auto result = strings;
+        result.minimiseStorageOverheads();
+        return result;
+    }
+    
+    // Reference count + allocated size header, then the UTF-8 text and terminator
+    size_t stringBytes(const juce::String& s) noexcept
+    {
+        return s.isEmpty() ? 0 : sizeof(int) + sizeof(size_t) + s.getNumBytesAsUTF8() + 1;
+    }
+    
+    size_t stringArrayBytes(const juce::StringArray& strings) noexcept
+    {
+        // Deltas trim their arrays (see trimmed()), so size() is the allocation
+        size_t bytes = (size_t)strings.size() * sizeof(juce::String);
+        for (const auto& s : strings)
+            bytes += stringBytes(s);
+        return bytes;
+    }
+    
+    // make_shared keeps the control block and the MemoryBlock in one allocation
+    size_t dumpBytes(const std::shared_ptr<const juce::MemoryBlock>& dump) noexcept
+    {
+        return dump == nullptr ? 0 : 2 * sizeof(void*) + sizeof(juce::MemoryBlock) + dump->getSize();
+    }
+    
+    bool sameDump(const std::shared_ptr<const juce::MemoryBlock>& a,
+                  const std::shared_ptr<const juce::MemoryBlock>& b) noexcept
+    {
+        if (a == b)
+            return true;
+        
+        return a != nullptr && b != nullptr && *a == *b;
+    }
+}
+
+PatchDelta PatchDelta::between(const PatchData& before, const PatchData& after)
+{
+    PatchDelta delta;
+    
+    if (before.getPatchName() != after.getPatchName())
+    {
+        delta.changedFields |= nameField;
+        delta.nameBefore = before.getPatchName();
+        delta.nameAfter = after.getPatchName();
+    }
+    
+    if (before.isFavorite() != after.isFavorite())
+    {
+        delta.changedFields |= favoriteField;
+        delta.favoriteBefore = before.isFavorite();
+        delta.favoriteAfter = after.isFavorite();
+    }
+    
+    if (before.getDeviceID() != after.getDeviceID())
+    {
+        delta.changedFields |= deviceField;
+        delta.deviceBefore = before.getDeviceID();
+        delta.deviceAfter = after.getDeviceID();
+    }
+    
+    if (before.getTags() != after.getTags())
+    {
+        delta.changedFields |= tagsField;
+        delta.tagsBefore = trimmed(before.getTags());
+        delta.tagsAfter = trimmed(after.getTags());
+    }
+    
+    if (!sameDump(before.getSharedPatchDump(), after.getSharedPatchDump()))
+    {
+        delta.changedFields |= dumpField;
+        delta.dumpBefore = before.getSharedPatchDump();
+        delta.dumpAfter = after.getSharedPatchDump();
+    }
+    
+    const auto& valuesBefore = before.getParameterValues();
+    const auto& valuesAfter = after.getParameterValues();
+    
+    for (const auto& value : valuesBefore)
+    {
+        auto* newValue = valuesAfter.getVarPointer(value.name);
+        if (newValue == nullptr || *newValue != value.value)
+            delta.parameters.add({ value.name, value.value, newValue != nullptr ? *newValue : juce::var() });
+    }
+    
+    for (const auto& value : valuesAfter)
+        if (!valuesBefore.contains(value.name))
+            delta.parameters.add({ value.name, juce::var(), value.value });
+    
+    delta.parameters.minimiseStorageOverheads();
+    return delta;
+}
+
+bool PatchDelta::isSame(const PatchData& a, const PatchData& b)
+{
+    return a.getPatchName() == b.getPatchName()
+        && a.isFavorite() == b.isFavorite()
+        && a.getDeviceID() == b.getDeviceID()
+        && a.getTags() == b.getTags()
+        && sameDump(a.getSharedPatchDump(), b.getSharedPatchDump())
+        && a.getParameterValues() == b.getParameterValues();
+}
+
+void PatchDelta::applyTo(PatchData& patch, bool forward) const
+{
+    // Each field moves only from the value this delta left it at
+    if ((changedFields & nameField) != 0 && patch.getPatchName() == (forward ? nameBefore : nameAfter))
+        patch.setPatchName(forward ? nameAfter : nameBefore);
+    
+    if ((changedFields & favoriteField) != 0 && patch.isFavorite() == (forward ? favoriteBefore : favoriteAfter))
+        patch.setFavorite(forward ? favoriteAfter : favoriteBefore);
+    
+    if ((changedFields & deviceField) != 0 && patch.getDeviceID() == (forward ? deviceBefore : deviceAfter))
+        patch.setDeviceID(forward ? deviceAfter : deviceBefore);
+    
+    if ((changedFields & tagsField) != 0 && patch.getTags() == (forward ? tagsBefore : tagsAfter))
+        patch.setTags(forward ? tagsAfter : tagsBefore);
+    
+    if ((changedFields & dumpField) != 0 && sameDump(patch.getSharedPatchDump(), forward ? dumpBefore : dumpAfter))
+        patch.setSharedPatchDump(forward ? dumpAfter : dumpBefore);
+    
+    for (const auto& change : parameters)
+    {
+        const auto* current = patch.getParameterValues().getVarPointer(change.id);
+        const auto& from = forward ? change.before : change.after;
+        const auto& value = forward ? change.after : change.before;
+        
+        if (from.isVoid() ? current != nullptr : (current == nullptr || *current != from))
+            continue;
+        
+        if (value.isVoid())
+            patch.removeParameterValue(change.id.toString());
+        else
+            patch.setParameterValue(change.id.toString(), (int)value);
+    }
+}
+
+void PatchDelta::mergeWith(const PatchDelta& later)
+{
+    // Fields this delta didn't touch take their before values from the later delta
+    const auto newFields = later.changedFields & ~changedFields;
+    
+    if ((later.changedFields & nameField) != 0)
+    {
+        if ((newFields & nameField) != 0)
+            nameBefore = later.nameBefore;
+        nameAfter = later.nameAfter;
+    }
+    
+    if ((later.changedFields & favoriteField) != 0)
+    {
+        if ((newFields & favoriteField) != 0)
+            favoriteBefore = later.favoriteBefore;
+        favoriteAfter = later.favoriteAfter;
+    }
+    
+    if ((later.changedFields & deviceField) != 0)
+    {
+        if ((newFields & deviceField) != 0)
+            deviceBefore = later.deviceBefore;
+        deviceAfter = later.deviceAfter;
+    }
+    
+    if ((later.changedFields & tagsField) != 0)
+    {
+        if ((newFields & tagsField) != 0)
+            tagsBefore = later.tagsBefore;
+        tagsAfter = later.tagsAfter;
+    }
+    
+    if ((later.changedFields & dumpField) != 0)
+    {
+        if ((newFields & dumpField) != 0)
+            dumpBefore = later.dumpBefore;
+        dumpAfter = later.dumpAfter;
+    }
+    
+    changedFields |= later.changedFields;
+    
+    for (const auto& change : later.parameters)
+    {
+        auto existing = std::find_if(parameters.begin(), parameters.end(),
+                                     [&change](const ParameterChange& c) { return c.id == change.id; });
+        
+        if (existing != parameters.end())
+            existing->after = change.after;
+        else
+            parameters.add(change);
+    }
+    
+    dropUnchangedFields();
+}
+
+void PatchDelta::dropUnchangedFields()
+{
+    if (nameBefore == nameAfter)
+    {
+        changedFields &= ~nameField;
+        nameBefore = nameAfter = {};
+    }
+    
+    if (favoriteBefore == favoriteAfter)
+        changedFields &= ~favoriteField;
+    
+    if (deviceBefore == deviceAfter)
+    {
+        changedFields &= ~deviceField;
+        deviceBefore = deviceAfter = {};
+    }
+    
+    if (tagsBefore == tagsAfter)
+    {
+        changedFields &= ~tagsField;
+        tagsBefore.clear();
+        tagsAfter.clear();
+    }
+    
+    if (sameDump(dumpBefore, dumpAfter))
+    {
+        changedFields &= ~dumpField;
+        dumpBefore = dumpAfter = nullptr;
+    }
+    
+    parameters.removeIf([](const ParameterChange& c) { return c.before.equalsWithSameType(c.after); });
+    parameters.minimiseStorageOverheads();
+}
+
+size_t PatchDelta::getSizeInBytes() const noexcept
+{
+    auto bytes = sizeof(PatchDelta)
+               + stringBytes(nameBefore) + stringBytes(nameAfter)
+               + stringArrayBytes(tagsBefore) + stringArrayBytes(tagsAfter)
+               + dumpBytes(dumpBefore) + dumpBytes(dumpAfter);
+    
+    // Parameter values are ints, which a var holds inline; the array is kept trimmed
+    bytes += (size_t)parameters.size() * sizeof(ParameterChange);
+    
+    return bytes;
+}
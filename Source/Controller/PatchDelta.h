@@ -0,0 +1,86 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "../Model/PatchData.h"
+#include <memory>
+
+/**
+ * Field-level difference between two versions of one patch, used by the
+ * undo history instead of whole PatchData copies.
+ * 
+ * Only fields that changed are stored, each with its before and after value.
+ * Parameters are diffed per value, so editing one knob records one entry
+ * rather than the whole parameter set. Names and tags are reference-counted
+ * juce::Strings shared with the patches they came from, and
+ * getSizeInBytes() counts their text in full, so the undo limit never
+ * undercounts a history of long names. Patch dumps are the patch's own
+ * immutable shared blocks, so recording a dump change doesn't copy it.
+ * 
+ * Two consecutive deltas for the same slot merge into one (see mergeWith()),
+ * which is how runs of edits such as typing a name collapse into a single
+ * undo step.
+ */
+class PatchDelta
+{
+public:
+    PatchDelta() = default;
+    
+    /** Records the fields that differ between two versions of a patch (slot index ignored). */
+    static PatchDelta between(const PatchData& before, const PatchData& after);
+    
+    /** True if between(a, b) would be empty, without building it. */
+    static bool isSame(const PatchData& a, const PatchData& b);
+    
+    bool isEmpty() const noexcept { return changedFields == 0 && parameters.isEmpty(); }
+    
+    /**
+     * Sets the recorded fields to their after values (redo) or before values
+     * (undo). A field that no longer holds the value this delta left it at
+     * (another instance published a change to it since) is left alone, so
+     * undo never reverts someone else's edit.
+     */
+    void applyTo(PatchData& patch, bool forward) const;
+    
+    /**
+     * Folds a delta that was recorded after this one into it, keeping this
+     * delta's before values and the later delta's after values. Fields that
+     * end up back where they started are dropped.
+     */
+    void mergeWith(const PatchDelta& later);
+    
+    /**
+     * Heap and inline bytes this delta keeps alive. Interned strings and
+     * shared dumps are counted in full by every delta that references them,
+     * so a sum over the history never under-reports.
+     */
+    size_t getSizeInBytes() const noexcept;
+    
+private:
+    enum Field : juce::uint8
+    {
+        nameField     = 1 << 0,
+        favoriteField = 1 << 1,
+        deviceField   = 1 << 2,
+        tagsField     = 1 << 3,
+        dumpField     = 1 << 4
+    };
+    
+    // A void value means the parameter had no stored value
+    struct ParameterChange
+    {
+        juce::Identifier id;
+        juce::var before;
+        juce::var after;
+    };
+    
+    juce::uint8 changedFields = 0;
+    bool favoriteBefore = false;
+    bool favoriteAfter = false;
+    juce::String nameBefore, nameAfter;
+    juce::Identifier deviceBefore, deviceAfter;
+    juce::StringArray tagsBefore, tagsAfter;
+    std::shared_ptr<const juce::MemoryBlock> dumpBefore, dumpAfter;
+    juce::Array<ParameterChange> parameters;
+    
+    void dropUnchangedFields();
+};
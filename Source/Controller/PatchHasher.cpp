@@ -0,0 +1,204 @@
+#include "PatchHasher.h"
+
+namespace
+{
+    constexpr juce::uint64 PRIME64_1 = 0x9E3779B185EBCA87ULL;
+    constexpr juce::uint64 PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr juce::uint64 PRIME64_3 = 0x165667B19E3779F9ULL;
+    constexpr juce::uint64 PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr juce::uint64 PRIME64_5 = 0x27D4EB2F165667C5ULL;
+    
+    constexpr juce::uint64 SEED_HIGH = 0;
+    constexpr juce::uint64 SEED_LOW = 0x5bd1e9955bd1e995ULL;
+    
+    inline juce::uint64 rotl(juce::uint64 x, int r) noexcept
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+    
+    inline juce::uint64 read64(const juce::uint8* p) noexcept
+    {
+        juce::uint64 v;
+        std::memcpy(&v, p, sizeof(v));
+        return juce::ByteOrder::swapIfBigEndian(v);
+    }
+    
+    inline juce::uint32 read32(const juce::uint8* p) noexcept
+    {
+        juce::uint32 v;
+        std::memcpy(&v, p, sizeof(v));
+        return juce::ByteOrder::swapIfBigEndian(v);
+    }
+    
+    inline juce::uint64 round(juce::uint64 acc, juce::uint64 input) noexcept
+    {
+        acc += input * PRIME64_2;
+        acc = rotl(acc, 31);
+        return acc * PRIME64_1;
+    }
+    
+    inline juce::uint64 mergeRound(juce::uint64 acc, juce::uint64 value) noexcept
+    {
+        acc ^= round(0, value);
+        return acc * PRIME64_1 + PRIME64_4;
+    }
+    
+    void appendString(juce::MemoryBlock& dest, const juce::String& text)
+    {
+        // Include the terminator so "ab"+"c" and "a"+"bc" differ
+        dest.append(text.toRawUTF8(), text.getNumBytesAsUTF8() + 1);
+    }
+}
+
+bool PatchHasher::hasSoundData(const PatchData& patch) noexcept
+{
+    return patch.hasPatchDump() || !patch.getParameterValues().isEmpty();
+}
+
+void PatchHasher::canonicalize(const PatchData& patch,
+                               const juce::Array<juce::Range<int>>& nonSoundRanges,
+                               juce::MemoryBlock& dest)
+{
+    dest.reset();
+    appendString(dest, patch.getDeviceID().toString());
+    
+    // Dump bytes, skipping the ranges that don't affect the sound
+    const auto& dump = patch.getPatchDump();
+    const auto* bytes = static_cast<const juce::uint8*>(dump.getData());
+    const int dumpSize = (int)dump.getSize();
+    int position = 0;
+    
+    while (position < dumpSize)
+    {
+        int runEnd = dumpSize;
+        int skipTo = dumpSize;
+        
+        for (const auto& range : nonSoundRanges)
+        {
+            if (range.contains(position))
+            {
+                runEnd = position;
+                skipTo = juce::jmin(dumpSize, range.getEnd());
+                break;
+            }
+            
+            if (range.getStart() > position && range.getStart() < runEnd)
+            {
+                runEnd = range.getStart();
+                skipTo = juce::jmin(dumpSize, range.getEnd());
+            }
+        }
+        
+        if (runEnd > position)
+            dest.append(bytes + position, (size_t)(runEnd - position));
+        
+        position = runEnd == dumpSize ? dumpSize : skipTo;
+    }
+    
+    // Edited parameters in ID order, so edit order doesn't matter
+    const auto& values = patch.getParameterValues();
+    if (!values.isEmpty())
+    {
+        juce::StringArray ids;
+        for (const auto& value : values)
+            ids.add(value.name.toString());
+        ids.sort(false);
+        
+        const juce::uint8 separator = 0xff;
+        dest.append(&separator, 1);
+        
+        for (const auto& id : ids)
+        {
+            appendString(dest, id);
+            const auto value = juce::ByteOrder::swapIfBigEndian((juce::uint32)(int)values[juce::Identifier(id)]);
+            dest.append(&value, sizeof(value));
+        }
+    }
+}
+
+PatchHash PatchHasher::hashPatch(const PatchData& patch,
+                                 const juce::Array<juce::Range<int>>& nonSoundRanges,
+                                 juce::MemoryBlock& scratch)
+{
+    if (!hasSoundData(patch))
+        return {};
+    
+    canonicalize(patch, nonSoundRanges, scratch);
+    
+    PatchHash hash;
+    hash.high = xxHash64(scratch.getData(), scratch.getSize(), SEED_HIGH);
+    hash.low = xxHash64(scratch.getData(), scratch.getSize(), SEED_LOW);
+    
+    // Reserve the empty hash for "no sound data"
+    if (hash.isEmpty())
+        hash.low = 1;
+    
+    return hash;
+}
+
+juce::uint64 PatchHasher::xxHash64(const void* data, size_t size, juce::uint64 seed) noexcept
+{
+    const auto* p = static_cast<const juce::uint8*>(data);
+    const auto* const end = p + size;
+    juce::uint64 h;
+    
+    if (size >= 32)
+    {
+        const auto* const limit = end - 32;
+        juce::uint64 v1 = seed + PRIME64_1 + PRIME64_2;
+        juce::uint64 v2 = seed + PRIME64_2;
+        juce::uint64 v3 = seed;
+        juce::uint64 v4 = seed - PRIME64_1;
+        
+        do
+        {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+            p += 32;
+        }
+        while (p <= limit);
+        
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    }
+    else
+    {
+        h = seed + PRIME64_5;
+    }
+    
+    h += (juce::uint64)size;
+    
+    while (p + 8 <= end)
+    {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+    
+    if (p + 4 <= end)
+    {
+        h ^= (juce::uint64)read32(p) * PRIME64_1;
+        h = rotl(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    
+    while (p < end)
+    {
+        h ^= (*p) * PRIME64_5;
+        h = rotl(h, 11) * PRIME64_1;
+        ++p;
+    }
+    
+    // Avalanche
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
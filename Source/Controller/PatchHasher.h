@@ -0,0 +1,64 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "../Model/PatchData.h"
+
+/**
+ * 128-bit content hash of a patch's sound data.
+ */
+struct PatchHash
+{
+    juce::uint64 high = 0;
+    juce::uint64 low = 0;
+    
+    bool isEmpty() const noexcept { return high == 0 && low == 0; }
+    bool operator==(const PatchHash& other) const noexcept { return high == other.high && low == other.low; }
+    bool operator!=(const PatchHash& other) const noexcept { return !(*this == other); }
+    bool operator<(const PatchHash& other) const noexcept
+    {
+        return high != other.high ? high < other.high : low < other.low;
+    }
+    
+    juce::String toString() const
+    {
+        return juce::String::toHexString((juce::int64)high).paddedLeft('0', 16)
+             + juce::String::toHexString((juce::int64)low).paddedLeft('0', 16);
+    }
+    
+    struct Hasher
+    {
+        size_t operator()(const PatchHash& hash) const noexcept { return (size_t)(hash.low ^ (hash.high >> 1)); }
+    };
+};
+
+/**
+ * Canonicalizes and hashes patches for content-addressed comparison.
+ * 
+ * The canonical form of a patch is its device ID, its dump bytes minus the
+ * template's non-sound ranges (name, bookkeeping), and its edited parameter
+ * values sorted by ID. Names, tags, favorites and slot numbers are ignored,
+ * and dumps are stored decoded, so SysEx checksums never take part.
+ * 
+ * Hashing is XXH64 run with two seeds for 128 bits. All functions are
+ * stateless and safe to call from any thread.
+ */
+class PatchHasher
+{
+public:
+    /** False for placeholder slots with no dump and no edited parameters. */
+    static bool hasSoundData(const PatchData& patch) noexcept;
+    
+    static void canonicalize(const PatchData& patch,
+                             const juce::Array<juce::Range<int>>& nonSoundRanges,
+                             juce::MemoryBlock& dest);
+    
+    /** Returns an empty hash for patches without sound data. */
+    static PatchHash hashPatch(const PatchData& patch,
+                               const juce::Array<juce::Range<int>>& nonSoundRanges,
+                               juce::MemoryBlock& scratch);
+    
+    static juce::uint64 xxHash64(const void* data, size_t size, juce::uint64 seed) noexcept;
+    
+private:
+    PatchHasher() = delete;
+};
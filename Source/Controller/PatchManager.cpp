@@ -1,46 +1,154 @@
 #include "PatchManager.h"
+#include "PatchSysExCodec.h"
+#include "TraceRecorder.h"
+
+namespace
+{
+    double millisecondsSince(juce::int64 startTicks) noexcept
+    {
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+    }
+}
 
 PatchManager::PatchManager()
 {
-    // Load saved data on startup
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::PatchManager");
+    
+    constructionTicks = juce::Time::getHighResolutionTicks();
+    
+    // Stage 1: device settings (the whole library if another instance already loaded it)
     loadAll();
     
-    // Load device template if device ID is set
-    if (deviceModel.getDeviceID() != "generic")
+    // Load device template if device ID is set. A user template may not be indexed
+    // yet; changeListenerCallback() applies it when the index arrives.
+    if (deviceModel.getDeviceID() != "generic" && templateManager.hasTemplate(deviceModel.getDeviceID()))
     {
         auto template_ = templateManager.getTemplate(deviceModel.getDeviceID());
         deviceModel.setTemplate(template_);
     }
     
-    // Sync MIDI manager with device model
-    syncMidiManagerWithDeviceModel();
+    // The output port is opened by beginStartup(); enumerating devices is too slow for here
+    midiManager.setMidiChannel(deviceModel.getMidiChannelDisplay());
+    parameterTransmitter.setDevice(deviceModel.getTemplate().getParameterMap(),
+                                   deviceModel.getTemplate().getSysExProtocol(),
+                                   deviceModel.getSysExDeviceId());
+    updateDeduplicatorRanges();
     
     // Setup MIDI learn callback
     midiLearnManager.onPatchRecall = [this](int slotIndex)
     {
         recallPatch(slotIndex);
+        midiManager.getTelemetry().recordLearnRecall();
     };
     
-    // Setup MIDI input callback to process learn messages
+    // Setup MIDI input callback to process learn messages and SysEx replies
     midiManager.onMidiInput = [this](const juce::MidiMessage& message)
     {
-        midiLearnManager.processMidiMessage(message);
+        if (message.isSysEx())
+            sysExRequestManager.handleIncomingSysEx(message);
+        else
+            midiLearnManager.processMidiMessage(message);
     };
     
-    // Listen to undo manager for change notifications
+    // Listen to undo manager, the template folder and other instances' library edits
     undoManager.addChangeListener(this);
+    templateManager.addChangeListener(this);
+    library->addChangeListener(this);
+    
+    timings.constructionMs = millisecondsSince(constructionTicks);
+}
+
+PatchManager::~PatchManager()
+{
+    // The port job uses midiManager
+    if (startupPool != nullptr)
+        startupPool->removeAllJobs(false, -1);
+    
+    // The library and its template manager outlive this instance
+    library->removeChangeListener(this);
+    templateManager.removeChangeListener(this);
+}
+
+void PatchManager::beginStartup()
+{
+    if (startupBegan.exchange(true))
+        return;
+    
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::beginStartup");
+    
+    startupBeganTicks = juce::Time::getHighResolutionTicks();
+    library->startLoading();
+    
+    // Stage 2, in parallel with the library: enumerate devices and open the port
+    startupPool = std::make_unique<juce::ThreadPool>(1);
+    startupPool->addJob([this, portName = deviceModel.getMidiOutputPortName(),
+                         identifier = deviceModel.getMidiOutputPortIdentifier()]
+    {
+        MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::openStartupPort");
+        
+        auto result = midiManager.setOutputPort(portName, identifier);
+        if (result.failed())
+            juce::Logger::writeToLog("Failed to open MIDI output port: " + result.getErrorMessage());
+        
+        portsOpenedTicks = juce::Time::getHighResolutionTicks();
+    });
+}
+
+void PatchManager::waitUntilReady()
+{
+    if (ready)
+        return;
+    
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::waitUntilReady");
+    
+    beginStartup();
+    library->waitUntilLoaded();
+    
+    // The bank belongs to the message thread; elsewhere changeListenerCallback() applies the library
+    if (juce::MessageManager::existsAndIsCurrentThread() && pullLibraryChanges())
+        sendChangeMessage();
+}
+
+juce::var PatchManager::StartupTimings::toVar() const
+{
+    juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+    obj->setProperty("constructionMs", constructionMs);
+    obj->setProperty("libraryMs", libraryMs);
+    obj->setProperty("portsMs", portsMs);
+    obj->setProperty("timeToInteractiveMs", timeToInteractiveMs);
+    return juce::var(obj.get());
+}
+
+PatchManager::StartupTimings PatchManager::getStartupTimings() const
+{
+    auto result = timings;
+    
+    const auto began = startupBeganTicks.load();
+    const auto portsOpened = portsOpenedTicks.load();
+    if (began != 0 && portsOpened != 0)
+        result.portsMs = juce::Time::highResolutionTicksToSeconds(portsOpened - began) * 1000.0;
+    
+    return result;
+}
+
+void PatchManager::setTimeToInteractive(double milliseconds)
+{
+    timings.timeToInteractiveMs = milliseconds;
+    juce::Logger::writeToLog("MIDI Librarian interactive after " + juce::String(milliseconds, 1) + " ms");
 }
 
 void PatchManager::renamePatch(int slotIndex, const juce::String& newName)
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::renamePatch");
+    
     if (patchBank.isValidSlot(slotIndex))
     {
-        const auto& oldPatch = patchBank.getPatch(slotIndex);
-        juce::String oldName = oldPatch.getPatchName();
+        auto patch = patchBank.getPatch(slotIndex);
+        patch.setPatchName(newName);
         
-        if (oldName != newName)
+        // Consecutive renames of one slot (typing) share an undo step
+        if (performPatchEdit("Rename Patch", { slotIndex }, { patch }, true))
         {
-            undoManager.perform(new RenamePatchAction(patchBank, slotIndex, newName, oldName));
             saveAll(); // Auto-save on rename
             sendChangeMessage();
         }
@@ -49,16 +157,21 @@ void PatchManager::renamePatch(int slotIndex, const juce::String& newName)
 
 void PatchManager::recallPatch(int slotIndex)
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::recallPatch");
+    
     if (patchBank.isValidSlot(slotIndex))
     {
-        // Send MIDI Program Change (queues to FIFO for audio thread)
-        auto result = midiManager.sendProgramChange(slotIndex);
+        // Send MIDI Program Change (queues to the realtime lane for the audio thread)
+        auto result = midiManager.sendProgramChange(slotIndex, MidiManager::Priority::realtime);
         
         if (result.failed())
         {
             juce::Logger::writeToLog("Failed to send program change: " + result.getErrorMessage());
         }
         
+        lastRecalledSlot = slotIndex;
+        transmitStoredParameters(slotIndex);
+        
         // Notify UI
         sendChangeMessage();
     }
@@ -68,12 +181,11 @@ void PatchManager::setPatchFavorite(int slotIndex, bool favorite)
 {
     if (patchBank.isValidSlot(slotIndex))
     {
-        const auto& patch = patchBank.getPatch(slotIndex);
-        bool oldFavorite = patch.isFavorite();
+        auto patch = patchBank.getPatch(slotIndex);
+        patch.setFavorite(favorite);
         
-        if (oldFavorite != favorite)
+        if (performPatchEdit("Set Favorite", { slotIndex }, { patch }))
         {
-            undoManager.perform(new SetFavoriteAction(patchBank, slotIndex, favorite, oldFavorite));
             saveAll();
             sendChangeMessage();
         }
@@ -84,9 +196,15 @@ void PatchManager::copyPatch(int sourceSlot, int destSlot)
 {
     if (patchBank.isValidSlot(sourceSlot) && patchBank.isValidSlot(destSlot) && sourceSlot != destSlot)
     {
-        undoManager.perform(new CopyPatchAction(patchBank, sourceSlot, destSlot));
-        saveAll();
-        sendChangeMessage();
+        auto newPatch = patchBank.getPatch(sourceSlot);
+        newPatch.setSlotIndex(destSlot);
+        
+        if (performPatchEdit("Copy Patch", { destSlot }, { newPatch }))
+        {
+            patchContentChanged(destSlot);
+            saveAll();
+            sendChangeMessage();
+        }
     }
 }
 
@@ -95,26 +213,23 @@ void PatchManager::batchRenamePatches(const juce::Array<int>& slotIndices, const
     if (slotIndices.isEmpty())
         return;
     
-    juce::Array<BatchRenameAction::PatchChange> changes;
+    juce::Array<int> slots;
+    juce::Array<PatchData> newPatches;
     
     for (int slotIndex : slotIndices)
     {
         if (patchBank.isValidSlot(slotIndex))
         {
-            const auto& patch = patchBank.getPatch(slotIndex);
-            juce::String newName = baseName + " " + juce::String(slotIndex + 1);
+            auto patch = patchBank.getPatch(slotIndex);
+            patch.setPatchName(baseName + " " + juce::String(slotIndex + 1));
             
-            BatchRenameAction::PatchChange change;
-            change.slotIndex = slotIndex;
-            change.oldName = patch.getPatchName();
-            change.newName = newName;
-            changes.add(change);
+            slots.add(slotIndex);
+            newPatches.add(patch);
         }
     }
     
-    if (changes.size() > 0)
+    if (performPatchEdit("Batch Rename", slots, newPatches))
     {
-        undoManager.perform(new BatchRenameAction(patchBank, changes));
         saveAll();
         sendChangeMessage();
     }
@@ -128,38 +243,273 @@ void PatchManager::clearPatchRange(int startSlot, int endSlot)
     if (startSlot > endSlot)
         std::swap(startSlot, endSlot);
     
-    juce::Array<BatchRenameAction::PatchChange> changes;
+    juce::Array<int> slots;
+    juce::Array<PatchData> newPatches;
     
     for (int i = startSlot; i <= endSlot; ++i)
     {
-        const auto& patch = patchBank.getPatch(i);
-        juce::String defaultName = "Patch " + juce::String(i + 1).paddedLeft('0', 3);
+        auto patch = patchBank.getPatch(i);
+        patch.setPatchName("Patch " + juce::String(i + 1).paddedLeft('0', 3));
         
-        BatchRenameAction::PatchChange change;
-        change.slotIndex = i;
-        change.oldName = patch.getPatchName();
-        change.newName = defaultName;
-        changes.add(change);
+        slots.add(i);
+        newPatches.add(patch);
+    }
+    
+    if (performPatchEdit("Clear Patches", slots, newPatches))
+    {
+        saveAll();
+        sendChangeMessage();
+    }
+}
+
+void PatchManager::retagPatches(const juce::Array<int>& slotIndices, const juce::StringArray& tagsToAdd,
+                                const juce::StringArray& tagsToRemove)
+{
+    juce::Array<int> slots;
+    juce::Array<PatchData> newPatches;
+    
+    for (int slotIndex : slotIndices)
+    {
+        if (patchBank.isValidSlot(slotIndex))
+        {
+            auto patch = patchBank.getPatch(slotIndex);
+            
+            for (const auto& tag : tagsToRemove)
+                patch.removeTag(tag);
+            for (const auto& tag : tagsToAdd)
+                patch.addTag(tag);
+            
+            slots.add(slotIndex);
+            newPatches.add(patch);
+        }
     }
     
-    if (changes.size() > 0)
+    if (performPatchEdit("Retag Patches", slots, newPatches))
     {
-        undoManager.perform(new BatchRenameAction(patchBank, changes));
         saveAll();
         sendChangeMessage();
     }
 }
 
+void PatchManager::movePatchRange(int startSlot, int numSlots, int destSlot)
+{
+    if (numSlots <= 0 || startSlot < 0 || startSlot + numSlots > PatchBank::BANK_SIZE
+        || destSlot < 0 || destSlot + numSlots > PatchBank::BANK_SIZE || destSlot == startSlot)
+        return;
+    
+    // The other slots close up around the gap, then the range is reinserted at destSlot
+    juce::Array<int> order;
+    order.ensureStorageAllocated(PatchBank::BANK_SIZE);
+    
+    for (int i = 0; i < PatchBank::BANK_SIZE; ++i)
+        if (i < startSlot || i >= startSlot + numSlots)
+            order.add(i);
+    
+    for (int i = 0; i < numSlots; ++i)
+        order.insert(destSlot + i, startSlot + i);
+    
+    reorderPatches("Move Patches", order);
+}
+
+void PatchManager::swapPatchRanges(int firstStart, int secondStart, int numSlots)
+{
+    if (numSlots <= 0 || firstStart < 0 || secondStart < 0
+        || juce::jmax(firstStart, secondStart) + numSlots > PatchBank::BANK_SIZE
+        || std::abs(firstStart - secondStart) < numSlots)
+        return;
+    
+    juce::Array<int> order;
+    order.ensureStorageAllocated(PatchBank::BANK_SIZE);
+    
+    for (int i = 0; i < PatchBank::BANK_SIZE; ++i)
+        order.add(i);
+    
+    for (int i = 0; i < numSlots; ++i)
+        order.swap(firstStart + i, secondStart + i);
+    
+    reorderPatches("Swap Patches", order);
+}
+
+void PatchManager::sortPatches(SortKey key, int startSlot, int endSlot)
+{
+    if (!patchBank.isValidSlot(startSlot) || !patchBank.isValidSlot(endSlot))
+        return;
+    
+    if (startSlot > endSlot)
+        std::swap(startSlot, endSlot);
+    
+    // Keys are read once rather than per comparison
+    juce::StringArray names, firstTags;
+    juce::Array<int> order;
+    
+    for (int i = 0; i < PatchBank::BANK_SIZE; ++i)
+    {
+        const auto& patch = patchBank.getPatch(i);
+        names.add(patch.getPatchName());
+        firstTags.add(key == SortKey::tag ? patch.getTags()[0] : juce::String());
+        order.add(i);
+    }
+    
+    std::stable_sort(order.begin() + startSlot, order.begin() + endSlot + 1, [&](int a, int b)
+    {
+        if (key == SortKey::tag)
+        {
+            const auto& tagA = firstTags.getReference(a);
+            const auto& tagB = firstTags.getReference(b);
+            
+            if (tagA.isEmpty() != tagB.isEmpty())
+                return tagB.isEmpty();
+            
+            if (const int result = tagA.compareIgnoreCase(tagB))
+                return result < 0;
+        }
+        
+        return names.getReference(a).compareNatural(names.getReference(b)) < 0;
+    });
+    
+    reorderPatches(key == SortKey::tag ? "Sort Patches by Tag" : "Sort Patches by Name", order);
+}
+
+void PatchManager::moveFavoritesToFront(int startSlot, int endSlot)
+{
+    if (!patchBank.isValidSlot(startSlot) || !patchBank.isValidSlot(endSlot))
+        return;
+    
+    if (startSlot > endSlot)
+        std::swap(startSlot, endSlot);
+    
+    juce::Array<int> order;
+    for (int i = 0; i < PatchBank::BANK_SIZE; ++i)
+        order.add(i);
+    
+    std::stable_partition(order.begin() + startSlot, order.begin() + endSlot + 1,
+                          [this](int slot) { return patchBank.getPatch(slot).isFavorite(); });
+    
+    reorderPatches("Move Favorites to Front", order);
+}
+
+bool PatchManager::reorderPatches(const juce::String& name, const juce::Array<int>& order)
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::reorderPatches");
+    
+    auto action = std::make_unique<PermutePatchesAction>(patchBank, order,
+                                                         [this](const juce::Array<int>& applied)
+                                                         {
+                                                             patchesReordered(applied);
+                                                         });
+    if (action->isEmpty())
+        return false;
+    
+    coalescingSlot = -1;
+    undoManager.beginNewTransaction(name);
+    
+    if (!undoManager.perform(action.release()))
+        return false;
+    
+    saveAll();
+    sendChangeMessage();
+    return true;
+}
+
+void PatchManager::patchesReordered(const juce::Array<int>& order)
+{
+    for (int i = 0; i < order.size(); ++i)
+        if (order[i] != i)
+            patchContentChanged(i);
+    
+    // The device's edit buffer still holds the recalled patch, wherever it moved to
+    if (lastRecalledSlot >= 0)
+        lastRecalledSlot = order.indexOf(lastRecalledSlot);
+    
+    writeReorderToDevice(order);
+}
+
+void PatchManager::writeReorderToDevice(const juce::Array<int>& order)
+{
+    auto protocol = deviceModel.getTemplate().getSysExProtocol();
+    if (protocol == nullptr || !protocol->canWritePatches())
+        return;
+    
+    const PatchSysExCodec codec(deviceModel.getTemplate(), deviceModel.getSysExDeviceId());
+    int numUnwritable = 0;
+    const auto writes = createReorderWrites(patchBank, order, codec, numUnwritable);
+    
+    if (numUnwritable > 0)
+        juce::Logger::writeToLog(juce::String(numUnwritable) + " reordered slots have no stored dump of the "
+                                 "device's patch size and were not written to the device");
+    
+    if (writes.isEmpty())
+        return;
+    
+    // Queued as one dump: either every slot goes out or none does
+    auto result = midiManager.sendSysExDump(static_cast<const juce::uint8*>(writes.getData()), (int)writes.getSize());
+    if (result.failed())
+        juce::Logger::writeToLog("Reordered patches were not written to the device: " + result.getErrorMessage());
+}
+
+juce::MemoryBlock PatchManager::createReorderWrites(const PatchBank& bank, const juce::Array<int>& order,
+                                                    const PatchSysExCodec& codec, int& numUnwritable)
+{
+    juce::MemoryOutputStream stream;
+    numUnwritable = 0;
+    
+    // inverse[slot] = where the patch that used to be in slot is now
+    juce::Array<int> inverse;
+    inverse.insertMultiple(0, 0, order.size());
+    for (int i = 0; i < order.size(); ++i)
+        inverse.set(order[i], i);
+    
+    for (int slot = 0; slot < order.size(); ++slot)
+    {
+        if (order[slot] == slot)
+            continue;
+        
+        // The device still holds this slot's previous patch; skip if the sound is the same
+        const auto& dump = bank.getPatch(slot).getPatchDump();
+        if (dump == bank.getPatch(inverse[slot]).getPatchDump())
+            continue;
+        
+        const auto writes = codec.createWrites(slot, dump);
+        if (writes.isEmpty())
+        {
+            ++numUnwritable;
+            continue;
+        }
+        
+        for (const auto& body : writes)
+        {
+            stream.writeByte((char)0xf0);
+            stream.write(body.getData(), body.getSize());
+            stream.writeByte((char)0xf7);
+        }
+    }
+    
+    return stream.getMemoryBlock();
+}
+
 void PatchManager::undo()
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::undo");
+    
+    coalescingSlot = -1;
+    
+    // A transaction may hold several actions; the bank announces them together
+    const PatchBank::ScopedTransaction transaction(patchBank);
     undoManager.undo();
+    patchContentChanged(-1);
     saveAll();
     sendChangeMessage();
 }
 
 void PatchManager::redo()
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::redo");
+    
+    coalescingSlot = -1;
+    
+    const PatchBank::ScopedTransaction transaction(patchBank);
     undoManager.redo();
+    patchContentChanged(-1);
     saveAll();
     sendChangeMessage();
 }
@@ -184,14 +534,22 @@ juce::String PatchManager::getRedoDescription() const
     return undoManager.getRedoDescription();
 }
 
-void PatchManager::setMidiOutputPort(const juce::String& portName)
+void PatchManager::setMidiOutputPort(const juce::String& portName, const juce::String& identifier)
 {
     deviceModel.setMidiOutputPortName(portName);
-    auto result = midiManager.setOutputPort(portName);
+    deviceModel.setMidiOutputPortIdentifier(identifier);
+    auto result = midiManager.setOutputPort(portName, identifier);
     
     if (result.wasOk())
     {
-        saveAll();
+        // Store what was actually opened: a name-only config gains its identifier here
+        if (portName.isNotEmpty())
+        {
+            deviceModel.setMidiOutputPortName(midiManager.getCurrentPortName());
+            deviceModel.setMidiOutputPortIdentifier(midiManager.getCurrentPortIdentifier());
+        }
+        
+        saveDeviceConfig();
         sendChangeMessage();
     }
     else
@@ -205,56 +563,573 @@ void PatchManager::setMidiChannel(int channel)
 {
     deviceModel.setMidiChannel(channel);
     midiManager.setMidiChannel(channel);
+    saveDeviceConfig();
+    sendChangeMessage();
+}
+
+void PatchManager::setDeviceTemplate(const DeviceTemplate& template_)
+{
+    deviceModel.setDeviceID(template_.getDeviceID());
+    deviceModel.setTemplate(template_);
+    parameterTransmitter.setDevice(template_.getParameterMap(), template_.getSysExProtocol(),
+                                   deviceModel.getSysExDeviceId());
+    updateDeduplicatorRanges();
+    similarityIndexValid = false;
+}
+
+void PatchManager::setSysExDeviceId(int deviceId)
+{
+    deviceModel.setSysExDeviceId(deviceId);
+    parameterTransmitter.setDevice(deviceModel.getTemplate().getParameterMap(),
+                                   deviceModel.getTemplate().getSysExProtocol(),
+                                   deviceModel.getSysExDeviceId());
+    saveDeviceConfig();
+    sendChangeMessage();
+}
+
+juce::Result PatchManager::setPatchParameter(int slotIndex, const juce::String& parameterId, int value)
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::setPatchParameter");
+    
+    if (!patchBank.isValidSlot(slotIndex))
+        return juce::Result::fail("Invalid slot: " + juce::String(slotIndex));
+    
+    auto parameterMap = parameterTransmitter.getParameterMap();
+    const int parameterIndex = parameterMap != nullptr ? parameterMap->indexOf(parameterId) : -1;
+    
+    if (parameterIndex < 0)
+        return juce::Result::fail("Unknown parameter: " + parameterId);
+    
+    value = parameterMap->getParameter(parameterIndex).clampValue(value);
+    patchBank.getPatch(slotIndex).setParameterValue(parameterId, value);
+    patchContentChanged(slotIndex);
+    
+    // Only the patch loaded on the device hears the edit
+    if (slotIndex == lastRecalledSlot)
+        parameterTransmitter.setParameter(parameterIndex, value);
+    
+    return juce::Result::ok();
+}
+
+void PatchManager::endParameterEdit()
+{
     saveAll();
     sendChangeMessage();
 }
 
+juce::Array<PatchDeduplicator::DuplicateGroup> PatchManager::findDuplicatePatches()
+{
+    deduplicator.update(patchBank);
+    return deduplicator.getDuplicateGroups();
+}
+
+PatchDeduplicator::MergeReport PatchManager::mergeDuplicatePatches()
+{
+    juce::Array<int> slots;
+    juce::Array<PatchData> newPatches;
+    auto report = PatchDeduplicator::planMerge(patchBank, findDuplicatePatches(), slots, newPatches);
+    
+    if (performPatchEdit("Merge Duplicates", slots, newPatches))
+    {
+        for (int slot : slots)
+            patchContentChanged(slot);
+        
+        saveAll();
+        sendChangeMessage();
+    }
+    
+    return report;
+}
+
+juce::Array<PatchSimilarityIndex::Match> PatchManager::findSimilarPatches(int slotIndex, int maxResults)
+{
+    if (!patchBank.isValidSlot(slotIndex))
+        return {};
+    
+    // Rebuilt lazily: edits only invalidate, so a knob sweep doesn't re-flatten the bank per tick
+    if (!similarityIndexValid)
+    {
+        similarityIndex.rebuild(parameterTransmitter.getParameterMap(), patchBank.getPatches());
+        similarityIndexValid = true;
+    }
+    
+    return similarityIndex.findSimilar(slotIndex, maxResults);
+}
+
+bool PatchManager::performPatchEdit(const juce::String& name, const juce::Array<int>& slots,
+                                    const juce::Array<PatchData>& newPatches, bool coalesce)
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::performPatchEdit");
+    
+    auto action = std::make_unique<PatchEditAction>(patchBank, slots, newPatches, coalesce);
+    if (action->isEmpty())
+        return false;
+    
+    // A new transaction unless this continues a run of the same edit on the same slot;
+    // within one transaction, UndoManager asks the previous action to absorb this one
+    const int slot = coalesce && slots.size() == 1 ? slots.getFirst() : -1;
+    const auto now = juce::Time::getMillisecondCounter();
+    const bool continuesEdit = slot >= 0 && slot == coalescingSlot && name == coalescingName
+                            && now - lastEditTime < COALESCE_WINDOW_MS;
+    
+    if (!continuesEdit)
+        undoManager.beginNewTransaction(name);
+    
+    coalescingSlot = slot;
+    coalescingName = name;
+    lastEditTime = now;
+    
+    return undoManager.perform(action.release());
+}
+
+void PatchManager::patchContentChanged(int slotIndex)
+{
+    if (slotIndex < 0)
+        deduplicator.markAllDirty();
+    else
+        deduplicator.markDirty(slotIndex);
+    
+    similarityIndexValid = false;
+}
+
+void PatchManager::updateDeduplicatorRanges()
+{
+    auto protocol = deviceModel.getTemplate().getSysExProtocol();
+    deduplicator.setNonSoundRanges(protocol != nullptr ? protocol->getNonSoundRanges()
+                                                       : juce::Array<juce::Range<int>>());
+}
+
+void PatchManager::transmitStoredParameters(int slotIndex)
+{
+    auto parameterMap = parameterTransmitter.getParameterMap();
+    if (parameterMap == nullptr)
+        return;
+    
+    // The program change loaded the device's stored values; re-apply the librarian's edits on top
+    parameterTransmitter.invalidateSentValues();
+    
+    const auto& patch = patchBank.getPatch(slotIndex);
+    for (int i = 0; i < parameterMap->size(); ++i)
+    {
+        const auto& parameter = parameterMap->getParameter(i);
+        if (patch.hasParameterValue(parameter.id))
+            parameterTransmitter.setParameter(i, patch.getParameterValue(parameter.id, parameter.defaultValue));
+    }
+}
+
+juce::Result PatchManager::syncPatchNamesFromDevice(std::function<void(int numRenamed, int numFailed)> onComplete)
+{
+    waitUntilReady();
+    
+    const auto& template_ = deviceModel.getTemplate();
+    const auto deviceKey = template_.getDeviceID().toString();
+    
+    auto protocol = template_.getSysExProtocol();
+    
+    if (protocol == nullptr || !protocol->canReadPatchNames())
+    {
+        return juce::Result::fail("Patch name readback is not supported for " + template_.getDeviceName());
+    }
+    
+    if (!midiManager.isPortOpen())
+    {
+        return juce::Result::fail("MIDI output port not open");
+    }
+    
+    const auto* requestFormat = protocol->getFormat(SysExProtocol::DATA_REQUEST);
+    const auto* replyFormat = protocol->getFormat(SysExProtocol::DATA_SET);
+    const auto nameMap = *protocol->getAddressMap(SysExProtocol::PATCH_NAME);
+    
+    // The parser holds the protocol so the compiled formats outlive this template copy
+    SysExRequestManager::DeviceConfig config;
+    config.parser = [protocol, replyFormat](const juce::uint8* data, int size, SysExRequestManager::ParsedReply& reply)
+    {
+        SysExMessageFormat::Decoded decoded;
+        if (!replyFormat->decode(data, size, decoded))
+            return false;
+        
+        reply.address = decoded.address;
+        reply.payload = std::move(decoded.data);
+        reply.checksumValid = decoded.checksumValid;
+        return true;
+    };
+    sysExRequestManager.configureDevice(deviceKey, config);
+    
+    // Shared by all request callbacks; the last one to finish applies the names
+    struct SyncState
+    {
+        juce::StringArray names;
+        int remaining = 0;
+        int failed = 0;
+    };
+    
+    auto state = std::make_shared<SyncState>();
+    const int firstSlot = juce::jmax(0, template_.getMinPatchNumber());
+    const int lastSlot = juce::jmin(PatchBank::BANK_SIZE - 1, template_.getMaxPatchNumber());
+    state->remaining = lastSlot - firstSlot + 1;
+    for (int i = 0; i < PatchBank::BANK_SIZE; ++i)
+        state->names.add(juce::String());
+    
+    for (int slot = firstSlot; slot <= lastSlot; ++slot)
+    {
+        SysExRequestManager::Request request;
+        request.address = nameMap.getAddress(slot);
+        
+        SysExMessageFormat::Fields fields;
+        fields.deviceId = deviceModel.getEffectiveSysExDeviceId();
+        fields.address = request.address;
+        fields.size = (juce::uint32)nameMap.length;
+        requestFormat->encodeInto(request.message, fields);
+        
+        request.onComplete = [this, state, slot, onComplete](const juce::Result& result, const juce::MemoryBlock& payload)
+        {
+            if (result.wasOk())
+                state->names.set(slot, juce::String::fromUTF8(static_cast<const char*>(payload.getData()),
+                                                              (int)payload.getSize()).trimEnd());
+            else
+                ++state->failed;
+            
+            if (--state->remaining > 0)
+                return;
+            
+            juce::Array<int> slots;
+            juce::Array<PatchData> newPatches;
+            for (int i = 0; i < PatchBank::BANK_SIZE; ++i)
+            {
+                const auto& newName = state->names[i];
+                auto patch = patchBank.getPatch(i);
+                
+                if (newName.isNotEmpty() && newName != patch.getPatchName())
+                {
+                    patch.setPatchName(newName);
+                    slots.add(i);
+                    newPatches.add(patch);
+                }
+            }
+            
+            if (performPatchEdit("Sync Names from Device", slots, newPatches))
+            {
+                saveAll();
+                sendChangeMessage();
+            }
+            
+            if (onComplete)
+                onComplete(slots.size(), state->failed);
+        };
+        
+        sysExRequestManager.submit(deviceKey, std::move(request));
+    }
+    
+    return juce::Result::ok();
+}
+
 void PatchManager::saveAll()
 {
-    persistenceManager.savePatchBank(patchBank);
-    persistenceManager.saveDeviceConfig(deviceModel);
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::saveAll");
+    
+    if (persistenceSuspended || detachedFromLibrary)
+        return;
+    
+    // Publishing before the library has loaded would replace it with this instance's empty bank
+    waitUntilReady();
+    
+    // Take in what other instances published since, or this would put their slots back
+    pullLibraryChanges();
+    
+    // Copy-on-write: publish a new library snapshot; the library does the disk write
+    SharedLibrary::Snapshot snapshot;
+    snapshot.patches = patchBank.getPatches();
+    snapshot.deviceConfig = deviceModel.toVar();
+    snapshot.midiLearn = midiLearnManager.toVar();
+    library->publish(std::move(snapshot));
+    librarySnapshot = library->getSnapshot();
+}
+
+void PatchManager::saveDeviceConfig()
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::saveDeviceConfig");
+    
+    if (persistenceSuspended || detachedFromLibrary)
+        return;
+    
+    waitUntilReady();
+    pullLibraryChanges();
+    
+    // The library's patches and learn map go back as they are; unpublished edits here stay unpublished
+    auto snapshot = *librarySnapshot;
+    snapshot.deviceConfig = deviceModel.toVar();
+    library->publish(std::move(snapshot));
+    librarySnapshot = library->getSnapshot();
+}
+
+bool PatchManager::pullLibraryChanges()
+{
+    auto latest = library->getSnapshot();
+    if (latest == librarySnapshot)
+        return false;
     
-    // Save MIDI learn mappings
-    auto learnFile = persistenceManager.getDataDirectory().getChildFile("midi_learn.json");
-    auto learnVar = midiLearnManager.toVar();
-    juce::String jsonString = juce::JSON::toString(learnVar, true);
-    learnFile.replaceWithText(jsonString);
+    applyLibrarySnapshot(latest);
+    return true;
 }
 
 void PatchManager::loadAll()
 {
-    persistenceManager.loadPatchBank(patchBank);
-    persistenceManager.loadDeviceConfig(deviceModel);
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::loadAll");
+    
+    // The library read the files once for the whole process
+    auto snapshot = library->getSnapshot();
+    
+    if (!snapshot->deviceConfig.isVoid())
+        deviceModel.fromVar(snapshot->deviceConfig);
+    
+    applyLibrarySnapshot(snapshot);
+}
+
+void PatchManager::applyLibrarySnapshot(const SharedLibrary::SnapshotPtr& snapshot)
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::applyLibrarySnapshot");
+    
+    const auto previous = std::move(librarySnapshot);
+    librarySnapshot = snapshot;
     
-    // Load MIDI learn mappings
-    auto learnFile = persistenceManager.getDataDirectory().getChildFile("midi_learn.json");
-    if (learnFile.existsAsFile())
+    if (!ready && library->isLoaded())
     {
-        juce::String jsonString = learnFile.loadFileAsString();
-        auto learnVar = juce::JSON::parse(jsonString);
-        if (!learnVar.isUndefined())
+        ready = true;
+        const auto began = startupBeganTicks.load();
+        timings.libraryMs = millisecondsSince(began != 0 ? began : constructionTicks);
+    }
+    
+    // The project's bank and learn map stay as the host restored them
+    if (detachedFromLibrary)
+        return;
+    
+    const bool hadBank = previous != nullptr && previous->patches.size() == PatchBank::BANK_SIZE;
+    
+    if (snapshot->patches.size() == PatchBank::BANK_SIZE && !hadBank)
+    {
+        // The first library this instance sees: nothing local to keep
+        patchBank.setPatches(snapshot->patches);
+        bankReplaced();
+    }
+    else if (snapshot->patches.size() == PatchBank::BANK_SIZE)
+    {
+        // Only the slots another instance changed, and not over an edit made here and not published yet
+        const PatchBank::ScopedTransaction transaction(patchBank);
+        
+        for (int slot = 0; slot < PatchBank::BANK_SIZE; ++slot)
         {
-            midiLearnManager.fromVar(learnVar);
+            const auto& theirs = snapshot->patches.getReference(slot);
+            const auto& seen = previous->patches.getReference(slot);
+            
+            if (PatchDelta::isSame(theirs, seen) || !PatchDelta::isSame(patchBank.getPatch(slot), seen))
+                continue;
+            
+            patchBank.setPatch(slot, theirs);
+            patchContentChanged(slot);
+            
+            if (slot == coalescingSlot)
+                coalescingSlot = -1; // Don't fold the next local edit into one made before this snapshot
         }
     }
+    
+    // MIDI learn mappings, if they changed
+    if (!snapshot->midiLearn.isVoid()
+        && (previous == nullptr || juce::JSON::toString(snapshot->midiLearn) != juce::JSON::toString(previous->midiLearn)))
+        midiLearnManager.fromVar(snapshot->midiLearn);
 }
 
-void PatchManager::exportPatches(const juce::File& file)
+void PatchManager::writeState(juce::MemoryBlock& dest) const
 {
-    persistenceManager.exportToFile(patchBank, file);
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::writeState");
+    
+    const auto revision = patchBank.getRevision();
+    
+    // A host thread can save before the message thread has applied the loaded library:
+    // save the library's bank then, and leave this instance's bank alone
+    const auto snapshot = library->getSnapshot();
+    const bool fromLibrary = !ready && !detachedFromLibrary && snapshot->patches.size() == PatchBank::BANK_SIZE;
+    
+    PluginStateChunk chunk;
+    chunk.addSection(PluginStateChunk::BANK_SECTION, fromLibrary ? serializeBank(snapshot->patches) : serializeBank());
+    chunk.addSection(PluginStateChunk::DEVICE_SECTION, serializeDeviceConfig());
+    chunk.writeTo(dest);
+    
+    if (!fromLibrary)
+        rememberBankSectionHash(chunk.getSection(PluginStateChunk::BANK_SECTION)->hash, revision);
 }
 
-void PatchManager::importPatches(const juce::File& file)
+void PatchManager::restoreState(const void* data, int sizeInBytes)
 {
-    persistenceManager.importFromFile(patchBank, file);
-    saveAll(); // Save imported data
-    sendChangeMessage();
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::restoreState");
+    
+    // Host state replaces the library bank, so the library must not arrive after it
+    waitUntilReady();
+    
+    // The host owns this state; applying it must not rewrite the shared data files
+    const juce::ScopedValueSetter<bool> suspend(persistenceSuspended, true);
+    
+    if (!PluginStateChunk::isChunk(data, (size_t)sizeInBytes))
+    {
+        restoreLegacyState(juce::JSON::parse(juce::String::fromUTF8(static_cast<const char*>(data), sizeInBytes)));
+        return;
+    }
+    
+    PluginStateChunk chunk;
+    auto result = chunk.read(data, (size_t)sizeInBytes);
+    
+    if (result.failed())
+    {
+        juce::Logger::writeToLog("Failed to restore plugin state: " + result.getErrorMessage());
+        return;
+    }
+    
+    bool changed = false;
+    
+    // Sections that hash the same as the current state are already applied
+    const auto* bank = chunk.getSection(PluginStateChunk::BANK_SECTION);
+    
+    // The project owns its bank from here on (see the class notes)
+    if (bank != nullptr)
+        detachedFromLibrary = true;
+    
+    if (bank != nullptr && bank->hash != getBankSectionHash())
+    {
+        juce::MemoryInputStream stream(bank->data, false);
+        if (patchBank.readFromStream(stream))
+        {
+            bankReplaced();
+            rememberBankSectionHash(bank->hash, patchBank.getRevision());
+            changed = true;
+        }
+    }
+    
+    const auto* device = chunk.getSection(PluginStateChunk::DEVICE_SECTION);
+    if (device != nullptr && device->hash != PluginStateChunk::hashPayload(serializeDeviceConfig()))
+    {
+        juce::MemoryInputStream stream(device->data, false);
+        deviceModel.fromVar(juce::var::readFromStream(stream));
+        applyDeviceConfig();
+        changed = true;
+    }
+    
+    if (changed)
+        sendChangeMessage();
 }
 
-void PatchManager::syncMidiManagerWithDeviceModel()
+juce::MemoryBlock PatchManager::serializeBank() const
 {
-    midiManager.setOutputPort(deviceModel.getMidiOutputPortName());
-    midiManager.setMidiChannel(deviceModel.getMidiChannelDisplay());
+    juce::MemoryBlock block;
+    juce::MemoryOutputStream stream(block, false);
+    patchBank.writeToStream(stream);
+    stream.flush();
+    return block;
+}
+
+juce::MemoryBlock PatchManager::serializeBank(const juce::Array<PatchData>& patches)
+{
+    juce::MemoryBlock block;
+    juce::MemoryOutputStream stream(block, false);
+    PatchBank::writeToStream(patches, stream);
+    stream.flush();
+    return block;
+}
+
+juce::uint64 PatchManager::getBankSectionHash() const
+{
+    const auto revision = patchBank.getRevision();
+    
+    {
+        const juce::SpinLock::ScopedLockType sl(bankSectionHashLock);
+        if (bankSectionHashValid && bankSectionRevision == revision)
+            return bankSectionHash;
+    }
+    
+    // Nothing written or applied since the bank last changed: serialize it once
+    const auto hash = PluginStateChunk::hashPayload(serializeBank());
+    rememberBankSectionHash(hash, revision);
+    return hash;
+}
+
+void PatchManager::rememberBankSectionHash(juce::uint64 hash, juce::uint32 revision) const
+{
+    const juce::SpinLock::ScopedLockType sl(bankSectionHashLock);
+    bankSectionHash = hash;
+    bankSectionRevision = revision;
+    bankSectionHashValid = true;
+}
+
+void PatchManager::bankReplaced()
+{
+    patchContentChanged(-1);
+    
+    // The history's deltas and permutations were recorded against the old bank
+    undoManager.clearUndoHistory();
+    coalescingSlot = -1;
+}
+
+juce::MemoryBlock PatchManager::serializeDeviceConfig() const
+{
+    juce::MemoryBlock block;
+    juce::MemoryOutputStream stream(block, false);
+    deviceModel.toVar().writeToStream(stream);
+    stream.flush();
+    return block;
+}
+
+void PatchManager::applyDeviceConfig()
+{
+    // Sync MIDI manager (will handle errors gracefully)
+    auto portName = deviceModel.getMidiOutputPortName();
+    if (portName.isNotEmpty())
+        setMidiOutputPort(portName, deviceModel.getMidiOutputPortIdentifier());
+    
+    setMidiChannel(deviceModel.getMidiChannelDisplay());
+    setDeviceTemplate(deviceModel.getTemplate());
+}
+
+void PatchManager::restoreLegacyState(const juce::var& state)
+{
+    // JSON text written before the binary chunk existed
+    if (auto* obj = state.getDynamicObject())
+    {
+        if (obj->hasProperty("patchBank"))
+        {
+            patchBank.fromVar(obj->getProperty("patchBank"));
+            bankReplaced();
+            detachedFromLibrary = true;
+        }
+        
+        if (obj->hasProperty("deviceConfig"))
+        {
+            deviceModel.fromVar(obj->getProperty("deviceConfig"));
+            applyDeviceConfig();
+        }
+        
+        sendChangeMessage();
+    }
+}
+
+juce::Result PatchManager::exportPatches(const juce::File& file)
+{
+    waitUntilReady();
+    
+    const PatchSysExCodec codec(deviceModel.getTemplate(), deviceModel.getSysExDeviceId());
+    return persistenceManager.exportToFile(patchBank, file, PersistenceManager::getFileFormat(file), &codec);
+}
+
+juce::Result PatchManager::importPatches(const juce::File& file)
+{
+    waitUntilReady(); // Or the library would overwrite the import when it arrives
+    
+    const PatchSysExCodec codec(deviceModel.getTemplate(), deviceModel.getSysExDeviceId());
+    auto result = persistenceManager.importFromFile(patchBank, file, PersistenceManager::getFileFormat(file), &codec);
+    if (result.failed())
+        return result;
+    
+    bankReplaced(); // Re-hashed on the next query, across cores
+    saveAll(); // Save imported data
+    sendChangeMessage();
+    return result;
 }
 
 void PatchManager::changeListenerCallback(juce::ChangeBroadcaster* source)
@@ -264,5 +1139,22 @@ void PatchManager::changeListenerCallback(juce::ChangeBroadcaster* source)
         // Undo manager changed - notify UI to update undo/redo buttons
         sendChangeMessage();
     }
+    else if (source == library.get())
+    {
+        // The startup load finished or another instance published an edit;
+        // device settings stay per instance
+        if (pullLibraryChanges())
+            sendChangeMessage();
+    }
+    else if (source == &templateManager)
+    {
+        // The current device's template file was edited on disk - pick up the new version
+        auto deviceID = deviceModel.getDeviceID();
+        if (templateManager.getLastChangedTemplates().contains(deviceID))
+        {
+            setDeviceTemplate(templateManager.getTemplate(deviceID));
+            sendChangeMessage();
+        }
+    }
 }
 
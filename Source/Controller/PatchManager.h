@@ -4,24 +4,78 @@
 #include "../Model/PatchBank.h"
 #include "../Model/DeviceModel.h"
 #include "MidiManager.h"
-#include "PersistenceManager.h"
-#include "DeviceTemplateManager.h"
+#include "SharedLibrary.h"
 #include "MidiLearnManager.h"
+#include "SysExRequestManager.h"
+#include "ParameterTransmitter.h"
+#include "PatchDeduplicator.h"
+#include "PatchSimilarityIndex.h"
+#include "PluginStateChunk.h"
 #include "UndoableActions.h"
 
+class PatchSysExCodec;
+
 /**
  * Coordinates patch operations, MIDI I/O, and persistence.
  * 
  * This is the main Controller that ties together Model, View, and I/O.
  * It provides a high-level API for patch management operations.
- * Includes undo/redo support for all patch operations.
+ * Includes undo/redo support for all patch operations, recorded as
+ * field-level deltas under a byte budget.
+ * 
+ * Each instance edits its own working copy of the library and publishes it
+ * to the process-wide SharedLibrary on save. Edits published by other
+ * instances are pulled in slot by slot as they arrive: only the slots that
+ * changed since the last snapshot this instance saw are replaced, and a slot
+ * this instance has edited but not yet published keeps its edit. The undo
+ * history stays; steps skip the fields another instance has changed since
+ * (see PatchDelta::applyTo()).
+ * 
+ * An instance whose bank was restored from host state is detached from the
+ * library: the project owns that bank, so library publishes no longer reach
+ * it and its edits are saved with the project instead of published.
+ * 
+ * Startup is staged so constructing an instance (all a host scanning the
+ * plugin does) reads nothing but config.json. beginStartup() loads the rest
+ * in parallel on worker threads: the library and template index (shared,
+ * see SharedLibrary) and this instance's MIDI output port. The library
+ * arrives as a change message; isReady() is true once it is applied, which
+ * only ever happens on the message thread.
  */
 class PatchManager : public juce::ChangeBroadcaster,
                      public juce::ChangeListener
 {
 public:
     PatchManager();
-    ~PatchManager() override = default;
+    ~PatchManager() override;
+    
+    /**
+     * Staged startup. beginStartup() may be called from any thread and more
+     * than once (prepareToPlay(), createEditor()). waitUntilReady() blocks
+     * until the library is loaded; on the message thread it also applies it.
+     * Host state, import/export and saves call it so they never see or
+     * publish the empty bank an instance starts with. Elsewhere (a host
+     * saving state from its own thread) nothing is changed: the library is
+     * applied by the change message, and writeState() saves the library's
+     * bank until then.
+     */
+    void beginStartup();
+    void waitUntilReady();
+    bool isReady() const noexcept { return ready; }
+    
+    /** Startup milestones in milliseconds (-1 = not reached yet). */
+    struct StartupTimings
+    {
+        double constructionMs = -1.0;       // The constructor: what a scanning host pays for
+        double libraryMs = -1.0;            // beginStartup() to the library being applied
+        double portsMs = -1.0;              // beginStartup() to the MIDI output port being open
+        double timeToInteractiveMs = -1.0;  // Editor opened to the patch list showing the library
+        
+        juce::var toVar() const;
+    };
+    
+    StartupTimings getStartupTimings() const;
+    void setTimeToInteractive(double milliseconds); // Reported by the editor
     
     // Access to models
     PatchBank& getPatchBank() noexcept { return patchBank; }
@@ -32,6 +86,8 @@ public:
     PersistenceManager& getPersistenceManager() noexcept { return persistenceManager; }
     DeviceTemplateManager& getTemplateManager() noexcept { return templateManager; }
     MidiLearnManager& getMidiLearnManager() noexcept { return midiLearnManager; }
+    SysExRequestManager& getSysExRequestManager() noexcept { return sysExRequestManager; }
+    ParameterTransmitter& getParameterTransmitter() noexcept { return parameterTransmitter; }
     juce::UndoManager& getUndoManager() noexcept { return undoManager; }
     
     // Patch operations (with undo support)
@@ -43,6 +99,57 @@ public:
                            const juce::String& baseName);
     void clearPatchRange(int startSlot, int endSlot);
     
+    // Batch operations: each is one undo step, one bank change message and one save
+    void retagPatches(const juce::Array<int>& slotIndices, const juce::StringArray& tagsToAdd,
+                      const juce::StringArray& tagsToRemove);
+    
+    /**
+     * Reordering. Each operation is applied as one slot permutation and
+     * recorded as the list of moved slots. If the device protocol can write
+     * patches, the device is updated (on apply, undo and redo) with one
+     * dataSet per slot whose stored dump differs from what the slot held
+     * before; slots that only moved onto an identical sound aren't written.
+     * The writes are queued together or not at all, so a full output queue
+     * never leaves the device half reordered.
+     */
+    enum class SortKey
+    {
+        name,   // Natural order ("Pad 2" before "Pad 10")
+        tag     // By first tag (untagged last), then by name
+    };
+    
+    void movePatchRange(int startSlot, int numSlots, int destSlot); // destSlot = new start of the range
+    void swapPatchRanges(int firstStart, int secondStart, int numSlots); // Ranges must not overlap
+    void sortPatches(SortKey key, int startSlot = 0, int endSlot = PatchBank::BANK_SIZE - 1);
+    void moveFavoritesToFront(int startSlot = 0, int endSlot = PatchBank::BANK_SIZE - 1); // Keeps relative order
+    
+    /**
+     * The device writes for a reorder, as a raw F0..F7 stream in slot order
+     * (every block of each moved patch, so no slot is left half written).
+     * bank holds the slots after the reorder; order[i] is the slot the patch
+     * now in slot i came from. Moved slots whose dump the codec can't write
+     * are counted in numUnwritable.
+     */
+    static juce::MemoryBlock createReorderWrites(const PatchBank& bank, const juce::Array<int>& order,
+                                                 const PatchSysExCodec& codec, int& numUnwritable);
+    
+    /**
+     * Stores a parameter value in a patch and, if it is the patch last recalled,
+     * queues it for the device via the ParameterTransmitter.
+     * 
+     * Not undoable and not saved per call, so knob sweeps stay cheap: call
+     * endParameterEdit() when the gesture ends (e.g. on mouse up).
+     */
+    juce::Result setPatchParameter(int slotIndex, const juce::String& parameterId, int value);
+    void endParameterEdit();
+    
+    // Duplicate detection (content hash of dump + parameters; names and tags ignored)
+    juce::Array<PatchDeduplicator::DuplicateGroup> findDuplicatePatches();
+    PatchDeduplicator::MergeReport mergeDuplicatePatches(); // Undoable
+    
+    // Similar-sound search over the template's parameters (closest first, slot itself excluded)
+    juce::Array<PatchSimilarityIndex::Match> findSimilarPatches(int slotIndex, int maxResults = 10);
+    
     // Undo/Redo
     void undo();
     void redo();
@@ -52,30 +159,106 @@ public:
     juce::String getRedoDescription() const;
     
     // Device operations
-    void setMidiOutputPort(const juce::String& portName);
+    void setMidiOutputPort(const juce::String& portName, const juce::String& identifier = {});
     void setMidiChannel(int channel); // 1-16
+    void setDeviceTemplate(const DeviceTemplate& template_);
+    void setSysExDeviceId(int deviceId); // 0-127, or -1 for the protocol's default
+    
+    /**
+     * Reads patch names from the device and renames the local slots to match.
+     * 
+     * Requests are pipelined through SysExRequestManager. When all replies are in
+     * (or failed), changed names are applied as one undoable batch rename.
+     * 
+     * @return Failure immediately if the current device has no readback protocol
+     */
+    juce::Result syncPatchNamesFromDevice(std::function<void(int numRenamed, int numFailed)> onComplete = nullptr);
     
     // Persistence
-    void saveAll();
+    void saveAll();             // Publishes the bank, MIDI learn and device settings
+    void saveDeviceConfig();    // Publishes the device settings alone
     void loadAll();
+    bool isDetachedFromLibrary() const noexcept { return detachedFromLibrary; }
     
-    // Export/Import
-    void exportPatches(const juce::File& file);
-    void importPatches(const juce::File& file);
+    /**
+     * Host project state (AudioProcessor get/setStateInformation).
+     * 
+     * Written as a PluginStateChunk. Restoring skips any section whose hash
+     * matches the current state, never writes the data files, and still
+     * accepts the JSON text saved by earlier versions. Restoring a bank
+     * detaches the instance from the shared library (see the class notes).
+     */
+    void writeState(juce::MemoryBlock& dest) const;
+    void restoreState(const void* data, int sizeInBytes);
+    
+    // Export/Import, in the format the file's extension names (see PersistenceManager::FileFormat;
+    // .syx uses the current device template)
+    juce::Result exportPatches(const juce::File& file);
+    juce::Result importPatches(const juce::File& file);
     
     // ChangeListener (for undo manager)
     void changeListenerCallback(juce::ChangeBroadcaster* source) override;
     
 private:
+    juce::SharedResourcePointer<SharedLibrary> library;
+    SharedLibrary::SnapshotPtr librarySnapshot; // As last applied or published
+    bool detachedFromLibrary = false;
     PatchBank patchBank;
     DeviceModel deviceModel;
     MidiManager midiManager;
-    PersistenceManager persistenceManager;
-    DeviceTemplateManager templateManager;
+    PersistenceManager& persistenceManager { library->getPersistenceManager() };
+    DeviceTemplateManager& templateManager { library->getTemplateManager() };
     MidiLearnManager midiLearnManager;
-    juce::UndoManager undoManager;
+    SysExRequestManager sysExRequestManager { midiManager };
+    ParameterTransmitter parameterTransmitter { midiManager };
+    PatchDeduplicator deduplicator;
+    PatchSimilarityIndex similarityIndex;
+    bool similarityIndexValid = false;
+    
+    // Undo history is limited by bytes (PatchEditAction sizes are in bytes), keeping a minimum number of steps
+    static constexpr int UNDO_BUDGET_BYTES = 2 * 1024 * 1024;
+    static constexpr int MIN_UNDO_STEPS = 30;
+    static constexpr juce::uint32 COALESCE_WINDOW_MS = 2000; // Gap that ends a run of same-slot edits
+    juce::UndoManager undoManager { UNDO_BUDGET_BYTES, MIN_UNDO_STEPS };
+    int coalescingSlot = -1;
+    juce::String coalescingName;
+    juce::uint32 lastEditTime = 0;
+    int lastRecalledSlot = -1;
+    bool persistenceSuspended = false; // Set while the host restores state
+    
+    // Bank section hash as last written or applied, valid while the bank is at that revision
+    mutable juce::SpinLock bankSectionHashLock;
+    mutable juce::uint64 bankSectionHash = 0;
+    mutable juce::uint32 bankSectionRevision = 0;
+    mutable bool bankSectionHashValid = false;
+    
+    // Startup (see beginStartup())
+    std::atomic<bool> startupBegan { false };
+    std::atomic<bool> ready { false }; // Set on the message thread only
+    std::unique_ptr<juce::ThreadPool> startupPool; // Opens the MIDI port
+    juce::int64 constructionTicks = 0;
+    std::atomic<juce::int64> startupBeganTicks { 0 };
+    std::atomic<juce::int64> portsOpenedTicks { 0 };
+    StartupTimings timings;
     
-    void syncMidiManagerWithDeviceModel();
+    void transmitStoredParameters(int slotIndex);
+    void updateDeduplicatorRanges();
+    void patchContentChanged(int slotIndex); // -1 = all slots
+    void bankReplaced(); // Whole bank loaded from elsewhere: also drops the undo history
+    bool performPatchEdit(const juce::String& name, const juce::Array<int>& slots,
+                          const juce::Array<PatchData>& newPatches, bool coalesce = false);
+    bool reorderPatches(const juce::String& name, const juce::Array<int>& order); // order[newSlot] = oldSlot
+    void patchesReordered(const juce::Array<int>& order);
+    void writeReorderToDevice(const juce::Array<int>& order);
+    juce::MemoryBlock serializeBank() const;
+    static juce::MemoryBlock serializeBank(const juce::Array<PatchData>& patches);
+    juce::uint64 getBankSectionHash() const;
+    void rememberBankSectionHash(juce::uint64 hash, juce::uint32 revision) const;
+    juce::MemoryBlock serializeDeviceConfig() const;
+    void applyDeviceConfig();
+    void restoreLegacyState(const juce::var& state);
+    void applyLibrarySnapshot(const SharedLibrary::SnapshotPtr& snapshot);
+    bool pullLibraryChanges(); // Applies a snapshot not seen yet; returns true if there was one
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PatchManager)
 };
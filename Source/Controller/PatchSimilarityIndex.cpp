@@ -0,0 +1,243 @@
+#include "PatchSimilarityIndex.h"
+#include <numeric>
+
+void PatchSimilarityIndex::rebuild(ParameterMap::Ptr newParameterMap, const juce::Array<PatchData>& patches)
+{
+    clear();
+    
+    parameterMap = std::move(newParameterMap);
+    if (parameterMap == nullptr || parameterMap->size() == 0 || patches.isEmpty())
+        return;
+    
+    numPatches = patches.size();
+    numParameters = parameterMap->size();
+    columnStride = (numPatches + 3) & ~3;
+    
+    matrix.allocate((size_t)numParameters * (size_t)columnStride, true);
+    weights.allocate((size_t)numParameters, false);
+    hasSoundData.allocate((size_t)numPatches, true);
+    
+    // Intern the IDs once rather than per lookup
+    juce::Array<juce::Identifier> ids;
+    for (int p = 0; p < numParameters; ++p)
+    {
+        ids.add(parameterMap->getParameter(p).id);
+        weights[p] = parameterMap->getParameter(p).weight;
+    }
+    
+    for (int i = 0; i < numPatches; ++i)
+    {
+        const auto& values = patches.getReference(i).getParameterValues();
+        hasSoundData[i] = !values.isEmpty();
+        
+        for (int p = 0; p < numParameters; ++p)
+        {
+            const auto& parameter = parameterMap->getParameter(p);
+            const auto* value = values.getVarPointer(ids.getReference(p));
+            matrix[(size_t)p * (size_t)columnStride + (size_t)i] = parameter.normalize(value != nullptr ? (int)*value
+                                                                                                       : parameter.defaultValue);
+        }
+    }
+}
+
+void PatchSimilarityIndex::clear()
+{
+    parameterMap = nullptr;
+    numPatches = 0;
+    numParameters = 0;
+    columnStride = 0;
+    matrix.free();
+    weights.free();
+    hasSoundData.free();
+}
+
+juce::Array<PatchSimilarityIndex::Match> PatchSimilarityIndex::findSimilar(int patchIndex, int k) const
+{
+    if (patchIndex < 0 || patchIndex >= numPatches)
+        return {};
+    
+    juce::HeapBlock<float> query((size_t)numParameters);
+    for (int p = 0; p < numParameters; ++p)
+        query[p] = getColumn(p)[patchIndex];
+    
+    return findSimilar(query.get(), k, patchIndex);
+}
+
+juce::Array<PatchSimilarityIndex::Match> PatchSimilarityIndex::findSimilar(const float* normalizedQuery, int k,
+                                                                         int excludeIndex) const
+{
+    if (numPatches == 0 || k <= 0)
+        return {};
+    
+    juce::HeapBlock<float> distances((size_t)columnStride, true);
+    juce::HeapBlock<float> difference((size_t)columnStride);
+    
+    for (int p = 0; p < numParameters; ++p)
+    {
+        if (weights[p] <= 0.0f)
+            continue;
+        
+        // difference = column - q; difference *= difference; distances += w * difference
+        juce::FloatVectorOperations::add(difference.get(), getColumn(p), -normalizedQuery[p], numPatches);
+        juce::FloatVectorOperations::multiply(difference.get(), difference.get(), numPatches);
+        juce::FloatVectorOperations::addWithMultiply(distances.get(), difference.get(), weights[p], numPatches);
+    }
+    
+    const float excluded = std::numeric_limits<float>::max();
+    for (int i = 0; i < numPatches; ++i)
+        if (!hasSoundData[i])
+            distances[i] = excluded;
+    
+    if (excludeIndex >= 0 && excludeIndex < numPatches)
+        distances[excludeIndex] = excluded;
+    
+    auto matches = selectTopK(distances.get(), numPatches, k);
+    matches.removeIf([excluded](const Match& m) { return m.distance >= excluded; });
+    return matches;
+}
+
+juce::Array<PatchSimilarityIndex::Match> PatchSimilarityIndex::findSimilarScalar(const ParameterMap& parameterMap,
+                                                                               const juce::Array<PatchData>& patches,
+                                                                               const PatchData& query, int k,
+                                                                               int excludeIndex)
+{
+    const float excluded = std::numeric_limits<float>::max();
+    std::vector<float> distances((size_t)patches.size(), excluded);
+    
+    for (int i = 0; i < patches.size(); ++i)
+    {
+        const auto& patch = patches.getReference(i);
+        if (i == excludeIndex || patch.getParameterValues().isEmpty())
+            continue;
+        
+        float distance = 0.0f;
+        for (int p = 0; p < parameterMap.size(); ++p)
+        {
+            const auto& parameter = parameterMap.getParameter(p);
+            const float a = parameter.normalize(patch.getParameterValue(parameter.id, parameter.defaultValue));
+            const float b = parameter.normalize(query.getParameterValue(parameter.id, parameter.defaultValue));
+            distance += parameter.weight * (a - b) * (a - b);
+        }
+        
+        distances[(size_t)i] = distance;
+    }
+    
+    auto matches = selectTopK(distances.data(), patches.size(), k);
+    matches.removeIf([excluded](const Match& m) { return m.distance >= excluded; });
+    return matches;
+}
+
+juce::Array<PatchSimilarityIndex::Match> PatchSimilarityIndex::selectTopK(const float* distances, int count, int k)
+{
+    k = juce::jmin(k, count);
+    
+    if (k <= 0)
+        return {}; // Empty library (or k <= 0): nth_element would be given begin() - 1
+    
+    std::vector<int> order((size_t)count);
+    std::iota(order.begin(), order.end(), 0);
+    
+    // Ties broken by index so both search paths agree
+    const auto closer = [distances](int a, int b)
+    {
+        return distances[a] < distances[b] || (distances[a] == distances[b] && a < b);
+    };
+    
+    std::nth_element(order.begin(), order.begin() + (k - 1), order.end(), closer);
+    std::sort(order.begin(), order.begin() + k, closer);
+    
+    juce::Array<Match> matches;
+    matches.ensureStorageAllocated(k);
+    for (int i = 0; i < k; ++i)
+        matches.add({ order[(size_t)i], distances[order[(size_t)i]] });
+    
+    return matches;
+}
+
+juce::var PatchSimilarityIndex::benchmark(int numPatches, int numParameters, int k, int iterations)
+{
+    numPatches = juce::jmax(1, numPatches);
+    numParameters = juce::jmax(1, numParameters);
+    iterations = juce::jmax(1, iterations);
+    
+    // Synthetic parameter map and library
+    juce::Array<juce::var> description;
+    for (int p = 0; p < numParameters; ++p)
+    {
+        juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+        obj->setProperty("id", "p" + juce::String(p));
+        obj->setProperty("cc", p % 128);
+        obj->setProperty("weight", 0.5 + (p % 4) * 0.25);
+        description.add(juce::var(obj.get()));
+    }
+    
+    ParameterMap::Ptr map;
+    auto result = ParameterMap::compile(juce::var(description), map);
+    if (result.failed())
+    {
+        juce::DynamicObject::Ptr failure = new juce::DynamicObject();
+        failure->setProperty("error", result.getErrorMessage());
+        return juce::var(failure.get());
+    }
+    
+    juce::Random random(0x5eed);
+    juce::Array<PatchData> patches;
+    patches.ensureStorageAllocated(numPatches);
+    
+    for (int i = 0; i < numPatches; ++i)
+    {
+        PatchData patch(i, "Patch " + juce::String(i), "generic");
+        for (int p = 0; p < numParameters; ++p)
+            patch.setParameterValue(map->getParameter(p).id, random.nextInt(128));
+        patches.add(patch);
+    }
+    
+    // Build
+    PatchSimilarityIndex index;
+    const double buildStart = juce::Time::getMillisecondCounterHiRes();
+    index.rebuild(map, patches);
+    const double buildMs = juce::Time::getMillisecondCounterHiRes() - buildStart;
+    
+    // Queries: same query patches for both paths
+    double scalarMs = 0.0, simdMs = 0.0;
+    int mismatches = 0;
+    
+    for (int n = 0; n < iterations; ++n)
+    {
+        const int queryIndex = random.nextInt(numPatches);
+        
+        const double scalarStart = juce::Time::getMillisecondCounterHiRes();
+        auto scalar = findSimilarScalar(*map, patches, patches.getReference(queryIndex), k, queryIndex);
+        scalarMs += juce::Time::getMillisecondCounterHiRes() - scalarStart;
+        
+        const double simdStart = juce::Time::getMillisecondCounterHiRes();
+        auto simd = index.findSimilar(queryIndex, k);
+        simdMs += juce::Time::getMillisecondCounterHiRes() - simdStart;
+        
+        // Float sums in a different order can swap near-ties, so compare the sets
+        for (const auto& match : simd)
+        {
+            bool found = false;
+            for (const auto& other : scalar)
+                found = found || other.patchIndex == match.patchIndex;
+            if (!found)
+                ++mismatches;
+        }
+    }
+    
+    scalarMs /= iterations;
+    simdMs /= iterations;
+    
+    juce::DynamicObject::Ptr report = new juce::DynamicObject();
+    report->setProperty("patches", numPatches);
+    report->setProperty("parameters", numParameters);
+    report->setProperty("k", k);
+    report->setProperty("queries", iterations);
+    report->setProperty("unit", "ms");
+    report->setProperty("build", buildMs);
+    report->setProperty("scalar", scalarMs);
+    report->setProperty("simd", simdMs);
+    report->setProperty("speedup", simdMs > 0.0 ? scalarMs / simdMs : 0.0);
+    report->setProperty("topKMismatches", mismatches);
+    return juce::var(report.get());
+}
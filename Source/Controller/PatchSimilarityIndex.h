@@ -0,0 +1,83 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "../Model/ParameterMap.h"
+#include "../Model/PatchData.h"
+#include <vector>
+
+/**
+ * "Find sounds like this": nearest patches by weighted parameter distance.
+ * 
+ * rebuild() flattens the library into a struct-of-arrays matrix of
+ * normalized (0..1) parameter values: one contiguous float column per
+ * parameter, one row per patch. Parameters a patch never set take the
+ * parameter's default. A query then walks the matrix column by column with
+ * juce::FloatVectorOperations (SIMD on every platform JUCE supports):
+ * 
+ *     distance[i] += weight[p] * (column[p][i] - query[p])^2
+ * 
+ * and selects the top k with nth_element, so a query over 100k patches
+ * touches each value once with no per-patch lookups or var conversions.
+ * 
+ * findSimilarScalar() is the straightforward walk over PatchData and
+ * juce::var values, kept as the reference for benchmark(). PatchManager
+ * answers findSimilarPatches() from one, which the command line's
+ * "search --like=SLOT" uses.
+ * 
+ * THREADING:
+ * - rebuild() on the message thread; queries are const and may run anywhere
+ */
+class PatchSimilarityIndex
+{
+public:
+    struct Match
+    {
+        int patchIndex = -1;
+        float distance = 0.0f;
+    };
+    
+    PatchSimilarityIndex() = default;
+    ~PatchSimilarityIndex() = default;
+    
+    void rebuild(ParameterMap::Ptr parameterMap, const juce::Array<PatchData>& patches);
+    void clear();
+    
+    int getNumPatches() const noexcept { return numPatches; }
+    int getNumParameters() const noexcept { return numParameters; }
+    
+    /** Nearest k patches to an indexed patch (excluding itself), closest first. */
+    juce::Array<Match> findSimilar(int patchIndex, int k) const;
+    
+    /** Nearest k patches to a normalized query vector of getNumParameters() values. */
+    juce::Array<Match> findSimilar(const float* normalizedQuery, int k, int excludeIndex = -1) const;
+    
+    /** Reference implementation: walks each patch's juce::var parameter values. */
+    static juce::Array<Match> findSimilarScalar(const ParameterMap& parameterMap,
+                                                const juce::Array<PatchData>& patches,
+                                                const PatchData& query, int k, int excludeIndex = -1);
+    
+    /**
+     * Times the scalar and SIMD paths on a synthetic library (BenchmarkSuite's
+     * "similarity" entry). Milliseconds per query, as a JSON-ready var.
+     * 
+     * Patches get random values for every parameter; both paths must return the
+     * same top-k, which topKMismatches confirms.
+     */
+    static juce::var benchmark(int numPatches = 100000, int numParameters = 64, int k = 10, int iterations = 20);
+    
+private:
+    ParameterMap::Ptr parameterMap;
+    int numPatches = 0;
+    int numParameters = 0;
+    int columnStride = 0;               // Rounded up so each column starts 16-byte aligned
+    
+    juce::HeapBlock<float> matrix;      // numParameters columns of columnStride floats
+    juce::HeapBlock<float> weights;
+    juce::HeapBlock<bool> hasSoundData; // Placeholder patches never match
+    
+    const float* getColumn(int parameter) const noexcept { return matrix.get() + (size_t)parameter * (size_t)columnStride; }
+    
+    static juce::Array<Match> selectTopK(const float* distances, int count, int k);
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PatchSimilarityIndex)
+};
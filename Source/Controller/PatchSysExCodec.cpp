@@ -0,0 +1,268 @@
+#include "PatchSysExCodec.h"
+#include <map>
+
+namespace
+{
+    /** Request/reply pairs for protocols that dump the current program. */
+    struct ProgramDump
+    {
+        const char* request;
+        const char* reply;
+    };
+    
+    constexpr ProgramDump programDumps[] =
+    {
+        { "voiceDumpRequest", "voiceDump" },        // Yamaha DX7 VCED
+        { "programDumpRequest", "programDump" }     // Korg M1
+    };
+}
+
+PatchSysExCodec::PatchSysExCodec(const DeviceTemplate& device_, int deviceId_)
+    : device(device_),
+      protocol(device_.getSysExProtocol()),
+      deviceId(deviceId_ >= 0 ? deviceId_ : (protocol != nullptr ? protocol->getDefaultDeviceId() : 0))
+{
+    if (protocol == nullptr)
+        return;
+    
+    const auto& nonSound = protocol->getNonSoundRanges();
+    
+    if (protocol->canReadPatchNames())
+    {
+        const auto* patchMap = protocol->getAddressMap(SysExProtocol::PATCH_DATA);
+        namesOnly = patchMap == nullptr || patchMap->length <= 0;
+        
+        mode = Mode::addressed;
+        map = namesOnly ? *protocol->getAddressMap(SysExProtocol::PATCH_NAME) : *patchMap;
+        requestFormat = protocol->getFormat(SysExProtocol::DATA_REQUEST);
+        replyFormat = protocol->getFormat(SysExProtocol::DATA_SET);
+        writeFormat = replyFormat;
+        nameRange = namesOnly || nonSound.isEmpty() ? juce::Range<int>(0, map.length) : nonSound.getFirst();
+        return;
+    }
+    
+    for (const auto& dump : programDumps)
+    {
+        requestFormat = protocol->getFormat(dump.request);
+        replyFormat = protocol->getFormat(dump.reply);
+        
+        if (requestFormat != nullptr && replyFormat != nullptr)
+        {
+            mode = Mode::perProgram;
+            writeFormat = replyFormat;
+            nameRange = nonSound.isEmpty() ? juce::Range<int>() : nonSound.getFirst();
+            return;
+        }
+    }
+    
+    requestFormat = replyFormat = nullptr;
+}
+
+juce::MemoryBlock PatchSysExCodec::createRequest(int slot, int block) const
+{
+    if (mode == Mode::none || !device.isValidPatchNumber(slot) || !juce::isPositiveAndBelow(block, getNumBlocks()))
+        return {};
+    
+    SysExMessageFormat::Fields fields;
+    fields.deviceId = deviceId;
+    
+    if (mode == Mode::addressed)
+    {
+        fields.address = map.getAddress(slot, block);
+        fields.size = (juce::uint32)map.getBlock(block).length;
+    }
+    
+    return requestFormat->encode(fields);
+}
+
+juce::uint32 PatchSysExCodec::getReplyAddress(int slot, int block) const noexcept
+{
+    return mode == Mode::addressed ? map.getAddress(slot, block) : 0;
+}
+
+juce::Array<juce::MemoryBlock> PatchSysExCodec::createWrites(int slot, const juce::MemoryBlock& dump) const
+{
+    if (!canWrite() || !device.isValidPatchNumber(slot) || dump.isEmpty())
+        return {};
+    
+    const auto* bytes = static_cast<const juce::uint8*>(dump.getData());
+    SysExMessageFormat::Fields fields;
+    fields.deviceId = deviceId;
+    
+    if (mode == Mode::perProgram)
+        return { writeFormat->encode(fields, bytes, (int)dump.getSize()) };
+    
+    // A dump of another size belongs to another device or layout
+    if ((int)dump.getSize() != map.length)
+        return {};
+    
+    juce::Array<juce::MemoryBlock> writes;
+    
+    for (int block = 0; block < map.getNumBlocks(); ++block)
+    {
+        const int length = map.getBlock(block).length;
+        fields.address = map.getAddress(slot, block);
+        fields.size = (juce::uint32)length;
+        writes.add(writeFormat->encode(fields, bytes + map.getBlockStart(block), length));
+    }
+    
+    return writes;
+}
+
+bool PatchSysExCodec::parseReply(const juce::uint8* body, int size, int requestedSlot, Reply& reply) const
+{
+    SysExMessageFormat::Decoded decoded;
+    
+    if (replyFormat == nullptr || !replyFormat->decode(body, size, decoded))
+        return false;
+    
+    if (decoded.deviceId >= 0 && decoded.deviceId != deviceId)
+        return false;
+    
+    reply.block = 0;
+    reply.slot = mode == Mode::addressed ? getSlotForAddress(decoded.address, reply.block) : requestedSlot;
+    reply.payload = std::move(decoded.data);
+    reply.checksumValid = decoded.checksumValid;
+    return reply.slot >= 0;
+}
+
+void PatchSysExCodec::storeBlock(juce::MemoryBlock& dump, int block, const juce::MemoryBlock& payload) const
+{
+    if (getNumBlocks() == 1)
+    {
+        dump = payload;
+        return;
+    }
+    
+    if (!juce::isPositiveAndBelow(block, getNumBlocks()))
+        return;
+    
+    if ((int)dump.getSize() != map.length)
+        dump.setSize((size_t)map.length, true);
+    
+    const int length = juce::jmin(map.getBlock(block).length, (int)payload.getSize());
+    dump.copyFrom(payload.getData(), map.getBlockStart(block), (size_t)length);
+}
+
+void PatchSysExCodec::applyReply(PatchData& patch, const juce::MemoryBlock& payload) const
+{
+    const auto range = nameRange.getIntersectionWith({ 0, (int)payload.getSize() });
+    
+    if (!range.isEmpty())
+        patch.setPatchName(juce::String::fromUTF8(static_cast<const char*>(payload.getData()) + range.getStart(),
+                                                  range.getLength()).trimEnd());
+    
+    if (!namesOnly)
+        patch.setPatchDump(payload);
+    
+    patch.setDeviceID(device.getDeviceID());
+}
+
+int PatchSysExCodec::writeSysEx(const PatchBank& bank, juce::OutputStream& stream) const
+{
+    int numWritten = 0;
+    
+    for (int slot = device.getMinPatchNumber(); slot <= device.getMaxPatchNumber(); ++slot)
+    {
+        const auto& patch = bank.getPatch(slot);
+        if (!patch.hasPatchDump())
+            continue;
+        
+        const auto writes = createWrites(slot, patch.getPatchDump());
+        if (writes.isEmpty())
+            continue;
+        
+        for (const auto& body : writes)
+        {
+            stream.writeByte((char)0xf0);
+            stream.write(body.getData(), body.getSize());
+            stream.writeByte((char)0xf7);
+        }
+        
+        ++numWritten;
+    }
+    
+    return numWritten;
+}
+
+juce::Result PatchSysExCodec::readSysEx(const juce::MemoryBlock& data, PatchBank& bank, int& numPatchesRead) const
+{
+    numPatchesRead = 0;
+    
+    if (replyFormat == nullptr)
+        return juce::Result::fail("No patch dump format for " + device.getDeviceName());
+    
+    const auto* bytes = static_cast<const juce::uint8*>(data.getData());
+    const int size = (int)data.getSize();
+    int nextProgramSlot = device.getMinPatchNumber(); // Per-program dumps are stored in order
+    int numOtherMessages = 0;
+    
+    // A slot is stored once all of its blocks are in, in whatever order they come
+    struct PartialDump
+    {
+        juce::MemoryBlock dump;
+        juce::BigInteger blocksRead;
+    };
+    
+    std::map<int, PartialDump> partialDumps;
+    
+    const PatchBank::ScopedTransaction transaction(bank);
+    
+    for (int i = 0; i < size; ++i)
+    {
+        if (bytes[i] != 0xf0)
+            continue;
+        
+        int end = i + 1;
+        while (end < size && bytes[end] != 0xf7)
+            ++end;
+        
+        if (end >= size)
+            break;
+        
+        Reply reply;
+        
+        if (parseReply(bytes + i + 1, end - i - 1, nextProgramSlot, reply) && reply.checksumValid
+            && bank.isValidSlot(reply.slot))
+        {
+            auto& partial = partialDumps[reply.slot];
+            storeBlock(partial.dump, reply.block, reply.payload);
+            partial.blocksRead.setBit(reply.block);
+            
+            if (partial.blocksRead.countNumberOfSetBits() == getNumBlocks())
+            {
+                auto patch = bank.getPatch(reply.slot);
+                applyReply(patch, partial.dump);
+                bank.setPatch(reply.slot, patch);
+                partialDumps.erase(reply.slot);
+                ++numPatchesRead;
+            }
+            
+            if (mode == Mode::perProgram)
+                ++nextProgramSlot;
+        }
+        else
+        {
+            ++numOtherMessages;
+        }
+        
+        i = end;
+    }
+    
+    if (numPatchesRead == 0)
+    {
+        auto detail = juce::String(numOtherMessages) + " other messages";
+        if (!partialDumps.empty())
+            detail << ", " << (int)partialDumps.size() << " patches missing blocks";
+        
+        return juce::Result::fail("No " + device.getDeviceName() + " patch dumps found (" + detail + ")");
+    }
+    
+    return juce::Result::ok();
+}
+
+int PatchSysExCodec::getSlotForAddress(juce::uint32 address, int& block) const noexcept
+{
+    const int slot = map.getSlot(address, block);
+    return device.isValidPatchNumber(slot) ? slot : -1;
+}
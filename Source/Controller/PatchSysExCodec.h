@@ -0,0 +1,95 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "../Model/DeviceTemplate.h"
+#include "../Model/PatchBank.h"
+
+/**
+ * Turns a device template's SysEx protocol into per-slot patch transfers.
+ * 
+ * Two kinds of protocol are understood:
+ * - addressed (Roland style): "dataRequest"/"dataSet" at the "patch" map's
+ *   address for each slot, one pair per block of the map; a slot's dump is
+ *   its blocks in map order. Without a "patch" map the "patchName" map is
+ *   used, which reads names only
+ * - per program (Yamaha, Korg style): select the slot with a program
+ *   change, then "voiceDumpRequest"/"voiceDump" or
+ *   "programDumpRequest"/"programDump" for the current program
+ * 
+ * A patch's name is taken from the first "ignoreForComparison" range of its
+ * dump (the whole payload for a name-only read), as the plugin shows it.
+ * 
+ * .syx files hold the write messages of each stored dump: a dataSet per
+ * block for addressed protocols, a program dump in slot order for
+ * per-program ones. Slots missing a block are not read back.
+ * 
+ * Immutable after construction, so one codec may be used from any thread.
+ * All message bodies exclude the F0/F7 framing bytes.
+ */
+class PatchSysExCodec
+{
+public:
+    enum class Mode
+    {
+        none,           // The protocol can't transfer patches
+        addressed,
+        perProgram
+    };
+    
+    struct Reply
+    {
+        int slot = -1;
+        int block = 0;
+        juce::MemoryBlock payload;
+        bool checksumValid = true;
+    };
+    
+    explicit PatchSysExCodec(const DeviceTemplate& device, int deviceId = -1); // -1: the protocol's default
+    
+    Mode getMode() const noexcept { return mode; }
+    bool canRead() const noexcept { return mode != Mode::none; }
+    bool canWrite() const noexcept { return writeFormat != nullptr && (mode == Mode::perProgram || !namesOnly); }
+    bool readsNamesOnly() const noexcept { return namesOnly; }
+    bool needsProgramChange() const noexcept { return mode == Mode::perProgram; } // Before each request and write
+    int getDeviceId() const noexcept { return deviceId; }
+    int getNumBlocks() const noexcept { return mode == Mode::addressed ? map.getNumBlocks() : 1; } // Messages per patch
+    const DeviceTemplate& getDevice() const noexcept { return device; }
+    
+    // Transfers (empty if the protocol can't)
+    juce::MemoryBlock createRequest(int slot, int block = 0) const;
+    juce::uint32 getReplyAddress(int slot, int block = 0) const noexcept; // 0 for per-program replies, which carry none
+    juce::Array<juce::MemoryBlock> createWrites(int slot, const juce::MemoryBlock& dump) const; // One per block
+    
+    /**
+     * Decodes a reply. Addressed replies carry their slot; a per-program reply
+     * is for requestedSlot. Returns false if the body isn't a reply from this
+     * device.
+     */
+    bool parseReply(const juce::uint8* body, int size, int requestedSlot, Reply& reply) const;
+    
+    /** Copies one block's reply into its place in a slot's dump, sizing the dump to hold every block. */
+    void storeBlock(juce::MemoryBlock& dump, int block, const juce::MemoryBlock& payload) const;
+    
+    /** Stores a whole dump in a patch: the name, and the dump unless it is a name-only read. */
+    void applyReply(PatchData& patch, const juce::MemoryBlock& payload) const;
+    
+    // .syx files (raw F0..F7 stream)
+    int writeSysEx(const PatchBank& bank, juce::OutputStream& stream) const; // Returns patches written
+    juce::Result readSysEx(const juce::MemoryBlock& data, PatchBank& bank, int& numPatchesRead) const;
+    
+private:
+    const DeviceTemplate device;
+    const SysExProtocol::Ptr protocol;
+    const int deviceId;
+    Mode mode = Mode::none;
+    bool namesOnly = false;
+    const SysExMessageFormat* requestFormat = nullptr;
+    const SysExMessageFormat* replyFormat = nullptr;
+    const SysExMessageFormat* writeFormat = nullptr;
+    SysExProtocol::AddressMap map;
+    juce::Range<int> nameRange;
+    
+    int getSlotForAddress(juce::uint32 address, int& block) const noexcept; // -1 if no block starts there
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PatchSysExCodec)
+};
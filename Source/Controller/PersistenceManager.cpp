@@ -1,11 +1,26 @@
 #include "PersistenceManager.h"
+#include "PatchSysExCodec.h"
+#include "PluginStateChunk.h"
+#include "TraceRecorder.h"
 
+namespace
+{
+    juce::File& getDefaultDataDirectoryOverride()
+    {
+        static juce::File directory;
+        return directory;
+    }
+}
+
+// User's application data directory, unless setDefaultDataDirectory() chose another
 PersistenceManager::PersistenceManager()
+    : PersistenceManager(getDefaultDataDirectory())
+{
+}
+
+PersistenceManager::PersistenceManager(const juce::File& directory)
+    : dataDirectory(directory)
 {
-    // Get user's application data directory
-    dataDirectory = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
-        .getChildFile("MidiLibrarian");
-    
     // Create directory if it doesn't exist
     if (!dataDirectory.exists())
     {
@@ -15,6 +30,8 @@ PersistenceManager::PersistenceManager()
 
 bool PersistenceManager::savePatchBank(const PatchBank& bank)
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("PersistenceManager::savePatchBank");
+    
     auto file = getPatchesFile();
     auto var = bank.toVar();
     
@@ -35,6 +52,8 @@ bool PersistenceManager::savePatchBank(const PatchBank& bank)
 
 bool PersistenceManager::loadPatchBank(PatchBank& bank)
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("PersistenceManager::loadPatchBank");
+    
     auto file = getPatchesFile();
     
     if (!file.existsAsFile())
@@ -52,6 +71,8 @@ bool PersistenceManager::loadPatchBank(PatchBank& bank)
 
 bool PersistenceManager::saveDeviceConfig(const DeviceModel& device)
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("PersistenceManager::saveDeviceConfig");
+    
     auto file = getConfigFile();
     auto var = device.toVar();
     
@@ -72,6 +93,8 @@ bool PersistenceManager::saveDeviceConfig(const DeviceModel& device)
 
 bool PersistenceManager::loadDeviceConfig(DeviceModel& device)
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("PersistenceManager::loadDeviceConfig");
+    
     auto file = getConfigFile();
     
     if (!file.existsAsFile())
@@ -89,6 +112,8 @@ bool PersistenceManager::loadDeviceConfig(DeviceModel& device)
 
 bool PersistenceManager::exportToFile(const PatchBank& bank, const juce::File& file)
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("PersistenceManager::exportToFile");
+    
     auto var = bank.toVar();
     juce::String jsonString = juce::JSON::toString(var, true);
     
@@ -107,6 +132,8 @@ bool PersistenceManager::exportToFile(const PatchBank& bank, const juce::File& f
 
 bool PersistenceManager::importFromFile(PatchBank& bank, const juce::File& file)
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("PersistenceManager::importFromFile");
+    
     if (!file.existsAsFile())
         return false;
     
@@ -120,6 +147,126 @@ bool PersistenceManager::importFromFile(PatchBank& bank, const juce::File& file)
     return true;
 }
 
+PersistenceManager::FileFormat PersistenceManager::getFileFormat(const juce::File& file)
+{
+    if (file.hasFileExtension("syx"))
+        return FileFormat::sysEx;
+    
+    if (file.hasFileExtension("bin"))
+        return FileFormat::binary;
+    
+    return FileFormat::json;
+}
+
+const char* PersistenceManager::getFileFormatName(FileFormat format) noexcept
+{
+    switch (format)
+    {
+        case FileFormat::binary:    return "binary";
+        case FileFormat::sysEx:     return "sysex";
+        case FileFormat::json:      break;
+    }
+    
+    return "json";
+}
+
+juce::Result PersistenceManager::exportToFile(const PatchBank& bank, const juce::File& file, FileFormat format,
+                                              const PatchSysExCodec* codec)
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("PersistenceManager::exportToFile");
+    
+    if (format == FileFormat::json)
+        return exportToFile(bank, file) ? juce::Result::ok()
+                                        : juce::Result::fail("Couldn't write " + file.getFullPathName());
+    
+    if (format == FileFormat::sysEx && codec == nullptr)
+        return juce::Result::fail("A device template is needed to write " + file.getFileName());
+    
+    juce::MemoryBlock data;
+    
+    if (format == FileFormat::binary)
+    {
+        juce::MemoryBlock bankData;
+        juce::MemoryOutputStream bankStream(bankData, false);
+        bank.writeToStream(bankStream);
+        bankStream.flush();
+        
+        PluginStateChunk chunk;
+        chunk.addSection(PluginStateChunk::BANK_SECTION, std::move(bankData));
+        chunk.writeTo(data);
+    }
+    else
+    {
+        juce::MemoryOutputStream stream(data, false);
+        if (codec->writeSysEx(bank, stream) == 0)
+            return juce::Result::fail("No " + codec->getDevice().getDeviceName() + " patch dumps to write");
+    }
+    
+    juce::TemporaryFile tempFile(file);
+    
+    if (!tempFile.getFile().replaceWithData(data.getData(), data.getSize())
+        || !tempFile.overwriteTargetFileWithTemporary())
+        return juce::Result::fail("Couldn't write " + file.getFullPathName());
+    
+    return juce::Result::ok();
+}
+
+juce::Result PersistenceManager::importFromFile(PatchBank& bank, const juce::File& file, FileFormat format,
+                                                const PatchSysExCodec* codec)
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("PersistenceManager::importFromFile");
+    
+    if (!file.existsAsFile())
+        return juce::Result::fail("No such file: " + file.getFullPathName());
+    
+    if (format == FileFormat::json)
+        return importFromFile(bank, file) ? juce::Result::ok()
+                                          : juce::Result::fail(file.getFileName() + " isn't a patch bank");
+    
+    juce::MemoryBlock data;
+    if (!file.loadFileAsData(data))
+        return juce::Result::fail("Couldn't read " + file.getFullPathName());
+    
+    if (format == FileFormat::sysEx)
+    {
+        if (codec == nullptr)
+            return juce::Result::fail("A device template is needed to read " + file.getFileName());
+        
+        int numPatches = 0;
+        return codec->readSysEx(data, bank, numPatches);
+    }
+    
+    PluginStateChunk chunk;
+    auto result = chunk.read(data.getData(), data.getSize());
+    if (result.failed())
+        return juce::Result::fail(file.getFileName() + ": " + result.getErrorMessage());
+    
+    const auto* section = chunk.getSection(PluginStateChunk::BANK_SECTION);
+    if (section == nullptr)
+        return juce::Result::fail(file.getFileName() + " holds no patch bank");
+    
+    juce::MemoryInputStream stream(section->data, false);
+    if (!bank.readFromStream(stream))
+        return juce::Result::fail(file.getFileName() + " holds a damaged patch bank");
+    
+    return juce::Result::ok();
+}
+
+void PersistenceManager::setDefaultDataDirectory(const juce::File& directory)
+{
+    getDefaultDataDirectoryOverride() = directory;
+}
+
+juce::File PersistenceManager::getDefaultDataDirectory()
+{
+    const auto& directory = getDefaultDataDirectoryOverride();
+    
+    if (directory != juce::File())
+        return directory;
+    
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("MidiLibrarian");
+}
+
 juce::File PersistenceManager::getDataDirectory() const
 {
     return dataDirectory;
@@ -135,3 +282,38 @@ juce::File PersistenceManager::getConfigFile() const
     return dataDirectory.getChildFile("config.json");
 }
 
+juce::File PersistenceManager::getMidiLearnFile() const
+{
+    return dataDirectory.getChildFile("midi_learn.json");
+}
+
+bool PersistenceManager::saveVar(const juce::File& file, const juce::var& value)
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("PersistenceManager::saveVar");
+    
+    juce::String jsonString = juce::JSON::toString(value, true);
+    
+    juce::TemporaryFile tempFile(file);
+    auto stream = tempFile.getFile().createOutputStream();
+    
+    if (stream == nullptr)
+        return false;
+    
+    stream->writeString(jsonString);
+    stream->flush();
+    stream.reset();
+    
+    return tempFile.overwriteTargetFileWithTemporary();
+}
+
+juce::var PersistenceManager::loadVar(const juce::File& file) const
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("PersistenceManager::loadVar");
+    
+    if (!file.existsAsFile())
+        return {};
+    
+    auto var = juce::JSON::parse(file.loadFileAsString());
+    return var.isUndefined() ? juce::var() : var;
+}
+
@@ -4,22 +4,38 @@
 #include "../Model/PatchBank.h"
 #include "../Model/DeviceModel.h"
 
+class PatchSysExCodec;
+
 /**
  * Handles all file I/O for persistence.
  * 
  * Stores data as JSON in user's application data directory:
  * - Patch bank: ~/Library/Application Support/MidiLibrarian/patches.json
  * - Device config: ~/Library/Application Support/MidiLibrarian/config.json
+ * - MIDI learn: ~/Library/Application Support/MidiLibrarian/midi_learn.json
  * 
- * All operations are synchronous and run on the message thread.
- * For large operations, consider moving to background thread in future.
+ * All operations are synchronous and run on the message thread, except that
+ * SharedLibrary's startup load reads the library files on worker threads
+ * (an instance holds no state besides its folder). The library files are
+ * only written through SharedLibrary, which owns the one instance used for
+ * them.
  */
 class PersistenceManager
 {
 public:
     PersistenceManager();
+    explicit PersistenceManager(const juce::File& dataDirectory); // E.g. a scratch folder for tools
     ~PersistenceManager() = default;
     
+    /**
+     * Folder used by the default constructor. Tools that run the whole plugin
+     * headless (the realtime stress driver) point it at a scratch folder
+     * before anything is constructed, so the user's library is never touched.
+     * An empty File restores the application data folder.
+     */
+    static void setDefaultDataDirectory(const juce::File& directory);
+    static juce::File getDefaultDataDirectory();
+    
     // Patch bank persistence
     bool savePatchBank(const PatchBank& bank);
     bool loadPatchBank(PatchBank& bank);
@@ -32,13 +48,39 @@ public:
     bool exportToFile(const PatchBank& bank, const juce::File& file);
     bool importFromFile(PatchBank& bank, const juce::File& file);
     
+    /**
+     * Bank file formats:
+     * - json: what exportToFile() writes
+     * - binary: a PluginStateChunk with the bank section (compact, hashed)
+     * - sysEx: the device's own patch dumps (.syx), so it needs the device's
+     *   codec; only slots with a dump for that device are written
+     */
+    enum class FileFormat
+    {
+        json,
+        binary,
+        sysEx
+    };
+    
+    static FileFormat getFileFormat(const juce::File& file); // By extension: .syx, .bin, anything else JSON
+    static const char* getFileFormatName(FileFormat format) noexcept;
+    
+    juce::Result exportToFile(const PatchBank& bank, const juce::File& file, FileFormat format,
+                              const PatchSysExCodec* codec);
+    juce::Result importFromFile(PatchBank& bank, const juce::File& file, FileFormat format,
+                                const PatchSysExCodec* codec);
+    
+    // Generic JSON files (atomic replace; loadVar returns void if missing or invalid)
+    bool saveVar(const juce::File& file, const juce::var& value);
+    juce::var loadVar(const juce::File& file) const;
+    
     // Utility
     juce::File getDataDirectory() const;
-    
-private:
     juce::File getPatchesFile() const;
     juce::File getConfigFile() const;
+    juce::File getMidiLearnFile() const;
     
+private:
     juce::File dataDirectory;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PersistenceManager)
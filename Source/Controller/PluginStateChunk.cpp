@@ -0,0 +1,104 @@
+#include "PluginStateChunk.h"
+#include "PatchHasher.h"
+
+namespace
+{
+    constexpr int HEADER_SIZE = 8;
+    constexpr int SECTION_HEADER_SIZE = 16;
+    constexpr juce::uint64 HASH_SEED = 0x4d4c5374;
+}
+
+bool PluginStateChunk::isChunk(const void* data, size_t size) noexcept
+{
+    return data != nullptr && size >= (size_t)HEADER_SIZE
+        && juce::ByteOrder::littleEndianInt(data) == MAGIC;
+}
+
+juce::uint64 PluginStateChunk::hashPayload(const juce::MemoryBlock& data) noexcept
+{
+    return PatchHasher::xxHash64(data.getData(), data.getSize(), HASH_SEED);
+}
+
+void PluginStateChunk::addSection(juce::uint32 id, juce::MemoryBlock data)
+{
+    Section section;
+    section.id = id;
+    section.hash = hashPayload(data);
+    section.data = std::move(data);
+    sections.add(std::move(section));
+}
+
+void PluginStateChunk::writeTo(juce::MemoryBlock& dest) const
+{
+    size_t totalSize = HEADER_SIZE;
+    for (const auto& section : sections)
+        totalSize += SECTION_HEADER_SIZE + section.data.getSize();
+    
+    dest.setSize(0);
+    dest.ensureSize(totalSize);
+    
+    juce::MemoryOutputStream stream(dest, false);
+    stream.writeInt((int)MAGIC);
+    stream.writeShort((short)VERSION);
+    stream.writeShort((short)sections.size());
+    
+    for (const auto& section : sections)
+    {
+        stream.writeInt((int)section.id);
+        stream.writeInt64((juce::int64)section.hash);
+        stream.writeInt((int)section.data.getSize());
+        stream.write(section.data.getData(), section.data.getSize());
+    }
+    
+    stream.flush();
+}
+
+juce::Result PluginStateChunk::read(const void* data, size_t size)
+{
+    sections.clear();
+    
+    if (!isChunk(data, size))
+        return juce::Result::fail("Not a state chunk");
+    
+    juce::MemoryInputStream stream(data, size, false);
+    stream.readInt(); // Magic
+    
+    const int version = (juce::uint16)stream.readShort();
+    if (version > VERSION)
+        return juce::Result::fail("State was saved by a newer version (" + juce::String(version) + ")");
+    
+    const int numSections = (juce::uint16)stream.readShort();
+    
+    for (int i = 0; i < numSections; ++i)
+    {
+        if (stream.getNumBytesRemaining() < SECTION_HEADER_SIZE)
+            return juce::Result::fail("Truncated section header");
+        
+        Section section;
+        section.id = (juce::uint32)stream.readInt();
+        section.hash = (juce::uint64)stream.readInt64();
+        const auto sectionSize = (juce::int64)(juce::uint32)stream.readInt();
+        
+        if (sectionSize > stream.getNumBytesRemaining())
+            return juce::Result::fail("Truncated section");
+        
+        section.data.setSize((size_t)sectionSize);
+        stream.read(section.data.getData(), (int)sectionSize);
+        
+        if (hashPayload(section.data) != section.hash)
+            return juce::Result::fail("Section checksum mismatch");
+        
+        sections.add(std::move(section));
+    }
+    
+    return juce::Result::ok();
+}
+
+const PluginStateChunk::Section* PluginStateChunk::getSection(juce::uint32 id) const noexcept
+{
+    for (const auto& section : sections)
+        if (section.id == id)
+            return &section;
+    
+    return nullptr;
+}
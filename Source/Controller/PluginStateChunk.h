@@ -0,0 +1,54 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Versioned binary container for the plugin's host-saved state.
+ * 
+ * Layout (little-endian):
+ *     uint32 magic ("MLst"), uint16 version, uint16 section count
+ *     per section: uint32 id, uint64 hash, uint32 size, payload
+ * 
+ * Each section carries an xxHash64 of its payload. The hash serves two
+ * purposes: read() rejects damaged sections, and on restore a caller can
+ * compare it with the hash of its current state and skip decoding and
+ * applying sections that haven't changed. Unknown section IDs are ignored,
+ * so newer versions can add sections without breaking older readers.
+ */
+class PluginStateChunk
+{
+public:
+    static constexpr juce::uint32 MAGIC = 0x74734c4d;   // "MLst"
+    static constexpr int VERSION = 1;
+    
+    // Section IDs (four-character codes)
+    static constexpr juce::uint32 BANK_SECTION = 0x4b4e4142;    // "BANK"
+    static constexpr juce::uint32 DEVICE_SECTION = 0x43564544;  // "DEVC"
+    
+    struct Section
+    {
+        juce::uint32 id = 0;
+        juce::uint64 hash = 0;
+        juce::MemoryBlock data;
+    };
+    
+    PluginStateChunk() = default;
+    
+    /** True if the data starts with the chunk magic (older states are JSON text). */
+    static bool isChunk(const void* data, size_t size) noexcept;
+    
+    static juce::uint64 hashPayload(const juce::MemoryBlock& data) noexcept;
+    
+    // Writing
+    void addSection(juce::uint32 id, juce::MemoryBlock data);
+    void writeTo(juce::MemoryBlock& dest) const;
+    
+    // Reading
+    juce::Result read(const void* data, size_t size);
+    const Section* getSection(juce::uint32 id) const noexcept;
+    
+private:
+    juce::Array<Section> sections;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginStateChunk)
+};
@@ -0,0 +1,365 @@
+#if MIDI_LIBRARIAN_RT_CHECKS && defined(__linux__)
+ // The hooks below define open/read/write; the fortified inline wrappers would clash with them
+ #undef _FORTIFY_SOURCE
+#endif
+
+#include "RealtimeSafetyChecker.h"
+
+#if MIDI_LIBRARIAN_RT_CHECKS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+ #define MIDI_LIBRARIAN_RT_LIBC_HOOKS 1
+ #include <dlfcn.h>
+ #include <fcntl.h>
+ #include <pthread.h>
+ #include <sched.h>
+ #include <time.h>
+ #include <unistd.h>
+ #include <cstdarg>
+#else
+ #define MIDI_LIBRARIAN_RT_LIBC_HOOKS 0
+#endif
+
+namespace
+{
+    thread_local int armedDepth = 0;        // Open ScopedRealtimeSections on this thread
+    thread_local bool isRecording = false;  // The checker's own allocations and locks pass
+    
+    std::atomic<int> numViolations { 0 };
+    
+    juce::SpinLock& getReportLock()
+    {
+        static juce::SpinLock lock;
+        return lock;
+    }
+    
+    juce::Array<RealtimeSafetyChecker::Report>& getReportStore()
+    {
+        static juce::Array<RealtimeSafetyChecker::Report> reports;
+        return reports;
+    }
+    
+    juce::String getCurrentThreadName()
+    {
+        if (auto* thread = juce::Thread::getCurrentThread())
+            return thread->getThreadName();
+        
+        if (juce::MessageManager::existsAndIsCurrentThread())
+            return "message thread";
+        
+        return "thread 0x" + juce::String::toHexString((juce::pointer_sized_int) juce::Thread::getCurrentThreadId());
+    }
+}
+
+bool RealtimeSafetyChecker::isArmed() noexcept
+{
+    return armedDepth > 0;
+}
+
+void RealtimeSafetyChecker::arm() noexcept
+{
+    ++armedDepth;
+}
+
+void RealtimeSafetyChecker::disarm() noexcept
+{
+    jassert(armedDepth > 0);
+    --armedDepth;
+}
+
+void RealtimeSafetyChecker::check(Violation kind, const char* call) noexcept
+{
+    if (armedDepth == 0 || isRecording)
+        return;
+    
+    isRecording = true;
+    record(kind, call);
+    isRecording = false;
+}
+
+void RealtimeSafetyChecker::record(Violation kind, const char* call)
+{
+    numViolations.fetch_add(1, std::memory_order_relaxed);
+    
+    auto stackTrace = juce::SystemStats::getStackBacktrace();
+    bool isNewStack = false;
+    
+    {
+        const juce::SpinLock::ScopedLockType sl(getReportLock());
+        auto& reports = getReportStore();
+        bool isKnownStack = false;
+        
+        for (auto& report : reports)
+        {
+            if (report.kind == kind && report.stackTrace == stackTrace)
+            {
+                ++report.count;
+                isKnownStack = true;
+                break;
+            }
+        }
+        
+        if (!isKnownStack && reports.size() < MAX_REPORTS)
+        {
+            Report report;
+            report.kind = kind;
+            report.call = call;
+            report.threadName = getCurrentThreadName();
+            report.stackTrace = stackTrace;
+            report.count = 1;
+            reports.add(report);
+            isNewStack = true;
+        }
+    }
+    
+    if (isNewStack)
+    {
+        juce::Logger::writeToLog("Real-time safety violation (" + juce::String(getViolationName(kind)) + ": "
+                                 + call + ") on " + getCurrentThreadName() + "\n" + stackTrace);
+        
+        // A real-time-unsafe call was made inside a ScopedRealtimeSection; the log has the stack
+        jassertfalse;
+    }
+}
+
+int RealtimeSafetyChecker::getNumViolations() noexcept
+{
+    return numViolations.load(std::memory_order_relaxed);
+}
+
+juce::Array<RealtimeSafetyChecker::Report> RealtimeSafetyChecker::getReports()
+{
+    const juce::SpinLock::ScopedLockType sl(getReportLock());
+    return getReportStore();
+}
+
+void RealtimeSafetyChecker::clearReports()
+{
+    const juce::SpinLock::ScopedLockType sl(getReportLock());
+    getReportStore().clear();
+    numViolations.store(0, std::memory_order_relaxed);
+}
+
+// Hooks. Allocation goes straight to the libc allocator so a hooked malloc
+// isn't reported a second time from inside operator new.
+
+#if MIDI_LIBRARIAN_RT_LIBC_HOOKS
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+    void __libc_free(void* ptr);
+}
+
+namespace
+{
+    void* rawMalloc(size_t size) noexcept { return __libc_malloc(size); }
+    void rawFree(void* ptr) noexcept { __libc_free(ptr); }
+}
+#else
+namespace
+{
+    void* rawMalloc(size_t size) noexcept { return std::malloc(size); }
+    void rawFree(void* ptr) noexcept { std::free(ptr); }
+}
+#endif
+
+void* operator new(std::size_t size)
+{
+    RealtimeSafetyChecker::check(RealtimeSafetyChecker::Violation::allocation, "operator new");
+    
+    if (auto* ptr = rawMalloc(size > 0 ? size : 1))
+        return ptr;
+    
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    RealtimeSafetyChecker::check(RealtimeSafetyChecker::Violation::allocation, "operator new");
+    return rawMalloc(size > 0 ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (ptr != nullptr)
+        RealtimeSafetyChecker::check(RealtimeSafetyChecker::Violation::deallocation, "operator delete");
+    
+    rawFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept                          { operator delete(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept               { operator delete(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept             { operator delete(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept     { operator delete(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept   { operator delete(ptr); }
+
+#if MIDI_LIBRARIAN_RT_LIBC_HOOKS
+namespace
+{
+    /** Looks up the libc definition that a hook replaces (cached; no static guard, which could lock). */
+    template <typename Function>
+    Function getNextSymbol(std::atomic<void*>& cache, const char* name) noexcept
+    {
+        auto* symbol = cache.load(std::memory_order_relaxed);
+        
+        if (symbol == nullptr)
+        {
+            symbol = dlsym(RTLD_NEXT, name);
+            cache.store(symbol, std::memory_order_relaxed);
+        }
+        
+        return reinterpret_cast<Function>(symbol);
+    }
+    
+    std::atomic<void*> nextMutexLock { nullptr };
+    std::atomic<void*> nextRwLockRead { nullptr };
+    std::atomic<void*> nextRwLockWrite { nullptr };
+    std::atomic<void*> nextOpen { nullptr };
+    std::atomic<void*> nextRead { nullptr };
+    std::atomic<void*> nextWrite { nullptr };
+    std::atomic<void*> nextNanosleep { nullptr };
+    std::atomic<void*> nextUsleep { nullptr };
+    std::atomic<void*> nextSchedYield { nullptr };
+    
+    using Violation = RealtimeSafetyChecker::Violation;
+}
+
+extern "C"
+{
+    void* malloc(size_t size)
+    {
+        RealtimeSafetyChecker::check(Violation::allocation, "malloc");
+        return __libc_malloc(size);
+    }
+    
+    void* calloc(size_t count, size_t size)
+    {
+        RealtimeSafetyChecker::check(Violation::allocation, "calloc");
+        return __libc_calloc(count, size);
+    }
+    
+    void* realloc(void* ptr, size_t size)
+    {
+        RealtimeSafetyChecker::check(Violation::allocation, "realloc");
+        return __libc_realloc(ptr, size);
+    }
+    
+    void free(void* ptr)
+    {
+        if (ptr != nullptr)
+            RealtimeSafetyChecker::check(Violation::deallocation, "free");
+        
+        __libc_free(ptr);
+    }
+    
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        RealtimeSafetyChecker::check(Violation::lock, "pthread_mutex_lock");
+        return getNextSymbol<int (*)(pthread_mutex_t*)>(nextMutexLock, "pthread_mutex_lock")(mutex);
+    }
+    
+    int pthread_rwlock_rdlock(pthread_rwlock_t* lock)
+    {
+        RealtimeSafetyChecker::check(Violation::lock, "pthread_rwlock_rdlock");
+        return getNextSymbol<int (*)(pthread_rwlock_t*)>(nextRwLockRead, "pthread_rwlock_rdlock")(lock);
+    }
+    
+    int pthread_rwlock_wrlock(pthread_rwlock_t* lock)
+    {
+        RealtimeSafetyChecker::check(Violation::lock, "pthread_rwlock_wrlock");
+        return getNextSymbol<int (*)(pthread_rwlock_t*)>(nextRwLockWrite, "pthread_rwlock_wrlock")(lock);
+    }
+    
+    int open(const char* path, int flags, ...)
+    {
+        mode_t mode = 0;
+        
+        if ((flags & O_CREAT) != 0
+           #ifdef O_TMPFILE
+            || (flags & O_TMPFILE) == O_TMPFILE
+           #endif
+           )
+        {
+            va_list args;
+            va_start(args, flags);
+            mode = (mode_t) va_arg(args, int);
+            va_end(args);
+        }
+        
+        RealtimeSafetyChecker::check(Violation::systemCall, "open");
+        return getNextSymbol<int (*)(const char*, int, ...)>(nextOpen, "open")(path, flags, mode);
+    }
+    
+    ssize_t read(int fd, void* buffer, size_t count)
+    {
+        RealtimeSafetyChecker::check(Violation::systemCall, "read");
+        return getNextSymbol<ssize_t (*)(int, void*, size_t)>(nextRead, "read")(fd, buffer, count);
+    }
+    
+    ssize_t write(int fd, const void* buffer, size_t count)
+    {
+        RealtimeSafetyChecker::check(Violation::systemCall, "write");
+        return getNextSymbol<ssize_t (*)(int, const void*, size_t)>(nextWrite, "write")(fd, buffer, count);
+    }
+    
+    int nanosleep(const struct timespec* duration, struct timespec* remaining)
+    {
+        RealtimeSafetyChecker::check(Violation::systemCall, "nanosleep");
+        return getNextSymbol<int (*)(const struct timespec*, struct timespec*)>(nextNanosleep, "nanosleep")(duration, remaining);
+    }
+    
+    int usleep(useconds_t microseconds)
+    {
+        RealtimeSafetyChecker::check(Violation::systemCall, "usleep");
+        return getNextSymbol<int (*)(useconds_t)>(nextUsleep, "usleep")(microseconds);
+    }
+    
+    int sched_yield()
+    {
+        RealtimeSafetyChecker::check(Violation::systemCall, "sched_yield");
+        return getNextSymbol<int (*)()>(nextSchedYield, "sched_yield")();
+    }
+}
+#endif
+
+#else // MIDI_LIBRARIAN_RT_CHECKS
+
+bool RealtimeSafetyChecker::isArmed() noexcept                { return false; }
+void RealtimeSafetyChecker::arm() noexcept                    {}
+void RealtimeSafetyChecker::disarm() noexcept                 {}
+void RealtimeSafetyChecker::check(Violation, const char*) noexcept {}
+void RealtimeSafetyChecker::record(Violation, const char*)    {}
+int RealtimeSafetyChecker::getNumViolations() noexcept        { return 0; }
+juce::Array<RealtimeSafetyChecker::Report> RealtimeSafetyChecker::getReports() { return {}; }
+void RealtimeSafetyChecker::clearReports()                    {}
+
+#endif
+
+const char* RealtimeSafetyChecker::getViolationName(Violation kind) noexcept
+{
+    switch (kind)
+    {
+        case Violation::allocation:     return "allocation";
+        case Violation::deallocation:   return "deallocation";
+        case Violation::lock:           return "lock";
+        case Violation::systemCall:     break;
+    }
+    
+    return "systemCall";
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Debug build mode that reports real-time-unsafe calls made on the audio thread.
+ * 
+ * Build with MIDI_LIBRARIAN_RT_CHECKS=1 to enable it. A ScopedRealtimeSection
+ * arms the checker for the current thread (processBlock() holds one for the
+ * whole callback); while armed, these calls are reported as violations:
+ * 
+ * - allocation / deallocation: global operator new and delete (all platforms);
+ *   malloc, calloc, realloc and free (glibc)
+ * - lock: pthread_mutex_lock, pthread_rwlock_rdlock/wrlock (glibc)
+ * - systemCall: open, read, write, nanosleep, usleep, sched_yield (glibc)
+ * 
+ * Each violation is recorded once per distinct call stack, with a stack
+ * trace and a count, logged with juce::Logger and stops in the debugger.
+ * The hooks replace global symbols, so they are only guaranteed to take
+ * effect in an executable that links this file directly, such as the
+ * realtime stress driver. Inside a plugin, the host's definitions may win
+ * (the bundle's own operator new/delete are used on macOS; on Linux the
+ * host's usually are).
+ * 
+ * With MIDI_LIBRARIAN_RT_CHECKS=0 (the default) nothing is hooked and
+ * ScopedRealtimeSection compiles to nothing.
+ */
+#ifndef MIDI_LIBRARIAN_RT_CHECKS
+ #define MIDI_LIBRARIAN_RT_CHECKS 0
+#endif
+
+class RealtimeSafetyChecker
+{
+public:
+    enum class Violation
+    {
+        allocation = 0,
+        deallocation,
+        lock,
+        systemCall
+    };
+    
+    struct Report
+    {
+        Violation kind = Violation::allocation;
+        juce::String call;          // e.g. "malloc", "pthread_mutex_lock"
+        juce::String threadName;
+        juce::String stackTrace;
+        int count = 0;              // Times this call stack was hit
+    };
+    
+    /** Arms the checker for the current thread during its lifetime (may nest). */
+    class ScopedRealtimeSection
+    {
+    public:
+       #if MIDI_LIBRARIAN_RT_CHECKS
+        ScopedRealtimeSection() noexcept { RealtimeSafetyChecker::arm(); }
+        ~ScopedRealtimeSection() noexcept { RealtimeSafetyChecker::disarm(); }
+       #else
+        ScopedRealtimeSection() noexcept {}
+       #endif
+    
+    private:
+        JUCE_DECLARE_NON_COPYABLE(ScopedRealtimeSection)
+    };
+    
+    RealtimeSafetyChecker() = delete;
+    
+    static constexpr bool isEnabled() noexcept { return MIDI_LIBRARIAN_RT_CHECKS != 0; }
+    static bool isArmed() noexcept; // On the current thread
+    
+    /** Called by the hooks; records a violation if the current thread is armed. */
+    static void check(Violation kind, const char* call) noexcept;
+    
+    // Results (any thread)
+    static int getNumViolations() noexcept; // Total hits, including repeats of a recorded stack
+    static juce::Array<Report> getReports();
+    static void clearReports();
+    static const char* getViolationName(Violation kind) noexcept;
+    
+    static constexpr int MAX_REPORTS = 64; // Distinct call stacks kept; later ones are only counted
+    
+private:
+    static void arm() noexcept;
+    static void disarm() noexcept;
+    static void record(Violation kind, const char* call);
+};
@@ -0,0 +1,172 @@
+#include "SharedLibrary.h"
+
+SharedLibrary::SharedLibrary()
+{
+    loadConfig();
+}
+
+SharedLibrary::~SharedLibrary()
+{
+    // The load jobs write into this object
+    if (loadPool != nullptr)
+        loadPool->removeAllJobs(false, -1);
+    
+    cancelPendingUpdate();
+    flush();
+}
+
+SharedLibrary::SnapshotPtr SharedLibrary::getSnapshot() const
+{
+    const juce::SpinLock::ScopedLockType lock(snapshotLock);
+    return current;
+}
+
+juce::uint64 SharedLibrary::publish(Snapshot snapshot)
+{
+    jassert(isLoaded());
+    juce::uint64 version;
+    
+    {
+        const juce::SpinLock::ScopedLockType lock(snapshotLock);
+        version = current->version + 1;
+        snapshot.version = version;
+        current = std::make_shared<const Snapshot>(std::move(snapshot));
+    }
+    
+    startTimer(SAVE_DELAY_MS);
+    sendChangeMessage();
+    return version;
+}
+
+void SharedLibrary::flush()
+{
+    stopTimer();
+    
+    auto snapshot = getSnapshot();
+    if (snapshot->version != savedVersion)
+        save(*snapshot);
+}
+
+void SharedLibrary::startLoading()
+{
+    const juce::ScopedLock sl(loadLock);
+    
+    if (loadPool != nullptr)
+        return;
+    
+    // Each job touches only its own file(s) and its own result member
+    loadPool = std::make_unique<juce::ThreadPool>(NUM_LOAD_JOBS);
+    
+    loadPool->addJob([this]
+    {
+        PatchBank bank;
+        persistenceManager.loadPatchBank(bank);
+        loadedPatches = bank.getPatches();
+        finishLoadJob();
+    });
+    
+    loadPool->addJob([this]
+    {
+        loadedMidiLearn = persistenceManager.loadVar(persistenceManager.getMidiLearnFile());
+        finishLoadJob();
+    });
+    
+    loadPool->addJob([this]
+    {
+        loadedTemplateIndex = templateManager.readIndex();
+        finishLoadJob();
+    });
+}
+
+void SharedLibrary::waitUntilLoaded()
+{
+    if (isLoaded())
+        return;
+    
+    startLoading();
+    loadJobsFinished.wait();
+    publishLoadedLibrary();
+    
+    // The template index belongs to the message thread; elsewhere it waits for handleAsyncUpdate()
+    if (juce::MessageManager::existsAndIsCurrentThread())
+        applyLoadedTemplateIndex();
+}
+
+void SharedLibrary::loadConfig()
+{
+    // Stage 1: the device settings; patches and MIDI learn follow in startLoading()
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->deviceConfig = persistenceManager.loadVar(persistenceManager.getConfigFile());
+    
+    current = std::move(snapshot);
+    savedVersion = current->version;
+}
+
+void SharedLibrary::finishLoadJob()
+{
+    if (--loadJobsRemaining == 0)
+    {
+        loadJobsFinished.signal();
+        triggerAsyncUpdate();
+    }
+}
+
+void SharedLibrary::publishLoadedLibrary()
+{
+    {
+        const juce::ScopedLock sl(loadLock);
+        
+        if (isLoaded())
+            return;
+        
+        const juce::SpinLock::ScopedLockType lock(snapshotLock);
+        auto snapshot = std::make_shared<Snapshot>(*current);
+        snapshot->patches = std::move(loadedPatches);
+        snapshot->midiLearn = std::move(loadedMidiLearn);
+        snapshot->version = current->version + 1;
+        
+        // This is what the files hold, so there is nothing to write back
+        current = std::move(snapshot);
+        savedVersion = current->version;
+        loaded.store(true, std::memory_order_release);
+    }
+    
+    sendChangeMessage();
+}
+
+void SharedLibrary::applyLoadedTemplateIndex()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+    
+    if (!templateManager.isIndexed())
+        templateManager.applyIndex(std::move(loadedTemplateIndex));
+}
+
+void SharedLibrary::save(const Snapshot& snapshot)
+{
+    juce::Array<juce::var> patchArray;
+    patchArray.ensureStorageAllocated(snapshot.patches.size());
+    for (const auto& patch : snapshot.patches)
+        patchArray.add(patch.toVar());
+    
+    persistenceManager.saveVar(persistenceManager.getPatchesFile(), juce::var(patchArray));
+    
+    if (!snapshot.deviceConfig.isVoid())
+        persistenceManager.saveVar(persistenceManager.getConfigFile(), snapshot.deviceConfig);
+    
+    if (!snapshot.midiLearn.isVoid())
+        persistenceManager.saveVar(persistenceManager.getMidiLearnFile(), snapshot.midiLearn);
+    
+    savedVersion = snapshot.version;
+}
+
+void SharedLibrary::timerCallback()
+{
+    flush();
+}
+
+void SharedLibrary::handleAsyncUpdate()
+{
+    publishLoadedLibrary();
+    applyLoadedTemplateIndex();
+}
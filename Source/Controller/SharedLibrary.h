@@ -0,0 +1,108 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "../Model/PatchData.h"
+#include "PersistenceManager.h"
+#include "DeviceTemplateManager.h"
+#include <memory>
+
+/**
+ * The patch library shared by every plugin instance in the process.
+ * 
+ * Instances obtain it through juce::SharedResourcePointer, so the files are
+ * read once per process and later instances start without any disk I/O.
+ * It is destroyed, after flushing, when the last instance closes.
+ * 
+ * Loading is staged. The constructor reads only config.json, which is all
+ * an instance needs to pick its device (and all a host scanning the plugin
+ * pays for). startLoading() then reads patches.json and midi_learn.json and
+ * indexes the templates folder in parallel on worker threads; the result is
+ * published as a new snapshot on the message thread, which instances pick up
+ * like any other library change. waitUntilLoaded() finishes the load on the
+ * calling thread for callers that can't wait for the message.
+ * 
+ * The library state is an immutable, reference-counted Snapshot. Edits are
+ * copy-on-write: an instance edits its own working PatchBank and publishes a
+ * new Snapshot built from it. Copying patches is cheap because names and
+ * tags are reference-counted strings and patch dumps are shared blobs.
+ * Publishing bumps the version and broadcasts a change, so other instances
+ * can pull the new snapshot.
+ * 
+ * This class owns the only PersistenceManager. Writes are coalesced on a
+ * short timer and always run here, so instances can't overwrite each
+ * other's files.
+ * 
+ * THREADING:
+ * - Publish and persistence on the message thread; getSnapshot() may be called from any thread
+ */
+class SharedLibrary : public juce::ChangeBroadcaster,
+                      private juce::Timer,
+                      private juce::AsyncUpdater
+{
+public:
+    struct Snapshot
+    {
+        juce::Array<PatchData> patches;
+        juce::var deviceConfig;     // Last used device settings (defaults for new instances)
+        juce::var midiLearn;
+        juce::uint64 version = 0;
+    };
+    
+    using SnapshotPtr = std::shared_ptr<const Snapshot>;
+    
+    // Edits within this window share one disk write
+    static constexpr int SAVE_DELAY_MS = 500;
+    
+    SharedLibrary();
+    ~SharedLibrary() override;
+    
+    SnapshotPtr getSnapshot() const;
+    
+    // Staged loading (thread-safe)
+    void startLoading();    // Does nothing once started
+    void waitUntilLoaded(); // Starts loading if needed and blocks until the snapshot is published
+    bool isLoaded() const noexcept { return loaded.load(std::memory_order_acquire); }
+    
+    /**
+     * Replaces the library with a new snapshot and schedules a write.
+     * Only valid once loaded, or the files would be replaced by an empty bank.
+     * 
+     * @return The new version, so the publisher can ignore its own change message
+     */
+    juce::uint64 publish(Snapshot snapshot);
+    
+    /** Writes any pending snapshot now. */
+    void flush();
+    
+    PersistenceManager& getPersistenceManager() noexcept { return persistenceManager; }
+    DeviceTemplateManager& getTemplateManager() noexcept { return templateManager; }
+    
+private:
+    PersistenceManager persistenceManager;
+    DeviceTemplateManager templateManager { persistenceManager.getDataDirectory().getChildFile("templates") };
+    
+    mutable juce::SpinLock snapshotLock;
+    SnapshotPtr current;
+    juce::uint64 savedVersion = 0;
+    
+    // Loading: the jobs fill the loaded* members, then the last one signals
+    static constexpr int NUM_LOAD_JOBS = 3; // Patches, MIDI learn, template index
+    juce::CriticalSection loadLock;
+    std::unique_ptr<juce::ThreadPool> loadPool; // Created by startLoading()
+    std::atomic<int> loadJobsRemaining { NUM_LOAD_JOBS };
+    juce::WaitableEvent loadJobsFinished { true };
+    std::atomic<bool> loaded { false };
+    juce::Array<PatchData> loadedPatches;
+    juce::var loadedMidiLearn;
+    DeviceTemplateManager::IndexScan loadedTemplateIndex;
+    
+    void loadConfig();
+    void finishLoadJob();
+    void publishLoadedLibrary();
+    void applyLoadedTemplateIndex();
+    void save(const Snapshot& snapshot);
+    void timerCallback() override;
+    void handleAsyncUpdate() override;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedLibrary)
+};
@@ -0,0 +1,325 @@
+#include "SimulatedSynthTransport.h"
+
+namespace
+{
+    /** A request the built-in devices answer, and the dump that answers it. */
+    struct DumpRule
+    {
+        const char* request;
+        const char* reply;
+        int payloadSize;    // 0: addressed (size from the request or address map)
+        bool perProgram;    // Unaddressed dump of the current program, not the whole memory
+    };
+    
+    constexpr DumpRule dumpRules[] =
+    {
+        { SysExProtocol::DATA_REQUEST,  SysExProtocol::DATA_SET, 0,         false },    // Roland RQ1/DT1
+        { "voiceDumpRequest",           "voiceDump",             155,       true },     // DX7 VCED
+        { "bankDumpRequest",            "bankDump",              4096,      false },    // DX7 32 packed voices
+        { "programDumpRequest",         "programDump",           143,       true },     // M1 program
+        { "allProgramsDumpRequest",     "allProgramsDump",       143 * 100, false }
+    };
+    
+    // Addresses are 7 bits per byte, so keys with the top bit set can't collide with them
+    constexpr juce::uint32 dumpKeyFlag = 0x80000000u;
+    
+    double secondsForBytes(int numBytes, double baudRate) noexcept
+    {
+        return baudRate > 0.0 ? MidiWireModel::getSecondsForBytes(numBytes, baudRate) : 0.0;
+    }
+    
+    double remainingBytesAt(double startSeconds, double endSeconds, int size, double timeSeconds) noexcept
+    {
+        if (timeSeconds >= endSeconds)
+            return 0.0;
+        
+        if (timeSeconds <= startSeconds || endSeconds <= startSeconds)
+            return (double)size;
+        
+        return size * (endSeconds - timeSeconds) / (endSeconds - startSeconds);
+    }
+}
+
+juce::var SimulatedSynthTransport::Statistics::toVar() const
+{
+    juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+    obj->setProperty("messagesReceived", (juce::int64)messagesReceived);
+    obj->setProperty("bytesReceived", (juce::int64)bytesReceived);
+    obj->setProperty("overflows", (juce::int64)overflows);
+    obj->setProperty("maxBufferedBytes", maxBufferedBytes);
+    obj->setProperty("programChanges", (juce::int64)programChanges);
+    obj->setProperty("requestsAnswered", (juce::int64)requestsAnswered);
+    obj->setProperty("requestsIgnored", (juce::int64)requestsIgnored);
+    obj->setProperty("dumpsStored", (juce::int64)dumpsStored);
+    obj->setProperty("repliesDelivered", (juce::int64)repliesDelivered);
+    obj->setProperty("replyBytes", (juce::int64)replyBytes);
+    obj->setProperty("lastReplySeconds", lastReplySeconds);
+    return juce::var(obj.get());
+}
+
+SimulatedSynthTransport::SimulatedSynthTransport(const DeviceTemplate& device_)
+    : SimulatedSynthTransport(device_, Config())
+{
+}
+
+SimulatedSynthTransport::SimulatedSynthTransport(const DeviceTemplate& device_, const Config& config_)
+    : device(device_),
+      config(config_),
+      protocol(device_.getSysExProtocol()),
+      name(config_.name.isNotEmpty() ? config_.name : "Simulated " + device_.getDeviceName()),
+      deviceId(config_.deviceId >= 0 ? config_.deviceId : (protocol != nullptr ? protocol->getDefaultDeviceId() : 0))
+{
+}
+
+void SimulatedSynthTransport::processBlock(const juce::MidiBuffer& output, double sampleRate, int numSamples)
+{
+    jassert(sampleRate > 0.0);
+    
+    const juce::ScopedLock sl(lock);
+    const double blockStart = elapsedSeconds;
+    
+    for (const auto metadata : output)
+        receive(metadata.getMessage(), blockStart + metadata.samplePosition / sampleRate);
+    
+    elapsedSeconds = blockStart + numSamples / sampleRate;
+    
+    while (!replies.empty() && replies.front().arrivalSeconds <= elapsedSeconds)
+    {
+        const auto& reply = replies.front();
+        ++statistics.repliesDelivered;
+        statistics.replyBytes += (juce::uint64)reply.message.getRawDataSize();
+        statistics.lastReplySeconds = reply.arrivalSeconds;
+        deliver(reply.message);
+        replies.pop_front();
+    }
+}
+
+SimulatedSynthTransport::Statistics SimulatedSynthTransport::getStatistics() const
+{
+    const juce::ScopedLock sl(lock);
+    return statistics;
+}
+
+double SimulatedSynthTransport::getElapsedSeconds() const
+{
+    const juce::ScopedLock sl(lock);
+    return elapsedSeconds;
+}
+
+int SimulatedSynthTransport::getCurrentProgram() const
+{
+    const juce::ScopedLock sl(lock);
+    return currentProgram;
+}
+
+bool SimulatedSynthTransport::isIdle() const
+{
+    const juce::ScopedLock sl(lock);
+    return replies.empty() && busyUntilSeconds <= elapsedSeconds;
+}
+
+juce::MemoryBlock SimulatedSynthTransport::readMemory(juce::uint32 address, int size) const
+{
+    const juce::ScopedLock sl(lock);
+    
+    // A stored block answers reads of its start (e.g. a name read of a stored patch)
+    const auto stored = memory.find(address);
+    if (stored != memory.end() && (int)stored->second.getSize() >= size)
+        return juce::MemoryBlock(stored->second.getData(), (size_t)size);
+    
+    return generateMemory(address, size);
+}
+
+juce::uint32 SimulatedSynthTransport::getDumpKey(const juce::String& dumpName, int program)
+{
+    for (int i = 0; i < (int)(sizeof(dumpRules) / sizeof(dumpRules[0])); ++i)
+        if (dumpName == dumpRules[i].reply)
+            return dumpKeyFlag | ((juce::uint32)i << 16) | (dumpRules[i].perProgram ? (juce::uint32)(program & 0x7f) : 0u);
+    
+    jassertfalse; // Not a dump the simulator knows
+    return dumpKeyFlag | 0xffff;
+}
+
+void SimulatedSynthTransport::receive(const juce::MidiMessage& message, double arrivalSeconds)
+{
+    const int size = message.getRawDataSize();
+    ++statistics.messagesReceived;
+    statistics.bytesReceived += (juce::uint64)size;
+    
+    // The cable carries one message at a time
+    const double receiveStart = juce::jmax(arrivalSeconds, inputLinkFreeSeconds);
+    const double receiveEnd = receiveStart + secondsForBytes(size, config.inputBaudRate);
+    inputLinkFreeSeconds = receiveEnd;
+    
+    // Handling can't finish before the last byte is in
+    const double handleStart = juce::jmax(receiveStart, busyUntilSeconds);
+    const double handleEnd = juce::jmax(receiveEnd, handleStart + size / config.processingBytesPerSecond);
+    
+    // The buffer is fullest when this message's last byte arrives
+    while (!handling.empty() && handling.front().endSeconds <= receiveStart)
+        handling.pop_front();
+    
+    double buffered = remainingBytesAt(handleStart, handleEnd, size, receiveEnd);
+    
+    for (const auto& earlier : handling)
+        buffered += remainingBytesAt(earlier.startSeconds, earlier.endSeconds, earlier.size, receiveEnd);
+    
+    if (buffered > config.inputBufferBytes)
+    {
+        ++statistics.overflows;
+        return;
+    }
+    
+    statistics.maxBufferedBytes = juce::jmax(statistics.maxBufferedBytes, (int)std::ceil(buffered));
+    handling.push_back({ handleStart, handleEnd, size });
+    busyUntilSeconds = handleEnd;
+    
+    if (message.isProgramChange())
+    {
+        ++statistics.programChanges;
+        currentProgram = message.getProgramChangeNumber();
+    }
+    else if (message.isSysEx())
+    {
+        // Storing a dump stalls everything behind it
+        if (handleSysEx(message.getSysExData(), message.getSysExDataSize(), handleEnd))
+            busyUntilSeconds += config.dumpWriteMs / 1000.0;
+    }
+}
+
+bool SimulatedSynthTransport::handleSysEx(const juce::uint8* body, int size, double handledSeconds)
+{
+    if (protocol == nullptr)
+        return false;
+    
+    for (int i = 0; i < (int)(sizeof(dumpRules) / sizeof(dumpRules[0])); ++i)
+    {
+        const auto& rule = dumpRules[i];
+        const auto* requestFormat = protocol->getFormat(rule.request);
+        const auto* replyFormat = protocol->getFormat(rule.reply);
+        if (requestFormat == nullptr || replyFormat == nullptr)
+            continue;
+        
+        SysExMessageFormat::Decoded decoded;
+        
+        if (requestFormat->decode(body, size, decoded))
+        {
+            if (decoded.deviceId >= 0 && decoded.deviceId != deviceId)
+            {
+                ++statistics.requestsIgnored;
+                return false;
+            }
+            
+            SysExMessageFormat::Fields fields;
+            fields.deviceId = deviceId;
+            int payloadSize = rule.payloadSize;
+            
+            if (payloadSize == 0)
+            {
+                // Addressed: the size comes from the request, or the map the address is in
+                fields.address = decoded.address;
+                payloadSize = (int)decoded.size;
+                
+                int block = 0;
+                if (payloadSize == 0)
+                    if (const auto* map = findAddressMap(decoded.address, block))
+                        payloadSize = map->getBlock(block).length;
+            }
+            else
+            {
+                fields.address = getDumpKey(rule.reply, currentProgram);
+            }
+            
+            if (payloadSize <= 0)
+            {
+                ++statistics.requestsIgnored;
+                return false;
+            }
+            
+            const auto stored = memory.find(fields.address);
+            const auto payload = stored != memory.end() && (int)stored->second.getSize() >= payloadSize
+                                     ? juce::MemoryBlock(stored->second.getData(), (size_t)payloadSize)
+                                     : generateMemory(fields.address, payloadSize);
+            
+            if (rule.payloadSize != 0)
+                fields.address = 0; // Unaddressed formats carry no address
+            
+            sendReply(*replyFormat, fields, payload, handledSeconds);
+            ++statistics.requestsAnswered;
+            return false;
+        }
+        
+        if (replyFormat->decode(body, size, decoded))
+        {
+            if (decoded.deviceId >= 0 && decoded.deviceId != deviceId)
+                return false;
+            
+            const auto address = rule.payloadSize == 0 ? decoded.address : getDumpKey(rule.reply, currentProgram);
+            memory[address] = std::move(decoded.data);
+            ++statistics.dumpsStored;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+void SimulatedSynthTransport::sendReply(const SysExMessageFormat& format, const SysExMessageFormat::Fields& fields,
+                                        const juce::MemoryBlock& payload, double handledSeconds)
+{
+    juce::MemoryBlock body;
+    format.encodeInto(body, fields, static_cast<const juce::uint8*>(payload.getData()), (int)payload.getSize());
+    auto message = juce::MidiMessage::createSysExMessage(body.getData(), (int)body.getSize());
+    
+    const double sendStart = juce::jmax(handledSeconds + config.replyDelayMs / 1000.0, replyLinkFreeSeconds);
+    const double arrival = sendStart + secondsForBytes(message.getRawDataSize(), config.replyBaudRate);
+    replyLinkFreeSeconds = arrival;
+    
+    replies.push_back({ arrival, std::move(message) });
+}
+
+juce::MemoryBlock SimulatedSynthTransport::generateMemory(juce::uint32 address, int size) const
+{
+    juce::MemoryBlock data((size_t)size);
+    auto* bytes = static_cast<juce::uint8*>(data.getData());
+    
+    juce::Random random((juce::int64)config.seed * 0x9e3779b1 + address);
+    for (int i = 0; i < size; ++i)
+        bytes[i] = (juce::uint8)random.nextInt(128);
+    
+    // A readable name where the template keeps it, so name readback has something to show
+    int block = 0;
+    const auto* map = findAddressMap(address, block);
+    const int slot = (address & dumpKeyFlag) != 0 ? (int)(address & 0x7f)
+                   : map != nullptr && block == 0 ? map->getSlot(address) : -1;
+    const auto& nameRanges = protocol != nullptr ? protocol->getNonSoundRanges() : juce::Array<juce::Range<int>>();
+    auto nameRange = nameRanges.isEmpty() ? juce::Range<int>(0, size) : nameRanges.getFirst();
+    
+    if (nameRange.getEnd() > size)
+        nameRange = juce::Range<int>(0, size); // A name-only read
+    
+    if (slot >= 0 && !nameRange.isEmpty())
+    {
+        const auto text = ("SIM " + juce::String(slot).paddedLeft('0', 3)).paddedRight(' ', nameRange.getLength());
+        for (int i = 0; i < nameRange.getLength(); ++i)
+            bytes[nameRange.getStart() + i] = (juce::uint8)(text[i] & 0x7f);
+    }
+    
+    return data;
+}
+
+const SysExProtocol::AddressMap* SimulatedSynthTransport::findAddressMap(juce::uint32 address, int& block) const
+{
+    if (protocol == nullptr)
+        return nullptr;
+    
+    // The patch map first: a name read at the start of a patch block still reads a whole patch's worth
+    for (const auto* mapName : { SysExProtocol::PATCH_DATA, SysExProtocol::PATCH_NAME })
+    {
+        const auto* map = protocol->getAddressMap(mapName);
+        if (map != nullptr && map->getSlot(address, block) >= 0)
+            return map;
+    }
+    
+    return nullptr;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MidiTransport.h"
+#include "MidiWireModel.h"
+#include "../Model/DeviceTemplate.h"
+#include <deque>
+#include <map>
+
+/**
+ * Deterministic model of a hardware synth behind a MIDI cable.
+ * 
+ * Built from a DeviceTemplate, it answers the template's SysEx requests the
+ * way the built-in devices do: JV-1080 RQ1 requests with DT1 replies, DX7
+ * voice and bank dump requests, and M1 program dump requests. Dumps sent to
+ * it are stored, so a later request reads them back. Memory that was never
+ * written reads as pseudo-random data from Config::seed, with a "SIM nnn"
+ * name in the template's name range, so every run sees the same contents.
+ * 
+ * TIMING (simulated time, from the block stream):
+ * - Received bytes arrive at inputBaudRate; each message starts when the
+ *   link is free (0 = all at once, like a USB device)
+ * - The synth handles bytes at processingBytesPerSecond, one message after
+ *   another, and pauses for dumpWriteMs after storing a dump
+ * - Bytes received but not handled yet sit in an inputBufferBytes buffer.
+ *   A message that would overflow it is lost, as a real synth drops a
+ *   corrupted SysEx
+ * - A reply starts replyDelayMs after its request was handled and comes
+ *   back at replyBaudRate; it is delivered in the block during which its
+ *   last byte arrives
+ * 
+ * THREADING:
+ * - processBlock() may run on any one thread at a time; the inspection
+ *   methods may be called from any thread
+ * - Replies are delivered from processBlock()
+ */
+class SimulatedSynthTransport : public MidiTransport
+{
+public:
+    struct Config
+    {
+        juce::String name;                                      // Empty: "Simulated <device name>"
+        int deviceId = -1;                                      // -1: the protocol's default
+        double inputBaudRate = MidiWireModel::DIN_BAUD_RATE;    // Librarian to synth
+        double replyBaudRate = MidiWireModel::DIN_BAUD_RATE;    // Synth to librarian
+        int inputBufferBytes = 256;
+        double processingBytesPerSecond = 10000.0;
+        double dumpWriteMs = 20.0;
+        double replyDelayMs = 5.0;
+        juce::uint32 seed = 1;
+    };
+    
+    struct Statistics
+    {
+        juce::uint64 messagesReceived = 0;
+        juce::uint64 bytesReceived = 0;
+        juce::uint64 overflows = 0;             // Messages lost to a full input buffer
+        int maxBufferedBytes = 0;
+        juce::uint64 programChanges = 0;
+        juce::uint64 requestsAnswered = 0;
+        juce::uint64 requestsIgnored = 0;       // Another device ID, or nothing at that address
+        juce::uint64 dumpsStored = 0;
+        juce::uint64 repliesDelivered = 0;
+        juce::uint64 replyBytes = 0;
+        double lastReplySeconds = 0.0;          // Simulated time the last delivered reply finished arriving
+        
+        juce::var toVar() const;
+    };
+    
+    explicit SimulatedSynthTransport(const DeviceTemplate& device);
+    SimulatedSynthTransport(const DeviceTemplate& device, const Config& config);
+    ~SimulatedSynthTransport() override = default;
+    
+    juce::String getName() const override { return name; }
+    void processBlock(const juce::MidiBuffer& output, double sampleRate, int numSamples) override;
+    
+    // Inspection (thread-safe)
+    Statistics getStatistics() const;
+    double getElapsedSeconds() const;       // Simulated time so far
+    int getCurrentProgram() const;
+    bool isIdle() const;                    // Nothing being handled and no reply waiting to go back
+    const DeviceTemplate& getDevice() const noexcept { return device; }
+    
+    /**
+     * What a request for this address would return. Unaddressed dumps (DX7,
+     * M1) use getDumpKey() as their address.
+     */
+    juce::MemoryBlock readMemory(juce::uint32 address, int size) const;
+    static juce::uint32 getDumpKey(const juce::String& dumpName, int program);
+    
+private:
+    struct HandledMessage
+    {
+        double startSeconds;
+        double endSeconds;
+        int size;
+    };
+    
+    struct PendingReply
+    {
+        double arrivalSeconds;
+        juce::MidiMessage message;
+    };
+    
+    const DeviceTemplate device;
+    const Config config;
+    const SysExProtocol::Ptr protocol;
+    const juce::String name;
+    const int deviceId;
+    
+    juce::CriticalSection lock;
+    double elapsedSeconds = 0.0;
+    double inputLinkFreeSeconds = 0.0;
+    double replyLinkFreeSeconds = 0.0;
+    double busyUntilSeconds = 0.0;
+    int currentProgram = 0;
+    std::deque<HandledMessage> handling;    // Received, not finished by the time of the latest arrival
+    std::deque<PendingReply> replies;       // In arrival order
+    std::map<juce::uint32, juce::MemoryBlock> memory;
+    Statistics statistics;
+    
+    void receive(const juce::MidiMessage& message, double arrivalSeconds);
+    bool handleSysEx(const juce::uint8* body, int size, double handledSeconds);
+    void sendReply(const SysExMessageFormat& format, const SysExMessageFormat::Fields& fields,
+                   const juce::MemoryBlock& payload, double handledSeconds);
+    juce::MemoryBlock generateMemory(juce::uint32 address, int size) const;
+    const SysExProtocol::AddressMap* findAddressMap(juce::uint32 address, int& block) const; // Map with a block starting here
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SimulatedSynthTransport)
+};
@@ -0,0 +1,256 @@
+#include "SysExRequestManager.h"
+
+namespace
+{
+    constexpr int TIMER_INTERVAL_MS = 10;
+}
+
+SysExRequestManager::SysExRequestManager(MidiManager& manager, Clock clock_)
+    : midiManager(manager),
+      clock(std::move(clock_))
+{
+}
+
+SysExRequestManager::~SysExRequestManager()
+{
+    stopTimer();
+}
+
+void SysExRequestManager::configureDevice(const juce::String& deviceKey, const DeviceConfig& config)
+{
+    jassert(config.parser != nullptr);
+    
+    auto& device = devices[deviceKey];
+    device.config = config;
+    device.config.maxInFlight = juce::jmax(1, config.maxInFlight);
+    device.config.maxRetries = juce::jmax(0, config.maxRetries);
+}
+
+bool SysExRequestManager::isDeviceConfigured(const juce::String& deviceKey) const
+{
+    auto it = devices.find(deviceKey);
+    return it != devices.end() && it->second.config.parser != nullptr;
+}
+
+void SysExRequestManager::submit(const juce::String& deviceKey, Request request)
+{
+    auto it = devices.find(deviceKey);
+    if (it == devices.end() || it->second.config.parser == nullptr)
+    {
+        if (request.onComplete)
+            request.onComplete(juce::Result::fail("No SysEx protocol configured for device: " + deviceKey), {});
+        return;
+    }
+    
+    it->second.waiting.push_back(std::move(request));
+    fillPipeline(it->second);
+    updateTimer();
+}
+
+void SysExRequestManager::cancelAll(const juce::String& deviceKey)
+{
+    auto it = devices.find(deviceKey);
+    if (it == devices.end())
+        return;
+    
+    // Move everything out first: callbacks may submit new requests
+    auto waiting = std::move(it->second.waiting);
+    auto inFlight = std::move(it->second.inFlight);
+    it->second.waiting.clear();
+    it->second.inFlight.clear();
+    
+    const auto cancelled = juce::Result::fail("Request cancelled");
+    
+    for (auto& entry : inFlight)
+        if (entry.request.onComplete)
+            entry.request.onComplete(cancelled, {});
+    
+    for (auto& request : waiting)
+        if (request.onComplete)
+            request.onComplete(cancelled, {});
+    
+    updateTimer();
+}
+
+int SysExRequestManager::getNumPending(const juce::String& deviceKey) const
+{
+    auto it = devices.find(deviceKey);
+    if (it == devices.end())
+        return 0;
+    
+    return (int)(it->second.waiting.size() + it->second.inFlight.size());
+}
+
+bool SysExRequestManager::isIdle() const noexcept
+{
+    for (const auto& pair : devices)
+        if (!pair.second.waiting.empty() || !pair.second.inFlight.empty())
+            return false;
+    
+    return true;
+}
+
+void SysExRequestManager::handleIncomingSysEx(const juce::MidiMessage& message)
+{
+    if (!message.isSysEx())
+        return;
+    
+    const auto* data = message.getSysExData();
+    const int size = message.getSysExDataSize();
+    
+    for (auto& pair : devices)
+    {
+        auto& device = pair.second;
+        if (device.inFlight.empty())
+            continue;
+        
+        ParsedReply reply;
+        if (!device.config.parser(data, size, reply))
+            continue;
+        
+        for (size_t i = 0; i < device.inFlight.size(); ++i)
+        {
+            auto& entry = device.inFlight[i];
+            if (!device.config.matchInOrder && entry.request.address != reply.address)
+                continue;
+            
+            if (!reply.checksumValid)
+            {
+                // Corrupted on the way back: resend now instead of waiting for the timeout
+                ++statistics.checksumErrors;
+                
+                if (entry.attempts <= device.config.maxRetries && transmit(entry, device.config))
+                    ++statistics.retries;
+                else
+                    complete(device, i, juce::Result::fail("SysEx checksum error"), {});
+            }
+            else
+            {
+                ++statistics.repliesMatched;
+                complete(device, i, juce::Result::ok(), reply.payload);
+            }
+            
+            fillPipeline(device);
+            updateTimer();
+            return;
+        }
+    }
+    
+    ++statistics.unmatchedReplies;
+}
+
+void SysExRequestManager::timerCallback()
+{
+    pump();
+}
+
+void SysExRequestManager::pump()
+{
+    const double now = nowMs();
+    
+    for (auto& pair : devices)
+    {
+        auto& device = pair.second;
+        
+        for (size_t i = 0; i < device.inFlight.size();)
+        {
+            auto& entry = device.inFlight[i];
+            if (now < entry.deadlineMs)
+            {
+                ++i;
+                continue;
+            }
+            
+            if (entry.attempts <= device.config.maxRetries && transmit(entry, device.config))
+            {
+                ++statistics.retries;
+                ++i;
+            }
+            else
+            {
+                ++statistics.timeouts;
+                complete(device, i, juce::Result::fail("SysEx request timed out"), {});
+                // complete() removed index i; don't advance
+            }
+        }
+        
+        fillPipeline(device);
+    }
+    
+    updateTimer();
+}
+
+double SysExRequestManager::getNextDeadlineMs() const noexcept
+{
+    double next = std::numeric_limits<double>::max();
+    
+    for (const auto& pair : devices)
+        for (const auto& entry : pair.second.inFlight)
+            next = juce::jmin(next, entry.deadlineMs);
+    
+    return next;
+}
+
+void SysExRequestManager::fillPipeline(DeviceState& device)
+{
+    while ((int)device.inFlight.size() < device.config.maxInFlight && !device.waiting.empty())
+    {
+        InFlightRequest entry;
+        entry.request = std::move(device.waiting.front());
+        device.waiting.pop_front();
+        
+        if (!transmit(entry, device.config))
+        {
+            if (entry.request.onComplete)
+                entry.request.onComplete(juce::Result::fail("Could not queue SysEx request"), {});
+            continue;
+        }
+        
+        device.inFlight.push_back(std::move(entry));
+    }
+}
+
+bool SysExRequestManager::transmit(InFlightRequest& entry, const DeviceConfig& config)
+{
+    auto result = entry.request.beforeSend != nullptr ? entry.request.beforeSend() : juce::Result::ok();
+    
+    if (result.wasOk())
+        result = midiManager.sendSysEx(static_cast<const juce::uint8*>(entry.request.message.getData()),
+                                       (int)entry.request.message.getSize(),
+                                       MidiManager::Priority::interactive);
+    
+    if (result.failed())
+    {
+        juce::Logger::writeToLog("SysEx request failed: " + result.getErrorMessage());
+        return false;
+    }
+    
+    ++entry.attempts;
+    ++statistics.requestsSent;
+    
+    // The request can't be answered before it has left the queue, so start the clock after it
+    const double queueDelayMs = midiManager.estimateWireDelayMs(MidiManager::Priority::interactive);
+    entry.deadlineMs = nowMs() + queueDelayMs + config.timeoutMs;
+    return true;
+}
+
+void SysExRequestManager::complete(DeviceState& device, size_t inFlightIndex, const juce::Result& result,
+                                   const juce::MemoryBlock& payload)
+{
+    auto callback = std::move(device.inFlight[inFlightIndex].request.onComplete);
+    device.inFlight.erase(device.inFlight.begin() + (std::ptrdiff_t)inFlightIndex);
+    
+    if (callback)
+        callback(result, payload);
+}
+
+void SysExRequestManager::updateTimer()
+{
+    if (clock != nullptr)
+        return; // The owner pumps
+    
+    if (isIdle())
+        stopTimer();
+    else if (!isTimerRunning())
+        startTimer(TIMER_INTERVAL_MS);
+}
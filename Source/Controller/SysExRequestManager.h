@@ -0,0 +1,130 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MidiManager.h"
+#include <deque>
+#include <map>
+
+/**
+ * Request/response engine for reading data back from hardware via SysEx.
+ * 
+ * Callers submit data requests tagged with the address they ask for. The
+ * manager keeps up to maxInFlight requests outstanding per device
+ * (pipelining), matches incoming replies to requests by address using the
+ * device's reply parser, verifies the checksum, and retries or fails
+ * requests that time out or arrive corrupted.
+ * 
+ * CLOCK:
+ * - By default deadlines are in wall time and a timer on the message
+ *   thread retries and fails requests that time out
+ * - Constructed with a clock, the manager starts no timer: its owner calls
+ *   pump() while waiting, and deadlines are in that clock's milliseconds.
+ *   DeviceSession drives it this way from its worker, on simulated time
+ * 
+ * THREADING:
+ * - Without a clock all public methods are message-thread only; replies
+ *   arrive via handleIncomingSysEx(), which PatchManager calls from
+ *   MidiManager::onMidiInput (already marshalled to the message thread)
+ * - With a clock the manager may be used by one thread at a time, any thread
+ * - Requests go out through MidiManager's interactive lane, so a running
+ *   bulk transfer doesn't hold them up
+ * 
+ * All SysEx byte buffers here exclude the F0/F7 framing bytes.
+ */
+class SysExRequestManager : private juce::Timer
+{
+public:
+    struct ParsedReply
+    {
+        juce::uint32 address = 0;
+        juce::MemoryBlock payload;
+        bool checksumValid = true;
+    };
+    
+    /** Returns true if the SysEx body is a data reply for this device. */
+    using ReplyParser = std::function<bool(const juce::uint8* data, int size, ParsedReply& reply)>;
+    
+    using CompletionCallback = std::function<void(const juce::Result& result, const juce::MemoryBlock& payload)>;
+    
+    struct DeviceConfig
+    {
+        ReplyParser parser;
+        int maxInFlight = 4;   // Requests outstanding at once
+        int timeoutMs = 400;   // Per attempt
+        int maxRetries = 2;    // Resends after the first attempt
+        bool matchInOrder = false; // Replies carry no address: each answers the oldest request in flight
+    };
+    
+    struct Request
+    {
+        juce::uint32 address = 0;   // Correlation key, must match ParsedReply::address
+        juce::MemoryBlock message;  // Request body (without F0/F7)
+        std::function<juce::Result()> beforeSend; // Optional, before each attempt (e.g. a program change)
+        CompletionCallback onComplete;
+    };
+    
+    struct Statistics
+    {
+        int requestsSent = 0;
+        int repliesMatched = 0;
+        int retries = 0;
+        int timeouts = 0;
+        int checksumErrors = 0;
+        int unmatchedReplies = 0;
+    };
+    
+    using Clock = std::function<double()>; // Milliseconds
+    
+    explicit SysExRequestManager(MidiManager& midiManager, Clock clock = nullptr);
+    ~SysExRequestManager() override;
+    
+    // Devices are identified by a caller-chosen key (e.g. template ID + device ID)
+    void configureDevice(const juce::String& deviceKey, const DeviceConfig& config);
+    bool isDeviceConfigured(const juce::String& deviceKey) const;
+    
+    // Requests
+    void submit(const juce::String& deviceKey, Request request);
+    void cancelAll(const juce::String& deviceKey);
+    int getNumPending(const juce::String& deviceKey) const;
+    bool isIdle() const noexcept;
+    
+    // Incoming data (message thread, or the owner's thread with a clock)
+    void handleIncomingSysEx(const juce::MidiMessage& message);
+    
+    // Driving with an external clock
+    void pump();                                    // Retries and fails what has timed out
+    double getNextDeadlineMs() const noexcept;      // Clock time of the earliest deadline; max() if idle
+    
+    const Statistics& getStatistics() const noexcept { return statistics; }
+    
+private:
+    struct InFlightRequest
+    {
+        Request request;
+        int attempts = 0;
+        double deadlineMs = 0.0;
+    };
+    
+    struct DeviceState
+    {
+        DeviceConfig config;
+        std::deque<Request> waiting;
+        std::vector<InFlightRequest> inFlight;
+    };
+    
+    MidiManager& midiManager;
+    const Clock clock;
+    std::map<juce::String, DeviceState> devices;
+    Statistics statistics;
+    
+    void timerCallback() override;
+    void fillPipeline(DeviceState& device);
+    bool transmit(InFlightRequest& entry, const DeviceConfig& config);
+    void complete(DeviceState& device, size_t inFlightIndex, const juce::Result& result,
+                  const juce::MemoryBlock& payload);
+    void updateTimer();
+    
+    double nowMs() const { return clock != nullptr ? clock() : juce::Time::getMillisecondCounterHiRes(); }
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SysExRequestManager)
+};
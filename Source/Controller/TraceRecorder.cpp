@@ -0,0 +1,200 @@
+#include "TraceRecorder.h"
+
+std::atomic<bool> TraceRecorder::enabled { false };
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        juce::int64 startTicks;
+        juce::int64 durationTicks;
+        juce::uint64 flowId;
+        TraceRecorder::Phase phase;
+    };
+    
+    /** One thread's ring of events; only that thread writes to it. */
+    struct ThreadBuffer
+    {
+        juce::String threadName;
+        int threadId = 0;                           // Chrome "tid": registration order
+        juce::HeapBlock<Event> events { (size_t)TraceRecorder::RING_SIZE };
+        std::atomic<juce::uint64> numWritten { 0 };
+        std::atomic<juce::uint64> clearedAt { 0 };  // Events before this index were dropped by clear()
+    };
+    
+    const juce::int64 originTicks = juce::Time::getHighResolutionTicks();
+    
+    juce::SpinLock& getRegistryLock()
+    {
+        static juce::SpinLock lock;
+        return lock;
+    }
+    
+    juce::OwnedArray<ThreadBuffer>& getThreadBuffers()
+    {
+        static juce::OwnedArray<ThreadBuffer> buffers;
+        return buffers;
+    }
+    
+    thread_local ThreadBuffer* currentThreadBuffer = nullptr;
+    
+    /** Allocates this thread's buffer on its first event; buffers live until the process exits. */
+    ThreadBuffer& getCurrentThreadBuffer()
+    {
+        if (currentThreadBuffer == nullptr)
+        {
+            auto* buffer = new ThreadBuffer();
+            
+            if (auto* thread = juce::Thread::getCurrentThread())
+                buffer->threadName = thread->getThreadName();
+            else if (juce::MessageManager::existsAndIsCurrentThread())
+                buffer->threadName = "Message Thread";
+            
+            const juce::SpinLock::ScopedLockType sl(getRegistryLock());
+            auto& buffers = getThreadBuffers();
+            buffer->threadId = buffers.size() + 1;
+            
+            if (buffer->threadName.isEmpty())
+                buffer->threadName = "Thread " + juce::String(buffer->threadId);
+            
+            buffers.add(buffer);
+            currentThreadBuffer = buffer;
+        }
+        
+        return *currentThreadBuffer;
+    }
+    
+    double ticksToMicroseconds(juce::int64 ticks) noexcept
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6;
+    }
+    
+    juce::var eventToVar(const Event& event, int threadId)
+    {
+        juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+        obj->setProperty("name", juce::String(event.name));
+        obj->setProperty("cat", "midi-librarian");
+        obj->setProperty("pid", 1);
+        obj->setProperty("tid", threadId);
+        obj->setProperty("ts", ticksToMicroseconds(event.startTicks - originTicks));
+        
+        switch (event.phase)
+        {
+            case TraceRecorder::Phase::complete:
+                obj->setProperty("ph", "X");
+                obj->setProperty("dur", ticksToMicroseconds(event.durationTicks));
+                break;
+            
+            case TraceRecorder::Phase::instant:
+                obj->setProperty("ph", "i");
+                obj->setProperty("s", "t");
+                break;
+            
+            case TraceRecorder::Phase::flowStart:
+                obj->setProperty("ph", "s");
+                obj->setProperty("id", juce::String::toHexString((juce::int64)event.flowId));
+                break;
+            
+            case TraceRecorder::Phase::flowEnd:
+                obj->setProperty("ph", "f");
+                obj->setProperty("bp", "e"); // Bind to the enclosing slice, not the next one
+                obj->setProperty("id", juce::String::toHexString((juce::int64)event.flowId));
+                break;
+        }
+        
+        return juce::var(obj.get());
+    }
+}
+
+void TraceRecorder::setEnabled(bool shouldRecord) noexcept
+{
+    // Without MIDI_LIBRARIAN_TRACING there are no trace points to record
+    jassert(isCompiledIn() || !shouldRecord);
+    enabled.store(shouldRecord && isCompiledIn(), std::memory_order_relaxed);
+}
+
+void TraceRecorder::recordInstant(const char* name) noexcept
+{
+    if (isEnabled())
+        record(name, Phase::instant, juce::Time::getHighResolutionTicks(), 0, 0);
+}
+
+void TraceRecorder::recordFlow(const char* name, juce::uint64 flowId, bool isStart) noexcept
+{
+    if (isEnabled())
+        record(name, isStart ? Phase::flowStart : Phase::flowEnd, juce::Time::getHighResolutionTicks(), 0, flowId);
+}
+
+void TraceRecorder::record(const char* name, Phase phase, juce::int64 startTicks,
+                           juce::int64 durationTicks, juce::uint64 flowId) noexcept
+{
+    if (!isEnabled())
+        return;
+    
+    auto& buffer = getCurrentThreadBuffer();
+    const auto index = buffer.numWritten.load(std::memory_order_relaxed);
+    buffer.events[(size_t)(index % RING_SIZE)] = { name, startTicks, durationTicks, flowId, phase };
+    buffer.numWritten.store(index + 1, std::memory_order_release);
+}
+
+juce::var TraceRecorder::exportChromeTrace()
+{
+    juce::Array<ThreadBuffer*> buffers;
+    {
+        const juce::SpinLock::ScopedLockType sl(getRegistryLock());
+        for (auto* buffer : getThreadBuffers())
+            buffers.add(buffer);
+    }
+    
+    juce::Array<juce::var> traceEvents;
+    juce::Array<Event> copied;
+    
+    for (auto* buffer : buffers)
+    {
+        juce::DynamicObject::Ptr nameArgs = new juce::DynamicObject();
+        nameArgs->setProperty("name", buffer->threadName);
+        
+        juce::DynamicObject::Ptr threadName = new juce::DynamicObject();
+        threadName->setProperty("name", "thread_name");
+        threadName->setProperty("ph", "M");
+        threadName->setProperty("pid", 1);
+        threadName->setProperty("tid", buffer->threadId);
+        threadName->setProperty("args", juce::var(nameArgs.get()));
+        traceEvents.add(juce::var(threadName.get()));
+        
+        // Copy the ring, then drop whatever the owning thread may have overwritten meanwhile
+        const auto end = buffer->numWritten.load(std::memory_order_acquire);
+        const auto ringStart = end > (juce::uint64)RING_SIZE ? end - RING_SIZE : 0;
+        const auto begin = juce::jmax(ringStart, buffer->clearedAt.load(std::memory_order_relaxed));
+        
+        copied.clearQuick();
+        for (auto i = begin; i < end; ++i)
+            copied.add(buffer->events[(size_t)(i % RING_SIZE)]);
+        
+        const auto endAfterCopy = buffer->numWritten.load(std::memory_order_acquire);
+        const auto firstIntact = endAfterCopy > (juce::uint64)RING_SIZE ? endAfterCopy - RING_SIZE : 0;
+        
+        for (int i = 0; i < copied.size(); ++i)
+            if (begin + (juce::uint64)i >= firstIntact)
+                traceEvents.add(eventToVar(copied.getReference(i), buffer->threadId));
+    }
+    
+    juce::DynamicObject::Ptr trace = new juce::DynamicObject();
+    trace->setProperty("traceEvents", traceEvents);
+    trace->setProperty("displayTimeUnit", "ms");
+    return juce::var(trace.get());
+}
+
+bool TraceRecorder::writeChromeTrace(const juce::File& file)
+{
+    return file.replaceWithText(juce::JSON::toString(exportChromeTrace(), true));
+}
+
+void TraceRecorder::clear()
+{
+    const juce::SpinLock::ScopedLockType sl(getRegistryLock());
+    
+    for (auto* buffer : getThreadBuffers())
+        buffer->clearedAt.store(buffer->numWritten.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Scoped hot-path tracing with Chrome trace-event export.
+ * 
+ * Build with MIDI_LIBRARIAN_TRACING=1 to compile the trace points in; with
+ * the default of 0 every MIDI_LIBRARIAN_TRACE_* macro expands to nothing.
+ * When compiled in, recording still has to be switched on with setEnabled()
+ * (the MIDI monitor's Diagnostics menu does this); while it is off a trace
+ * point costs one relaxed atomic load.
+ * 
+ * Each thread writes into its own fixed-size ring buffer (no locks, no
+ * allocation after the thread's first event), keeping the most recent
+ * RING_SIZE events. exportChromeTrace() collects all buffers into the JSON
+ * format read by chrome://tracing and ui.perfetto.dev; flows (arrows between
+ * threads) connect e.g. a recall on the message thread to the block that
+ * put it on the wire.
+ * 
+ * Names must be string literals (only the pointer is stored).
+ * 
+ *     void PatchManager::recallPatch(int slotIndex)
+ *     {
+ *         MIDI_LIBRARIAN_TRACE_SCOPE("PatchManager::recallPatch");
+ *         ...
+ */
+#ifndef MIDI_LIBRARIAN_TRACING
+ #define MIDI_LIBRARIAN_TRACING 0
+#endif
+
+class TraceRecorder
+{
+public:
+    static constexpr int RING_SIZE = 8192; // Events kept per thread
+    
+    enum class Phase : juce::uint8
+    {
+        complete,       // A scope with a duration
+        instant,
+        flowStart,      // Start of an arrow to the matching flowEnd (same name and id)
+        flowEnd
+    };
+    
+    /** Records the enclosing scope as one complete event. */
+    class ScopedTrace
+    {
+    public:
+        explicit ScopedTrace(const char* eventName) noexcept
+            : name(eventName), startTicks(isEnabled() ? juce::Time::getHighResolutionTicks() : 0)
+        {
+        }
+        
+        ~ScopedTrace() noexcept
+        {
+            if (startTicks != 0)
+                record(name, Phase::complete, startTicks, juce::Time::getHighResolutionTicks() - startTicks, 0);
+        }
+    
+    private:
+        const char* name;
+        const juce::int64 startTicks;
+        
+        JUCE_DECLARE_NON_COPYABLE(ScopedTrace)
+    };
+    
+    TraceRecorder() = delete;
+    
+    static constexpr bool isCompiledIn() noexcept { return MIDI_LIBRARIAN_TRACING != 0; }
+    static bool isEnabled() noexcept { return enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool shouldRecord) noexcept;
+    
+    // Recording (lock-free; call through the macros)
+    static void recordInstant(const char* name) noexcept;
+    static void recordFlow(const char* name, juce::uint64 flowId, bool isStart) noexcept;
+    static void record(const char* name, Phase phase, juce::int64 startTicks,
+                       juce::int64 durationTicks, juce::uint64 flowId) noexcept;
+    
+    // Export (message thread; events recorded meanwhile may be left out)
+    static juce::var exportChromeTrace();
+    static bool writeChromeTrace(const juce::File& file);
+    static void clear(); // Drops recorded events; thread buffers are kept
+    
+private:
+    static std::atomic<bool> enabled;
+};
+
+#if MIDI_LIBRARIAN_TRACING
+ #define MIDI_LIBRARIAN_TRACE_SCOPE(name)           const TraceRecorder::ScopedTrace JUCE_JOIN_MACRO(traceScope_, __LINE__)(name)
+ #define MIDI_LIBRARIAN_TRACE_INSTANT(name)         TraceRecorder::recordInstant(name)
+ #define MIDI_LIBRARIAN_TRACE_FLOW_BEGIN(name, id)  TraceRecorder::recordFlow(name, (juce::uint64)(id), true)
+ #define MIDI_LIBRARIAN_TRACE_FLOW_END(name, id)    TraceRecorder::recordFlow(name, (juce::uint64)(id), false)
+#else
+ #define MIDI_LIBRARIAN_TRACE_SCOPE(name)
+ #define MIDI_LIBRARIAN_TRACE_INSTANT(name)
+ #define MIDI_LIBRARIAN_TRACE_FLOW_BEGIN(name, id)
+ #define MIDI_LIBRARIAN_TRACE_FLOW_END(name, id)
+#endif
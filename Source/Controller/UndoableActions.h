@@ -3,161 +3,193 @@
 #include <JuceHeader.h>
 #include "../Model/PatchBank.h"
 #include "../Model/PatchData.h"
+#include "PatchDelta.h"
 
 /**
- * Undoable action for renaming a patch.
+ * Undoable edit of one or more patches, stored as field-level deltas.
+ * 
+ * Construct it with the new contents of the slots before performing it: it
+ * diffs them against the bank and keeps only what changed, so renaming a
+ * patch records two names rather than a copy of the patch. Unchanged slots
+ * are dropped; check isEmpty() before handing it to the UndoManager.
+ * 
+ * getSizeInUnits() returns bytes (see PatchDelta::getSizeInBytes()), so the
+ * UndoManager's unit limit is a memory budget for the history. Performing or
+ * undoing it is one PatchBank transaction, however many slots it touches.
+ * Fields another instance has changed since are left as they are (see
+ * PatchDelta::applyTo()), so a library publish needn't clear the history.
+ * 
+ * Coalescible single-slot edits merge with the previous action in the same
+ * transaction when it edited the same slot, so the owner decides what counts
+ * as one step by when it begins a new transaction.
  */
-class RenamePatchAction : public juce::UndoableAction
+class PatchEditAction : public juce::UndoableAction
 {
 public:
-    RenamePatchAction(PatchBank& bank, int slotIndex, 
-                     const juce::String& newName, const juce::String& oldName)
+    PatchEditAction(PatchBank& bank, const juce::Array<int>& slots,
+                    const juce::Array<PatchData>& newPatches, bool coalescible = false)
         : patchBank(bank)
-        , slotIndex(slotIndex)
-        , newName(newName)
-        , oldName(oldName)
+        , coalescible(coalescible)
     {
+        jassert(slots.size() == newPatches.size());
+        
+        for (int i = 0; i < slots.size(); ++i)
+        {
+            if (!bank.isValidSlot(slots[i]))
+                continue;
+            
+            auto delta = PatchDelta::between(bank.getPatch(slots[i]), newPatches.getReference(i));
+            if (!delta.isEmpty())
+                changes.add({ slots[i], std::move(delta) });
+        }
+        
+        changes.minimiseStorageOverheads();
     }
     
+    bool isEmpty() const noexcept { return changes.isEmpty(); }
+    
     bool perform() override
     {
-        patchBank.renamePatch(slotIndex, newName);
+        const PatchBank::ScopedTransaction transaction(patchBank);
+        for (const auto& change : changes)
+            apply(change, true);
         return true;
     }
     
     bool undo() override
     {
-        patchBank.renamePatch(slotIndex, oldName);
+        const PatchBank::ScopedTransaction transaction(patchBank);
+        for (int i = changes.size(); --i >= 0;)
+            apply(changes.getReference(i), false);
         return true;
     }
     
-    int getSizeInUnits() override { return 1; }
-    
-private:
-    PatchBank& patchBank;
-    int slotIndex;
-    juce::String newName;
-    juce::String oldName;
-};
-
-/**
- * Undoable action for setting patch favorite status.
- */
-class SetFavoriteAction : public juce::UndoableAction
-{
-public:
-    SetFavoriteAction(PatchBank& bank, int slotIndex, bool newFavorite, bool oldFavorite)
-        : patchBank(bank)
-        , slotIndex(slotIndex)
-        , newFavorite(newFavorite)
-        , oldFavorite(oldFavorite)
+    int getSizeInUnits() override
     {
+        auto bytes = sizeof(*this);
+        for (const auto& change : changes)
+            bytes += sizeof(SlotChange) - sizeof(PatchDelta) + change.delta.getSizeInBytes();
+        
+        return (int)juce::jmin(bytes, (size_t)std::numeric_limits<int>::max());
     }
     
-    bool perform() override
+    juce::UndoableAction* createCoalescedAction(juce::UndoableAction* nextAction) override
     {
-        auto& patch = patchBank.getPatch(slotIndex);
-        patch.setFavorite(newFavorite);
-        patchBank.setPatch(slotIndex, patch);
-        return true;
+        auto* next = dynamic_cast<PatchEditAction*>(nextAction);
+        
+        if (next == nullptr || !coalescible || !next->coalescible || &next->patchBank != &patchBank
+            || changes.size() != 1 || next->changes.size() != 1
+            || changes.getReference(0).slotIndex != next->changes.getReference(0).slotIndex)
+            return nullptr;
+        
+        auto* merged = new PatchEditAction(patchBank, true);
+        merged->changes = changes;
+        merged->changes.getReference(0).delta.mergeWith(next->changes.getReference(0).delta);
+        return merged;
     }
     
-    bool undo() override
+private:
+    struct SlotChange
     {
-        auto& patch = patchBank.getPatch(slotIndex);
-        patch.setFavorite(oldFavorite);
-        patchBank.setPatch(slotIndex, patch);
-        return true;
-    }
-    
-    int getSizeInUnits() override { return 1; }
+        int slotIndex;
+        PatchDelta delta;
+    };
     
-private:
     PatchBank& patchBank;
-    int slotIndex;
-    bool newFavorite;
-    bool oldFavorite;
+    bool coalescible;
+    juce::Array<SlotChange> changes;
+    
+    PatchEditAction(PatchBank& bank, bool coalescible)
+        : patchBank(bank)
+        , coalescible(coalescible)
+    {
+    }
+    
+    // Called inside a bank transaction, so the whole action is one change message
+    void apply(const SlotChange& change, bool forward)
+    {
+        auto patch = patchBank.getPatch(change.slotIndex);
+        change.delta.applyTo(patch, forward);
+        patchBank.setPatch(change.slotIndex, patch);
+    }
 };
 
 /**
- * Undoable action for copying a patch to another slot.
+ * Undoable reorder of the bank's slots.
+ * 
+ * Stores only the slots that moved (two bytes each) rather than any patch
+ * contents, and performs the whole reorder as one PatchBank::permute().
+ * onApplied is called with the order just applied (to the bank as it now
+ * is) after perform and after undo, so the owner can bring the device in line.
  */
-class CopyPatchAction : public juce::UndoableAction
+class PermutePatchesAction : public juce::UndoableAction
 {
 public:
-    CopyPatchAction(PatchBank& bank, int sourceSlot, int destSlot)
+    PermutePatchesAction(PatchBank& bank, const juce::Array<int>& order,
+                         std::function<void(const juce::Array<int>&)> onApplied = nullptr)
         : patchBank(bank)
-        , sourceSlot(sourceSlot)
-        , destSlot(destSlot)
-        , oldPatch(bank.getPatch(destSlot))
+        , onApplied(std::move(onApplied))
     {
+        jassert(order.size() == PatchBank::BANK_SIZE);
+        
+        for (int i = 0; i < order.size(); ++i)
+            if (order[i] != i)
+                moves.add({ (juce::uint8)i, (juce::uint8)order[i] });
+        
+        moves.minimiseStorageOverheads();
     }
     
+    bool isEmpty() const noexcept { return moves.isEmpty(); }
+    
     bool perform() override
     {
-        const auto& sourcePatch = patchBank.getPatch(sourceSlot);
-        auto newPatch = sourcePatch;
-        newPatch.setSlotIndex(destSlot);
-        patchBank.setPatch(destSlot, newPatch);
+        apply(true);
         return true;
     }
     
     bool undo() override
     {
-        patchBank.setPatch(destSlot, oldPatch);
+        apply(false);
         return true;
     }
     
-    int getSizeInUnits() override { return 1; }
+    int getSizeInUnits() override
+    {
+        return (int)(sizeof(*this) + (size_t)moves.size() * sizeof(Move));
+    }
     
 private:
-    PatchBank& patchBank;
-    int sourceSlot;
-    int destSlot;
-    PatchData oldPatch;
-};
-
-/**
- * Undoable action for batch renaming patches.
- */
-class BatchRenameAction : public juce::UndoableAction
-{
-public:
-    struct PatchChange
-    {
-        int slotIndex;
-        juce::String oldName;
-        juce::String newName;
-    };
+    static_assert(PatchBank::BANK_SIZE <= 256, "Slot numbers are stored as bytes");
     
-    BatchRenameAction(PatchBank& bank, const juce::Array<PatchChange>& changes)
-        : patchBank(bank)
-        , changes(changes)
+    struct Move
     {
-    }
+        juce::uint8 to;
+        juce::uint8 from;
+    };
     
-    bool perform() override
-    {
-        for (const auto& change : changes)
-        {
-            patchBank.renamePatch(change.slotIndex, change.newName);
-        }
-        return true;
-    }
+    PatchBank& patchBank;
+    std::function<void(const juce::Array<int>&)> onApplied;
+    juce::Array<Move> moves;
     
-    bool undo() override
+    void apply(bool forward)
     {
-        for (const auto& change : changes)
+        juce::Array<int> order;
+        order.ensureStorageAllocated(PatchBank::BANK_SIZE);
+        for (int i = 0; i < PatchBank::BANK_SIZE; ++i)
+            order.add(i);
+        
+        // Undo applies the inverse: the patch now in slot "to" goes back to "from"
+        for (const auto& move : moves)
         {
-            patchBank.renamePatch(change.slotIndex, change.oldName);
+            if (forward)
+                order.set(move.to, move.from);
+            else
+                order.set(move.from, move.to);
         }
-        return true;
+        
+        patchBank.permute(order);
+        
+        if (onApplied)
+            onApplied(order);
     }
-    
-    int getSizeInUnits() override { return changes.size(); }
-    
-private:
-    PatchBank& patchBank;
-    juce::Array<PatchChange> changes;
 };
-
@@ -4,8 +4,10 @@ juce::var DeviceModel::toVar() const
 {
     juce::DynamicObject::Ptr obj = new juce::DynamicObject();
     obj->setProperty("midiOutputPortName", midiOutputPortName);
+    obj->setProperty("midiOutputPortIdentifier", midiOutputPortIdentifier);
     obj->setProperty("midiChannel", midiChannel + 1); // Store as 1-16
     obj->setProperty("deviceID", deviceID.toString());
+    obj->setProperty("sysExDeviceId", sysExDeviceId);
     obj->setProperty("deviceTemplate", deviceTemplate.toVar());
     return juce::var(obj);
 }
@@ -15,9 +17,11 @@ void DeviceModel::fromVar(const juce::var& v)
     if (auto* obj = v.getDynamicObject())
     {
         midiOutputPortName = obj->getProperty("midiOutputPortName").toString();
+        midiOutputPortIdentifier = obj->getProperty("midiOutputPortIdentifier").toString(); // Absent in older configs
         int channel = obj->getProperty("midiChannel");
         setMidiChannel(channel); // This handles validation
         deviceID = juce::Identifier(obj->getProperty("deviceID").toString());
+        setSysExDeviceId(obj->getProperty("sysExDeviceId").isVoid() ? -1 : (int)obj->getProperty("sysExDeviceId")); // Absent in older configs
         
         // Load template if present
         if (obj->hasProperty("deviceTemplate"))
@@ -15,12 +15,15 @@ public:
     
     // Getters
     juce::String getMidiOutputPortName() const noexcept { return midiOutputPortName; }
+    juce::String getMidiOutputPortIdentifier() const noexcept { return midiOutputPortIdentifier; }
     int getMidiChannel() const noexcept { return midiChannel; }
     juce::Identifier getDeviceID() const noexcept { return deviceID; }
     const DeviceTemplate& getTemplate() const noexcept { return deviceTemplate; }
+    int getSysExDeviceId() const noexcept { return sysExDeviceId; } // -1: the protocol's default
     
     // Setters
     void setMidiOutputPortName(const juce::String& name) noexcept { midiOutputPortName = name; }
+    void setMidiOutputPortIdentifier(const juce::String& identifier) noexcept { midiOutputPortIdentifier = identifier; }
     void setMidiChannel(int channel) noexcept 
     { 
         // MIDI channels are 1-16, but we store 0-15 internally
@@ -34,6 +37,7 @@ public:
         deviceTemplate.setDeviceID(id);
     }
     void setTemplate(const DeviceTemplate& template_) noexcept { deviceTemplate = template_; }
+    void setSysExDeviceId(int id) noexcept { sysExDeviceId = juce::jlimit(-1, 127, id); }
     
     // Helper: Get MIDI channel as 1-16 for display
     int getMidiChannelDisplay() const noexcept { return midiChannel + 1; }
@@ -41,6 +45,16 @@ public:
     // Helper: Get MIDI channel as 0-15 for MIDI messages
     int getMidiChannelZeroBased() const noexcept { return midiChannel; }
     
+    // The device ID byte to put in SysEx messages: the one set, or the protocol's default
+    int getEffectiveSysExDeviceId() const noexcept
+    {
+        if (sysExDeviceId >= 0)
+            return sysExDeviceId;
+        
+        auto protocol = deviceTemplate.getSysExProtocol();
+        return protocol != nullptr ? protocol->getDefaultDeviceId() : 0;
+    }
+    
     // Template helpers
     bool isValidPatchNumber(int patchNumber) const noexcept
     {
@@ -53,7 +67,9 @@ public:
     
 private:
     juce::String midiOutputPortName;
+    juce::String midiOutputPortIdentifier; // MidiDeviceInfo::identifier; the name is the fallback
     int midiChannel = 0; // 0-15 (channel 1-16)
     juce::Identifier deviceID = "generic";
+    int sysExDeviceId = -1; // The unit's SysEx device ID if it isn't the protocol's default
     DeviceTemplate deviceTemplate = DeviceTemplate::createGeneric();
 };
@@ -1,4 +1,5 @@
 #include "DeviceTemplate.h"
+#include "FactoryTemplates.h"
 
 juce::var DeviceTemplate::toVar() const
 {
@@ -12,6 +13,13 @@ juce::var DeviceTemplate::toVar() const
     obj->setProperty("useMSB", useMSB);
     obj->setProperty("useLSB", useLSB);
     obj->setProperty("defaultChannel", defaultChannel);
+    
+    if (sysExProtocol != nullptr)
+        obj->setProperty("sysex", sysExProtocol->toVar());
+    
+    if (parameterMap != nullptr)
+        obj->setProperty("parameters", parameterMap->toVar());
+    
     return juce::var(obj);
 }
 
@@ -30,6 +38,28 @@ DeviceTemplate DeviceTemplate::fromVar(const juce::var& v)
         template_.useMSB = obj->getProperty("useMSB", true);
         template_.useLSB = obj->getProperty("useLSB", false);
         template_.defaultChannel = obj->getProperty("defaultChannel", 1);
+        
+        if (obj->hasProperty("sysex"))
+        {
+            auto result = SysExProtocol::compile(obj->getProperty("sysex"), template_.sysExProtocol);
+            if (result.failed())
+            {
+                juce::Logger::writeToLog("Template " + template_.deviceID.toString() + ": "
+                                         + result.getErrorMessage());
+                template_.sysExProtocol = nullptr;
+            }
+        }
+        
+        if (obj->hasProperty("parameters"))
+        {
+            auto result = ParameterMap::compile(obj->getProperty("parameters"), template_.parameterMap);
+            if (result.failed())
+            {
+                juce::Logger::writeToLog("Template " + template_.deviceID.toString() + ": "
+                                         + result.getErrorMessage());
+                template_.parameterMap = nullptr;
+            }
+        }
     }
     
     return template_;
@@ -37,36 +67,6 @@ DeviceTemplate DeviceTemplate::fromVar(const juce::var& v)
 
 DeviceTemplate DeviceTemplate::createGeneric()
 {
-    DeviceTemplate t("Generic", "Generic", "generic");
-    t.setPatchRange(0, 127);
-    t.setDefaultChannel(1);
-    return t;
+    // Built-in devices are rows in the FactoryTemplates table; row 0 is generic
+    return *FactoryTemplates::materialize(0);
 }
-
-DeviceTemplate DeviceTemplate::createRolandJV1080()
-{
-    DeviceTemplate t("JV-1080", "Roland", "roland_jv1080");
-    t.setPatchRange(0, 127);
-    t.setBankSelect(true, true, false); // Uses MSB only
-    t.setDefaultChannel(1);
-    return t;
-}
-
-DeviceTemplate DeviceTemplate::createYamahaDX7()
-{
-    DeviceTemplate t("DX7", "Yamaha", "yamaha_dx7");
-    t.setPatchRange(0, 31); // DX7 has 32 patches
-    t.setBankSelect(false); // No bank select
-    t.setDefaultChannel(1);
-    return t;
-}
-
-DeviceTemplate DeviceTemplate::createKorgM1()
-{
-    DeviceTemplate t("M1", "Korg", "korg_m1");
-    t.setPatchRange(0, 127);
-    t.setBankSelect(true, true, true); // Uses both MSB and LSB
-    t.setDefaultChannel(1);
-    return t;
-}
-
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "SysExProtocol.h"
+#include "ParameterMap.h"
 
 /**
  * Device template/profile for specific hardware synths.
@@ -10,8 +12,8 @@
  * - MIDI channel requirements
  * - Bank select method (MSB/LSB/both)
  * - Valid patch ranges
- * - SysEx command formats (future)
- * - Parameter maps (future)
+ * - SysEx message layouts and address maps (see SysExProtocol)
+ * - Editable parameters and their CC/NRPN/SysEx transport (see ParameterMap)
  */
 class DeviceTemplate
 {
@@ -37,6 +39,9 @@ public:
     bool usesMSB() const noexcept { return useMSB; }
     bool usesLSB() const noexcept { return useLSB; }
     int getDefaultChannel() const noexcept { return defaultChannel; }
+    SysExProtocol::Ptr getSysExProtocol() const noexcept { return sysExProtocol; }
+    bool hasSysExProtocol() const noexcept { return sysExProtocol != nullptr; }
+    ParameterMap::Ptr getParameterMap() const noexcept { return parameterMap; }
     
     // Setters
     void setDeviceName(const juce::String& name) noexcept { deviceName = name; }
@@ -57,6 +62,8 @@ public:
     { 
         defaultChannel = juce::jlimit(1, 16, channel); 
     }
+    void setSysExProtocol(SysExProtocol::Ptr protocol) noexcept { sysExProtocol = std::move(protocol); }
+    void setParameterMap(ParameterMap::Ptr map) noexcept { parameterMap = std::move(map); }
     
     // Validation
     bool isValidPatchNumber(int patchNumber) const noexcept
@@ -68,11 +75,8 @@ public:
     juce::var toVar() const;
     static DeviceTemplate fromVar(const juce::var& v);
     
-    // Factory methods for common devices
+    // Fallback template (other built-in devices: see FactoryTemplates)
     static DeviceTemplate createGeneric();
-    static DeviceTemplate createRolandJV1080();
-    static DeviceTemplate createYamahaDX7();
-    static DeviceTemplate createKorgM1();
     
 private:
     juce::String deviceName = "Generic";
@@ -84,5 +88,7 @@ private:
     bool useMSB = true;
     bool useLSB = false;
     int defaultChannel = 1;
+    SysExProtocol::Ptr sysExProtocol; // Compiled once when loaded; shared between copies
+    ParameterMap::Ptr parameterMap;   // Likewise
 };
 
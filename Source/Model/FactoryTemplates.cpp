@@ -0,0 +1,307 @@
+#include "FactoryTemplates.h"
+#include <mutex>
+
+namespace
+{
+    using Device = FactoryTemplates::Device;
+    using BankSelect = FactoryTemplates::BankSelect;
+    
+    // General MIDI sound controllers; most modern synths follow these
+    constexpr const char* genericParameters = R"json(
+    [
+        { "id": "modulation", "name": "Modulation", "cc": 1 },
+        { "id": "volume", "name": "Volume", "cc": 7, "default": 100 },
+        { "id": "pan", "name": "Pan", "cc": 10, "default": 64 },
+        { "id": "resonance", "name": "Resonance", "cc": 71, "default": 64 },
+        { "id": "release", "name": "Release", "cc": 72, "default": 64 },
+        { "id": "attack", "name": "Attack", "cc": 73, "default": 64 },
+        { "id": "cutoff", "name": "Cutoff", "cc": 74, "default": 64 },
+        { "id": "reverb", "name": "Reverb Send", "cc": 91, "default": 40 },
+        { "id": "chorus", "name": "Chorus Send", "cc": 93 }
+    ])json";
+    
+    // Roland JV-1080: RQ1/DT1 with 4-byte addresses and a Roland checksum.
+    // User patch n is at 11 nn 00 00: a 72-byte common block (the name is its first
+    // 12 bytes) and 129-byte tone blocks at 10 00, 12 00, 14 00 and 16 00. A dump is
+    // all five, 588 bytes, so a patch is only ever moved or restored whole.
+    constexpr const char* rolandJV1080SysEx = R"json(
+    {
+        "deviceId": 16,
+        "messages": [
+            { "name": "dataRequest", "header": [ "0x41", "deviceId", "0x6a", "0x11" ],
+              "addressBytes": 4, "sizeBytes": 4, "data": "none", "checksum": "roland" },
+            { "name": "dataSet", "header": [ "0x41", "deviceId", "0x6a", "0x12" ],
+              "addressBytes": 4, "data": "raw", "checksum": "roland" }
+        ],
+        "addresses": {
+            "patchName": { "base": "0x11000000", "stride": "0x10000", "length": 12 },
+            "patch": { "base": "0x11000000", "stride": "0x10000",
+                       "blocks": [ [ "0x0000", 72 ], [ "0x1000", 129 ], [ "0x1200", 129 ],
+                                   [ "0x1400", 129 ], [ "0x1600", 129 ] ] }
+        },
+        "ignoreForComparison": [ [ 0, 12 ] ]
+    })json";
+    
+    // JV-1080 patch mode receives these CCs on the patch's receive channel
+    constexpr const char* rolandJV1080Parameters = R"json(
+    [
+        { "id": "modulation", "name": "Modulation", "cc": 1 },
+        { "id": "volume", "name": "Volume", "cc": 7, "default": 127 },
+        { "id": "pan", "name": "Pan", "cc": 10, "default": 64 },
+        { "id": "reverb", "name": "Reverb Send", "cc": 91 },
+        { "id": "chorus", "name": "Chorus Send", "cc": 93 }
+    ])json";
+    
+    // Yamaha DX7: dump requests (2n), voice/bank dumps (0n) with a checksum over the data,
+    // and parameter changes (1n) addressed by group and parameter number.
+    // The voice name is VCED bytes 145-154.
+    constexpr const char* yamahaDX7SysEx = R"json(
+    {
+        "deviceId": 0,
+        "messages": [
+            { "name": "voiceDumpRequest", "header": [ "0x43", { "deviceId": "0x20" }, "0x00" ] },
+            { "name": "bankDumpRequest", "header": [ "0x43", { "deviceId": "0x20" }, "0x09" ] },
+            { "name": "voiceDump", "header": [ "0x43", { "deviceId": "0x00" }, "0x00", "0x01", "0x1b" ],
+              "data": "raw", "checksum": "yamaha" },
+            { "name": "bankDump", "header": [ "0x43", { "deviceId": "0x00" }, "0x09", "0x20", "0x00" ],
+              "data": "raw", "checksum": "yamaha" },
+            { "name": "parameterChange", "header": [ "0x43", { "deviceId": "0x10" } ],
+              "addressBytes": 2, "data": "raw" }
+        ],
+        "ignoreForComparison": [ [ 145, 155 ] ]
+    })json";
+    
+    // DX7 voice parameters (VCED numbers) via the parameterChange SysEx message;
+    // parameters 128-155 are in group 1, so 134 is addressed as 01 06
+    constexpr const char* yamahaDX7Parameters = R"json(
+    [
+        { "id": "algorithm", "name": "Algorithm", "sysex": "parameterChange", "address": "0x0106", "max": 31 },
+        { "id": "feedback", "name": "Feedback", "sysex": "parameterChange", "address": "0x0107", "max": 7 },
+        { "id": "lfoSpeed", "name": "LFO Speed", "sysex": "parameterChange", "address": "0x0109", "max": 99, "default": 35 },
+        { "id": "lfoDelay", "name": "LFO Delay", "sysex": "parameterChange", "address": "0x010a", "max": 99 },
+        { "id": "transpose", "name": "Transpose", "sysex": "parameterChange", "address": "0x0110", "max": 48, "default": 24 }
+    ])json";
+    
+    // Korg M1: function codes after the 42 3n 19 header; dumps use 7-in-8 packing, no checksum.
+    // The program name is the first 10 bytes of the unpacked program data.
+    constexpr const char* korgM1SysEx = R"json(
+    {
+        "deviceId": 0,
+        "messages": [
+            { "name": "programDumpRequest", "header": [ "0x42", { "deviceId": "0x30" }, "0x19", "0x10" ] },
+            { "name": "programDump", "header": [ "0x42", { "deviceId": "0x30" }, "0x19", "0x40" ],
+              "data": "packed7" },
+            { "name": "allProgramsDumpRequest", "header": [ "0x42", { "deviceId": "0x30" }, "0x19", "0x1c" ] },
+            { "name": "allProgramsDump", "header": [ "0x42", { "deviceId": "0x30" }, "0x19", "0x4c" ],
+              "data": "packed7" }
+        ],
+        "ignoreForComparison": [ [ 0, 10 ] ]
+    })json";
+    
+    constexpr const char* korgM1Parameters = R"json(
+    [
+        { "id": "modulation", "name": "Modulation", "cc": 1 },
+        { "id": "volume", "name": "Volume", "cc": 7, "default": 127 }
+    ])json";
+    
+    constexpr Device devices[] =
+    {
+        { "generic",       "Generic", "Generic", 0, 127, BankSelect::none,      1, nullptr,           genericParameters },
+        { "roland_jv1080", "JV-1080", "Roland",  0, 127, BankSelect::msb,       1, rolandJV1080SysEx, rolandJV1080Parameters },
+        { "yamaha_dx7",    "DX7",     "Yamaha",  0, 31,  BankSelect::none,      1, yamahaDX7SysEx,    yamahaDX7Parameters },
+        { "korg_m1",       "M1",      "Korg",    0, 127, BankSelect::msbAndLsb, 1, korgM1SysEx,       korgM1Parameters },
+    };
+    
+    constexpr int numDevices = (int)(sizeof(devices) / sizeof(devices[0]));
+    
+    // Compile-time checks
+    
+    constexpr bool stringsEqual(const char* a, const char* b)
+    {
+        while (*a != 0 && *a == *b)
+        {
+            ++a;
+            ++b;
+        }
+        return *a == *b;
+    }
+    
+    constexpr bool isValidId(const char* id)
+    {
+        if (id == nullptr || *id == 0)
+            return false;
+        
+        // Lower-case snake case, as used for template file names
+        for (; *id != 0; ++id)
+            if (!((*id >= 'a' && *id <= 'z') || (*id >= '0' && *id <= '9') || *id == '_'))
+                return false;
+        
+        return true;
+    }
+    
+    constexpr bool isNonEmpty(const char* s)
+    {
+        return s != nullptr && *s != 0;
+    }
+    
+    /** Brackets balance outside strings and the outermost one is `open`. Not a full JSON check. */
+    constexpr bool isWellNested(const char* json, char open)
+    {
+        if (json == nullptr)
+            return true;
+        
+        while (*json == ' ' || *json == '\n' || *json == '\r' || *json == '\t')
+            ++json;
+        
+        if (*json != open)
+            return false;
+        
+        char stack[32] = {};
+        int depth = 0;
+        bool inString = false;
+        
+        for (; *json != 0; ++json)
+        {
+            const char c = *json;
+            
+            if (inString)
+            {
+                if (c == '\\' && json[1] != 0)
+                    ++json;
+                else if (c == '"')
+                    inString = false;
+            }
+            else if (c == '"')
+            {
+                inString = true;
+            }
+            else if (c == '{' || c == '[')
+            {
+                if (depth == 32)
+                    return false;
+                stack[depth++] = c == '{' ? '}' : ']';
+            }
+            else if (c == '}' || c == ']')
+            {
+                if (depth == 0 || stack[--depth] != c)
+                    return false;
+                
+                // Nothing but whitespace may follow the outermost bracket
+                if (depth == 0)
+                {
+                    for (++json; *json != 0; ++json)
+                        if (*json != ' ' && *json != '\n' && *json != '\r' && *json != '\t')
+                            return false;
+                    return true;
+                }
+            }
+        }
+        
+        return false;
+    }
+    
+    template <typename Predicate>
+    constexpr bool allDevices(Predicate predicate)
+    {
+        for (const auto& device : devices)
+            if (!predicate(device))
+                return false;
+        return true;
+    }
+    
+    constexpr bool idsAreUnique()
+    {
+        for (int i = 0; i < numDevices; ++i)
+            for (int j = i + 1; j < numDevices; ++j)
+                if (stringsEqual(devices[i].deviceID, devices[j].deviceID))
+                    return false;
+        return true;
+    }
+    
+    static_assert(numDevices > 0 && stringsEqual(devices[0].deviceID, "generic"),
+                  "Row 0 must be the generic device");
+    static_assert(allDevices([](const Device& d) { return isValidId(d.deviceID); }),
+                  "Device IDs must be non-empty [a-z0-9_]");
+    static_assert(idsAreUnique(), "Device IDs must be unique");
+    static_assert(allDevices([](const Device& d) { return isNonEmpty(d.deviceName) && isNonEmpty(d.manufacturer); }),
+                  "Devices need a name and manufacturer");
+    static_assert(allDevices([](const Device& d) { return d.minPatch >= 0 && d.minPatch <= d.maxPatch && d.maxPatch <= 127; }),
+                  "Patch range must be within 0-127");
+    static_assert(allDevices([](const Device& d) { return d.defaultChannel >= 1 && d.defaultChannel <= 16; }),
+                  "Default channel must be 1-16");
+    static_assert(allDevices([](const Device& d) { return isWellNested(d.sysEx, '{') && isWellNested(d.parameters, '['); }),
+                  "SysEx layouts must be JSON objects and parameter lists JSON arrays");
+    
+    // Runtime: compiling the JSON still happens once per device, on first use
+    
+    template <typename Definition>
+    std::shared_ptr<const Definition> compileFactory(const char* deviceID, const char* json)
+    {
+        std::shared_ptr<const Definition> definition;
+        if (json == nullptr)
+            return definition;
+        
+        auto result = Definition::compile(juce::JSON::parse(json), definition);
+        
+        // The static_asserts catch structure; a failure here is a typo in a field
+        jassert(result.wasOk());
+        if (result.failed())
+            juce::Logger::writeToLog("Factory template " + juce::String(deviceID) + ": " + result.getErrorMessage());
+        
+        return definition;
+    }
+    
+    DeviceTemplate buildTemplate(const Device& device)
+    {
+        DeviceTemplate t(device.deviceName, device.manufacturer, device.deviceID);
+        t.setPatchRange(device.minPatch, device.maxPatch);
+        t.setDefaultChannel(device.defaultChannel);
+        
+        switch (device.bankSelect)
+        {
+            case BankSelect::none:      t.setBankSelect(false); break;
+            case BankSelect::msb:       t.setBankSelect(true, true, false); break;
+            case BankSelect::lsb:       t.setBankSelect(true, false, true); break;
+            case BankSelect::msbAndLsb: t.setBankSelect(true, true, true); break;
+        }
+        
+        t.setSysExProtocol(compileFactory<SysExProtocol>(device.deviceID, device.sysEx));
+        t.setParameterMap(compileFactory<ParameterMap>(device.deviceID, device.parameters));
+        return t;
+    }
+}
+
+int FactoryTemplates::getNumDevices() noexcept
+{
+    return numDevices;
+}
+
+const FactoryTemplates::Device& FactoryTemplates::getDevice(int index) noexcept
+{
+    jassert(juce::isPositiveAndBelow(index, numDevices));
+    return devices[juce::jlimit(0, numDevices - 1, index)];
+}
+
+int FactoryTemplates::indexOf(const juce::Identifier& deviceID) noexcept
+{
+    for (int i = 0; i < numDevices; ++i)
+        if (deviceID == juce::StringRef(devices[i].deviceID))
+            return i;
+    
+    return -1;
+}
+
+std::shared_ptr<const DeviceTemplate> FactoryTemplates::materialize(int index)
+{
+    // Constant-initialized: no construction, allocation or locking until a slot is first used
+    static std::once_flag built[numDevices];
+    static std::shared_ptr<const DeviceTemplate> templates[numDevices];
+    
+    index = juce::jlimit(0, numDevices - 1, index);
+    std::call_once(built[index], [index]
+    {
+        templates[index] = std::make_shared<const DeviceTemplate>(buildTemplate(devices[index]));
+    });
+    
+    return templates[index];
+}
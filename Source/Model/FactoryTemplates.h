@@ -0,0 +1,58 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DeviceTemplate.h"
+#include <memory>
+
+/**
+ * The built-in device catalog.
+ * 
+ * Each device is one constexpr row of string literals and integers, with its
+ * SysEx layout and parameter list as JSON literals in the same row, so the
+ * whole catalog sits in read-only data: listing it costs no parsing and no
+ * heap. The table is checked by static_asserts (ID syntax and uniqueness,
+ * patch and channel ranges, well-formed JSON nesting), so a bad row fails the
+ * build rather than the first launch.
+ * 
+ * A row becomes a DeviceTemplate, with its SysExProtocol and ParameterMap
+ * compiled, on the first materialize() for that device; the result is cached
+ * and shared for the rest of the process.
+ * 
+ * THREADING:
+ * - Row access is lock-free; materialize() is safe from any thread
+ */
+class FactoryTemplates
+{
+public:
+    enum class BankSelect
+    {
+        none,
+        msb,
+        lsb,
+        msbAndLsb
+    };
+    
+    struct Device
+    {
+        const char* deviceID;
+        const char* deviceName;
+        const char* manufacturer;
+        int minPatch;
+        int maxPatch;
+        BankSelect bankSelect;
+        int defaultChannel;
+        const char* sysEx;      // SysExProtocol JSON, or nullptr
+        const char* parameters; // ParameterMap JSON, or nullptr
+    };
+    
+    // Row 0 is the generic device, used when nothing else matches
+    static int getNumDevices() noexcept;
+    static const Device& getDevice(int index) noexcept;
+    static int indexOf(const juce::Identifier& deviceID) noexcept; // -1 if not built in
+    
+    /** The device's template, built on first use and shared afterwards. */
+    static std::shared_ptr<const DeviceTemplate> materialize(int index);
+    
+private:
+    FactoryTemplates() = delete;
+};
@@ -0,0 +1,103 @@
+#include "ParameterMap.h"
+#include "SysExMessageFormat.h"
+
+juce::Result ParameterMap::compile(const juce::var& desc, Ptr& result)
+{
+    auto* list = desc.getArray();
+    if (list == nullptr)
+        return juce::Result::fail("Parameter map must be an array");
+    
+    std::shared_ptr<ParameterMap> map(new ParameterMap());
+    map->description = desc;
+    map->parameters.reserve((size_t)list->size());
+    
+    for (const auto& entry : *list)
+    {
+        auto* obj = entry.getDynamicObject();
+        if (obj == nullptr)
+            return juce::Result::fail("Parameter definition must be an object");
+        
+        Parameter parameter;
+        parameter.id = obj->getProperty("id").toString();
+        parameter.name = obj->getProperty("name").toString();
+        
+        if (parameter.id.isEmpty())
+            return juce::Result::fail("Parameter definition has no id");
+        
+        if (map->indexById.count(parameter.id) > 0)
+            return juce::Result::fail("Duplicate parameter: " + parameter.id);
+        
+        if (parameter.name.isEmpty())
+            parameter.name = parameter.id;
+        
+        const int numTransports = (obj->hasProperty("cc") ? 1 : 0)
+                                + (obj->hasProperty("nrpn") ? 1 : 0)
+                                + (obj->hasProperty("sysex") ? 1 : 0);
+        if (numTransports != 1)
+            return juce::Result::fail("Parameter '" + parameter.id + "' needs exactly one of cc, nrpn or sysex");
+        
+        if (obj->hasProperty("cc"))
+        {
+            parameter.transport = Transport::controlChange;
+            parameter.number = obj->getProperty("cc");
+            
+            if (parameter.number < 0 || parameter.number > 127)
+                return juce::Result::fail("Parameter '" + parameter.id + "' has an invalid CC number");
+        }
+        else if (obj->hasProperty("nrpn"))
+        {
+            parameter.transport = Transport::nrpn;
+            parameter.number = obj->getProperty("nrpn");
+            
+            if (parameter.number < 0 || parameter.number > 16383)
+                return juce::Result::fail("Parameter '" + parameter.id + "' has an invalid NRPN number");
+        }
+        else
+        {
+            parameter.transport = Transport::sysEx;
+            parameter.sysExMessage = obj->getProperty("sysex").toString();
+            parameter.valueBytes = juce::jlimit(1, 4, (int)obj->getProperty("valueBytes", 1));
+            
+            juce::int64 address = 0;
+            if (obj->hasProperty("address") && !SysExMessageFormat::parseNumber(obj->getProperty("address"), address))
+                return juce::Result::fail("Parameter '" + parameter.id + "' has an invalid address");
+            
+            parameter.address = (juce::uint32)address;
+        }
+        
+        int maxForTransport = 127;
+        if (parameter.transport == Transport::nrpn)
+            maxForTransport = 16383;
+        else if (parameter.transport == Transport::sysEx)
+            maxForTransport = (1 << (7 * parameter.valueBytes)) - 1;
+        
+        parameter.minValue = juce::jlimit(0, maxForTransport, (int)obj->getProperty("min", 0));
+        parameter.maxValue = juce::jlimit(parameter.minValue, maxForTransport, (int)obj->getProperty("max", 127));
+        parameter.defaultValue = parameter.clampValue(obj->getProperty("default", parameter.minValue));
+        parameter.weight = juce::jmax(0.0f, (float)(double)obj->getProperty("weight", 1.0));
+        
+        map->indexById[parameter.id] = (int)map->parameters.size();
+        map->parameters.push_back(std::move(parameter));
+    }
+    
+    result = std::move(map);
+    return juce::Result::ok();
+}
+
+int ParameterMap::indexOf(const juce::String& parameterId) const noexcept
+{
+    auto it = indexById.find(parameterId);
+    return it != indexById.end() ? it->second : -1;
+}
+
+const char* ParameterMap::getTransportName(Transport transport) noexcept
+{
+    switch (transport)
+    {
+        case Transport::controlChange:  return "CC";
+        case Transport::nrpn:           return "NRPN";
+        case Transport::sysEx:          return "SysEx";
+    }
+    
+    return "";
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+#include <vector>
+
+/**
+ * A device's editable sound parameters and how each one is sent.
+ * 
+ * JSON description (the "parameters" property of a device template):
+ * [
+ *     { "id": "cutoff", "name": "Cutoff", "cc": 74 },
+ *     { "id": "lfoRate", "name": "LFO Rate", "nrpn": 257, "max": 16383 },
+ *     { "id": "level", "name": "Patch Level", "sysex": "dataSet",
+ *       "address": "0x0300000e", "valueBytes": 1 }
+ * ]
+ * 
+ * "min", "max" and "default" are optional (0, 127 and min), as is "weight"
+ * (1.0), the parameter's importance in similarity search. Exactly one of
+ * "cc", "nrpn" or "sysex" selects the transport; SysEx parameters name a
+ * message in the template's SysExProtocol and are sent with the value as
+ * the message data (valueBytes 7-bit bytes, most significant first).
+ * 
+ * Parameters are addressed by index at runtime; the index of an ID is
+ * resolved once. Compiled maps are immutable and shared between template copies.
+ */
+class ParameterMap
+{
+public:
+    using Ptr = std::shared_ptr<const ParameterMap>;
+    
+    enum class Transport
+    {
+        controlChange,
+        nrpn,
+        sysEx
+    };
+    
+    struct Parameter
+    {
+        juce::String id;
+        juce::String name;
+        Transport transport = Transport::controlChange;
+        int number = 0;                 // CC or NRPN number
+        juce::String sysExMessage;      // Message name in the SysExProtocol
+        juce::uint32 address = 0;
+        int valueBytes = 1;
+        int minValue = 0;
+        int maxValue = 127;
+        int defaultValue = 0;
+        float weight = 1.0f;
+        
+        int clampValue(int value) const noexcept { return juce::jlimit(minValue, maxValue, value); }
+        
+        float normalize(int value) const noexcept
+        {
+            return maxValue > minValue ? (float)(clampValue(value) - minValue) / (float)(maxValue - minValue) : 0.0f;
+        }
+    };
+    
+    /** Compiles a JSON parameter list. */
+    static juce::Result compile(const juce::var& description, Ptr& result);
+    
+    // Lookup
+    int size() const noexcept { return (int)parameters.size(); }
+    const Parameter& getParameter(int index) const { return parameters[(size_t)index]; }
+    int indexOf(const juce::String& parameterId) const noexcept; // -1 if not found
+    
+    // Serialization (returns the description it was compiled from)
+    juce::var toVar() const { return description; }
+    
+    static const char* getTransportName(Transport transport) noexcept;
+    
+private:
+    ParameterMap() = default;
+    
+    juce::var description;
+    std::vector<Parameter> parameters;
+    std::map<juce::String, int> indexById;
+};
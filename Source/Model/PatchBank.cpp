@@ -9,13 +9,14 @@ PatchBank::PatchBank()
 const PatchData& PatchBank::getPatch(int slotIndex) const
 {
     jassert(isValidSlot(slotIndex));
-    return patches[slotIndex];
+    return patches.getReference(slotIndex);
 }
 
 PatchData& PatchBank::getPatch(int slotIndex)
 {
     jassert(isValidSlot(slotIndex));
-    return patches[slotIndex];
+    ++revision;
+    return patches.getReference(slotIndex);
 }
 
 void PatchBank::setPatch(int slotIndex, const PatchData& patch)
@@ -23,19 +24,96 @@ void PatchBank::setPatch(int slotIndex, const PatchData& patch)
     if (isValidSlot(slotIndex))
     {
         patches.set(slotIndex, patch);
-        sendChangeMessage();
+        slotsChanged(slotIndex);
     }
 }
 
+void PatchBank::setPatches(const juce::Array<PatchData>& newPatches)
+{
+    jassert(newPatches.size() == BANK_SIZE);
+    if (newPatches.size() == BANK_SIZE)
+    {
+        patches = newPatches;
+        slotsChanged(-1);
+    }
+}
+
+void PatchBank::permute(const juce::Array<int>& order)
+{
+    juce::BigInteger seen;
+    for (int source : order)
+    {
+        if (!isValidSlot(source) || seen[source])
+            break;
+        seen.setBit(source);
+    }
+    
+    jassert(order.size() == BANK_SIZE && seen.countNumberOfSetBits() == BANK_SIZE);
+    if (order.size() != BANK_SIZE || seen.countNumberOfSetBits() != BANK_SIZE)
+        return;
+    
+    const ScopedTransaction transaction(*this);
+    juce::Array<PatchData> reordered;
+    reordered.ensureStorageAllocated(BANK_SIZE);
+    
+    for (int i = 0; i < BANK_SIZE; ++i)
+    {
+        // Copies share strings and dumps, so this doesn't duplicate patch data
+        reordered.add(patches.getReference(order[i]));
+        reordered.getReference(i).setSlotIndex(i);
+        
+        if (order[i] != i)
+            slotsChanged(i);
+    }
+    
+    patches.swapWith(reordered);
+}
+
 void PatchBank::renamePatch(int slotIndex, const juce::String& newName)
 {
     if (isValidSlot(slotIndex))
     {
         patches.getReference(slotIndex).setPatchName(newName);
-        sendChangeMessage();
+        slotsChanged(slotIndex);
     }
 }
 
+void PatchBank::commitTransaction()
+{
+    jassert(transactionDepth > 0);
+    if (--transactionDepth > 0 || transactionSlots.isZero())
+        return;
+    
+    pendingSlots |= transactionSlots;
+    transactionSlots.clear();
+    triggerAsyncUpdate();
+}
+
+void PatchBank::slotsChanged(int slotIndex)
+{
+    ++revision;
+    
+    if (slotIndex < 0)
+        transactionSlots.setRange(0, BANK_SIZE, true);
+    else
+        transactionSlots.setBit(slotIndex);
+    
+    // An edit outside a transaction is a transaction of its own
+    if (transactionDepth == 0)
+    {
+        beginTransaction();
+        commitTransaction();
+    }
+}
+
+void PatchBank::handleAsyncUpdate()
+{
+    // Delivered synchronously from here, so the slot set is exact for every listener
+    changedSlots = pendingSlots;
+    pendingSlots.clear();
+    sendSynchronousChangeMessage();
+}
+
 bool PatchBank::isValidSlot(int slotIndex) const noexcept
 {
     return slotIndex >= 0 && slotIndex < BANK_SIZE;
@@ -49,7 +127,7 @@ void PatchBank::clear()
     {
         patches.add(PatchData(i, "Init", juce::Identifier("generic")));
     }
-    sendChangeMessage();
+    slotsChanged(-1);
 }
 
 void PatchBank::initializeDefaults()
@@ -94,7 +172,48 @@ void PatchBank::fromVar(const juce::var& v)
             patches.add(PatchData(index, defaultName, juce::Identifier("generic")));
         }
         
-        sendChangeMessage();
+        slotsChanged(-1);
     }
 }
 
+void PatchBank::writeToStream(juce::OutputStream& stream) const
+{
+    writeToStream(patches, stream);
+}
+
+void PatchBank::writeToStream(const juce::Array<PatchData>& patchesToWrite, juce::OutputStream& stream)
+{
+    stream.writeCompressedInt(patchesToWrite.size());
+    for (const auto& patch : patchesToWrite)
+        patch.writeToStream(stream);
+}
+
+bool PatchBank::readFromStream(juce::InputStream& stream)
+{
+    const int numPatches = stream.readCompressedInt();
+    if (numPatches < 0 || numPatches > BANK_SIZE)
+        return false;
+    
+    juce::Array<PatchData> loaded;
+    loaded.ensureStorageAllocated(BANK_SIZE);
+    
+    for (int i = 0; i < numPatches; ++i)
+    {
+        if (stream.isExhausted())
+            return false;
+        
+        loaded.add(PatchData::readFromStream(stream));
+    }
+    
+    // Ensure we always have 128 patches
+    while (loaded.size() < BANK_SIZE)
+    {
+        int index = loaded.size();
+        juce::String defaultName = "Patch " + juce::String(index + 1).paddedLeft('0', 3);
+        loaded.add(PatchData(index, defaultName, juce::Identifier("generic")));
+    }
+    
+    patches.swapWith(loaded);
+    slotsChanged(-1);
+    return true;
+}
@@ -9,24 +9,68 @@
  * This is the core Model class that holds all patch data.
  * It broadcasts changes so Views can update automatically.
  * 
+ * Edits can be grouped into a transaction (beginTransaction() /
+ * commitTransaction(), or a ScopedTransaction): slots changed inside it are
+ * collected and announced once, when the outermost transaction commits.
+ * Edits made outside a transaction are announced one by one. While listeners
+ * are called, getChangedSlots() holds every slot changed since the previous
+ * change message, so they can update just those slots.
+ * 
  * Thread-safe: All operations should be called from the message thread.
  */
-class PatchBank : public juce::ChangeBroadcaster
+class PatchBank : public juce::ChangeBroadcaster,
+                  private juce::AsyncUpdater
 {
 public:
     static constexpr int BANK_SIZE = 128;
     
+    /** Groups the edits made during its lifetime into one change message. */
+    class ScopedTransaction
+    {
+    public:
+        explicit ScopedTransaction(PatchBank& bank) : bank(bank) { bank.beginTransaction(); }
+        ~ScopedTransaction() { bank.commitTransaction(); }
+    
+    private:
+        PatchBank& bank;
+        
+        JUCE_DECLARE_NON_COPYABLE(ScopedTransaction)
+    };
+    
     PatchBank();
     ~PatchBank() override = default;
     
     // Patch access
     const PatchData& getPatch(int slotIndex) const;
     PatchData& getPatch(int slotIndex);
+    const juce::Array<PatchData>& getPatches() const noexcept { return patches; }
     
     // Patch modification
     void setPatch(int slotIndex, const PatchData& patch);
+    void setPatches(const juce::Array<PatchData>& newPatches); // Exactly BANK_SIZE patches
     void renamePatch(int slotIndex, const juce::String& newName);
     
+    /**
+     * Reorders the bank in one step: slot i receives the patch that was in
+     * slot order[i]. order must be a permutation of 0..BANK_SIZE-1. Only the
+     * slots whose patch moved are reported as changed.
+     */
+    void permute(const juce::Array<int>& order);
+    
+    // Transactions (may nest; only the outermost commit broadcasts)
+    void beginTransaction() noexcept { ++transactionDepth; }
+    void commitTransaction();
+    bool isInTransaction() const noexcept { return transactionDepth > 0; }
+    
+    /**
+     * Bumped by every change, and by every non-const getPatch() (which may be
+     * used to edit in place), so a cache keyed by it is never stale. Thread-safe.
+     */
+    juce::uint32 getRevision() const noexcept { return revision.load(); }
+    
+    /** Slots changed since the previous change message (valid inside changeListenerCallback). */
+    const juce::BigInteger& getChangedSlots() const noexcept { return changedSlots; }
+    
     // Validation
     bool isValidSlot(int slotIndex) const noexcept;
     
@@ -37,9 +81,22 @@ public:
     // Serialization
     juce::var toVar() const;
     void fromVar(const juce::var& v);
+    void writeToStream(juce::OutputStream& stream) const;
+    bool readFromStream(juce::InputStream& stream);
+    
+    /** Writes patches in writeToStream()'s format without a PatchBank (e.g. a library snapshot). */
+    static void writeToStream(const juce::Array<PatchData>& patches, juce::OutputStream& stream);
     
 private:
     juce::Array<PatchData> patches;
+    int transactionDepth = 0;
+    juce::BigInteger transactionSlots;  // Changed in the open transaction
+    juce::BigInteger pendingSlots;      // Committed, waiting for the change message
+    juce::BigInteger changedSlots;      // Reported to listeners
+    std::atomic<juce::uint32> revision { 0 };
+    
+    void slotsChanged(int slotIndex); // -1 = all slots
+    void handleAsyncUpdate() override;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PatchBank)
 };
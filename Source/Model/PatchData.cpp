@@ -1,5 +1,15 @@
 #include "PatchData.h"
 
+namespace
+{
+    // A count can't exceed the bytes left, so a corrupt chunk can't request a huge allocation
+    int readCount(juce::InputStream& stream)
+    {
+        const int count = stream.readCompressedInt();
+        return (int)juce::jlimit((juce::int64)0, juce::jmax((juce::int64)0, stream.getNumBytesRemaining()), (juce::int64)count);
+    }
+}
+
 bool PatchData::matchesSearchQuery(const juce::String& query) const
 {
     if (query.isEmpty())
@@ -27,6 +37,20 @@ bool PatchData::matchesSearchQuery(const juce::String& query) const
     return false;
 }
 
+const juce::MemoryBlock& PatchData::getPatchDump() const noexcept
+{
+    static const juce::MemoryBlock empty;
+    return patchDump != nullptr ? *patchDump : empty;
+}
+
+void PatchData::setPatchDump(const juce::MemoryBlock& data)
+{
+    if (data.isEmpty())
+        patchDump = nullptr;
+    else
+        patchDump = std::make_shared<const juce::MemoryBlock>(data);
+}
+
 juce::var PatchData::toVar() const
 {
     juce::DynamicObject::Ptr obj = new juce::DynamicObject();
@@ -41,6 +65,18 @@ juce::var PatchData::toVar() const
         tagArray.add(juce::var(tag));
     obj->setProperty("tags", juce::var(tagArray));
     
+    if (hasPatchDump())
+        obj->setProperty("dump", patchDump->toBase64Encoding());
+    
+    // Only written when edited, so unedited banks keep their compact form
+    if (!parameterValues.isEmpty())
+    {
+        juce::DynamicObject::Ptr params = new juce::DynamicObject();
+        for (const auto& value : parameterValues)
+            params->setProperty(value.name, value.value);
+        obj->setProperty("parameters", juce::var(params.get()));
+    }
+    
     return juce::var(obj);
 }
 
@@ -61,8 +97,78 @@ PatchData PatchData::fromVar(const juce::var& v)
                 patch.tags.add(tagVar.toString());
         }
         
+        if (obj->hasProperty("dump"))
+        {
+            juce::MemoryBlock dump;
+            dump.fromBase64Encoding(obj->getProperty("dump").toString());
+            patch.setPatchDump(dump);
+        }
+        
+        if (auto* params = obj->getProperty("parameters").getDynamicObject())
+        {
+            for (const auto& value : params->getProperties())
+                patch.parameterValues.set(value.name, (int)value.value);
+        }
+        
         return patch;
     }
     return PatchData();
 }
 
+
+void PatchData::writeToStream(juce::OutputStream& stream) const
+{
+    stream.writeCompressedInt(slotIndex);
+    stream.writeString(patchName);
+    stream.writeString(deviceID.toString());
+    stream.writeBool(isFavoriteFlag);
+    
+    stream.writeCompressedInt(tags.size());
+    for (const auto& tag : tags)
+        stream.writeString(tag);
+    
+    const auto& dump = getPatchDump();
+    stream.writeCompressedInt((int)dump.getSize());
+    stream.write(dump.getData(), dump.getSize());
+    
+    stream.writeCompressedInt(parameterValues.size());
+    for (const auto& value : parameterValues)
+    {
+        stream.writeString(value.name.toString());
+        stream.writeCompressedInt((int)value.value);
+    }
+}
+
+PatchData PatchData::readFromStream(juce::InputStream& stream)
+{
+    PatchData patch;
+    patch.slotIndex = stream.readCompressedInt();
+    patch.patchName = stream.readString();
+    
+    auto id = stream.readString();
+    patch.deviceID = id.isNotEmpty() ? juce::Identifier(id) : juce::Identifier("generic");
+    patch.isFavoriteFlag = stream.readBool();
+    
+    const int numTags = readCount(stream);
+    for (int i = 0; i < numTags && !stream.isExhausted(); ++i)
+        patch.tags.add(stream.readString());
+    
+    const int dumpSize = readCount(stream);
+    if (dumpSize > 0)
+    {
+        juce::MemoryBlock dump((size_t)dumpSize);
+        stream.read(dump.getData(), dumpSize);
+        patch.setPatchDump(dump);
+    }
+    
+    const int numParameters = readCount(stream);
+    for (int i = 0; i < numParameters && !stream.isExhausted(); ++i)
+    {
+        auto name = stream.readString();
+        const int value = stream.readCompressedInt();
+        if (name.isNotEmpty())
+            patch.parameterValues.set(name, value);
+    }
+    
+    return patch;
+}
@@ -1,13 +1,19 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <memory>
 
 /**
  * Represents a single patch/program in the librarian.
  * 
- * This is a value-type class that holds patch metadata.
- * The actual patch data (parameters) would be stored in the device itself
- * or in a future device template system.
+ * This is a value-type class that holds patch metadata, the patch's raw
+ * data as dumped by the device (decoded SysEx payload, if any), and the
+ * parameter values edited in the librarian, keyed by the template's parameter IDs.
+ * Parameters that were never edited have no stored value; the device's
+ * own setting applies.
+ * 
+ * Copies are cheap: strings are reference-counted and the dump is an
+ * immutable shared block that setPatchDump() replaces rather than edits.
  */
 class PatchData
 {
@@ -27,6 +33,15 @@ public:
     juce::Identifier getDeviceID() const noexcept { return deviceID; }
     bool isFavorite() const noexcept { return isFavoriteFlag; }
     juce::StringArray getTags() const noexcept { return tags; }
+    const juce::MemoryBlock& getPatchDump() const noexcept;
+    bool hasPatchDump() const noexcept { return patchDump != nullptr; }
+    std::shared_ptr<const juce::MemoryBlock> getSharedPatchDump() const noexcept { return patchDump; }
+    const juce::NamedValueSet& getParameterValues() const noexcept { return parameterValues; }
+    bool hasParameterValue(const juce::String& parameterId) const noexcept { return parameterValues.contains(parameterId); }
+    int getParameterValue(const juce::String& parameterId, int defaultValue) const
+    {
+        return parameterValues.getWithDefault(parameterId, defaultValue);
+    }
     
     // Setters
     void setSlotIndex(int index) noexcept { slotIndex = index; }
@@ -36,6 +51,12 @@ public:
     void setTags(const juce::StringArray& newTags) noexcept { tags = newTags; }
     void addTag(const juce::String& tag) noexcept { if (!tags.contains(tag)) tags.add(tag); }
     void removeTag(const juce::String& tag) noexcept { tags.removeString(tag); }
+    void setPatchDump(const juce::MemoryBlock& data);
+    void clearPatchDump() noexcept { patchDump = nullptr; }
+    void setSharedPatchDump(std::shared_ptr<const juce::MemoryBlock> data) noexcept { patchDump = std::move(data); }
+    void setParameterValue(const juce::String& parameterId, int value) { parameterValues.set(parameterId, value); }
+    void removeParameterValue(const juce::String& parameterId) { parameterValues.remove(parameterId); }
+    void clearParameterValues() noexcept { parameterValues.clear(); }
     
     // Comparison
     bool operator==(const PatchData& other) const noexcept
@@ -58,11 +79,17 @@ public:
     juce::var toVar() const;
     static PatchData fromVar(const juce::var& v);
     
+    // Binary form for plugin state chunks (dump stored raw, not base64)
+    void writeToStream(juce::OutputStream& stream) const;
+    static PatchData readFromStream(juce::InputStream& stream);
+    
 private:
     int slotIndex = 0;                    // 0-127 (MIDI program numbers)
     juce::String patchName = "Init";      // User-friendly name
     juce::Identifier deviceID = "generic"; // For future device template system
     bool isFavoriteFlag = false;          // Favorite/starred patch
     juce::StringArray tags;               // Tags/categories (bass, lead, pad, etc.)
+    std::shared_ptr<const juce::MemoryBlock> patchDump; // Device patch data (decoded SysEx payload), shared
+    juce::NamedValueSet parameterValues;  // Edited parameter values by parameter ID
 };
 
@@ -0,0 +1,370 @@
+#include "SysExMessageFormat.h"
+
+namespace
+{
+    // Roland and Yamaha use the same arithmetic (low 7 bits of the
+    // two's complement of the sum); they differ only in which bytes are summed
+    juce::uint8 twosComplementChecksum(const juce::uint8* data, int size)
+    {
+        int sum = 0;
+        for (int i = 0; i < size; ++i)
+            sum += data[i];
+        
+        return (juce::uint8)((128 - (sum & 0x7f)) & 0x7f);
+    }
+    
+    int rawEncode(const juce::uint8* source, int size, juce::uint8* dest)
+    {
+        for (int i = 0; i < size; ++i)
+            dest[i] = (juce::uint8)(source[i] & 0x7f);
+        return size;
+    }
+    
+    int rawDecode(const juce::uint8* source, int size, juce::uint8* dest)
+    {
+        std::memcpy(dest, source, (size_t)size);
+        return size;
+    }
+    
+    int nibbleHighLowEncode(const juce::uint8* source, int size, juce::uint8* dest)
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            dest[2 * i] = (juce::uint8)(source[i] >> 4);
+            dest[2 * i + 1] = (juce::uint8)(source[i] & 0x0f);
+        }
+        return size * 2;
+    }
+    
+    int nibbleHighLowDecode(const juce::uint8* source, int size, juce::uint8* dest)
+    {
+        const int n = size / 2;
+        for (int i = 0; i < n; ++i)
+            dest[i] = (juce::uint8)(((source[2 * i] & 0x0f) << 4) | (source[2 * i + 1] & 0x0f));
+        return n;
+    }
+    
+    int nibbleLowHighEncode(const juce::uint8* source, int size, juce::uint8* dest)
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            dest[2 * i] = (juce::uint8)(source[i] & 0x0f);
+            dest[2 * i + 1] = (juce::uint8)(source[i] >> 4);
+        }
+        return size * 2;
+    }
+    
+    int nibbleLowHighDecode(const juce::uint8* source, int size, juce::uint8* dest)
+    {
+        const int n = size / 2;
+        for (int i = 0; i < n; ++i)
+            dest[i] = (juce::uint8)((source[2 * i] & 0x0f) | ((source[2 * i + 1] & 0x0f) << 4));
+        return n;
+    }
+    
+    int packed7Encode(const juce::uint8* source, int size, juce::uint8* dest)
+    {
+        int written = 0;
+        
+        for (int group = 0; group < size; group += 7)
+        {
+            const int n = juce::jmin(7, size - group);
+            juce::uint8 msbs = 0;
+            
+            for (int j = 0; j < n; ++j)
+            {
+                msbs |= (juce::uint8)(((source[group + j] >> 7) & 1) << j);
+                dest[written + 1 + j] = (juce::uint8)(source[group + j] & 0x7f);
+            }
+            
+            dest[written] = msbs;
+            written += n + 1;
+        }
+        
+        return written;
+    }
+    
+    int packed7Decode(const juce::uint8* source, int size, juce::uint8* dest)
+    {
+        int written = 0;
+        
+        for (int group = 0; group < size; group += 8)
+        {
+            const int n = juce::jmin(8, size - group);
+            const juce::uint8 msbs = source[group];
+            
+            for (int j = 1; j < n; ++j)
+                dest[written++] = (juce::uint8)((source[group + j] & 0x7f) | (((msbs >> (j - 1)) & 1) << 7));
+        }
+        
+        return written;
+    }
+    
+    int sameSize(int size) { return size; }
+    int doubleSize(int size) { return size * 2; }
+    int halfSize(int size) { return size / 2; }
+    int packed7EncodedSize(int size) { return (size / 7) * 8 + (size % 7 > 0 ? size % 7 + 1 : 0); }
+    int packed7DecodedSize(int size) { return (size / 8) * 7 + (size % 8 > 1 ? size % 8 - 1 : 0); }
+}
+
+juce::Result SysExMessageFormat::compile(const juce::var& desc, SysExMessageFormat& result)
+{
+    auto* obj = desc.getDynamicObject();
+    if (obj == nullptr)
+        return juce::Result::fail("SysEx message description must be an object");
+    
+    SysExMessageFormat format;
+    format.description = desc;
+    format.name = obj->getProperty("name").toString();
+    
+    if (format.name.isEmpty())
+        return juce::Result::fail("SysEx message description has no name");
+    
+    const auto error = [&format](const juce::String& message)
+    {
+        return juce::Result::fail("SysEx message '" + format.name + "': " + message);
+    };
+    
+    // Header
+    auto* header = obj->getProperty("header").getArray();
+    if (header == nullptr || header->isEmpty())
+        return error("header must be a non-empty array");
+    
+    for (const auto& token : *header)
+    {
+        juce::int64 value = 0;
+        
+        if (token.toString() == "deviceId" && !token.isObject())
+        {
+            if (format.deviceIdIndex >= 0)
+                return error("header has more than one device ID byte");
+            
+            format.deviceIdIndex = format.headerBytes.size();
+            format.deviceIdMask = 0x7f;
+            format.headerBytes.add(0);
+            format.headerMask.add(0);
+        }
+        else if (auto* tokenObj = token.getDynamicObject())
+        {
+            if (format.deviceIdIndex >= 0)
+                return error("header has more than one device ID byte");
+            
+            if (!parseNumber(tokenObj->getProperty("deviceId"), value) || value < 0 || value > 0x7f || (value & 0x0f) != 0)
+                return error("device ID base must be a 7-bit value with a clear low nibble");
+            
+            format.deviceIdIndex = format.headerBytes.size();
+            format.deviceIdMask = 0x0f;
+            format.headerBytes.add((juce::uint8)value);
+            format.headerMask.add(0x70);
+        }
+        else if (parseNumber(token, value) && value >= 0 && value <= 0x7f)
+        {
+            format.headerBytes.add((juce::uint8)value);
+            format.headerMask.add(0x7f);
+        }
+        else
+        {
+            return error("invalid header byte '" + token.toString() + "'");
+        }
+    }
+    
+    // Fields
+    format.addressBytes = obj->getProperty("addressBytes");
+    format.sizeBytes = obj->getProperty("sizeBytes");
+    
+    if (format.addressBytes < 0 || format.addressBytes > 4 || format.sizeBytes < 0 || format.sizeBytes > 4)
+        return error("addressBytes and sizeBytes must be between 0 and 4");
+    
+    bool ok = false;
+    format.dataEncoding = parseDataEncoding(obj->getProperty("data").toString(), ok);
+    if (!ok)
+        return error("unknown data encoding '" + obj->getProperty("data").toString() + "'");
+    
+    format.checksum = parseChecksum(obj->getProperty("checksum").toString(), ok);
+    if (!ok)
+        return error("unknown checksum '" + obj->getProperty("checksum").toString() + "'");
+    
+    // Resolve offsets and dispatch once, here, rather than per message
+    format.addressOffset = format.headerBytes.size();
+    format.sizeOffset = format.addressOffset + format.addressBytes;
+    format.dataOffset = format.sizeOffset + format.sizeBytes;
+    format.checksumBytes = format.checksum == Checksum::none ? 0 : 1;
+    format.checksumStart = format.checksum == Checksum::yamaha ? format.dataOffset : format.addressOffset;
+    format.checksumFunction = format.checksum == Checksum::none ? nullptr : &twosComplementChecksum;
+    
+    switch (format.dataEncoding)
+    {
+        case DataEncoding::none:
+            break;
+        case DataEncoding::raw:
+            format.encodeData = &rawEncode;
+            format.decodeData = &rawDecode;
+            format.encodedSizeFor = &sameSize;
+            format.decodedSizeFor = &sameSize;
+            break;
+        case DataEncoding::nibbleHighLow:
+            format.encodeData = &nibbleHighLowEncode;
+            format.decodeData = &nibbleHighLowDecode;
+            format.encodedSizeFor = &doubleSize;
+            format.decodedSizeFor = &halfSize;
+            break;
+        case DataEncoding::nibbleLowHigh:
+            format.encodeData = &nibbleLowHighEncode;
+            format.decodeData = &nibbleLowHighDecode;
+            format.encodedSizeFor = &doubleSize;
+            format.decodedSizeFor = &halfSize;
+            break;
+        case DataEncoding::packed7:
+            format.encodeData = &packed7Encode;
+            format.decodeData = &packed7Decode;
+            format.encodedSizeFor = &packed7EncodedSize;
+            format.decodedSizeFor = &packed7DecodedSize;
+            break;
+    }
+    
+    result = std::move(format);
+    return juce::Result::ok();
+}
+
+int SysExMessageFormat::getEncodedSize(int dataSize) const noexcept
+{
+    const int encodedData = encodedSizeFor != nullptr ? encodedSizeFor(dataSize) : 0;
+    return dataOffset + encodedData + checksumBytes;
+}
+
+juce::MemoryBlock SysExMessageFormat::encode(const Fields& fields, const juce::uint8* data, int dataSize) const
+{
+    juce::MemoryBlock block;
+    encodeInto(block, fields, data, dataSize);
+    return block;
+}
+
+void SysExMessageFormat::encodeInto(juce::MemoryBlock& dest, const Fields& fields,
+                                    const juce::uint8* data, int dataSize) const
+{
+    jassert(headerBytes.size() > 0); // Not compiled
+    
+    if (data == nullptr || encodeData == nullptr)
+        dataSize = 0;
+    
+    const int totalSize = getEncodedSize(dataSize);
+    dest.setSize((size_t)totalSize, false);
+    auto* out = static_cast<juce::uint8*>(dest.getData());
+    
+    std::memcpy(out, headerBytes.getRawDataPointer(), (size_t)headerBytes.size());
+    
+    if (deviceIdIndex >= 0)
+        out[deviceIdIndex] = (juce::uint8)(headerBytes[deviceIdIndex] | (fields.deviceId & deviceIdMask));
+    
+    for (int i = 0; i < addressBytes; ++i)
+        out[addressOffset + i] = (juce::uint8)((fields.address >> (8 * (addressBytes - 1 - i))) & 0x7f);
+    
+    for (int i = 0; i < sizeBytes; ++i)
+        out[sizeOffset + i] = (juce::uint8)((fields.size >> (7 * (sizeBytes - 1 - i))) & 0x7f);
+    
+    int dataEnd = dataOffset;
+    if (dataSize > 0)
+        dataEnd += encodeData(data, dataSize, out + dataOffset);
+    
+    if (checksumFunction != nullptr)
+        out[dataEnd] = checksumFunction(out + checksumStart, dataEnd - checksumStart);
+}
+
+bool SysExMessageFormat::matches(const juce::uint8* data, int size) const noexcept
+{
+    if (data == nullptr || size < dataOffset + checksumBytes)
+        return false;
+    
+    for (int i = 0; i < headerBytes.size(); ++i)
+        if ((data[i] & headerMask.getUnchecked(i)) != headerBytes.getUnchecked(i))
+            return false;
+    
+    // Layouts without data have a fixed length
+    return decodeData != nullptr || size == dataOffset + checksumBytes;
+}
+
+bool SysExMessageFormat::decode(const juce::uint8* data, int size, Decoded& result) const
+{
+    if (!matches(data, size))
+        return false;
+    
+    result.deviceId = deviceIdIndex >= 0 ? (data[deviceIdIndex] & deviceIdMask) : -1;
+    
+    result.address = 0;
+    for (int i = 0; i < addressBytes; ++i)
+        result.address = (result.address << 8) | (juce::uint32)(data[addressOffset + i] & 0x7f);
+    
+    result.size = 0;
+    for (int i = 0; i < sizeBytes; ++i)
+        result.size = (result.size << 7) | (juce::uint32)(data[sizeOffset + i] & 0x7f);
+    
+    const int encodedDataSize = size - dataOffset - checksumBytes;
+    
+    if (decodeData != nullptr && encodedDataSize > 0)
+    {
+        result.data.setSize((size_t)decodedSizeFor(encodedDataSize), false);
+        decodeData(data + dataOffset, encodedDataSize, static_cast<juce::uint8*>(result.data.getData()));
+    }
+    else
+    {
+        result.data.reset();
+    }
+    
+    result.checksumValid = checksumFunction == nullptr
+                        || checksumFunction(data + checksumStart, size - checksumBytes - checksumStart) == data[size - 1];
+    return true;
+}
+
+SysExMessageFormat::DataEncoding SysExMessageFormat::parseDataEncoding(const juce::String& text, bool& ok) noexcept
+{
+    ok = true;
+    
+    if (text.isEmpty() || text == "none")   return DataEncoding::none;
+    if (text == "raw")                      return DataEncoding::raw;
+    if (text == "nibbleHighLow")            return DataEncoding::nibbleHighLow;
+    if (text == "nibbleLowHigh")            return DataEncoding::nibbleLowHigh;
+    if (text == "packed7")                  return DataEncoding::packed7;
+    
+    ok = false;
+    return DataEncoding::none;
+}
+
+SysExMessageFormat::Checksum SysExMessageFormat::parseChecksum(const juce::String& text, bool& ok) noexcept
+{
+    ok = true;
+    
+    if (text.isEmpty() || text == "none")   return Checksum::none;
+    if (text == "roland")                   return Checksum::roland;
+    if (text == "yamaha")                   return Checksum::yamaha;
+    
+    ok = false;
+    return Checksum::none;
+}
+
+bool SysExMessageFormat::parseNumber(const juce::var& value, juce::int64& result)
+{
+    if (value.isInt() || value.isInt64() || value.isDouble())
+    {
+        result = (juce::int64)value;
+        return true;
+    }
+    
+    if (value.isString())
+    {
+        auto text = value.toString().trim();
+        
+        if (text.startsWithIgnoreCase("0x") && text.length() > 2)
+        {
+            result = (juce::int64)(juce::uint32)text.substring(2).getHexValue32();
+            return true;
+        }
+        
+        if (text.containsOnly("0123456789") && text.isNotEmpty())
+        {
+            result = text.getLargeIntValue();
+            return true;
+        }
+    }
+    
+    return false;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * One SysEx message layout, compiled from a JSON description.
+ * 
+ * A layout is a fixed header followed by optional address, size and data
+ * fields and an optional checksum byte:
+ * 
+ *     header | address | size | data | checksum
+ * 
+ * JSON description:
+ * {
+ *     "name": "dataSet",
+ *     "header": [ "0x41", "deviceId", "0x6a", "0x12" ],
+ *     "addressBytes": 4,
+ *     "sizeBytes": 0,
+ *     "data": "raw",          // none, raw, nibbleHighLow, nibbleLowHigh, packed7
+ *     "checksum": "roland"    // none, roland (address..data), yamaha (data only)
+ * }
+ * 
+ * Header entries are byte values (numbers or "0x.." strings), "deviceId"
+ * for a full 7-bit device ID byte, or { "deviceId": base } for a byte that
+ * carries the device ID in its low nibble (e.g. Yamaha 0n/2n, Korg 3n).
+ * Addresses are written as the big-endian bytes of the 32-bit value; sizes
+ * are written 7 bits per byte.
+ * 
+ * compile() resolves the description once into byte templates, offsets and
+ * function pointers, so encode()/decode() do no per-message interpretation.
+ * All buffers exclude the F0/F7 framing bytes.
+ */
+class SysExMessageFormat
+{
+public:
+    enum class DataEncoding
+    {
+        none,
+        raw,
+        nibbleHighLow,
+        nibbleLowHigh,
+        packed7         // Korg-style 7-in-8: one MSB byte per group of seven
+    };
+    
+    enum class Checksum
+    {
+        none,
+        roland,
+        yamaha
+    };
+    
+    struct Fields
+    {
+        int deviceId = 0;
+        juce::uint32 address = 0;
+        juce::uint32 size = 0;
+    };
+    
+    struct Decoded
+    {
+        int deviceId = -1;          // -1 if the header has no device ID byte
+        juce::uint32 address = 0;
+        juce::uint32 size = 0;
+        juce::MemoryBlock data;     // Decoded payload (nibbles/packing removed)
+        bool checksumValid = true;
+    };
+    
+    SysExMessageFormat() = default;
+    
+    /** Compiles a JSON layout description. */
+    static juce::Result compile(const juce::var& description, SysExMessageFormat& result);
+    
+    // Encoding
+    juce::MemoryBlock encode(const Fields& fields, const juce::uint8* data = nullptr, int dataSize = 0) const;
+    void encodeInto(juce::MemoryBlock& dest, const Fields& fields,
+                    const juce::uint8* data = nullptr, int dataSize = 0) const;
+    int getEncodedSize(int dataSize) const noexcept;
+    
+    // Decoding (returns false if the body doesn't match this layout's header)
+    bool matches(const juce::uint8* data, int size) const noexcept;
+    bool decode(const juce::uint8* data, int size, Decoded& result) const;
+    
+    // Description
+    const juce::String& getName() const noexcept { return name; }
+    const juce::var& getDescription() const noexcept { return description; }
+    DataEncoding getDataEncoding() const noexcept { return dataEncoding; }
+    Checksum getChecksum() const noexcept { return checksum; }
+    
+    static DataEncoding parseDataEncoding(const juce::String& text, bool& ok) noexcept;
+    static Checksum parseChecksum(const juce::String& text, bool& ok) noexcept;
+    
+    // Accepts numbers and "0x.." strings
+    static bool parseNumber(const juce::var& value, juce::int64& result);
+    
+private:
+    using ChecksumFunction = juce::uint8 (*)(const juce::uint8* data, int size);
+    using EncodeFunction = int (*)(const juce::uint8* source, int size, juce::uint8* dest);
+    using DecodeFunction = int (*)(const juce::uint8* source, int size, juce::uint8* dest);
+    using SizeFunction = int (*)(int size);
+    
+    juce::String name;
+    juce::var description;
+    
+    // Compiled header: a byte matches when (byte & headerMask[i]) == headerBytes[i]
+    juce::Array<juce::uint8> headerBytes;
+    juce::Array<juce::uint8> headerMask;
+    int deviceIdIndex = -1;
+    juce::uint8 deviceIdMask = 0x7f;
+    
+    int addressBytes = 0;
+    int sizeBytes = 0;
+    DataEncoding dataEncoding = DataEncoding::none;
+    Checksum checksum = Checksum::none;
+    
+    // Derived offsets and dispatch
+    int addressOffset = 0;
+    int sizeOffset = 0;
+    int dataOffset = 0;
+    int checksumBytes = 0;
+    int checksumStart = 0;
+    
+    ChecksumFunction checksumFunction = nullptr;
+    EncodeFunction encodeData = nullptr;
+    DecodeFunction decodeData = nullptr;
+    SizeFunction encodedSizeFor = nullptr;
+    SizeFunction decodedSizeFor = nullptr;
+};
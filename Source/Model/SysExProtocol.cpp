@@ -0,0 +1,199 @@
+#include "SysExProtocol.h"
+
+juce::Result SysExProtocol::compile(const juce::var& desc, Ptr& result)
+{
+    auto* obj = desc.getDynamicObject();
+    if (obj == nullptr)
+        return juce::Result::fail("SysEx protocol description must be an object");
+    
+    std::shared_ptr<SysExProtocol> protocol(new SysExProtocol());
+    protocol->description = desc;
+    
+    juce::int64 deviceId = 0;
+    if (obj->hasProperty("deviceId") && !SysExMessageFormat::parseNumber(obj->getProperty("deviceId"), deviceId))
+        return juce::Result::fail("SysEx protocol has an invalid deviceId");
+    
+    protocol->defaultDeviceId = (int)(deviceId & 0x7f);
+    
+    if (auto* messages = obj->getProperty("messages").getArray())
+    {
+        protocol->formats.reserve((size_t)messages->size());
+        
+        for (const auto& messageDesc : *messages)
+        {
+            SysExMessageFormat format;
+            auto formatResult = SysExMessageFormat::compile(messageDesc, format);
+            if (formatResult.failed())
+                return formatResult;
+            
+            if (protocol->getFormat(format.getName()) != nullptr)
+                return juce::Result::fail("Duplicate SysEx message: " + format.getName());
+            
+            protocol->formats.push_back(std::move(format));
+        }
+    }
+    
+    if (auto* addresses = obj->getProperty("addresses").getDynamicObject())
+    {
+        for (const auto& property : addresses->getProperties())
+        {
+            auto* mapObj = property.value.getDynamicObject();
+            juce::int64 base = 0, stride = 0;
+            
+            if (mapObj == nullptr
+                || !SysExMessageFormat::parseNumber(mapObj->getProperty("base"), base)
+                || !SysExMessageFormat::parseNumber(mapObj->getProperty("stride"), stride))
+            {
+                return juce::Result::fail("Invalid SysEx address map: " + property.name.toString());
+            }
+            
+            AddressMap map;
+            map.base = (juce::uint32)base;
+            map.stride = (juce::uint32)stride;
+            map.length = mapObj->getProperty("length");
+            
+            if (auto* blocks = mapObj->getProperty("blocks").getArray())
+            {
+                map.length = 0;
+                
+                for (const auto& blockDesc : *blocks)
+                {
+                    auto* pair = blockDesc.getArray();
+                    juce::int64 offset = 0;
+                    
+                    if (pair == nullptr || pair->size() != 2
+                        || !SysExMessageFormat::parseNumber((*pair)[0], offset) || (int)(*pair)[1] <= 0)
+                        return juce::Result::fail("SysEx address map blocks must be [offset, length] pairs: "
+                                                  + property.name.toString());
+                    
+                    map.blocks.push_back({ (juce::uint32)offset, (int)(*pair)[1] });
+                    map.length += map.blocks.back().length;
+                }
+            }
+            
+            protocol->addressMaps[property.name.toString()] = map;
+        }
+    }
+    
+    if (auto* ranges = obj->getProperty("ignoreForComparison").getArray())
+    {
+        for (const auto& range : *ranges)
+        {
+            auto* bounds = range.getArray();
+            if (bounds == nullptr || bounds->size() != 2 || (int)(*bounds)[0] < 0 || (int)(*bounds)[1] < (int)(*bounds)[0])
+                return juce::Result::fail("ignoreForComparison entries must be [start, end] pairs");
+            
+            protocol->nonSoundRanges.add({ (int)(*bounds)[0], (int)(*bounds)[1] });
+        }
+    }
+    
+    result = std::move(protocol);
+    return juce::Result::ok();
+}
+
+juce::uint32 SysExProtocol::toLinearAddress(juce::uint32 address) noexcept
+{
+    juce::uint32 linear = 0;
+    
+    for (int shift = 24; shift >= 0; shift -= 8)
+        linear = (linear << 7) | ((address >> shift) & 0x7f);
+    
+    return linear;
+}
+
+juce::uint32 SysExProtocol::fromLinearAddress(juce::uint32 linear) noexcept
+{
+    juce::uint32 address = 0;
+    
+    for (int shift = 0; shift < 32; shift += 8, linear >>= 7)
+        address |= (linear & 0x7f) << shift;
+    
+    return address;
+}
+
+SysExProtocol::Block SysExProtocol::AddressMap::getBlock(int index) const noexcept
+{
+    if (blocks.empty())
+        return { 0, length };
+    
+    return juce::isPositiveAndBelow(index, (int)blocks.size()) ? blocks[(size_t)index] : Block();
+}
+
+int SysExProtocol::AddressMap::getBlockStart(int index) const noexcept
+{
+    int start = 0;
+    
+    for (int i = 0; i < index && i < (int)blocks.size(); ++i)
+        start += blocks[(size_t)i].length;
+    
+    return start;
+}
+
+juce::uint32 SysExProtocol::AddressMap::getAddress(int slot, int block) const noexcept
+{
+    return fromLinearAddress(toLinearAddress(base) + (juce::uint32)slot * toLinearAddress(stride)
+                             + toLinearAddress(getBlock(block).offset));
+}
+
+int SysExProtocol::AddressMap::getSlot(juce::uint32 address) const noexcept
+{
+    int block = -1;
+    const int slot = getSlot(address, block);
+    return block == 0 ? slot : -1;
+}
+
+int SysExProtocol::AddressMap::getSlot(juce::uint32 address, int& block) const noexcept
+{
+    const auto linearStride = toLinearAddress(stride);
+    const auto linear = toLinearAddress(address);
+    block = -1;
+    
+    // A byte with bit 7 set is no address at all, not one that wraps into a slot
+    if (linearStride == 0 || fromLinearAddress(linear) != address)
+        return -1;
+    
+    for (int i = 0; i < getNumBlocks(); ++i)
+    {
+        const auto blockBase = toLinearAddress(base) + toLinearAddress(getBlock(i).offset);
+        
+        if (linear >= blockBase && (linear - blockBase) % linearStride == 0)
+        {
+            block = i;
+            return (int)((linear - blockBase) / linearStride);
+        }
+    }
+    
+    return -1;
+}
+
+const SysExMessageFormat* SysExProtocol::getFormat(const juce::String& messageName) const noexcept
+{
+    for (const auto& format : formats)
+        if (format.getName() == messageName)
+            return &format;
+    
+    return nullptr;
+}
+
+const SysExProtocol::AddressMap* SysExProtocol::getAddressMap(const juce::String& mapName) const noexcept
+{
+    auto it = addressMaps.find(mapName);
+    return it != addressMaps.end() ? &it->second : nullptr;
+}
+
+bool SysExProtocol::canReadPatchNames() const noexcept
+{
+    const auto* nameMap = getAddressMap(PATCH_NAME);
+    
+    return getFormat(DATA_REQUEST) != nullptr
+        && getFormat(DATA_SET) != nullptr
+        && nameMap != nullptr && nameMap->length > 0;
+}
+
+bool SysExProtocol::canWritePatches() const noexcept
+{
+    const auto* patchMap = getAddressMap(PATCH_DATA);
+    
+    return getFormat(DATA_SET) != nullptr
+        && patchMap != nullptr && patchMap->length > 0;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SysExMessageFormat.h"
+#include <map>
+#include <vector>
+
+/**
+ * A device's SysEx protocol: its compiled message layouts and named address maps.
+ * 
+ * JSON description (the "sysex" property of a device template):
+ * {
+ *     "deviceId": 16,
+ *     "messages": [ { "name": "dataRequest", ... }, { "name": "dataSet", ... } ],
+ *     "addresses": {
+ *         "patchName": { "base": "0x11000000", "stride": "0x10000", "length": 12 },
+ *         "patch": { "base": "0x11000000", "stride": "0x10000",
+ *                    "blocks": [ [ "0x0000", 72 ], [ "0x1000", 129 ] ] }
+ *     },
+ *     "ignoreForComparison": [ [ 0, 12 ] ]
+ * }
+ * 
+ * An address map locates each patch slot at base + slot * stride, added in
+ * 7-bit-per-byte arithmetic (see toLinearAddress()). A slot is one block of
+ * "length" bytes there, or the "blocks" listed as [offset, length] pairs
+ * from the slot's address (a Roland patch is a common block and one block
+ * per tone). A slot's dump is its blocks' bytes one after another, and each
+ * block is transferred as a message of its own.
+ * Protocols that define "dataRequest", "dataSet" and a "patchName" map
+ * support reading patch names back from the device. Protocols that define
+ * "dataSet" and a "patch" map support writing stored patch dumps to device
+ * slots (used to keep the device in step when slots are reordered).
+ * 
+ * "ignoreForComparison" lists [start, end) byte ranges of a stored patch
+ * dump that don't affect the sound (name, bookkeeping), so two dumps that
+ * differ only there are treated as the same patch.
+ * 
+ * Compiled protocols are immutable and shared between template copies.
+ */
+class SysExProtocol
+{
+public:
+    using Ptr = std::shared_ptr<const SysExProtocol>;
+    
+    struct Block
+    {
+        juce::uint32 offset = 0;    // From the slot's address, 7 bits per byte
+        int length = 0;
+    };
+    
+    struct AddressMap
+    {
+        juce::uint32 base = 0;
+        juce::uint32 stride = 0;
+        int length = 0;                 // All blocks together
+        std::vector<Block> blocks;      // Empty: one block of length bytes at the slot's address
+        
+        int getNumBlocks() const noexcept { return blocks.empty() ? 1 : (int)blocks.size(); }
+        Block getBlock(int index) const noexcept;
+        int getBlockStart(int index) const noexcept;    // Offset of the block's bytes in a slot's dump
+        
+        juce::uint32 getAddress(int slot, int block = 0) const noexcept;
+        int getSlot(juce::uint32 address) const noexcept; // -1 unless a slot's first block starts there
+        int getSlot(juce::uint32 address, int& block) const noexcept; // -1 unless one of its blocks starts there
+    };
+    
+    /**
+     * Addresses are written one 7-bit value per byte (0x11 0x7f 0x00 0x00 is
+     * 0x117f0000), so arithmetic on them must carry from bit 6 of each byte
+     * into the next: 0x117f0000 + 0x10000 is 0x12000000. These convert
+     * between that form and a plain number.
+     */
+    static juce::uint32 toLinearAddress(juce::uint32 address) noexcept;
+    static juce::uint32 fromLinearAddress(juce::uint32 linear) noexcept;
+    
+    // Well-known message and address names
+    static constexpr const char* DATA_REQUEST = "dataRequest";
+    static constexpr const char* DATA_SET = "dataSet";
+    static constexpr const char* PATCH_NAME = "patchName";
+    static constexpr const char* PATCH_DATA = "patch";
+    
+    /** Compiles a JSON protocol description. */
+    static juce::Result compile(const juce::var& description, Ptr& result);
+    
+    // Lookup (returns nullptr if not defined)
+    const SysExMessageFormat* getFormat(const juce::String& messageName) const noexcept;
+    const AddressMap* getAddressMap(const juce::String& mapName) const noexcept;
+    
+    int getDefaultDeviceId() const noexcept { return defaultDeviceId; }
+    int getNumFormats() const noexcept { return (int)formats.size(); }
+    bool canReadPatchNames() const noexcept;
+    bool canWritePatches() const noexcept;
+    const juce::Array<juce::Range<int>>& getNonSoundRanges() const noexcept { return nonSoundRanges; }
+    
+    // Serialization (returns the description it was compiled from)
+    juce::var toVar() const { return description; }
+    
+private:
+    SysExProtocol() = default;
+    
+    juce::var description;
+    int defaultDeviceId = 0;
+    std::vector<SysExMessageFormat> formats;
+    std::map<juce::String, AddressMap> addressMaps;
+    juce::Array<juce::Range<int>> nonSoundRanges;
+};
@@ -1,5 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "Controller/TraceRecorder.h"
 
 MidiLibrarianAudioProcessorEditor::MidiLibrarianAudioProcessorEditor(MidiLibrarianAudioProcessor& p)
     : AudioProcessorEditor(&p)
@@ -7,7 +8,22 @@ MidiLibrarianAudioProcessorEditor::MidiLibrarianAudioProcessorEditor(MidiLibrari
     , deviceSelectorPanel(p.getPatchManager())
     , toolbarPanel(p.getPatchManager())
     , patchListPanel(p.getPatchManager())
+    , midiMonitorPanel(p.getPatchManager().getMidiManager())
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("Editor constructor");
+    
+    // Time to interactive: from here until the list shows the loaded library
+    patchListPanel.onListUpdated = [this]()
+    {
+        if (!interactive && patchListPanel.isPopulated())
+        {
+            interactive = true;
+            const auto elapsedTicks = juce::Time::getHighResolutionTicks() - openedTicks;
+            audioProcessor.getPatchManager().setTimeToInteractive(juce::Time::highResolutionTicksToSeconds(elapsedTicks) * 1000.0);
+            MIDI_LIBRARIAN_TRACE_INSTANT("Editor interactive");
+        }
+    };
+    
     // Apply custom look and feel
     setLookAndFeel(&valhallaLookAndFeel);
     
@@ -15,6 +31,13 @@ MidiLibrarianAudioProcessorEditor::MidiLibrarianAudioProcessorEditor(MidiLibrari
     addAndMakeVisible(deviceSelectorPanel);
     addAndMakeVisible(toolbarPanel);
     addAndMakeVisible(patchListPanel);
+    addChildComponent(midiMonitorPanel);
+    
+    toolbarPanel.onMonitorToggled = [this](bool shown)
+    {
+        midiMonitorPanel.setVisible(shown);
+        resized();
+    };
     
     // Set initial window size (resizable)
     // Minimum size for comfortable use
@@ -30,6 +53,15 @@ MidiLibrarianAudioProcessorEditor::~MidiLibrarianAudioProcessorEditor()
 
 void MidiLibrarianAudioProcessorEditor::paint(juce::Graphics& g)
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("Editor::paint");
+    
+    // Marks the end of editor startup in the trace
+    if (!hasPainted)
+    {
+        MIDI_LIBRARIAN_TRACE_INSTANT("Editor first paint");
+        hasPainted = true;
+    }
+    
     // Fill background with look and feel color
     g.fillAll(valhallaLookAndFeel.getBackgroundColour());
 }
@@ -50,6 +82,14 @@ void MidiLibrarianAudioProcessorEditor::resized()
     
     bounds.removeFromTop(8); // Spacing
     
+    // MIDI monitor along the bottom while shown
+    if (midiMonitorPanel.isVisible())
+    {
+        const int monitorHeight = juce::jmin(220, bounds.getHeight() / 2);
+        midiMonitorPanel.setBounds(bounds.removeFromBottom(monitorHeight));
+        bounds.removeFromBottom(8); // Spacing
+    }
+    
     // Patch list takes remaining space
     patchListPanel.setBounds(bounds);
 }
@@ -6,6 +6,7 @@
 #include "View/DeviceSelectorPanel.h"
 #include "View/PatchListPanel.h"
 #include "View/ToolbarPanel.h"
+#include "View/MidiMonitorPanel.h"
 
 /**
  * Main plugin editor window.
@@ -14,6 +15,8 @@
  * - DeviceSelectorPanel (top)
  * - ToolbarPanel (undo/redo, actions)
  * - PatchListPanel (main area)
+ * - MidiMonitorPanel (bottom, shown with the toolbar's Monitor button):
+ *   traffic log, diagnostics and trace recording
  * 
  * Applies the custom ValhallaLookAndFeel to all child components.
  */
@@ -22,18 +25,23 @@ class MidiLibrarianAudioProcessorEditor : public juce::AudioProcessorEditor
 public:
     MidiLibrarianAudioProcessorEditor(MidiLibrarianAudioProcessor&);
     ~MidiLibrarianAudioProcessorEditor() override;
-
+    
     void paint(juce::Graphics& g) override;
     void resized() override;
-
+    
 private:
     MidiLibrarianAudioProcessor& audioProcessor;
+    const juce::int64 openedTicks = juce::Time::getHighResolutionTicks(); // Before the panels are built
     
     ValhallaLookAndFeel valhallaLookAndFeel;
     
     DeviceSelectorPanel deviceSelectorPanel;
     ToolbarPanel toolbarPanel;
     PatchListPanel patchListPanel;
+    MidiMonitorPanel midiMonitorPanel;
+    
+    bool hasPainted = false;
+    bool interactive = false;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiLibrarianAudioProcessorEditor)
 };
@@ -1,5 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "Controller/RealtimeSafetyChecker.h"
 
 MidiLibrarianAudioProcessor::MidiLibrarianAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -81,7 +82,11 @@ void MidiLibrarianAudioProcessor::changeProgramName(int index, const juce::Strin
 
 void MidiLibrarianAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    // No audio processing needed
+    // No audio processing needed; the sample rate drives MIDI wire-time pacing
+    patchManager.getMidiManager().prepareToPlay(sampleRate);
+    
+    // Hosts only scanning the plugin never get here, so they skip the library load
+    patchManager.beginStartup();
 }
 
 void MidiLibrarianAudioProcessor::releaseResources()
@@ -110,53 +115,33 @@ bool MidiLibrarianAudioProcessor::isBusesLayoutSupported(const BusesLayout& layo
 
 void MidiLibrarianAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    // With MIDI_LIBRARIAN_RT_CHECKS, allocations, locks and system calls below are reported
+    const RealtimeSafetyChecker::ScopedRealtimeSection realtimeSection;
+    
     // Clear audio buffer (MIDI-only plugin)
     buffer.clear();
     
     // Process queued MIDI messages from MidiManager (sample-accurate timing)
-    patchManager.getMidiManager().processAudioThread(midiMessages);
+    patchManager.getMidiManager().processAudioThread(midiMessages, buffer.getNumSamples());
 }
 
 void MidiLibrarianAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
     // Serialize plugin state (patch bank and device config)
     // This is for DAW project save/load
-    juce::MemoryOutputStream mos(destData, true);
-    
-    auto var = juce::DynamicObject::Ptr(new juce::DynamicObject());
-    var->setProperty("patchBank", patchManager.getPatchBank().toVar());
-    var->setProperty("deviceConfig", patchManager.getDeviceModel().toVar());
-    
-    juce::JSON::writeToStream(mos, juce::var(var));
+    patchManager.waitUntilReady();
+    patchManager.writeState(destData);
 }
 
 void MidiLibrarianAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-    // Deserialize plugin state
-    auto jsonString = juce::String::fromUTF8(static_cast<const char*>(data), sizeInBytes);
-    auto var = juce::JSON::parse(jsonString);
-    
-    if (auto* obj = var.getDynamicObject())
-    {
-        if (obj->hasProperty("patchBank"))
-            patchManager.getPatchBank().fromVar(obj->getProperty("patchBank"));
-        
-        if (obj->hasProperty("deviceConfig"))
-        {
-            patchManager.getDeviceModel().fromVar(obj->getProperty("deviceConfig"));
-            // Sync MIDI manager (will handle errors gracefully)
-            auto portName = patchManager.getDeviceModel().getMidiOutputPortName();
-            if (!portName.isEmpty())
-            {
-                patchManager.setMidiOutputPort(portName);
-            }
-            patchManager.setMidiChannel(patchManager.getDeviceModel().getMidiChannelDisplay());
-        }
-    }
+    // Deserialize plugin state (binary chunk, or JSON from older versions)
+    patchManager.restoreState(data, sizeInBytes);
 }
 
 juce::AudioProcessorEditor* MidiLibrarianAudioProcessor::createEditor()
 {
+    patchManager.beginStartup();
     return new MidiLibrarianAudioProcessorEditor(*this);
 }
 
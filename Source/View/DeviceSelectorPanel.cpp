@@ -24,6 +24,14 @@ DeviceSelectorPanel::DeviceSelectorPanel(PatchManager& pm)
     updateChannelComboBox();
     addAndMakeVisible(channelComboBox);
     
+    sysExIdLabel.setText("SysEx ID:", juce::dontSendNotification);
+    sysExIdLabel.setJustificationType(juce::Justification::centredRight);
+    addAndMakeVisible(sysExIdLabel);
+    
+    sysExIdComboBox.addListener(this);
+    updateSysExIdComboBox();
+    addAndMakeVisible(sysExIdComboBox);
+    
     // Bank selection
     bankLabel.setText("Bank:", juce::dontSendNotification);
     bankLabel.setJustificationType(juce::Justification::centredLeft);
@@ -48,8 +56,9 @@ DeviceSelectorPanel::DeviceSelectorPanel(PatchManager& pm)
     updateTemplateComboBox();
     addAndMakeVisible(templateComboBox);
     
-    // Listen for MIDI device changes
+    // Listen for MIDI device and template folder changes
     patchManager.getMidiManager().addChangeListener(this);
+    patchManager.getTemplateManager().addChangeListener(this);
     
     // Initial refresh
     refreshPortList();
@@ -64,11 +73,14 @@ DeviceSelectorPanel::DeviceSelectorPanel(PatchManager& pm)
     
     channelComboBox.setSelectedId(patchManager.getDeviceModel().getMidiChannelDisplay(),
                                   juce::dontSendNotification);
+    sysExIdComboBox.setSelectedId(patchManager.getDeviceModel().getSysExDeviceId() + 2,
+                                  juce::dontSendNotification);
 }
 
 DeviceSelectorPanel::~DeviceSelectorPanel()
 {
     patchManager.getMidiManager().removeChangeListener(this);
+    patchManager.getTemplateManager().removeChangeListener(this);
 }
 
 void DeviceSelectorPanel::paint(juce::Graphics& g)
@@ -101,6 +113,10 @@ void DeviceSelectorPanel::resized()
     channelLabel.setBounds(channelRow.removeFromLeft(labelWidth));
     channelRow.removeFromLeft(spacing);
     channelComboBox.setBounds(channelRow.removeFromLeft(80));
+    channelRow.removeFromLeft(spacing);
+    sysExIdLabel.setBounds(channelRow.removeFromLeft(labelWidth));
+    channelRow.removeFromLeft(spacing);
+    sysExIdComboBox.setBounds(channelRow.removeFromLeft(100));
     
     bounds.removeFromTop(spacing);
     
@@ -127,8 +143,12 @@ void DeviceSelectorPanel::comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged
 {
     if (comboBoxThatHasChanged == &portComboBox)
     {
-        juce::String selectedPort = portComboBox.getText();
-        patchManager.setMidiOutputPort(selectedPort);
+        // Select by identifier, so two devices with the same name stay apart
+        const int index = portComboBox.getSelectedId() - 2;
+        if (juce::isPositiveAndBelow(index, listedPorts.size()))
+            patchManager.setMidiOutputPort(listedPorts[index].name, listedPorts[index].identifier);
+        else
+            patchManager.setMidiOutputPort(portComboBox.getText());
         updateConnectionStatus();
     }
     else if (comboBoxThatHasChanged == &channelComboBox)
@@ -139,13 +159,18 @@ void DeviceSelectorPanel::comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged
             patchManager.setMidiChannel(selectedChannel);
         }
     }
+    else if (comboBoxThatHasChanged == &sysExIdComboBox)
+    {
+        if (sysExIdComboBox.getSelectedId() > 0)
+            patchManager.setSysExDeviceId(sysExIdComboBox.getSelectedId() - 2);
+    }
     else if (comboBoxThatHasChanged == &bankComboBox)
     {
         int selectedBank = bankComboBox.getSelectedId() - 1; // IDs are 1-based
         if (selectedBank >= 0 && selectedBank <= 127)
         {
             bool useMSB = useMSBButton.getToggleState();
-            patchManager.getMidiManager().sendBankSelect(selectedBank, useMSB);
+            patchManager.getMidiManager().sendBankSelect(selectedBank, useMSB, MidiManager::Priority::realtime);
         }
     }
     else if (comboBoxThatHasChanged == &templateComboBox)
@@ -153,12 +178,13 @@ void DeviceSelectorPanel::comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged
         int selectedId = templateComboBox.getSelectedId();
         if (selectedId > 0)
         {
-            auto templates = patchManager.getTemplateManager().getAvailableTemplates();
+            auto& templateManager = patchManager.getTemplateManager();
+            const auto& templates = templateManager.getAvailableTemplates();
             if (selectedId <= templates.size())
             {
-                const auto& template_ = templates[selectedId - 1];
-                patchManager.getDeviceModel().setDeviceID(template_.getDeviceID());
-                patchManager.getDeviceModel().setTemplate(template_);
+                // Parsed here on first selection, not at startup
+                auto template_ = templateManager.getTemplate(templates.getReference(selectedId - 1).deviceID);
+                patchManager.setDeviceTemplate(template_);
                 
                 // Update channel to template default if not set
                 if (patchManager.getDeviceModel().getMidiChannelDisplay() == 1)
@@ -170,7 +196,7 @@ void DeviceSelectorPanel::comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged
                 useMSBButton.setToggleState(template_.usesMSB(), juce::dontSendNotification);
                 useMSBButton.setEnabled(template_.usesBankSelect());
                 
-                patchManager.saveAll();
+                patchManager.saveDeviceConfig();
             }
         }
     }
@@ -185,13 +211,19 @@ void DeviceSelectorPanel::buttonClicked(juce::Button* button)
         if (selectedBank >= 0 && selectedBank <= 127)
         {
             bool useMSB = useMSBButton.getToggleState();
-            patchManager.getMidiManager().sendBankSelect(selectedBank, useMSB);
+            patchManager.getMidiManager().sendBankSelect(selectedBank, useMSB, MidiManager::Priority::realtime);
         }
     }
 }
 
 void DeviceSelectorPanel::changeListenerCallback(juce::ChangeBroadcaster* source)
 {
+    if (source == &patchManager.getTemplateManager())
+    {
+        updateTemplateComboBox();
+        return;
+    }
+    
     refreshPortList();
     updateConnectionStatus();
 }
@@ -201,17 +233,18 @@ void DeviceSelectorPanel::refreshPortList()
     portComboBox.clear();
     portComboBox.addItem("(No Output)", 1);
     
-    auto ports = patchManager.getMidiManager().getAvailableOutputPorts();
-    for (int i = 0; i < ports.size(); ++i)
+    listedPorts = patchManager.getMidiManager().getAvailableOutputDevices();
+    for (int i = 0; i < listedPorts.size(); ++i)
     {
-        portComboBox.addItem(ports[i], i + 2);
+        portComboBox.addItem(listedPorts.getReference(i).name, i + 2);
     }
     
     // Restore selection if still available
-    auto currentPort = patchManager.getDeviceModel().getMidiOutputPortName();
+    const auto& deviceModel = patchManager.getDeviceModel();
+    auto currentPort = deviceModel.getMidiOutputPortName();
     if (currentPort.isNotEmpty())
     {
-        int index = ports.indexOf(currentPort);
+        int index = MidiDeviceWatcher::findDevice(listedPorts, deviceModel.getMidiOutputPortIdentifier(), currentPort);
         if (index >= 0)
         {
             portComboBox.setSelectedId(index + 2, juce::dontSendNotification);
@@ -228,6 +261,16 @@ void DeviceSelectorPanel::updateChannelComboBox()
     }
 }
 
+void DeviceSelectorPanel::updateSysExIdComboBox()
+{
+    sysExIdComboBox.clear();
+    sysExIdComboBox.addItem("Default", 1);
+    for (int i = 0; i <= 127; ++i)
+    {
+        sysExIdComboBox.addItem("0x" + juce::String::toHexString(i).paddedLeft('0', 2), i + 2);
+    }
+}
+
 void DeviceSelectorPanel::updateBankComboBox()
 {
     bankComboBox.clear();
@@ -242,16 +285,15 @@ void DeviceSelectorPanel::updateBankComboBox()
 void DeviceSelectorPanel::updateTemplateComboBox()
 {
     templateComboBox.clear();
-    auto templates = patchManager.getTemplateManager().getAvailableTemplates();
+    const auto& templates = patchManager.getTemplateManager().getAvailableTemplates();
     
     for (int i = 0; i < templates.size(); ++i)
     {
-        const auto& template_ = templates[i];
-        juce::String displayName = template_.getManufacturer() + " " + template_.getDeviceName();
-        templateComboBox.addItem(displayName, i + 1);
+        const auto& info = templates.getReference(i);
+        templateComboBox.addItem(info.getDisplayName(), i + 1);
         
         // Select current template if it matches
-        if (template_.getDeviceID() == patchManager.getDeviceModel().getDeviceID())
+        if (info.deviceID == patchManager.getDeviceModel().getDeviceID())
         {
             templateComboBox.setSelectedId(i + 1, juce::dontSendNotification);
         }
@@ -266,14 +308,19 @@ void DeviceSelectorPanel::updateTemplateComboBox()
 
 void DeviceSelectorPanel::updateConnectionStatus()
 {
-    bool isConnected = patchManager.getMidiManager().isPortOpen();
-    auto portName = patchManager.getMidiManager().getCurrentPortName();
+    const auto& midiManager = patchManager.getMidiManager();
+    bool isConnected = midiManager.isPortOpen();
+    auto portName = midiManager.getCurrentPortName();
     
     juce::String statusText;
     if (isConnected && portName.isNotEmpty())
     {
         statusText = "Connected: " + portName;
     }
+    else if (midiManager.isPortReconnecting())
+    {
+        statusText = "Reconnecting: " + portName;
+    }
     else if (!portName.isEmpty())
     {
         statusText = "Disconnected";
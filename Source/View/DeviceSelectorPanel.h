@@ -8,6 +8,8 @@
  * Panel for selecting MIDI output port and channel.
  * 
  * Displays a ComboBox for port selection and a ComboBox for channel (1-16).
+ * The SysEx ID box next to the channel sets the device ID byte of SysEx
+ * messages, for units moved off their protocol's default.
  * Updates the PatchManager when selections change.
  * Shows device connection status with visual indicator.
  */
@@ -29,7 +31,7 @@ public:
     // Button::Listener
     void buttonClicked(juce::Button* button) override;
     
-    // ChangeListener (for MIDI device list changes)
+    // ChangeListener (for MIDI device list and template changes)
     void changeListenerCallback(juce::ChangeBroadcaster* source) override;
     
 private:
@@ -37,10 +39,13 @@ private:
     
     juce::Label portLabel;
     juce::ComboBox portComboBox;
+    juce::Array<juce::MidiDeviceInfo> listedPorts; // Item ID i + 2 is listedPorts[i]
     DeviceStatusIndicator statusIndicator;
     
     juce::Label channelLabel;
     juce::ComboBox channelComboBox;
+    juce::Label sysExIdLabel;
+    juce::ComboBox sysExIdComboBox; // Item ID 1 is the protocol's default, id + 2 is device ID id
     
     juce::Label bankLabel;
     juce::ComboBox bankComboBox;
@@ -51,6 +56,7 @@ private:
     
     void refreshPortList();
     void updateChannelComboBox();
+    void updateSysExIdComboBox();
     void updateBankComboBox();
     void updateTemplateComboBox();
     void updateConnectionStatus();
@@ -1,7 +1,47 @@
 #include "MidiMonitorPanel.h"
 #include "ValhallaLookAndFeel.h"
+#include "../Controller/TraceRecorder.h"
+#include <cstdio>
 
-MidiMonitorPanel::MidiMonitorPanel()
+namespace
+{
+    constexpr int FLUSH_INTERVAL_MS = 50;
+    constexpr int STATISTICS_INTERVAL_TICKS = 10; // Every 500 ms
+    
+    // Popup menu item IDs
+    constexpr int MENU_INCOMING = 1;
+    constexpr int MENU_OUTGOING = 2;
+    constexpr int MENU_ALL_TYPES = 3;
+    constexpr int MENU_ALL_CHANNELS = 4;
+    constexpr int MENU_TYPE_BASE = 100;
+    constexpr int MENU_CHANNEL_BASE = 200;
+    
+    constexpr int MENU_COPY_DIAGNOSTICS = 1;
+    constexpr int MENU_SAVE_DIAGNOSTICS = 2;
+    constexpr int MENU_RESET_DIAGNOSTICS = 3;
+    constexpr int MENU_TOGGLE_TRACING = 4;
+    constexpr int MENU_SAVE_TRACE = 5;
+    constexpr int MENU_CLEAR_TRACE = 6;
+    
+    juce::String formatPortStatistics(const char* label, const MidiTrafficStatistics& stats)
+    {
+        return juce::String::formatted("%s %.0f B/s (%.0f%%) %.0f msg/s", label,
+                                       stats.getBytesPerSecond(),
+                                       stats.getBusLoad() * 100.0,
+                                       stats.getMessagesPerSecond());
+    }
+    
+    juce::String formatMicroseconds(juce::uint64 microseconds)
+    {
+        if (microseconds < 1000)
+            return juce::String((juce::int64)microseconds) + " us";
+        
+        return juce::String(microseconds / 1000.0, 1) + " ms";
+    }
+}
+
+MidiMonitorPanel::MidiMonitorPanel(MidiManager& manager)
+    : midiManager(manager)
 {
     logEditor.setMultiLine(true);
     logEditor.setReadOnly(true);
@@ -27,6 +67,33 @@ MidiMonitorPanel::MidiMonitorPanel()
         }
     };
     addAndMakeVisible(exportButton);
+    
+    filterButton.setButtonText("Filter");
+    filterButton.onClick = [this]() { showFilterMenu(); };
+    addAndMakeVisible(filterButton);
+    
+    diagnosticsButton.setButtonText("Diagnostics");
+    diagnosticsButton.onClick = [this]() { showDiagnosticsMenu(); };
+    addAndMakeVisible(diagnosticsButton);
+    
+    statisticsLabel.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 11.0f, juce::Font::plain));
+    statisticsLabel.setJustificationType(juce::Justification::centredLeft);
+    addAndMakeVisible(statisticsLabel);
+    
+    diagnosticsLabel.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 11.0f, juce::Font::plain));
+    diagnosticsLabel.setJustificationType(juce::Justification::centredLeft);
+    addAndMakeVisible(diagnosticsLabel);
+    
+    midiManager.addInputListener(this);
+    midiManager.addOutputListener(this);
+    startTimer(FLUSH_INTERVAL_MS);
+}
+
+MidiMonitorPanel::~MidiMonitorPanel()
+{
+    stopTimer();
+    midiManager.removeInputListener(this);
+    midiManager.removeOutputListener(this);
 }
 
 void MidiMonitorPanel::paint(juce::Graphics& g)
@@ -39,9 +106,16 @@ void MidiMonitorPanel::resized()
     auto bounds = getLocalBounds().reduced(4);
     
     auto buttonRow = bounds.removeFromTop(30);
+    diagnosticsButton.setBounds(buttonRow.removeFromRight(90));
+    buttonRow.removeFromRight(8);
     exportButton.setBounds(buttonRow.removeFromRight(80));
     buttonRow.removeFromRight(8);
     clearButton.setBounds(buttonRow.removeFromRight(80));
+    buttonRow.removeFromRight(8);
+    filterButton.setBounds(buttonRow.removeFromRight(80));
+    buttonRow.removeFromRight(8);
+    statisticsLabel.setBounds(buttonRow);
+    diagnosticsLabel.setBounds(bounds.removeFromTop(18));
     bounds.removeFromTop(4);
     
     logEditor.setBounds(bounds);
@@ -54,72 +128,258 @@ void MidiMonitorPanel::textEditorTextChanged(juce::TextEditor& editor)
 
 void MidiMonitorPanel::logMidiMessage(const juce::MidiMessage& message, bool isOutgoing)
 {
-    juce::String logLine = formatMidiMessage(message, isOutgoing);
+    const auto type = MidiMessageDecoder::getType(message);
+    const int channel = MidiMessageDecoder::getChannel(message);
     
-    juce::MessageManager::callAsync([this, logLine]()
-    {
-        auto currentText = logEditor.getText();
-        currentText += logLine + "\n";
-        
-        // Limit to max lines
-        auto lines = juce::StringArray::fromLines(currentText);
-        if (lines.size() > maxLogLines)
-        {
-            lines.removeRange(0, lines.size() - maxLogLines);
-            currentText = lines.joinIntoString("\n") + "\n";
-        }
-        
-        logEditor.setText(currentText);
-        logEditor.moveCaretToEnd();
-    });
+    const juce::ScopedLock sl(pendingLock);
+    
+    // Filter before formatting so dropped events cost a table lookup only
+    if (!filter.accepts(type, channel, isOutgoing))
+        return;
+    
+    pendingLines.add(formatMidiMessage(message, isOutgoing));
+    
+    // Don't let a flooding port grow the pending buffer past what can be shown
+    if (pendingLines.size() > maxLogLines)
+        pendingLines.removeRange(0, pendingLines.size() - maxLogLines);
 }
 
 void MidiMonitorPanel::clearLog()
 {
+    {
+        const juce::ScopedLock sl(pendingLock);
+        pendingLines.clear();
+    }
+    
+    visibleLines.clear();
     logEditor.clear();
 }
 
-juce::String MidiMonitorPanel::formatMidiMessage(const juce::MidiMessage& message, bool isOutgoing) const
+void MidiMonitorPanel::setFilter(const MidiMessageDecoder::Filter& newFilter)
+{
+    const juce::ScopedLock sl(pendingLock);
+    filter = newFilter;
+}
+
+MidiMessageDecoder::Filter MidiMonitorPanel::getFilter() const
+{
+    const juce::ScopedLock sl(pendingLock);
+    return filter;
+}
+
+void MidiMonitorPanel::timerCallback()
 {
-    juce::String direction = isOutgoing ? "OUT" : "IN ";
-    juce::String timestamp = juce::Time::getCurrentTime().toString(true, true, false, true);
-    juce::String description;
+    flushPendingLines();
     
-    if (message.isProgramChange())
+    if (++statisticsTick >= STATISTICS_INTERVAL_TICKS)
     {
-        int channel = message.getChannel();
-        int program = message.getProgramChangeNumber();
-        description = juce::String::formatted("PC Ch%d Prg%d", channel, program);
+        statisticsTick = 0;
+        updateStatistics();
+        updateDiagnostics();
     }
-    else if (message.isController())
-    {
-        int channel = message.getChannel();
-        int controller = message.getControllerNumber();
-        int value = message.getControllerValue();
-        description = juce::String::formatted("CC Ch%d #%d=%d", channel, controller, value);
-    }
-    else if (message.isNoteOn())
+}
+
+void MidiMonitorPanel::flushPendingLines()
+{
+    juce::StringArray newLines;
     {
-        int channel = message.getChannel();
-        int note = message.getNoteNumber();
-        int velocity = message.getVelocity();
-        description = juce::String::formatted("NoteOn Ch%d Note%d Vel%d", channel, note, velocity);
+        const juce::ScopedLock sl(pendingLock);
+        if (pendingLines.isEmpty())
+            return;
+        
+        newLines.swapWith(pendingLines);
     }
-    else if (message.isNoteOff())
+    
+    visibleLines.addArray(newLines);
+    if (visibleLines.size() > maxLogLines)
+        visibleLines.removeRange(0, visibleLines.size() - maxLogLines);
+    
+    logEditor.setText(visibleLines.joinIntoString("\n") + "\n", false);
+    logEditor.moveCaretToEnd();
+}
+
+void MidiMonitorPanel::updateStatistics()
+{
+    // Rates as of MidiManager's last refresh
+    const auto& input = midiManager.getInputStatistics();
+    const auto& output = midiManager.getOutputStatistics();
+    
+    auto text = formatPortStatistics("IN", input) + "  " + formatPortStatistics("OUT", output);
+    
+    // Active sensing is ~3 msg/s per device; anything persistent is worth calling out
+    const double sensingRate = input.getTypeRate(MidiMessageDecoder::MessageType::activeSensing);
+    if (sensingRate >= 1.0)
+        text += juce::String::formatted("  AS %.0f/s", sensingRate);
+    
+    statisticsLabel.setText(text, juce::dontSendNotification);
+}
+
+void MidiMonitorPanel::updateDiagnostics()
+{
+    const auto& telemetry = midiManager.getTelemetry();
+    const auto& queueLatency = telemetry.getEnqueueLatencyMicroseconds();
+    const auto& learnLatency = telemetry.getLearnRecallLatencyMicroseconds();
+    
+    auto text = "Queue p50 " + formatMicroseconds(queueLatency.getPercentile(0.5))
+              + " p99 " + formatMicroseconds(queueLatency.getPercentile(0.99))
+              + "  Drain p99 " + formatMicroseconds(telemetry.getDrainTimeNanoseconds().getPercentile(0.99) / 1000)
+              + "  HWM";
+    
+    for (int i = 0; i < MidiManager::NUM_PRIORITIES; ++i)
+        text += (i == 0 ? " " : "/") + juce::String(midiManager.getLaneStatistics(static_cast<MidiManager::Priority>(i)).highWaterMark);
+    
+    text += "  Full " + juce::String((juce::int64)telemetry.getQueueFullFailures());
+    
+    if (telemetry.getDisconnectDrops() > 0)
+        text += "  Disconnect drops " + juce::String((juce::int64)telemetry.getDisconnectDrops());
+    
+    if (learnLatency.getCount() > 0)
+        text += "  Learn p99 " + formatMicroseconds(learnLatency.getPercentile(0.99));
+    
+    diagnosticsLabel.setText(text, juce::dontSendNotification);
+}
+
+void MidiMonitorPanel::showDiagnosticsMenu()
+{
+    juce::PopupMenu menu;
+    menu.addItem(MENU_COPY_DIAGNOSTICS, "Copy Diagnostics JSON");
+    menu.addItem(MENU_SAVE_DIAGNOSTICS, "Save Diagnostics JSON...");
+    menu.addSeparator();
+    menu.addItem(MENU_RESET_DIAGNOSTICS, "Reset Diagnostics");
+    
+    // Only builds with MIDI_LIBRARIAN_TRACING have trace points to record
+    const bool canTrace = TraceRecorder::isCompiledIn();
+    menu.addSeparator();
+    menu.addItem(MENU_TOGGLE_TRACING, "Record Trace", canTrace, TraceRecorder::isEnabled());
+    menu.addItem(MENU_SAVE_TRACE, "Save Chrome Trace...", canTrace);
+    menu.addItem(MENU_CLEAR_TRACE, "Clear Trace", canTrace);
+    
+    juce::Component::SafePointer<MidiMonitorPanel> safeThis(this);
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&diagnosticsButton),
+                       [safeThis](int result)
     {
-        int channel = message.getChannel();
-        int note = message.getNoteNumber();
-        description = juce::String::formatted("NoteOff Ch%d Note%d", channel, note);
-    }
-    else if (message.isSysEx())
+        if (safeThis == nullptr || result == 0)
+            return;
+        
+        auto& manager = safeThis->midiManager;
+        
+        if (result == MENU_COPY_DIAGNOSTICS)
+        {
+            juce::SystemClipboard::copyTextToClipboard(juce::JSON::toString(manager.getDiagnostics()));
+        }
+        else if (result == MENU_SAVE_DIAGNOSTICS)
+        {
+            juce::FileChooser chooser("Save MIDI Diagnostics", juce::File(), "*.json");
+            if (chooser.browseForFileToSave(true))
+            {
+                auto file = chooser.getResult();
+                if (file != juce::File())
+                {
+                    file.replaceWithText(juce::JSON::toString(manager.getDiagnostics()));
+                }
+            }
+        }
+        else if (result == MENU_RESET_DIAGNOSTICS)
+        {
+            manager.resetDiagnostics();
+            safeThis->updateDiagnostics();
+        }
+        else if (result == MENU_TOGGLE_TRACING)
+        {
+            TraceRecorder::setEnabled(!TraceRecorder::isEnabled());
+        }
+        else if (result == MENU_SAVE_TRACE)
+        {
+            juce::FileChooser chooser("Save Chrome Trace", juce::File(), "*.json");
+            if (chooser.browseForFileToSave(true))
+            {
+                auto file = chooser.getResult();
+                if (file != juce::File())
+                {
+                    TraceRecorder::writeChromeTrace(file);
+                }
+            }
+        }
+        else if (result == MENU_CLEAR_TRACE)
+        {
+            TraceRecorder::clear();
+        }
+    });
+}
+
+void MidiMonitorPanel::showFilterMenu()
+{
+    using MessageType = MidiMessageDecoder::MessageType;
+    const auto current = getFilter();
+    
+    juce::PopupMenu menu;
+    menu.addItem(MENU_INCOMING, "Incoming", true, current.showIncoming);
+    menu.addItem(MENU_OUTGOING, "Outgoing", true, current.showOutgoing);
+    menu.addSeparator();
+    
+    juce::PopupMenu typeMenu;
+    typeMenu.addItem(MENU_ALL_TYPES, "All Types");
+    typeMenu.addSeparator();
+    for (int i = 0; i < MidiMessageDecoder::NUM_TYPES; ++i)
     {
-        description = "SysEx (" + juce::String(message.getSysExDataSize()) + " bytes)";
+        const auto type = static_cast<MessageType>(i);
+        typeMenu.addItem(MENU_TYPE_BASE + i, MidiMessageDecoder::getTypeName(type), true,
+                         current.isTypeEnabled(type));
     }
-    else
+    menu.addSubMenu("Message Types", typeMenu);
+    
+    juce::PopupMenu channelMenu;
+    channelMenu.addItem(MENU_ALL_CHANNELS, "All Channels");
+    channelMenu.addSeparator();
+    for (int channel = 1; channel <= 16; ++channel)
     {
-        description = "Other (0x" + juce::String::toHexString(message.getRawData(), message.getRawDataSize()) + ")";
+        channelMenu.addItem(MENU_CHANNEL_BASE + channel, "Channel " + juce::String(channel), true,
+                            current.isChannelEnabled(channel));
     }
+    menu.addSubMenu("Channels", channelMenu);
     
-    return juce::String::formatted("[%s] %s %s", timestamp.substring(11, 19), direction, description);
+    juce::Component::SafePointer<MidiMonitorPanel> safeThis(this);
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&filterButton),
+                       [safeThis](int result)
+    {
+        if (safeThis == nullptr || result == 0)
+            return;
+        
+        auto updated = safeThis->getFilter();
+        
+        if (result == MENU_INCOMING)
+            updated.showIncoming = !updated.showIncoming;
+        else if (result == MENU_OUTGOING)
+            updated.showOutgoing = !updated.showOutgoing;
+        else if (result == MENU_ALL_TYPES)
+            updated.typeMask = 0xffffffffu;
+        else if (result == MENU_ALL_CHANNELS)
+            updated.channelMask = 0xffffu;
+        else if (result >= MENU_CHANNEL_BASE)
+        {
+            const int channel = result - MENU_CHANNEL_BASE;
+            updated.setChannelEnabled(channel, !updated.isChannelEnabled(channel));
+        }
+        else if (result >= MENU_TYPE_BASE)
+        {
+            const auto type = static_cast<MessageType>(result - MENU_TYPE_BASE);
+            updated.setTypeEnabled(type, !updated.isTypeEnabled(type));
+        }
+        
+        safeThis->setFilter(updated);
+    });
 }
 
+juce::String MidiMonitorPanel::formatMidiMessage(const juce::MidiMessage& message, bool isOutgoing) const
+{
+    char description[MidiMessageDecoder::MAX_DESCRIPTION_LENGTH];
+    MidiMessageDecoder::formatDescription(message, description, (int)sizeof(description));
+    
+    const auto now = juce::Time::getCurrentTime();
+    char line[MidiMessageDecoder::MAX_DESCRIPTION_LENGTH + 32];
+    std::snprintf(line, sizeof(line), "[%02d:%02d:%02d] %s %s",
+                  now.getHours(), now.getMinutes(), now.getSeconds(),
+                  isOutgoing ? "OUT" : "IN ", description);
+    
+    return juce::String(line);
+}
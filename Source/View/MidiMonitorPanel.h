@@ -2,19 +2,35 @@
 
 #include <JuceHeader.h>
 #include "../Controller/MidiManager.h"
+#include "../Controller/MidiMessageDecoder.h"
 
 /**
  * Real-time MIDI monitoring panel.
  * 
  * Displays incoming and outgoing MIDI messages for debugging.
- * Shows message type, channel, data, and timestamp.
+ * Shows message type, channel, data, and timestamp. The panel listens to
+ * the MidiManager's input and output for as long as it exists.
+ * 
+ * Messages are classified with MidiMessageDecoder and filtered by type,
+ * channel and direction before any text is formatted. Accepted lines are
+ * buffered and flushed to the log by a timer, so bursts (e.g. active
+ * sensing or clock) don't trigger one repaint per event. A status line
+ * shows per-port throughput and bus load from MidiManager's statistics.
+ * 
+ * A diagnostics line summarises the pipeline telemetry (queue latency,
+ * drain time, lane high-water marks, queue-full rejections and learn recall
+ * latency); the Diagnostics menu copies or saves the full JSON report and,
+ * in tracing builds, records and saves a Chrome trace (see TraceRecorder).
  */
 class MidiMonitorPanel : public juce::Component,
-                         public juce::TextEditor::Listener
+                         public juce::TextEditor::Listener,
+                         private MidiManager::InputListener,
+                         private MidiManager::OutputListener,
+                         private juce::Timer
 {
 public:
-    MidiMonitorPanel();
-    ~MidiMonitorPanel() override = default;
+    MidiMonitorPanel(MidiManager& midiManager);
+    ~MidiMonitorPanel() override;
     
     void paint(juce::Graphics& g) override;
     void resized() override;
@@ -22,22 +38,51 @@ public:
     // TextEditor::Listener
     void textEditorTextChanged(juce::TextEditor& editor) override;
     
-    // MIDI message logging
+    // MIDI message logging (thread-safe)
     void logMidiMessage(const juce::MidiMessage& message, bool isOutgoing);
     void clearLog();
     
+    // Filtering (applied before formatting)
+    void setFilter(const MidiMessageDecoder::Filter& newFilter);
+    MidiMessageDecoder::Filter getFilter() const;
+    
     // Settings
     void setMaxLines(int maxLines) noexcept { maxLogLines = maxLines; }
     int getMaxLines() const noexcept { return maxLogLines; }
     
 private:
+    MidiManager& midiManager;
+    
     juce::TextEditor logEditor;
     juce::TextButton clearButton;
     juce::TextButton exportButton;
+    juce::TextButton filterButton;
+    juce::TextButton diagnosticsButton;
+    juce::Label statisticsLabel;
+    juce::Label diagnosticsLabel;
     int maxLogLines = 100;
     
+    // Written from any thread, consumed by the timer on the message thread
+    juce::CriticalSection pendingLock;
+    juce::StringArray pendingLines;
+    MidiMessageDecoder::Filter filter;
+    
+    // Lines currently shown (message thread only)
+    juce::StringArray visibleLines;
+    int statisticsTick = 0;
+    
+    // MidiManager listeners (MIDI input and sending threads)
+    void midiInputReceived(const juce::MidiMessage& message) override { logMidiMessage(message, false); }
+    void midiOutputQueued(const juce::MidiMessage& message) override { logMidiMessage(message, true); }
+    
+    void timerCallback() override;
+    void flushPendingLines();
+    void updateStatistics();
+    void updateDiagnostics();
+    void showFilterMenu();
+    void showDiagnosticsMenu();
+    
     juce::String formatMidiMessage(const juce::MidiMessage& message, bool isOutgoing) const;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiMonitorPanel)
 };
-
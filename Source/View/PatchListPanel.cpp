@@ -1,5 +1,6 @@
 #include "PatchListPanel.h"
 #include "ValhallaLookAndFeel.h"
+#include "../Controller/TraceRecorder.h"
 
 PatchListPanel::PatchListPanel(PatchManager& pm)
     : patchManager(pm)
@@ -28,12 +29,22 @@ PatchListPanel::PatchListPanel(PatchManager& pm)
 
 PatchListPanel::~PatchListPanel()
 {
+    stopTimer();
     patchManager.getPatchBank().removeChangeListener(this);
     patchManager.getMidiLearnManager().removeChangeListener(this);
 }
 
 void PatchListPanel::paint(juce::Graphics& g)
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchListPanel::paint");
+    
+    // End of the keystroke -> filter -> repaint path
+    if (pendingSearchTrace != 0)
+    {
+        MIDI_LIBRARIAN_TRACE_FLOW_END("Search", pendingSearchTrace);
+        pendingSearchTrace = 0;
+    }
+    
     // Background
     auto& lf = getLookAndFeel();
     g.setColour(static_cast<ValhallaLookAndFeel&>(lf).getBackgroundColour());
@@ -77,13 +88,19 @@ void PatchListPanel::resized()
 
 void PatchListPanel::changeListenerCallback(juce::ChangeBroadcaster* source)
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchListPanel::changeListenerCallback");
+    
     if (source == &patchManager.getPatchBank())
     {
-        // Update existing items instead of full rebuild if possible
+        // Update only the slots the bank reports as changed instead of a full rebuild.
+        // Rows still to be streamed in are built from the current bank anyway.
         const auto& bank = patchManager.getPatchBank();
+        const auto& changedSlots = bank.getChangedSlots();
+        const bool streaming = isTimerRunning();
         bool needsRebuild = false;
         
-        for (int i = 0; i < patchItems.size() && i < PatchBank::BANK_SIZE; ++i)
+        for (int i = changedSlots.findNextSetBit(0); i >= 0 && i < patchItems.size();
+             i = changedSlots.findNextSetBit(i + 1))
         {
             const auto& patch = bank.getPatch(i);
             if (patchItems[i] != nullptr)
@@ -98,13 +115,18 @@ void PatchListPanel::changeListenerCallback(juce::ChangeBroadcaster* source)
             }
         }
         
-        if (needsRebuild || patchItems.size() != PatchBank::BANK_SIZE)
+        listContainer.setEnabled(patchManager.isReady());
+        
+        if (needsRebuild || (!streaming && patchItems.size() != PatchBank::BANK_SIZE))
         {
             rebuildList();
         }
         else
         {
             applyFilters(); // Re-apply filters in case favorites changed
+            
+            if (!streaming && onListUpdated != nullptr)
+                onListUpdated();
         }
     }
     else if (source == &patchManager.getMidiLearnManager())
@@ -116,11 +138,26 @@ void PatchListPanel::changeListenerCallback(juce::ChangeBroadcaster* source)
 
 void PatchListPanel::rebuildList()
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchListPanel::rebuildList");
+    
+    stopTimer();
     patchItems.clear();
     
+    // Enough rows to fill the view now; timerCallback() adds the rest
+    addRows(ROWS_PER_BATCH);
+    
+    if (patchItems.size() < PatchBank::BANK_SIZE)
+        startTimer(BATCH_INTERVAL_MS);
+}
+
+void PatchListPanel::addRows(int maxRows)
+{
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchListPanel::addRows");
+    
     const auto& bank = patchManager.getPatchBank();
+    const int endSlot = juce::jmin(PatchBank::BANK_SIZE, patchItems.size() + maxRows);
     
-    for (int i = 0; i < PatchBank::BANK_SIZE; ++i)
+    for (int i = patchItems.size(); i < endSlot; ++i)
     {
         const auto& patch = bank.getPatch(i);
         auto* item = new PatchListItem(i, patch.getPatchName());
@@ -160,15 +197,34 @@ void PatchListPanel::rebuildList()
         listContainer.addChildComponent(item); // Use addChildComponent so we can hide/show
     }
     
+    listContainer.setEnabled(patchManager.isReady());
+    
     // Update learning state
     updateLearningStates();
     
     applyFilters();
-    resized();
+    
+    if (patchItems.size() == PatchBank::BANK_SIZE && onListUpdated != nullptr)
+        onListUpdated();
+}
+
+void PatchListPanel::timerCallback()
+{
+    addRows(ROWS_PER_BATCH);
+    
+    if (patchItems.size() == PatchBank::BANK_SIZE)
+        stopTimer();
+}
+
+bool PatchListPanel::isPopulated() const noexcept
+{
+    return patchItems.size() == PatchBank::BANK_SIZE && patchManager.isReady();
 }
 
 void PatchListPanel::applyFilters()
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchListPanel::applyFilters");
+    
     for (int i = 0; i < patchItems.size(); ++i)
     {
         bool shouldShow = shouldShowPatch(i);
@@ -199,6 +255,11 @@ bool PatchListPanel::shouldShowPatch(int slotIndex) const
 
 void PatchListPanel::onSearchTextChanged(const juce::String& query)
 {
+    MIDI_LIBRARIAN_TRACE_SCOPE("PatchListPanel::onSearchTextChanged");
+    
+    pendingSearchTrace = (juce::uint64)juce::Time::getHighResolutionTicks();
+    MIDI_LIBRARIAN_TRACE_FLOW_BEGIN("Search", pendingSearchTrace);
+    
     currentSearchQuery = query;
     applyFilters();
 }
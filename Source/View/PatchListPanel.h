@@ -11,9 +11,14 @@
  * Uses a Viewport with a vertical list of PatchListItem components.
  * Automatically updates when PatchBank changes.
  * Supports search/filtering and favorites.
+ * 
+ * Rows are streamed in: a rebuild creates the first ROWS_PER_BATCH rows at
+ * once and the rest in batches on a timer, so opening the editor doesn't
+ * wait for all 128. The list is disabled until the PatchManager is ready.
  */
 class PatchListPanel : public juce::Component,
-                       public juce::ChangeListener
+                       public juce::ChangeListener,
+                       private juce::Timer
 {
 public:
     PatchListPanel(PatchManager& patchManager);
@@ -25,7 +30,14 @@ public:
     // ChangeListener (for PatchBank updates and MIDI Learn)
     void changeListenerCallback(juce::ChangeBroadcaster* source) override;
     
+    /** True once every row exists and shows the loaded library. */
+    bool isPopulated() const noexcept;
+    std::function<void()> onListUpdated; // After the last row is built and after each bank update
+    
 private:
+    static constexpr int ROWS_PER_BATCH = 16;
+    static constexpr int BATCH_INTERVAL_MS = 1;
+    
     PatchManager& patchManager;
     
     SearchBar searchBar;
@@ -35,8 +47,11 @@ private:
     
     juce::String currentSearchQuery;
     bool showFavoritesOnly = false;
+    juce::uint64 pendingSearchTrace = 0; // Trace flow id of a search waiting for its repaint
     
     void rebuildList();
+    void addRows(int maxRows);
+    void timerCallback() override;
     void applyFilters();
     bool shouldShowPatch(int slotIndex) const;
     void onPatchRename(int slotIndex, const juce::String& newName);
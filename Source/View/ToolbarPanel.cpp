@@ -21,6 +21,11 @@ ToolbarPanel::ToolbarPanel(PatchManager& pm)
     clearButton.addListener(this);
     addAndMakeVisible(clearButton);
     
+    monitorButton.setButtonText("Monitor");
+    monitorButton.setClickingTogglesState(true);
+    monitorButton.addListener(this);
+    addAndMakeVisible(monitorButton);
+    
     // Listen to undo manager
     patchManager.getUndoManager().addChangeListener(this);
     
@@ -53,6 +58,8 @@ void ToolbarPanel::resized()
     bounds.removeFromLeft(spacing);
     
     clearButton.setBounds(bounds.removeFromLeft(buttonWidth + 20));
+    
+    monitorButton.setBounds(bounds.removeFromRight(buttonWidth));
 }
 
 void ToolbarPanel::buttonClicked(juce::Button* button)
@@ -81,6 +88,11 @@ void ToolbarPanel::buttonClicked(juce::Button* button)
         
         patchManager.clearPatchRange(dialog.getStartSlot(), dialog.getEndSlot());
     }
+    else if (button == &monitorButton)
+    {
+        if (onMonitorToggled)
+            onMonitorToggled(monitorButton.getToggleState());
+    }
 }
 
 void ToolbarPanel::changeListenerCallback(juce::ChangeBroadcaster* source)
@@ -5,6 +5,8 @@
 
 /**
  * Toolbar panel with undo/redo buttons and other actions.
+ * 
+ * The Monitor button toggles the editor's MIDI monitor (onMonitorToggled).
  */
 class ToolbarPanel : public juce::Component,
                      public juce::Button::Listener,
@@ -23,6 +25,7 @@ public:
     // ChangeListener (for undo manager changes)
     void changeListenerCallback(juce::ChangeBroadcaster* source) override;
     
+    std::function<void(bool shown)> onMonitorToggled;
     
 private:
     PatchManager& patchManager;
@@ -31,6 +34,7 @@ private:
     juce::TextButton redoButton;
     juce::TextButton copyButton;
     juce::TextButton clearButton;
+    juce::TextButton monitorButton;
     
     void updateUndoRedoButtons();
     
@@ -0,0 +1,124 @@
+#include <JuceHeader.h>
+#include "ProtocolChecks.h"
+#include "RealtimeStressDriver.h"
+#include "../../Source/Controller/RealtimeSafetyChecker.h"
+#include "../../Source/Controller/TraceRecorder.h"
+#include <iostream>
+
+/**
+ * Console entry point for the realtime stress driver.
+ * 
+ * Usage: LibrarianStressTest [--seconds=N] [--block-size=N] [--ui-threads=N]
+ *                            [--midi-threads=N] [--realtime] [--output=file.json]
+ *                            [--trace=file.json]
+ *        LibrarianStressTest --checks[=name,name] [--output=file.json]
+ * 
+ * Prints the JSON report to stdout unless --output is given. Exits with 2
+ * if any real-time safety violation was reported (or, with --checks, any
+ * ProtocolChecks check failed), so a release script can fail on it.
+ * --trace records the stress run as a Chrome trace (tracing builds only).
+ */
+namespace
+{
+    bool writeReport(const juce::ArgumentList& args, const juce::var& report)
+    {
+        const auto json = juce::JSON::toString(report);
+        
+        if (!args.containsOption("--output"))
+        {
+            std::cout << json << std::endl;
+            return true;
+        }
+        
+        const auto file = args.getFileForOption("--output");
+        if (file.replaceWithText(json))
+            return true;
+        
+        std::cerr << "Couldn't write " << file.getFullPathName() << std::endl;
+        return false;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    
+    juce::ArgumentList args(argc, argv);
+    RealtimeStressDriver::Options options;
+    
+    if (args.containsOption("--help|-h"))
+    {
+        std::cout << "Usage: " << args.executableName << " [--seconds=N] [--block-size=N] [--ui-threads=N]"
+                  << " [--midi-threads=N] [--realtime] [--output=file.json] [--trace=file.json]" << std::endl
+                  << "       " << args.executableName << " --checks[=" << ProtocolChecks::getCheckNames().joinIntoString(",")
+                  << "] [--output=file.json]" << std::endl;
+        return 0;
+    }
+    
+    if (args.containsOption("--checks"))
+    {
+        juce::StringArray only;
+        only.addTokens(args.getValueForOption("--checks"), ",", {});
+        only.removeEmptyStrings();
+        
+        const auto report = ProtocolChecks::run(only);
+        if (!writeReport(args, report))
+            return 1;
+        
+        const int numFailed = report["failed"];
+        if (numFailed > 0)
+        {
+            std::cerr << numFailed << " check(s) failed" << std::endl;
+            return 2;
+        }
+        
+        return 0;
+    }
+    
+    if (args.containsOption("--seconds"))
+        options.seconds = juce::jmax(0.1, args.getValueForOption("--seconds").getDoubleValue());
+    
+    if (args.containsOption("--block-size"))
+        options.blockSize = juce::jlimit(16, 4096, args.getValueForOption("--block-size").getIntValue());
+    
+    if (args.containsOption("--ui-threads"))
+        options.numUiThreads = juce::jmax(0, args.getValueForOption("--ui-threads").getIntValue());
+    
+    if (args.containsOption("--midi-threads"))
+        options.numMidiInThreads = juce::jmax(0, args.getValueForOption("--midi-threads").getIntValue());
+    
+    options.realtimePacing = args.containsOption("--realtime");
+    
+    if (!RealtimeSafetyChecker::isEnabled())
+        std::cerr << "Built without MIDI_LIBRARIAN_RT_CHECKS=1: only block timings are measured" << std::endl;
+    
+    const auto traceFile = args.containsOption("--trace") ? args.getFileForOption("--trace") : juce::File();
+    if (traceFile != juce::File() && !TraceRecorder::isCompiledIn())
+    {
+        std::cerr << "--trace needs a build with MIDI_LIBRARIAN_TRACING=1" << std::endl;
+        return 1;
+    }
+    
+    TraceRecorder::setEnabled(traceFile != juce::File());
+    const auto report = RealtimeStressDriver::run(options);
+    
+    if (traceFile != juce::File())
+    {
+        TraceRecorder::setEnabled(false);
+        if (!TraceRecorder::writeChromeTrace(traceFile))
+            std::cerr << "Couldn't write " << traceFile.getFullPathName() << std::endl;
+    }
+    
+    if (!writeReport(args, report))
+        return 1;
+    
+    const int numViolations = report["violations"];
+    
+    if (numViolations > 0)
+    {
+        std::cerr << numViolations << " real-time safety violation(s) in processBlock()" << std::endl;
+        return 2;
+    }
+    
+    return 0;
+}
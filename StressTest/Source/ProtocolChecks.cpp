@@ -0,0 +1,386 @@
+#include "ProtocolChecks.h"
+#include "../../Source/Model/SysExProtocol.h"
+#include "../../Source/Model/FactoryTemplates.h"
+#include "../../Source/Controller/PatchSysExCodec.h"
+#include "../../Source/Controller/PatchManager.h"
+#include "../../Source/Controller/DeviceSession.h"
+#include "../../Source/Controller/LoopbackMidiTransport.h"
+#include "../../Source/Controller/MidiBlockDriver.h"
+
+namespace
+{
+    void expect(juce::StringArray& failures, bool condition, const juce::String& description)
+    {
+        if (!condition)
+            failures.add(description);
+    }
+    
+    juce::String hex(juce::uint32 value)
+    {
+        return "0x" + juce::String::toHexString((juce::int64)value).paddedLeft('0', 8);
+    }
+    
+    /** Splits a raw F0..F7 stream into message bodies. */
+    juce::Array<juce::MemoryBlock> splitSysEx(const juce::MemoryBlock& stream)
+    {
+        juce::Array<juce::MemoryBlock> bodies;
+        const auto* bytes = static_cast<const juce::uint8*>(stream.getData());
+        int start = -1;
+        
+        for (int i = 0; i < (int)stream.getSize(); ++i)
+        {
+            if (bytes[i] == 0xf0)
+                start = i + 1;
+            else if (bytes[i] == 0xf7 && start >= 0)
+                bodies.add(juce::MemoryBlock(bytes + start, (size_t)(i - start)));
+        }
+        
+        return bodies;
+    }
+    
+    /** A JV-1080 patch sized dump (common block and four tones) whose bytes all depend on seed. */
+    juce::MemoryBlock makeDump(int seed, int size = 588)
+    {
+        juce::MemoryBlock dump((size_t)size);
+        for (int i = 0; i < size; ++i)
+            static_cast<juce::uint8*>(dump.getData())[i] = (juce::uint8)((seed * 31 + i) & 0x7f);
+        return dump;
+    }
+    
+    /** Keeps what a MidiManager receives, on whichever thread it arrives. */
+    class InputCollector : public MidiManager::InputListener
+    {
+    public:
+        void midiInputReceived(const juce::MidiMessage& message) override
+        {
+            const juce::ScopedLock sl(lock);
+            messages.add(message);
+        }
+        
+        juce::Array<juce::MidiMessage> getMessages() const
+        {
+            const juce::ScopedLock sl(lock);
+            return messages;
+        }
+    
+    private:
+        juce::CriticalSection lock;
+        juce::Array<juce::MidiMessage> messages;
+    };
+    
+    bool sameBytes(const juce::MidiMessage& a, const juce::MidiMessage& b)
+    {
+        return a.getRawDataSize() == b.getRawDataSize()
+            && std::memcmp(a.getRawData(), b.getRawData(), (size_t)a.getRawDataSize()) == 0;
+    }
+    
+    SysExProtocol::Ptr compileProtocol(const char* json)
+    {
+        SysExProtocol::Ptr protocol;
+        const auto result = SysExProtocol::compile(juce::JSON::parse(json), protocol);
+        jassert(result.wasOk());
+        return protocol;
+    }
+    
+    struct Entry
+    {
+        const char* name;
+        void (*function)(juce::StringArray&);
+    };
+    
+    const Entry checks[] =
+    {
+        { "addressCarry", &ProtocolChecks::checkAddressCarry },
+        { "reorderWrites", &ProtocolChecks::checkReorderWrites },
+        { "loopbackEcho", &ProtocolChecks::checkLoopbackEcho },
+        { "simulatedRoundTrip", &ProtocolChecks::checkSimulatedRoundTrip }
+    };
+}
+
+juce::StringArray ProtocolChecks::getCheckNames()
+{
+    juce::StringArray names;
+    for (const auto& entry : checks)
+        names.add(entry.name);
+    return names;
+}
+
+juce::var ProtocolChecks::run(const juce::StringArray& only)
+{
+    juce::Array<juce::var> results;
+    int numFailed = 0;
+    
+    for (const auto& entry : checks)
+    {
+        if (!only.isEmpty() && !only.contains(entry.name))
+            continue;
+        
+        juce::StringArray failures;
+        entry.function(failures);
+        numFailed += failures.isEmpty() ? 0 : 1;
+        
+        juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+        obj->setProperty("name", entry.name);
+        obj->setProperty("passed", failures.isEmpty());
+        if (!failures.isEmpty())
+            obj->setProperty("failures", failures);
+        results.add(juce::var(obj.get()));
+    }
+    
+    juce::DynamicObject::Ptr report = new juce::DynamicObject();
+    report->setProperty("checks", results);
+    report->setProperty("failed", numFailed);
+    return juce::var(report.get());
+}
+
+void ProtocolChecks::checkAddressCarry(juce::StringArray& failures)
+{
+    // Every byte of a Roland address holds 7 bits, so 0x7f + 1 carries into the byte above
+    const auto protocol = compileProtocol(R"json(
+    {
+        "messages": [ { "name": "dataSet", "header": [ "0x41", "deviceId", "0x6a", "0x12" ],
+                        "addressBytes": 4, "data": "raw", "checksum": "roland" } ],
+        "addresses": {
+            "patches": { "base": "0x11000000", "stride": "0x10000", "length": 72 },
+            "tones": { "base": "0x10000000", "stride": "0x60", "length": 96 },
+            "upper": { "base": "0x117f0000", "stride": "0x10000", "length": 72 }
+        }
+    })json");
+    
+    const auto& patches = *protocol->getAddressMap("patches");
+    const auto& tones = *protocol->getAddressMap("tones");
+    const auto& upper = *protocol->getAddressMap("upper");
+    
+    const struct { const SysExProtocol::AddressMap& map; int slot; juce::uint32 address; } cases[] =
+    {
+        { patches, 5, 0x11050000 },
+        { patches, 127, 0x117f0000 },
+        { tones, 1, 0x10000060 },
+        { tones, 2, 0x10000140 },     // 0x60 + 0x60 = 0xc0 would not be a valid address byte
+        { tones, 43, 0x10002020 },
+        { upper, 1, 0x12000000 }      // Carries through the second byte into the first
+    };
+    
+    for (const auto& c : cases)
+    {
+        const auto address = c.map.getAddress(c.slot);
+        expect(failures, address == c.address,
+               "slot " + juce::String(c.slot) + " at " + hex(address) + ", expected " + hex(c.address));
+        expect(failures, c.map.getSlot(c.address) == c.slot,
+               hex(c.address) + " read back as slot " + juce::String(c.map.getSlot(c.address)));
+    }
+    
+    expect(failures, tones.getSlot(0x100000c0) == -1, "0x100000c0 (bit 7 set) was taken for a slot");
+    expect(failures, tones.getSlot(0x10000061) == -1, "0x10000061 (inside a block) was taken for a slot");
+    
+    // And the bytes on the wire
+    SysExMessageFormat::Fields fields;
+    fields.deviceId = 0x10;
+    fields.address = tones.getAddress(2);
+    const juce::uint8 data[] = { 0x01 };
+    const auto message = protocol->getFormat(SysExProtocol::DATA_SET)->encode(fields, data, 1);
+    const auto* bytes = static_cast<const juce::uint8*>(message.getData());
+    
+    expect(failures, message.getSize() >= 8 && bytes[4] == 0x10 && bytes[5] == 0x00 && bytes[6] == 0x01 && bytes[7] == 0x40,
+           "dataSet for tone 2 doesn't carry address 10 00 01 40");
+}
+
+void ProtocolChecks::checkReorderWrites(juce::StringArray& failures)
+{
+    const auto device = FactoryTemplates::materialize(FactoryTemplates::indexOf("roland_jv1080"));
+    const auto protocol = device->getSysExProtocol();
+    const PatchSysExCodec codec(*device, 0x11); // A unit moved off the default ID 0x10
+    
+    expect(failures, protocol->canWritePatches(), "the JV-1080 protocol can't write patches");
+    expect(failures, codec.canWrite() && !codec.readsNamesOnly(), "the JV-1080 codec reads names only");
+    
+    // Slots 0 and 1 swap; 3 (a names-only dump) and 6 swap; 4 and 5 swap but hold the same sound
+    PatchBank before;
+    for (int slot = 0; slot < 7; ++slot)
+    {
+        PatchData patch;
+        patch.setPatchDump(slot == 3 ? makeDump(slot, 12) : makeDump(slot == 5 ? 4 : slot));
+        before.setPatch(slot, patch);
+    }
+    
+    juce::Array<int> order;
+    for (int i = 0; i < PatchBank::BANK_SIZE; ++i)
+        order.add(i);
+    order.swap(0, 1);
+    order.swap(3, 6);
+    order.swap(4, 5);
+    
+    PatchBank after;
+    for (int slot = 0; slot < PatchBank::BANK_SIZE; ++slot)
+        after.setPatch(slot, before.getPatch(order[slot]));
+    
+    int numUnwritable = 0;
+    const auto bodies = splitSysEx(PatchManager::createReorderWrites(after, order, codec, numUnwritable));
+    
+    // Each written slot gets its common block and all four tone blocks
+    const struct { juce::uint32 offset; int start; int length; } blocks[] =
+    {
+        { 0x0000, 0, 72 }, { 0x1000, 72, 129 }, { 0x1200, 201, 129 }, { 0x1400, 330, 129 }, { 0x1600, 459, 129 }
+    };
+    
+    struct Write
+    {
+        int slot;
+        juce::uint32 address;
+        juce::MemoryBlock data;
+    };
+    
+    juce::Array<Write> writes;
+    for (int slot : { 0, 1, 3 })
+        for (const auto& block : blocks)
+            writes.add({ slot, 0x11000000u + ((juce::uint32)slot << 16) + block.offset,
+                         juce::MemoryBlock(static_cast<const juce::uint8*>(after.getPatch(slot).getPatchDump().getData())
+                                               + block.start, (size_t)block.length) });
+    
+    expect(failures, numUnwritable == 1, juce::String(numUnwritable) + " slots unwritable, expected 1 (slot 6)");
+    expect(failures, bodies.size() == writes.size(), juce::String(bodies.size()) + " dataSets, expected "
+           + juce::String(writes.size()) + " (five blocks each for slots 0, 1 and 3)");
+    
+    for (int i = 0; i < juce::jmin(bodies.size(), writes.size()); ++i)
+    {
+        const auto& body = bodies.getReference(i);
+        const auto& write = writes.getReference(i);
+        SysExMessageFormat::Decoded decoded;
+        
+        if (!protocol->getFormat(SysExProtocol::DATA_SET)->decode(static_cast<const juce::uint8*>(body.getData()),
+                                                                  (int)body.getSize(), decoded))
+        {
+            failures.add("write " + juce::String(i) + " isn't a dataSet");
+            continue;
+        }
+        
+        expect(failures, decoded.deviceId == 0x11,
+               "slot " + juce::String(write.slot) + " written to device ID " + juce::String(decoded.deviceId));
+        expect(failures, decoded.address == write.address,
+               "slot " + juce::String(write.slot) + " written at " + hex(decoded.address) + ", expected " + hex(write.address));
+        expect(failures, decoded.checksumValid, "slot " + juce::String(write.slot) + " has a bad checksum");
+        expect(failures, decoded.data == write.data,
+               "slot " + juce::String(write.slot) + " written at " + hex(write.address) + " with the wrong bytes");
+    }
+    
+    // Templates saved with the old common-block-only map must not write: they would split patches
+    const auto legacy = compileProtocol(R"json(
+    {
+        "messages": [ { "name": "dataSet", "header": [ "0x41", "deviceId", "0x6a", "0x12" ],
+                        "addressBytes": 4, "data": "raw", "checksum": "roland" } ],
+        "addresses": { "patchCommon": { "base": "0x11000000", "stride": "0x10000", "length": 72 } }
+    })json");
+    
+    expect(failures, !legacy->canWritePatches(), "a \"patchCommon\" map (the common block alone) writes patches");
+}
+
+void ProtocolChecks::checkLoopbackEcho(juce::StringArray& failures)
+{
+    // One message per lane through MidiManager and back: same bytes, realtime first, bulk last
+    LoopbackMidiTransport::Options loopbackOptions;
+    loopbackOptions.latencySamples = 32;
+    LoopbackMidiTransport loopback(loopbackOptions);
+    
+    MidiManager midiManager;
+    InputCollector collector;
+    midiManager.setTransport(&loopback);
+    midiManager.setMidiChannel(3);
+    midiManager.addInputListener(&collector);
+    
+    MidiBlockDriver::Options driverOptions;
+    driverOptions.speed = 0.0;
+    MidiBlockDriver driver(midiManager, driverOptions);
+    
+    const juce::uint8 body[] = { 0x41, 0x10, 0x6a, 0x12, 0x11, 0x05, 0x00, 0x00, 0x41, 0x29 };
+    const juce::MidiMessage expected[] =
+    {
+        juce::MidiMessage::programChange(3, 5),
+        juce::MidiMessage::controllerEvent(3, 7, 100),
+        juce::MidiMessage::createSysExMessage(body, (int)sizeof(body))
+    };
+    
+    // Queued in reverse priority order; the lanes put them back in order
+    expect(failures, midiManager.sendSysEx(body, (int)sizeof(body)).wasOk(), "the SysEx message wasn't queued");
+    expect(failures, midiManager.sendControlChange(7, 100).wasOk(), "the control change wasn't queued");
+    expect(failures, midiManager.sendProgramChange(5).wasOk(), "the program change wasn't queued");
+    
+    const int numExpected = juce::numElementsInArray(expected);
+    driver.processUntil([&collector, numExpected] { return collector.getMessages().size() >= numExpected; }, 1.0);
+    
+    const auto received = collector.getMessages();
+    expect(failures, received.size() == numExpected,
+           juce::String(received.size()) + " messages came back, expected " + juce::String(numExpected));
+    expect(failures, (int)loopback.getNumMessagesEchoed() == numExpected,
+           "the loopback echoed " + juce::String((juce::int64)loopback.getNumMessagesEchoed()) + " messages");
+    
+    for (int i = 0; i < juce::jmin(received.size(), numExpected); ++i)
+        expect(failures, sameBytes(received.getReference(i), expected[i]),
+               "message " + juce::String(i) + " came back as " + received.getReference(i).getDescription()
+               + ", expected " + expected[i].getDescription());
+    
+    midiManager.removeInputListener(&collector);
+    midiManager.setTransport(nullptr);
+}
+
+void ProtocolChecks::checkSimulatedRoundTrip(juce::StringArray& failures)
+{
+    // Restore four slots to a simulated JV-1080 at device ID 0x11, then dump them back
+    DeviceSession::Settings settings;
+    settings.device = *FactoryTemplates::materialize(FactoryTemplates::indexOf("roland_jv1080"));
+    settings.deviceId = 0x11;
+    settings.simulate = true;
+    
+    constexpr int firstSlot = 10, lastSlot = 13;
+    PatchBank written;
+    for (int slot = firstSlot; slot <= lastSlot; ++slot)
+    {
+        PatchData patch;
+        patch.setPatchDump(makeDump(slot));
+        written.setPatch(slot, patch);
+    }
+    
+    DeviceSession session(settings);
+    auto result = session.open();
+    expect(failures, result.wasOk(), "the session didn't open: " + result.getErrorMessage());
+    if (result.failed())
+        return;
+    
+    result = session.restore(written, firstSlot, lastSlot);
+    expect(failures, result.wasOk(), "restore failed: " + result.getErrorMessage());
+    
+    const auto* synth = session.getSimulatedSynth();
+    const auto synthStatistics = synth->getStatistics();
+    expect(failures, synthStatistics.dumpsStored == (juce::uint64)(5 * (lastSlot - firstSlot + 1)),
+           "the synth stored " + juce::String((juce::int64)synthStatistics.dumpsStored) + " blocks, expected 20");
+    
+    // Every block of the patch lands at its own address: the common block and each tone
+    const auto& patchMap = *settings.device.getSysExProtocol()->getAddressMap(SysExProtocol::PATCH_DATA);
+    const auto* dumpBytes = static_cast<const juce::uint8*>(written.getPatch(12).getPatchDump().getData());
+    expect(failures, patchMap.getNumBlocks() == 5,
+           "the JV-1080 patch map has " + juce::String(patchMap.getNumBlocks()) + " blocks, expected 5");
+    
+    for (int block = 0; block < patchMap.getNumBlocks(); ++block)
+    {
+        const auto address = patchMap.getAddress(12, block);
+        const int length = patchMap.getBlock(block).length;
+        
+        expect(failures, synth->readMemory(address, length)
+                             == juce::MemoryBlock(dumpBytes + patchMap.getBlockStart(block), (size_t)length),
+               "slot 12's " + juce::String(block == 0 ? "common block" : "tone " + juce::String(block))
+               + " isn't in the synth's memory at " + hex(address));
+    }
+    
+    PatchBank read;
+    result = session.dump(firstSlot, lastSlot, read);
+    expect(failures, result.wasOk(), "dump failed: " + result.getErrorMessage());
+    
+    for (int slot = firstSlot; slot <= lastSlot; ++slot)
+        expect(failures, read.getPatch(slot).getPatchDump() == written.getPatch(slot).getPatchDump(),
+               "slot " + juce::String(slot) + " read back " + juce::String((int)read.getPatch(slot).getPatchDump().getSize())
+               + " bytes that differ from the restored dump");
+    
+    expect(failures, synth->getStatistics().requestsIgnored == 0,
+           juce::String((juce::int64)synth->getStatistics().requestsIgnored) + " requests ignored by the synth");
+    
+    session.close();
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Functional checks of the SysEx and MIDI code, run headless against the
+ * virtual transports (LibrarianStressTest --checks).
+ * 
+ * Each check compares what the code sends, stores or decodes with what the
+ * device would expect; no MIDI hardware is needed. The report lists every
+ * check with "passed" and, when it failed, what it found instead. Run them
+ * with the stress run before each release.
+ * 
+ * run() must be called on the message thread.
+ */
+class ProtocolChecks
+{
+public:
+    ProtocolChecks() = delete;
+    
+    static juce::var run(const juce::StringArray& only = {});
+    static juce::StringArray getCheckNames();
+    
+    // Each adds a line to failures for every expectation it breaks
+    static void checkAddressCarry(juce::StringArray& failures);
+    static void checkReorderWrites(juce::StringArray& failures);
+    static void checkLoopbackEcho(juce::StringArray& failures);
+    static void checkSimulatedRoundTrip(juce::StringArray& failures);
+};
@@ -0,0 +1,323 @@
+#include "RealtimeStressDriver.h"
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/Controller/LoopbackMidiTransport.h"
+#include "../../Source/Controller/PersistenceManager.h"
+#include "../../Source/Controller/RealtimeSafetyChecker.h"
+#include <atomic>
+
+namespace
+{
+    constexpr int MIDI_BUFFER_BYTES = 4096;     // Reserved like a host's MIDI buffer
+    constexpr int MAX_PENDING_EDITS = 64;       // Per UI thread, so the message queue can't grow without bound
+    constexpr int SYSEX_EVERY_N_ITERATIONS = 50;
+    
+    /** Calls processBlock() back to back, as a host's audio callback would. */
+    class AudioCallbackThread : public juce::Thread
+    {
+    public:
+        AudioCallbackThread(juce::AudioProcessor& processorToRun, const RealtimeStressDriver::Options& driverOptions)
+            : juce::Thread("Stress audio"),
+              processor(processorToRun),
+              options(driverOptions),
+              audioBuffer(juce::jmax(1, processorToRun.getTotalNumOutputChannels()), driverOptions.blockSize)
+        {
+            midiBuffer.ensureSize(MIDI_BUFFER_BYTES);
+        }
+        
+        ~AudioCallbackThread() override
+        {
+            stopThread(2000);
+        }
+        
+        void run() override
+        {
+            const double blockMs = options.blockSize * 1000.0 / options.sampleRate;
+            auto nextBlockTime = juce::Time::getMillisecondCounterHiRes();
+            juce::Random random;
+            
+            while (!threadShouldExit())
+            {
+                // Host MIDI input for this block (fits in the reserved space)
+                midiBuffer.clear();
+                const int numInputEvents = random.nextInt(4);
+                
+                for (int i = 0; i < numInputEvents; ++i)
+                {
+                    midiBuffer.addEvent(juce::MidiMessage::controllerEvent(1, random.nextInt(120), random.nextInt(128)),
+                                        random.nextInt(options.blockSize));
+                }
+                
+                const auto startTicks = juce::Time::getHighResolutionTicks();
+                processor.processBlock(audioBuffer, midiBuffer);
+                const double elapsedMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks()
+                                                                                  - startTicks) * 1000.0;
+                
+                ++numBlocks;
+                totalMs += elapsedMs;
+                maxMs = juce::jmax(maxMs, elapsedMs);
+                numOutputEvents += midiBuffer.getNumEvents() - numInputEvents;
+                
+                if (elapsedMs > blockMs)
+                    ++numOverruns;
+                
+                if (options.realtimePacing)
+                {
+                    nextBlockTime += blockMs;
+                    const auto waitMs = nextBlockTime - juce::Time::getMillisecondCounterHiRes();
+                    
+                    if (waitMs >= 1.0)
+                        wait((int)waitMs);
+                }
+            }
+        }
+        
+        juce::var getResults() const
+        {
+            juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+            obj->setProperty("blocks", (juce::int64)numBlocks);
+            obj->setProperty("overruns", (juce::int64)numOverruns);
+            obj->setProperty("meanBlockUs", numBlocks > 0 ? totalMs * 1000.0 / numBlocks : 0.0);
+            obj->setProperty("maxBlockUs", maxMs * 1000.0);
+            obj->setProperty("outputEvents", (juce::int64)numOutputEvents);
+            return juce::var(obj.get());
+        }
+    
+    private:
+        juce::AudioProcessor& processor;
+        const RealtimeStressDriver::Options options;
+        juce::AudioBuffer<float> audioBuffer;
+        juce::MidiBuffer midiBuffer;
+        
+        // Written by this thread only; read after it has stopped
+        juce::int64 numBlocks = 0;
+        juce::int64 numOverruns = 0;     // Blocks that took longer than their duration
+        juce::int64 numOutputEvents = 0;
+        double totalMs = 0.0;
+        double maxMs = 0.0;
+    };
+    
+    /** Posts patch edits to the message thread and queues CC/SysEx directly, as the editor does. */
+    class UiLoadThread : public juce::Thread
+    {
+    public:
+        explicit UiLoadThread(PatchManager& manager)
+            : juce::Thread("Stress UI"), patchManager(manager)
+        {
+        }
+        
+        ~UiLoadThread() override
+        {
+            stopThread(2000);
+        }
+        
+        void run() override
+        {
+            juce::Random random;
+            int iteration = 0;
+            
+            while (!threadShouldExit())
+            {
+                if (pendingEdits.load() < MAX_PENDING_EDITS)
+                {
+                    ++pendingEdits;
+                    ++numEdits;
+                    postEdit(random.nextInt(8), random.nextInt(PatchBank::BANK_SIZE), random.nextInt(128));
+                }
+                
+                auto& midiManager = patchManager.getMidiManager();
+                midiManager.sendControlChange(random.nextInt(120), random.nextInt(128));
+                
+                if (++iteration % SYSEX_EVERY_N_ITERATIONS == 0)
+                {
+                    const juce::uint8 sysEx[] = { 0x7d, 0x01, (juce::uint8)random.nextInt(128), 0x00 };
+                    midiManager.sendSysEx(sysEx, (int)sizeof(sysEx));
+                }
+                
+                wait(1);
+            }
+        }
+        
+        juce::int64 getNumEdits() const noexcept { return numEdits.load(); }
+    
+    private:
+        PatchManager& patchManager;
+        std::atomic<int> pendingEdits { 0 };
+        std::atomic<juce::int64> numEdits { 0 };
+        
+        void postEdit(int operation, int slot, int value)
+        {
+            juce::MessageManager::callAsync([this, operation, slot, value]
+            {
+                switch (operation)
+                {
+                    case 0:  patchManager.renamePatch(slot, "Stress " + juce::String(value)); break;
+                    case 1:  patchManager.recallPatch(slot); break;
+                    case 2:  patchManager.setPatchFavorite(slot, value % 2 == 0); break;
+                    case 3:  patchManager.setPatchParameter(slot, "cutoff", value); break;
+                    case 4:  patchManager.retagPatches({ slot }, { "stress" }, {}); break;
+                    case 5:  patchManager.sortPatches(PatchManager::SortKey::name, juce::jmin(slot, 120), juce::jmin(slot, 120) + 7); break;
+                    case 6:  patchManager.undo(); break;
+                    default: patchManager.redo(); break;
+                }
+                
+                --pendingEdits;
+            });
+        }
+    };
+    
+    /** Delivers incoming MIDI through MidiManager's input callback, as a MIDI device thread would. */
+    class MidiInLoadThread : public juce::Thread
+    {
+    public:
+        explicit MidiInLoadThread(MidiManager& midiManager)
+            : juce::Thread("Stress MIDI in"), callback(midiManager)
+        {
+        }
+        
+        ~MidiInLoadThread() override
+        {
+            stopThread(2000);
+        }
+        
+        void run() override
+        {
+            juce::Random random;
+            
+            while (!threadShouldExit())
+            {
+                const auto message = random.nextInt(4) == 0
+                    ? juce::MidiMessage::programChange(1, random.nextInt(128))
+                    : juce::MidiMessage::controllerEvent(1, random.nextInt(120), random.nextInt(128));
+                
+                callback.handleIncomingMidiMessage(nullptr, message);
+                ++numMessages;
+                wait(1);
+            }
+        }
+        
+        juce::int64 getNumMessages() const noexcept { return numMessages.load(); }
+    
+    private:
+        MidiManager::MidiInputCallback callback;    // Must outlive the messages it posts to the message thread
+        std::atomic<juce::int64> numMessages { 0 };
+    };
+    
+    /** Runs the message loop until everything posted so far has been delivered. */
+    void dispatchPendingMessages()
+    {
+        std::atomic<bool> isDrained { false };
+        juce::MessageManager::callAsync([&isDrained] { isDrained = true; });
+        
+        while (!isDrained.load())
+            juce::MessageManager::getInstance()->runDispatchLoopUntil(10);
+    }
+    
+    juce::var reportsToVar(const juce::Array<RealtimeSafetyChecker::Report>& reports)
+    {
+        juce::Array<juce::var> list;
+        
+        for (const auto& report : reports)
+        {
+            juce::DynamicObject::Ptr obj = new juce::DynamicObject();
+            obj->setProperty("kind", RealtimeSafetyChecker::getViolationName(report.kind));
+            obj->setProperty("call", report.call);
+            obj->setProperty("thread", report.threadName);
+            obj->setProperty("count", report.count);
+            obj->setProperty("stackTrace", report.stackTrace);
+            list.add(juce::var(obj.get()));
+        }
+        
+        return list;
+    }
+}
+
+juce::var RealtimeStressDriver::run(const Options& options)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+    
+    const auto scratchFolder = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                                   .getNonexistentChildFile("MidiLibrarianStress", {});
+    scratchFolder.createDirectory();
+    PersistenceManager::setDefaultDataDirectory(scratchFolder);
+    
+    juce::DynamicObject::Ptr result = new juce::DynamicObject();
+    
+    {
+        // Stands in for an open output port, so sends are queued and drained instead of rejected
+        LoopbackMidiTransport::Options sinkOptions;
+        sinkOptions.echo = false;
+        LoopbackMidiTransport sink(sinkOptions);
+        
+        MidiLibrarianAudioProcessor processor;
+        processor.setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+        processor.prepareToPlay(options.sampleRate, options.blockSize);
+        
+        auto& patchManager = processor.getPatchManager();
+        patchManager.waitUntilReady(); // The edits below need the library loaded
+        patchManager.getMidiManager().setTransport(&sink);
+        
+        AudioCallbackThread audioThread(processor, options);
+        juce::OwnedArray<UiLoadThread> uiThreads;
+        juce::OwnedArray<MidiInLoadThread> midiInThreads;
+        
+        for (int i = 0; i < options.numUiThreads; ++i)
+            uiThreads.add(new UiLoadThread(patchManager));
+        
+        for (int i = 0; i < options.numMidiInThreads; ++i)
+            midiInThreads.add(new MidiInLoadThread(patchManager.getMidiManager()));
+        
+        RealtimeSafetyChecker::clearReports();
+        audioThread.startThread(juce::Thread::Priority::highest);
+        
+        for (auto* thread : uiThreads)
+            thread->startThread();
+        
+        for (auto* thread : midiInThreads)
+            thread->startThread();
+        
+        // This thread plays the message thread: it runs the edits the UI threads post
+        const auto endTime = juce::Time::getMillisecondCounterHiRes() + options.seconds * 1000.0;
+        
+        while (juce::Time::getMillisecondCounterHiRes() < endTime)
+            juce::MessageManager::getInstance()->runDispatchLoopUntil(50);
+        
+        for (auto* thread : uiThreads)
+            thread->stopThread(2000);
+        
+        for (auto* thread : midiInThreads)
+            thread->stopThread(2000);
+        
+        audioThread.stopThread(2000);
+        processor.releaseResources();
+        patchManager.getMidiManager().setTransport(nullptr);
+        
+        // Posted edits and input callbacks refer to the processor and the load threads,
+        // so deliver them before either is destroyed
+        dispatchPendingMessages();
+        
+        juce::int64 numEdits = 0;
+        for (auto* thread : uiThreads)
+            numEdits += thread->getNumEdits();
+        
+        juce::int64 numMidiIn = 0;
+        for (auto* thread : midiInThreads)
+            numMidiIn += thread->getNumMessages();
+        
+        result->setProperty("rtChecksEnabled", RealtimeSafetyChecker::isEnabled());
+        result->setProperty("seconds", options.seconds);
+        result->setProperty("sampleRate", options.sampleRate);
+        result->setProperty("blockSize", options.blockSize);
+        result->setProperty("realtimePacing", options.realtimePacing);
+        result->setProperty("audio", audioThread.getResults());
+        result->setProperty("uiEdits", numEdits);
+        result->setProperty("midiInMessages", numMidiIn);
+        result->setProperty("portMessages", (juce::int64)sink.getNumMessagesReceived());
+        result->setProperty("violations", RealtimeSafetyChecker::getNumViolations());
+        result->setProperty("reports", reportsToVar(RealtimeSafetyChecker::getReports()));
+    }
+    
+    PersistenceManager::setDefaultDataDirectory({});
+    scratchFolder.deleteRecursively();
+    
+    return juce::var(result.get());
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Runs the plugin processor under heavy concurrent load to catch real-time
+ * safety regressions before release.
+ * 
+ * One thread calls processBlock() back to back as a host's audio thread
+ * would, while at the same time:
+ * - UI threads post edits to the message thread (rename, recall, favorite,
+ *   parameter edits, retag, sort, undo/redo) and queue CC and SysEx directly
+ * - MIDI-in threads deliver messages through MidiManager's input callback,
+ *   and the audio thread feeds host MIDI into each block
+ * 
+ * Built with MIDI_LIBRARIAN_RT_CHECKS=1, every allocation, lock and system
+ * call made inside processBlock() is reported by RealtimeSafetyChecker; the
+ * report lists them with stack traces. Without it only block timings are
+ * measured.
+ * 
+ * The library is loaded from and saved to a scratch folder in the temp
+ * directory, never the user's library. run() must be called on the message
+ * thread, before any PatchManager exists.
+ */
+class RealtimeStressDriver
+{
+public:
+    struct Options
+    {
+        double seconds = 10.0;
+        double sampleRate = 48000.0;
+        int blockSize = 128;
+        int numUiThreads = 2;
+        int numMidiInThreads = 2;
+        bool realtimePacing = false;    // Wait for each block's deadline instead of running flat out
+    };
+    
+    RealtimeStressDriver() = delete;
+    
+    static juce::var run(const Options& options);
+};